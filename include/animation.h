@@ -2,6 +2,7 @@
 #ifndef WORLD_EXPLORER_ANIMATION_H
 #define WORLD_EXPLORER_ANIMATION_H
 
+#include <cstdint>
 #include <glm/fwd.hpp>
 #include <map>
 #include <string>
@@ -12,57 +13,23 @@
 #include "assimp/scene.h"
 #include "glm/gtc/type_ptr.hpp"
 #include "model.h"
-
-glm::mat4 AiToGlm(const aiMatrix4x4& aiMat);
-
-template <typename T>
-struct Keyframe {
-        float time;
-        T value;  // could be vec3, quat
-};
-
-struct AnimationChannel {
-        std::vector<Keyframe<glm::vec3>> translations;
-        std::vector<Keyframe<glm::quat>> quats;
-        std::vector<Keyframe<glm::vec3>> scales;
-};
-
-struct Bone {
-        int id;
-        std::string name;
-        glm::mat4 offsetMatrix;
-        int parentIndex = -1;
-        std::vector<int> childrens;
-        AnimationChannel channel;
-        bool hasSkining = false;
-};
-
-struct Action {
-        std::unordered_map<std::string, Bone*> Bonemap;
-        std::unordered_map<std::string, Action*> MixedActions;
-        double mAnimationSecond = 0.0;
-        double mAnimationDuration = 0.0;
-        bool loop = false;
-        bool hasSkining = false;
-        std::string name;
-};
+#include "skeleton.h"
 
 struct Animation {
-        std::unordered_map<std::string, glm::mat4> calculatedTransform;
-        std::unordered_map<std::string, glm::mat4> localTransformation;
+        Skeleton skeleton;
+        std::vector<glm::mat4> mLocalTransforms;   // per joint, result of the last update
+        std::vector<glm::mat4> mGlobalTransforms;  // per joint, relative to the scene root
         std::vector<glm::mat4> mFinalTransformations;
         std::unordered_map<std::string, Action*> actions;
         size_t activeActionIdx;
         Action* activeAction = nullptr;
 
-        glm::mat4 getLocalTransformAtTime(const aiNode* node, double time);
-
-        void computeGlobalTransforms(const aiNode* node, const glm::mat4& parentGlobal, double time,
-                                     std::unordered_map<std::string, glm::mat4>& outGlobalMap,
-                                     std::unordered_map<std::string, glm::mat4>& outLocalMap);
+        // largest element difference between sampleSkeleton and sampleReference for the active action
+        float compareWithReference(const aiNode* root);
 
         bool initAnimation(const aiScene* scene, std::string name);
-        void update(aiNode* root);
+        void compileAction(Action* action);
+        void update();
         Action* getActiveAction();
         Action* getAction(const std::string& actionName);
         void playAction(const std::string& name, bool loop = false);
@@ -99,6 +66,11 @@ struct BoneSocket {
         // private:
         bool mDirty = false;
         glm::mat4 transform = glm::mat4{1.0};
+
+    private:
+        // anchorName resolved to a joint, redone when the name changes
+        std::string mResolvedAnchor;
+        int32_t mJointIndex = -1;
 };
 
 #endif  //! WORLD_EXPLORER_ANIMATION_H
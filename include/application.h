@@ -10,21 +10,32 @@
 
 #include "binding_group.h"
 #include "camera.h"
+#include "draw_list.h"
+#include "frame_pacer.h"
 #include "gpu_buffer.h"
+#include "light_clusters.h"
 #include "material.h"
+#include "material_table.h"
 #include "mesh.h"
+#include "model_hierarchy.h"
+#include "slot_buffer.h"
 #include "terrain_pass.h"
 #include "texture.h"
+#include "texture_bind_groups.h"
 #include "utils.h"
 #include "webgpu/webgpu.h"
 
 // Forward Declarations
 class ShadowPass;
 class InstanceManager;
+class GeometryArena;
+class UploadRing;
+class PipelineCache;
 class LightManager;
 class DepthPrePass;
 class TransparencyPass;
 class Texture;
+class TextureStreamer;
 struct LineEngine;
 class SkyBox;
 class Pipeline;
@@ -76,6 +87,7 @@ class Application {
         const std::vector<WGPUBindGroupEntry> getDefaultTextureBindingData() const;
         WGPUTextureView getDepthStencilTarget();
         WGPUTextureView getColorTarget();
+        // the default pipeline, its depth equal variant while models the prepass drew are shaded
         Pipeline* getPipeline();
 
         std::filesystem::path getWorkingDirectoryPath() const;
@@ -95,6 +107,12 @@ class Application {
         AudioEngine* getAudioEngine();
 
         InstanceManager* mInstanceManager;
+        GeometryArena* mGeometryArena;
+        UploadRing* mUploadRing;
+        PipelineCache* mPipelineCache;
+        FramePacer mFramePacer;
+        DrawList mDrawList;  // the color pass draws
+        double mFrameWaitTime = 0.0;  // the CPU waited this long for a frame in flight
 
         WGPUBindGroupDescriptor mTrasBindGroupDesc = {};
         std::array<WGPUBindGroupLayout, 7> mBindGroupLayouts;
@@ -105,6 +123,7 @@ class Application {
         Texture* mDefaultNormalMap = nullptr;
 
         Registery<std::string, Texture>* mTextureRegistery;
+        TextureStreamer* mTextureStreamer;
         // Registery<std::string, Material>* mMaterialRegistery;
         MaterialRegistery* mMaterialRegistery;
         AudioEngine* audioEngine = nullptr;
@@ -114,12 +133,25 @@ class Application {
         BindingGroup mDefaultCameraIndexBindgroup = {};
         BindingGroup mDefaultClipPlaneBG = {};
         BindingGroup mDefaultVisibleBuffer = {};
+        // group 5 over mAllInstancesIndexBuffer, for instanced draws that skip the culling results
+        WGPUBindGroup mAllInstancesBindGroup = nullptr;
 
         Editor* mEditor;
         BaseModel* mSelectedModel = nullptr;
         Buffer mLightBuffer;
+        Buffer mClusterParamsBuffer;
+        Buffer mClusterGridBuffer;
+        Buffer mClusterIndexBuffer;
+        LightClusters mLightClusters;
         Buffer mVisibleIndexBuffer;
+        Buffer mAllInstancesIndexBuffer;
         Buffer mDefaultBoneFinalTransformData;
+        // per object uniforms, written during the frame and uploaded in a few ranges right before the submit
+        SlotBuffer mObjectSlots;
+        MaterialTable mMaterials;  // every ShaderMaterial and the per draw data of the meshes
+        TextureBindGroups mTextureBindGroups;  // of the meshes, shared by meshes with the same textures
+        SlotBuffer mBoneSlots;
+        ModelHierarchy mModelHierarchy;  // world transforms of the models updateModels moves
         Buffer mDefaultMeshGlobalTransformData;
         std::vector<WGPUBindGroupEntry> mBindingData{20};
         WGPUTextureView mCurrentTargetView;
@@ -133,6 +165,8 @@ class Application {
         LightingUniforms mLightingUniforms;
         LightManager* mLightManager;
         Pipeline* mPipeline;
+        Pipeline* mDepthEqualPipeline;
+        bool mShadeDepthEqual = false;
         Pipeline* mHDRPipeline;
         Pipeline* mStenctilEnabledPipeline;
 
@@ -180,6 +214,7 @@ class Application {
     private:
         bool initDepthBuffer();
         bool createHDRTexture();
+        void updateLightClusters();
         std::filesystem::path mCWDPath;
         std::filesystem::path mBinaryPath;
         std::string mSceneFilePath;
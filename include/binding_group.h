@@ -9,7 +9,7 @@
 class Application;
 
 enum class BindGroupEntryVisibility { UNDEFINED = 0, VERTEX, FRAGMENT, VERTEX_FRAGMENT, COMPUTE };
-enum class TextureSampleType { FLAOT = 0, DEPTH, UINT };
+enum class TextureSampleType { FLAOT = 0, DEPTH, UINT, UNFILTERABLE_FLOAT };
 enum class TextureViewDimension { UNDEFINED = 0, VIEW_2D = 0x2, ARRAY_2D = 0x3, CUBE = 0x4 };
 enum class BufferBindingType { UNIFORM = 0, STORAGE, STORAGE_READONLY };
 enum class SampleType { Filtering = 0, Compare };
@@ -24,11 +24,12 @@ class BindingGroup {
         BindingGroup& addTexture(uint32_t bindingNumber, BindGroupEntryVisibility visibleTo,
                                  TextureSampleType sampleType, TextureViewDimension viewDim);
         BindingGroup& addBuffer(uint32_t bindingNumber, BindGroupEntryVisibility visibleTo, BufferBindingType type,
-                                uint64_t minBindingSize);
+                                uint64_t minBindingSize, bool hasDynamicOffset = false);
         BindingGroup& addSampler(uint32_t bindingNumber, BindGroupEntryVisibility visibleTo, SampleType type);
 
         BindingGroup& addStorageTexture(uint32_t bindingNumber, BindGroupEntryVisibility visibleTo,
-                                        StorageTextureAccessMode access, TextureViewDimension viewDim);
+                                        StorageTextureAccessMode access, TextureViewDimension viewDim,
+                                        WGPUTextureFormat format = WGPUTextureFormat_RGBA8Unorm);
 
         // --- Getter functions
         size_t getEntryCount() const;
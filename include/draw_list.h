@@ -0,0 +1,56 @@
+#ifndef WORLD_EXPLORER_DRAW_LIST_H
+#define WORLD_EXPLORER_DRAW_LIST_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "render_queue.h"
+#include "webgpu/webgpu.h"
+
+class Application;
+class Model;
+
+/*
+ * The mesh draws of a pass, recorded from the model hierarchies and replayed ordered by RenderQueue keys. Opaque
+ * draws are grouped by pipeline and material, transparent ones are drawn back to front. Pipeline and bind group
+ * calls that would rebind what is already bound are skipped, and so are geometry buffers shared through GeometryArena.
+ */
+class DrawList {
+    public:
+        // of the last draw()
+        struct Stats {
+                size_t draws = 0;
+                size_t issued = 0;  // pipeline and bind group calls
+                size_t elided = 0;
+        };
+
+        // `far` normalizes the camera distance for the depth part of the keys
+        void begin(const glm::vec3& cameraPos, float far);
+        // the pipeline of each mesh is resolved here, with the state the application has at this point
+        void add(Application* app, Model* model, bool transparent);
+        void draw(Application* app, WGPURenderPassEncoder encoder);
+
+        const Stats& getStats() const;
+
+    private:
+        struct Draw {
+                Model* model;
+                int meshId;
+                WGPURenderPipeline pipeline;
+        };
+
+        uint32_t getId(std::unordered_map<const void*, uint32_t>& ids, const void* handle);
+
+        RenderQueue mQueue;
+        StateCache mState;
+        std::vector<Draw> mDraws;
+        std::unordered_map<const void*, uint32_t> mPipelineIds;
+        std::unordered_map<const void*, uint32_t> mMaterialIds;
+        glm::vec3 mCameraPos{0.0};
+        float mFar = 1.0;
+        Stats mStats;
+};
+
+#endif  //! WORLD_EXPLORER_DRAW_LIST_H
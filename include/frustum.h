@@ -0,0 +1,69 @@
+#ifndef WORLD_EXPLORER_FRUSTUM_H
+#define WORLD_EXPLORER_FRUSTUM_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+// Ensure 16-byte alignment for structs used in uniform/storage buffers
+// Use alignas(16) for structs
+struct alignas(16) FrustumPlane {
+        glm::vec4 N_D;  // (Nx, Ny, Nz, D)
+};
+
+struct alignas(16) FrustumPlanesUniform {
+        FrustumPlane planes[6];  // Left, Right, Bottom, Top, Near, Far
+};
+
+namespace frustum {
+
+class Plane {
+    public:
+        Plane() {}
+        Plane(const glm::vec3& p1, const glm::vec3& norm);
+        Plane(float d, const glm::vec3& norm);
+        glm::vec3 normal;
+        float distance;
+
+        void normalize();
+};
+}  // namespace frustum
+
+class Frustum {
+    public:
+        Frustum() {};
+        frustum::Plane topFace;
+        frustum::Plane bottomFace;
+
+        frustum::Plane rightFace;
+        frustum::Plane leftFace;
+
+        frustum::Plane farFace;
+        frustum::Plane nearFace;
+        frustum::Plane faces[6];  // same order as FrustumPlanesUniform
+        // false when the box is completely outside one of the planes
+        bool AABBTest(const glm::vec3& min, const glm::vec3& max) const;
+
+        // planes of a GL style (-1..1 depth) view projection matrix, normals point inside
+        static Frustum fromMatrix(const glm::mat4& viewProjection);
+        // the planes the culling compute shader reads
+        static Frustum fromPlanes(const FrustumPlanesUniform& planes);
+};
+
+FrustumPlanesUniform createFrustumPlanes(const Frustum& frustum);
+
+// the world space bounds of an instance as the culling compute shader reads them from InstanceData
+struct InstanceBounds {
+        glm::vec4 minAABB;
+        glm::vec4 maxAABB;
+};
+
+// CPU reference of the frustum test of the culling compute shader. `visible` gets a flag per instance, `indices` the
+// visible instances compacted in instance order (the GPU writes the same set in any order). Instance 0 is the model
+// itself and is never culled, it is flagged but not part of `indices`, the drawn instance count is 1 + indices.size()
+void cullInstances(const FrustumPlanesUniform& planes, std::span<const InstanceBounds> instances,
+                   std::vector<uint8_t>& visible, std::vector<uint32_t>& indices);
+
+#endif  // WORLD_EXPLORER_FRUSTUM_H
@@ -4,18 +4,11 @@
 #include <vector>
 
 #include "camera.h"
+#include "frustum.h"
 #include "glm/fwd.hpp"
 #include "gpu_buffer.h"
 
-// Ensure 16-byte alignment for structs used in uniform/storage buffers
-// Use alignas(16) for structs
-struct alignas(16) FrustumPlane {
-        glm::vec4 N_D;  // (Nx, Ny, Nz, D)
-};
-
-struct alignas(16) FrustumPlanesUniform {
-        FrustumPlane planes[2];  // Left, Right, Bottom, Top, Near, Far
-};
+struct InstanceData;
 
 struct FrustumCorners {
         glm::vec4 nearBottomLeft;
@@ -30,46 +23,21 @@ struct FrustumCorners {
 
 void setupComputePass(Application* app, WGPUBuffer instanceDataBuffer);
 WGPUBindGroup createObjectInfoBindGroupForComputePass(Application* app, WGPUBuffer objetcInfoBuffer,
-                                                      WGPUBuffer indirectDrawArgsBuffer);
+                                                      uint64_t objectInfoOffset, WGPUBuffer indirectDrawArgsBuffer,
+                                                      WGPUBuffer meshDrawArgsBuffer, uint64_t meshDrawArgsSize);
 void runFrustumCullingTask(Application* app, WGPUCommandEncoder encoder);
 
+// Hi-Z occlusion culling of the instances in two phases. runFrustumCullingTask() also drops the instances behind the
+// pyramid of the last frame, runOcclusionCullingTask() builds this frame's pyramid from the depth prepass and appends
+// the ones it does not hide after all. HiZPyramid is the CPU reference of both
+void resizeOcclusionCulling(Application* app, WGPUTextureView depthView, uint32_t width, uint32_t height);
+// `viewProjection` is the one the depth prepass renders with, once per frame before the frame is submitted
+void updateOcclusionCulling(bool enabled, const glm::mat4& viewProjection);
+void runOcclusionCullingTask(Application* app, WGPUCommandEncoder encoder);
+
 Buffer& getFrustumPlaneBuffer();
 
 FrustumCorners getFrustumCornersWorldSpace(const glm::mat4& proj, const glm::mat4& view);
-std::vector<FrustumPlane> create2FrustumPlanes(const FrustumCorners& corners);
 bool isInFrustum(const FrustumCorners& corners, BaseModel* model);
 
-namespace frustum {
-
-class Plane {
-    public:
-        Plane() {}
-        Plane(const glm::vec3& p1, const glm::vec3& norm);
-        Plane(float d, const glm::vec3& norm);
-        glm::vec3 normal;
-        float distance;
-
-        void normalize();
-};
-}  // namespace frustum
-
-class Frustum {
-    public:
-        Frustum() {};
-        frustum::Plane topFace;
-        frustum::Plane bottomFace;
-
-        frustum::Plane rightFace;
-        frustum::Plane leftFace;
-
-        frustum::Plane farFace;
-        frustum::Plane nearFace;
-        frustum::Plane faces[6];
-        bool AABBTest(const glm::vec3& min, const glm::vec3& max);
-};
-
-namespace mipmap {
-void createMipMapComputShader(Application* app);
-}
-
 #endif  // WEBGPUTEST_FRUSTUM_CULLING_H
@@ -0,0 +1,72 @@
+#ifndef WORLD_EXPLORER_GEOMETRY_ARENA_H
+#define WORLD_EXPLORER_GEOMETRY_ARENA_H
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gpu_buffer.h"
+#include "mesh.h"
+#include "range_allocator.h"
+#include "render_queue.h"
+#include "rendererResource.h"
+#include "webgpu/webgpu.h"
+
+// Where a mesh lives inside the arena, offsets are in vertices of `layout` and in indices
+struct GeometryAllocation {
+        VertexLayout layout = VertexLayout::Full;
+        RangeAllocator::Range vertices{0, 0};
+        RangeAllocator::Range indices{0, 0};
+};
+
+/*
+ * Shared vertex/index storage for every model. Each VertexLayout has its own pool of large vertex buffers and all
+ * meshes share one uint32 index buffer, meshes are drawn with baseVertex/firstIndex into them.
+ * Pools grow on demand and are compacted when freed ranges leave them fragmented, the data is moved by copies queued
+ * on the upload ring, so allocations may happen on the loader threads.
+ */
+class GeometryArena {
+    public:
+        explicit GeometryArena(RendererResource* resource);
+
+        // thread safe, models are uploaded from the loader threads. Returns nullptr for empty meshes or on failure
+        std::shared_ptr<GeometryAllocation> allocate(VertexLayout layout, uint32_t vertexCount, uint32_t indexCount);
+        // `stream` 0 is the vertex data, 1 the PackedSkin data of VertexLayout::Packed
+        void writeVertices(const GeometryAllocation& allocation, size_t stream, const void* data, size_t vertexCount);
+        void writeIndices(const GeometryAllocation& allocation, const uint32_t* data, size_t indexCount);
+        void free(const std::shared_ptr<GeometryAllocation>& allocation);
+        // compacts the pools whose free space is too scattered
+        void defragment(bool force = false);
+
+        // skips the buffers `state` has bound already, without one every buffer is set
+        void bind(WGPURenderPassEncoder encoder, const GeometryAllocation& allocation, StateCache* state = nullptr);
+
+        static inline const uint32_t INITIAL_VERTEX_CAPACITY = 1 << 16;
+        static inline const uint32_t INITIAL_INDEX_CAPACITY = 1 << 20;
+        static inline const float DEFRAGMENT_THRESHOLD = 0.5f;
+
+    private:
+        struct Pool {
+                std::string name;
+                std::vector<uint64_t> strides;  // one per vertex stream
+                std::vector<Buffer> buffers;
+                WGPUBufferUsage usage;
+                RangeAllocator allocator{0};
+        };
+
+        Pool& getPool(VertexLayout layout);
+        std::optional<uint64_t> allocateFrom(Pool& pool, uint64_t size, uint64_t initialCapacity);
+        void relocate(Pool& pool, uint64_t capacity, const std::vector<RangeAllocator::Move>& moves);
+        void compact(Pool& pool, bool indices);
+
+        RendererResource* mResource;
+        std::array<Pool, 3> mVertexPools;
+        Pool mIndexPool;
+        std::vector<std::shared_ptr<GeometryAllocation>> mAllocations;
+        std::mutex mMutex;
+};
+
+#endif  //! WORLD_EXPLORER_GEOMETRY_ARENA_H
@@ -27,7 +27,7 @@ class Buffer {
 
     private:
         WGPUBufferDescriptor mBufferDescriptor;
-        WGPUBuffer mBuffer;
+        WGPUBuffer mBuffer = nullptr;
         std::string mName;
         RendererResource* mResources;
 };
@@ -0,0 +1,77 @@
+#ifndef WORLD_EXPLORER_MATERIAL_TABLE_H
+#define WORLD_EXPLORER_MATERIAL_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "dirty_slots.h"
+#include "gpu_buffer.h"
+#include "mesh.h"
+#include "rendererResource.h"
+#include "slot_buffer.h"
+#include "webgpu/webgpu.h"
+
+/*
+ * The ShaderMaterial of every mesh in one storage buffer, indexed by material id. What differs per draw (the
+ * material id, the mesh transform index and the wind) is a DrawData slot in shared uniform pages bound with a
+ * dynamic offset, so all meshes share one bind group per page instead of owning one each. Material ids and draw
+ * slots are handed out from the loader threads. The table doubles once its ids run out, the buffer follows on the next
+ * flush() and the bind groups are made again, which the meshes notice by the generation of their cached binding.
+ */
+class MaterialTable {
+    public:
+        static inline const uint32_t INITIAL_MATERIALS = 4096;
+        static inline const uint32_t DRAWS_PER_PAGE = 256;
+        // kept at its defaults
+        static inline const uint32_t DEFAULT_MATERIAL = 0;
+        static inline const uint32_t NO_MATERIAL = UINT32_MAX;
+
+        // the bind group of a draw, for the layout passed to create()
+        using Binding = DrawBinding;
+
+        void create(RendererResource* resource, WGPUBindGroupLayout layout);
+
+        uint32_t allocateMaterial();
+        void freeMaterial(uint32_t& material);
+        // uploaded by the next flush()
+        void writeMaterial(uint32_t material, const ShaderMaterial& data);
+
+        SlotBuffer::Slot allocateDraw();
+        void freeDraw(SlotBuffer::Slot& draw);
+        void writeDraw(const SlotBuffer::Slot& draw, const DrawData& data);
+        // the binding cached on the mesh, only looked up again when the bind groups were made again
+        const Binding& getBinding(Mesh& mesh);
+
+        void flush();
+
+        uint32_t getMaterialCount();
+        // of the material buffer
+        uint32_t getCapacity() const;
+        // of the last flush()
+        const SlotBuffer::Stats& getStats() const;
+        SlotBuffer& getDrawSlots();
+
+    private:
+        Binding lookupBinding(const SlotBuffer::Slot& draw);
+        void createMaterialBuffer(uint32_t capacity);
+
+        RendererResource* mResources = nullptr;
+        WGPUBindGroupLayout mLayout = nullptr;
+        Buffer mMaterialBuffer;
+        std::vector<ShaderMaterial> mMaterials;
+        std::vector<uint32_t> mFreeMaterials;
+        uint32_t mUsedMaterials = 0;
+        DirtySlots mDirty;
+        std::vector<DirtySlots::Range> mRanges;  // reused by flush()
+        size_t mPendingWrites = 0;
+        SlotBuffer::Stats mStats;
+        SlotBuffer mDraws;
+        std::vector<WGPUBindGroup> mBindGroups;  // by draw page
+        uint32_t mCapacity = 0;
+        std::atomic<uint32_t> mGeneration = 1;  // of mBindGroups, only changed by flush()
+        std::mutex mMutex;
+};
+
+#endif  // WORLD_EXPLORER_MATERIAL_TABLE_H
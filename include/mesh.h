@@ -6,7 +6,9 @@
 #include <cstdint>
 #include <format>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <vector>
 
 #include "../tinyobjloader/tiny_obj_loader.h"
 #include "glm/fwd.hpp"
@@ -14,8 +16,13 @@
 #include "gpu_buffer.h"
 #include "imgui.h"
 #include "material.h"
+#include "slot_buffer.h"
+#include "vertex_packing.h"
 
 class Texture;
+class GeometryArena;
+class StateCache;
+struct GeometryAllocation;
 
 enum class MaterialProps : uint32_t {
     None = 0,                     // No flags set
@@ -26,6 +33,7 @@ enum class MaterialProps : uint32_t {
     HasEmissiveMap = (1u << 4),   // Bit 4: Does it have an emissive map?
     IsDoubleSided = (1u << 5),    // Bit 5: Is it double-sided?
     IsAnimated = (1u << 6),       // Bit 5: Is it animated?
+    IsFoliage = (1u << 7),        // Bit 7: Alpha tested, the depth prepass discards its cut out texels
 
 };
 
@@ -82,6 +90,24 @@ struct alignas(16) ShaderMaterial {
         }
 };
 
+// DrawData in common.wgsl, what a draw of a mesh reads besides its material
+struct alignas(16) DrawData {
+        uint32_t materialIndex;  // into the MaterialTable
+        int32_t meshIdx;
+        uint32_t _padding[2];
+        WindParams windParams;
+};
+
+// the bind group and dynamic offset a draw of a mesh binds its material and DrawData with, see MaterialTable
+struct DrawBinding {
+        WGPUBindGroup group = nullptr;
+        uint32_t dynamicOffsetCount = 0;
+        uint32_t dynamicOffset = 0;
+        uint32_t generation = 0;  // of the material table's bind groups, they are made again when its buffer grows
+
+        void set(WGPURenderPassEncoder encoder, uint32_t groupIndex) const;
+};
+
 // Shader-equivalant struct for vertex data
 struct alignas(16) VertexAttributes {
         glm::vec3 position;
@@ -94,35 +120,76 @@ struct alignas(16) VertexAttributes {
         glm::vec4 weights{1.0, 0.0, 0.0, 0.0};
 };
 
+// GPU vertex formats a mesh can be uploaded with, chosen per mesh in Model::uploadToGPU
+enum class VertexLayout : uint32_t {
+    Full = 0,      // VertexAttributes as is
+    Packed,        // PackedVertex + PackedSkin in a second vertex buffer
+    PackedStatic,  // PackedVertex only, static meshes carry no skinning data
+};
+
+// Packed counterpart of VertexAttributes, 28 bytes instead of 112 (see PackedVertexInput in vertex_packing.wgsl)
+struct PackedVertex {
+        glm::vec3 position;
+        uint32_t normal;   // octahedral, snorm16x2
+        uint32_t color;    // unorm8x4, alpha holds the bitangent sign
+        uint32_t tangent;  // octahedral, snorm16x2
+        uint32_t uv;       // float16x2
+};
+static_assert(sizeof(PackedVertex) == 28);
+
+struct PackedSkin {
+        uint32_t boneIds;  // uint8x4
+        uint32_t weights;  // unorm8x4, quantized to sum up to 255
+};
+
+// the attribute encodings are in vertex_packing.h
+namespace packing {
+VertexLayout chooseLayout(const std::vector<VertexAttributes>& vertices, bool skinned);
+PackedVertex packVertex(const VertexAttributes& vertex);
+PackedSkin packSkin(const VertexAttributes& vertex);
+}  // namespace packing
+
 class Mesh {
     public:
         void setVisible(bool visibility = true);
         bool getVisible() const;
         void setMatreial(const std::shared_ptr<Material> mat);
         std::shared_ptr<Material> getMatreial();
+        // binds the vertex/index buffers the mesh lives in, the skin stream of VertexLayout::Packed goes to slot 1.
+        // Buffers `state` has bound already are skipped
+        void bindGeometry(WGPURenderPassEncoder encoder, GeometryArena* arena, StateCache* state = nullptr);
+        void drawIndexed(WGPURenderPassEncoder encoder, uint32_t instanceCount = 1);
+        uint32_t getFirstIndex() const;
+        int32_t getBaseVertex() const;
 
         unsigned int meshId;
         std::vector<VertexAttributes> mVertexData;
         std::vector<uint32_t> mIndexData;
+        // model space bounds, the vertices are already in model space
+        glm::vec3 mBoundsMin{std::numeric_limits<float>::max()};
+        glm::vec3 mBoundsMax{std::numeric_limits<float>::lowest()};
         std::shared_ptr<Texture> mTexture = nullptr;
         std::shared_ptr<Texture> mSpecularTexture = nullptr;
         std::shared_ptr<Texture> mNormalMapTexture = nullptr;
+        std::shared_ptr<GeometryAllocation> mGeometry = nullptr;  // range in the geometry arena
+        // own buffers, only used when the mesh is not in the arena
         Buffer mVertexBuffer = {};
+        Buffer mSkinBuffer = {};
         Buffer mIndexBuffer = {};
-        Buffer mIndirectDrawArgsBuffer;
-        Buffer mMaterialBuffer;
-        Buffer mWindBuffer;
-        Buffer mMeshMapIdx;
+        uint32_t mMaterialIndex = UINT32_MAX;  // mMaterial in Application::mMaterials
+        SlotBuffer::Slot mDrawSlot;            // its DrawData in Application::mMaterials
+        DrawBinding mDrawBinding;              // of mDrawSlot, kept by MaterialTable::getBinding(Mesh&)
         bool isTransparent = false;
         WGPUBindGroup mTextureBindGroup = {};
+        uint32_t mTextureBindVersion = 0;  // Model::textureViewVersion() when mTextureBindGroup was built
         std::vector<WGPUBindGroupEntry> binding_data{2};
-        WGPUBindGroup mMaterialBindGroup = {};
         ShaderMaterial mMaterial;
         WindParams mWindParams;
         std::shared_ptr<Material> mTextureMaterial = nullptr;
         std::string mMaterialName;
         std::string mName;
         bool mIsVisible = true;
+        VertexLayout mVertexLayout = VertexLayout::Full;
 };
 
 #endif  //! WEBGPUTEST_MESH_H
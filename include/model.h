@@ -8,8 +8,11 @@
 #include <unordered_map>
 
 // #include "animation.h"
+#include "cooked_asset.h"
 #include "glm/fwd.hpp"
 #include "gpu_buffer.h"
+#include "indirect_draw_args.h"
+#include "material_table.h"
 #define DEVELOPMENT_BUILD 1
 
 #include <array>
@@ -17,6 +20,7 @@
 #include <filesystem>
 #include <format>
 #include <iostream>
+#include <memory>
 #include <numeric>
 #include <vector>
 
@@ -24,7 +28,9 @@
 #include "glm/glm.hpp"
 // #include "instance.h"
 #include "mesh.h"
+#include "slot_buffer.h"
 // #include "texture.h"
+#include "transform_hierarchy.h"
 #include "webgpu/webgpu.h"
 #include "webgpu/wgpu.h"
 
@@ -41,14 +47,6 @@ struct PhysicsComponent;
 struct Action;
 class InputHandler;
 
-struct alignas(4) DrawIndexedIndirectArgs {
-        uint32_t indexCount;
-        uint32_t instanceCount;
-        uint32_t firstIndex;
-        uint32_t baseVertex;
-        uint32_t firstInstance;
-};
-
 /*
  * hold the object specific configuration for rendering in shader
  */
@@ -57,6 +55,7 @@ struct alignas(16) ObjectInfo {
         uint32_t instanceOffsetId;
         uint32_t isSelected;
         uint32_t isAnimated;
+        uint32_t instanceCount;  // read by the culling pass only
 };
 
 class Node {
@@ -66,11 +65,16 @@ class Node {
         Node* mParent;
         std::vector<Node*> mChildrens;
         std::vector<unsigned int> mMeshIndices;
+        int32_t mJointIndex = -1;      // this node in the Animation skeleton
+        int32_t mTransformIndex = -1;  // this node in the TransformHierarchy of its model
 
+        // walks up the parents, the reference for the cached world transforms in BaseModel::mNodeTransforms
         glm::mat4 getGlobalTransform() const;
 
         static inline Node* buildNodeTree(aiNode* ainode, Node* parent,
                                           std::unordered_map<std::string, Node*>& nodemap);
+        // appends `node` and everything below it to `transforms` and `nodes` in depth-first order
+        static void flatten(Node* node, int32_t parent, TransformHierarchy& transforms, std::vector<Node*>& nodes);
 };
 
 enum ModelTypes {
@@ -80,8 +84,6 @@ enum ModelTypes {
 
 // Hold the properties and needed object to represents the object transformation
 class Transform {
-        friend class BaseModel;
-
     public:
         glm::vec3& getPosition();
         glm::vec3& getScale();
@@ -102,9 +104,6 @@ class Transform {
         glm::mat4 mTransformMatrix;
         glm::quat mOrientation{};
         bool mDirty = true;
-
-    private:
-        glm::mat4 getGlobalTransform(BaseModel* parent);
 };
 
 class Drawable {
@@ -114,10 +113,15 @@ class Drawable {
         virtual void draw(Application* app, WGPURenderPassEncoder encoder);
         virtual void drawHirarchy(Application* app, WGPURenderPassEncoder encoder);
 
-        Buffer& getUniformBuffer();
+        // the ObjectInfo of the drawable lives in a slot of Application::mObjectSlots, bound with an offset
+        WGPUBuffer getObjectInfoBuffer();
+        uint64_t getObjectInfoOffset() const;
+        // uploaded with the other slots before the frame is submitted
+        void writeObjectInfo(const void* data, size_t size, uint64_t offset = 0);
 
     private:
-        Buffer mUniformBuffer;
+        SlotBuffer* mObjectSlots = nullptr;
+        SlotBuffer::Slot mObjectSlot;
 };
 
 class DebugUI {
@@ -172,8 +176,8 @@ class BaseModel : public Drawable, public AABB, public DebugUI {
         virtual Pipeline* getPipeline(Application* app);
 
         void addChildren(BaseModel* child);
-        glm::mat4 getGlobalTransform();
-        void updateHirarchy();
+        // as of the last updateModels, the local one for a model that is not updated there (see ModelHierarchy)
+        const glm::mat4& getGlobalTransform() const;
         CoordinateSystem getCoordinateSystem() const;
         void setCoordinateSystem(const CoordinateSystem& cs);
         virtual ModelTypes getType() const;
@@ -188,8 +192,11 @@ class BaseModel : public Drawable, public AABB, public DebugUI {
         /* Scene graph related property */
         BaseModel* mParent = nullptr;
         Transform mTransform;
+        uint32_t mTransformVersion = 0;  // bumped whenever mTransform's local matrix changes
         Node* mRootNode = nullptr;
         std::unordered_map<std::string, Node*> mNodeNameMap;
+        TransformHierarchy mNodeTransforms;
+        std::vector<Node*> mNodes;  // mRootNode's tree in the order of mNodeTransforms
 
         BoneSocket* mSocket = nullptr;
 
@@ -204,6 +211,9 @@ class BaseModel : public Drawable, public AABB, public DebugUI {
         InputHandler* mInputHandler = nullptr;
 
     private:
+        // rebuilds the local matrix after its position, scale or rotation changed
+        void transformChanged();
+
         bool mIsTransparent = false;
         bool mIsVisible = true;
         CoordinateSystem mCoordinateSystem = Z_UP;
@@ -216,25 +226,59 @@ class Model : public BaseModel {
 
         void processMesh(Application* app, aiMesh* mesh, const aiScene* scene, unsigned int meshId,
                          const glm::mat4& globalTransform);
+        // processMesh for a mesh flattened by the exporter, only the coordinate system swap and bone ids are left
+        void processCookedMesh(Application* app, const cooked::Mesh& cookedMesh, const aiScene* scene,
+                               unsigned int meshId);
         void processNode(Application* app, aiNode* node, const aiScene* scene, const glm::mat4& parentTransform);
+        void applyBoneWeights(const aiMesh* mesh, Mesh& mmesh);
+        void loadMeshTextures(Application* app, Mesh& mmesh, const aiMaterial* material);
         virtual Model& load(std::string name, Application* app, const std::filesystem::path& path,
                             WGPUBindGroupLayout layout);
         virtual Model& uploadToGPU(Application* app);
+        // returns the meshes' geometry arena ranges and compacts the arena, main thread only
+        void unloadFromGPU();
         void getCustomBindGroup(Application* app, WGPURenderPassEncoder encoder, Mesh& mesh) override;
         Pipeline* getPipeline(Application* app) override;
+        // what internalDraw binds for `mesh`, for callers recording the draws themselves
+        WGPURenderPipeline getMeshPipeline(Application* app, Mesh& mesh);
+        // rebuilds the mesh's bind group first when one of its textures changed its view, like streamed ones do
+        WGPUBindGroup getTextureBindGroup(Application* app, Mesh& mesh);
+        virtual const MaterialTable::Binding& getMaterialBinding(Application* app, Mesh& mesh);
+        // queues mesh.mMaterial and the mesh's DrawData (material id, mesh index and wind) for upload
+        void writeMaterial(Application* app, Mesh& mesh);
         void draw(Application* app, WGPURenderPassEncoder encoder) override;
+        // `culledInstances` false when the caller bound Application::mAllInstancesBindGroup to group 5 and wants every
+        // instance drawn, for passes that look through another camera than the one the culling pass used
+        void draw(Application* app, WGPURenderPassEncoder encoder, Pipeline* pipeline, bool culledInstances = true);
         void drawHirarchy(Application* app, WGPURenderPassEncoder encoder) override;
         void drawGraph(Application* app, WGPURenderPassEncoder encoder, Node* node);
         void internalDraw(Application* app, WGPURenderPassEncoder encoder, Node* node);
+        // true for the instanced models runFrustumCullingTask prepares draw args for
+        bool hasCulledInstances() const;
+        // draws the instances of `mesh`, through the culled draw args when the culling pass prepared them and
+        // `culledInstances` is set, otherwise all of them mapped to themselves
+        void drawInstances(Application* app, WGPURenderPassEncoder encoder, int meshId, Mesh& mesh,
+                           bool culledInstances = true);
 
         Model& setFoliage();
         Model& useTexture(bool use = true);
+        // upload meshes with the packed vertex layouts (see VertexLayout), has to be set before uploadToGPU
+        Model& setVertexPacking(bool pack = true);
 
         void updateSocketTransformation(std::unordered_map<Model*, bool>& calculatedTransforms);
-        virtual void update(Application* app, float dt, float physicSimulating = true);
+        // applies only this model's socket, the model it is socketed to has to be updated already
+        void updateSocketTransformation();
+        // updateState followed by writeBuffers
+        void update(Application* app, float dt, float physicSimulating = true);
+        // animation and physics driven transform, touches only this model so it can run on a job thread
+        virtual void updateState(Application* app, float dt, float physicSimulating = true);
+        // queues the buffer writes for what updateState changed, has to run on the main thread
+        virtual void writeBuffers(Application* app);
 
         // Getters
         void createSomeBinding(Application* app, std::vector<WGPUBindGroupEntry> bindingData);
+        // texture bind group of `mesh` from its current texture views, after a streamed texture was recreated
+        void createTextureBindGroup(Application* app, Mesh& mesh);
         WGPUBindGroup getObjectInfoBindGroup();
         void updateAnimation(float dt);
 
@@ -243,12 +287,15 @@ class Model : public BaseModel {
         void setDefaultAction(Action* defaultAction);
         // std::unordered_map<Model*, bool> mCalculatedSocketTransforms;
 
-        Buffer mIndirectDrawArgsBuffer;
-        Buffer mSkiningTransformationBuffer;
+        Buffer mIndirectDrawArgsBuffer;  // its instanceCount is the visible instance counter of the culling pass
+        Buffer mMeshDrawArgsBuffer;      // mMeshDrawArgs on the GPU, slots are the mesh ids
+        IndirectDrawArgs mMeshDrawArgs;
+        SlotBuffer::Slot mBoneSlot;  // final bone transforms in Application::mBoneSlots, when animated
         Buffer mGlobalMeshTransformationBuffer;
 
         const aiScene* mScene;
         Assimp::Importer mImport;
+        std::unique_ptr<cooked::Asset> mCookedAsset;  // owns mScene when loaded from a cooked asset
 
         std::vector<glm::vec3> mBonePosition;
         std::vector<glm::mat4> mGlobalMeshTransformationData;
@@ -268,6 +315,20 @@ class Model : public BaseModel {
         WGPUBindGroup mBindGroup = nullptr;
         WGPUBindGroup mObjectInfoBindGroup = nullptr;
         bool mIsLoaded = false;
+        bool mPackVertices = false;
+        bool mHasPackedMeshes = false;
+        bool mMeshTransformsDirty = false;
+        bool mBonesDirty = false;  // mFinalTransformations changed since they were written to mBoneSlot
+        // the action and time the pose was last sampled at
+        Action* mSampledAction = nullptr;
+        double mSampledSecond = -1.0;
+        // what the socket last produced and the transform version it left, nothing else moved the model if it held
+        glm::mat4 mLastSocketTransform{0.0};
+        uint32_t mSocketVersion = 0;
 };
 
+// Updates sockets and state of `models` as jobs on the physics job system, a model waits for the model it is socketed
+// to. The world transforms and buffer writes are done afterwards on the calling thread
+void updateModels(Application* app, const std::vector<Model*>& models, float dt, bool physicSimulating);
+
 #endif  //! WEBGPUTEST_MODEL_H
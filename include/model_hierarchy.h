@@ -0,0 +1,39 @@
+#ifndef WORLD_EXPLORER_MODEL_HIERARCHY_H
+#define WORLD_EXPLORER_MODEL_HIERARCHY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "transform_hierarchy.h"
+
+class BaseModel;
+class Model;
+
+/*
+ * The model level parents and sockets flattened into a TransformHierarchy. A model's transform is relative to its
+ * parent, a socketed one's to the frame of the model it is socketed to, as BoneSocket::update already applies that
+ * model's own transform. The hierarchy is rebuilt only when the models or their parents and sockets change, a moved
+ * model is picked up by its transform version and only the moved subtrees are recomputed.
+ */
+class ModelHierarchy {
+    public:
+        // the model the transform of `model` is relative to, nullptr for the world
+        static const BaseModel* getFrameParent(const BaseModel* model);
+
+        // has to run after the transforms of the frame are set, stores the world transforms in the object infos
+        void update(const std::vector<Model*>& models);
+
+        // socketed to a socketed model and so on, longer chains are cut there
+        static inline const uint32_t MAX_SOCKET_CHAIN = 16;
+
+    private:
+        void rebuild(const std::vector<Model*>& models);
+
+        TransformHierarchy mTransforms;
+        std::vector<Model*> mModels;                  // as given to the last update
+        std::vector<const BaseModel*> mFrameParents;  // of mModels
+        std::vector<Model*> mNodes;                   // mModels in the order of mTransforms
+        std::vector<uint32_t> mVersions;              // the transform version of each node last set as its local
+};
+
+#endif  // WORLD_EXPLORER_MODEL_HIERARCHY_H
@@ -4,15 +4,16 @@
 #define WEBGPUTEST_MODEL_REGISTERY_H
 
 #include <functional>
-#include <future>
 #include <glm/fwd.hpp>
 #include <iostream>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "input_manager.h"
+#include "loader_pool.h"
 
 class Model;      // Forward declaration
 class BaseModel;  // Forward declaration
@@ -55,6 +56,9 @@ class PawnBehaviour {
 
 enum ModelVisibility { Visibility_Editor = 0, Visibility_User = 1, Visibility_Other = 100 };
 
+// higher loads first
+enum LoadPriority { LoadPriority_Background = 0, LoadPriority_Visible = 1, LoadPriority_Actor = 2 };
+
 struct LoadModelResult {
         Model* model;
         ModelVisibility visibility;
@@ -81,7 +85,12 @@ class ModelRegistry {
         using ModelContainer = std::vector<Model*>;
 
         static ModelRegistry& instance();
-        void registerModel(const std::string& name, FactoryFunc func);
+        void registerModel(const std::string& name, FactoryFunc func, int priority = LoadPriority_Background);
+        // drops a model that did not start loading yet, false when it is already loading or loaded
+        bool cancelLoad(const std::string& name);
+        // stops drawing a loaded model and gives its geometry back to the arena, false when it is not loaded. The
+        // Model itself and its place in the world stay, others may still point at it
+        bool unloadModel(Model* model);
         void registerInputHandler(const std::string& name, InputHandler* inputHandler);
         void registerBehaviour(const std::string& name, PawnBehaviour* behaviour);
         void tick(Application* app);
@@ -91,9 +100,17 @@ class ModelRegistry {
         std::optional<Model*> query(std::string modelName, std::function<void(Model*, void*)> cb, void* args);
 
     private:
+        ModelRegistry();
+        void onModelLoaded(Application* app, const LoadModelResult& model);
+
         ModelContainer mUserLoadedModel;
         ModelContainer mEditorLoadedModel;
-        std::vector<std::future<LoadModelResult>> futures;
+        std::unordered_map<std::string, int> mPriorities;
+        std::unordered_map<std::string, LoaderPool::Ticket> mLoading;
+        // filled by the loader threads, handed to the rest of the engine in tick()
+        std::vector<std::pair<std::string, LoadModelResult>> mLoaded;
+        std::mutex mLoadedMutex;
+        LoaderPool mLoaderPool;
         std::unordered_map<std::string, InputHandler*> inputHandlerMap;
         std::unordered_map<std::string, PawnBehaviour*> pawnBehaviourMap;
 
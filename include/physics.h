@@ -23,6 +23,7 @@
 
 #include "Jolt/Physics/Body/Body.h"
 #include "Jolt/Physics/Character/CharacterVirtual.h"
+#include "fixed_timestep.h"
 #include "glm/ext/matrix_float4x4.hpp"
 #include "glm/ext/matrix_transform.hpp"
 #include "glm/ext/vector_float3.hpp"
@@ -118,8 +119,14 @@ class PhysicSystem {
 
 HitResult ShootRay(glm::vec3 origin, glm::vec3 direction, float maxDistance);
 void prepareJolt();
+// Runs as many fixed steps as `dt` covers (see FixedTimestep)
 void JoltLoop(float dt);
+void setFixedTimestep(float stepsPerSecond, int maxSubSteps);
+FixedTimestep& getFixedTimestep();
 std::pair<glm::vec3, glm::quat> getPositionAndRotationyId(JPH::BodyID id);
+// body pose between the last two fixed steps at the current frame's alpha, falls back to the live pose for bodies
+// created or moved by hand since the last step
+std::pair<glm::vec3, glm::quat> getInterpolatedPositionAndRotation(JPH::BodyID id);
 JPH::BodyID createAndAddBody(const glm::vec3& shape, const glm::vec3 centerPos, const glm::quat& rotation,
                              MotionType motionType, float friction, float restitution, float linearDamping,
                              float gravityFactor, bool isSensor = false, void* userData = nullptr);
@@ -129,6 +136,8 @@ void setPosition(JPH::BodyID id, const glm::vec3& pos);
 JPH::CharacterVirtual* createCharacter(JPH::Ref<JPH::Shape> shape, const glm::vec3& initialPosition,
                                        JPH::uint64 userData = 0);
 JPH::PhysicsSystem* getPhysicsSystem();
+// the thread pool created in prepareJolt, shared with game code that runs outside of the physics update
+JPH::JobSystem* getJobSystem();
 JPH::CapsuleShape* createCapsuleShape(float halfHeight, float radius);
 void updateCharacter(JPH::CharacterVirtual* physicalCharacter, float dt, JPH::Vec3 movement);
 }  // namespace physics
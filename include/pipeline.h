@@ -1,6 +1,7 @@
 #ifndef TEST_WGPU_PIPELINE_H
 #define TEST_WGPU_PIPELINE_H
 
+#include <array>
 #include <vector>
 
 #include "../webgpu/webgpu.h"
@@ -19,10 +20,14 @@ class Pipeline {
                                        WGPUTextureFormat depthTextureFormat = WGPUTextureFormat_Depth24Plus,
                                        const char* shaderPath = "./resources/shaders/shader.wgsl");
         Pipeline& createPipeline(const RendererResource& resource);
+        // also build variants for meshes uploaded with a packed VertexLayout, the shader has to provide
+        // vs_main_packed and vs_main_packed_static next to vs_main
+        Pipeline& enablePackedVertexVariants(bool enable = true);
 
         // Getters
         WGPUPipelineLayout getPipelineLayout();
         WGPURenderPipeline getPipeline();
+        WGPURenderPipeline getPipeline(VertexLayout layout);
         WGPURenderPipelineDescriptor getDescriptor();
         WGPURenderPipelineDescriptor* getDescriptorPtr();
         WGPUVertexBufferLayout getDefaultVertexBufferLayout();
@@ -62,6 +67,13 @@ class Pipeline {
         WGPURenderPipeline mPipeline = nullptr;
         WGPUVertexBufferLayout mlVertexBufferLayout;
 
+        bool mPackedVariants = false;
+        VertexBufferLayout mPackedVertexLayout = {};
+        VertexBufferLayout mPackedSkinLayout = {};
+        std::array<WGPUVertexBufferLayout, 2> mlPackedBufferLayouts;
+        WGPURenderPipeline mPackedPipeline = nullptr;
+        WGPURenderPipeline mPackedStaticPipeline = nullptr;
+
         WGPUTextureFormat mDepthTextureFormat = WGPUTextureFormat_Depth24Plus;
 
         // state
@@ -0,0 +1,61 @@
+#ifndef WORLD_EXPLORER_PIPELINE_CACHE_H
+#define WORLD_EXPLORER_PIPELINE_CACHE_H
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "cache_key.h"
+#include "rendererResource.h"
+#include "shader_source_cache.h"
+#include "webgpu/webgpu.h"
+
+/*
+ * Shader modules, pipeline layouts and pipelines shared between everything that asks for an identical one. Modules
+ * are keyed by their preprocessed source, layouts and pipelines by the fields of their descriptor (labels aside), so
+ * rebuilding a pass or reloading a scene reuses what was created before. The cache owns the handles it returns.
+ * Descriptors with a chained struct are not keyed and always create a new object.
+ */
+class PipelineCache {
+    public:
+        struct Stats {
+                size_t hits = 0;
+                size_t misses = 0;
+        };
+
+        explicit PipelineCache(RendererResource* resource);
+
+        // keeps preprocessed shader sources in `directory` across runs, empty disables it
+        void setDiskDirectory(const std::filesystem::path& directory);
+
+        WGPUShaderModule getShaderModule(const std::filesystem::path& path);
+        WGPUShaderModule getShaderModule(const std::string& code, const char* label);
+        WGPUPipelineLayout getPipelineLayout(const WGPUPipelineLayoutDescriptor& descriptor);
+        WGPURenderPipeline getRenderPipeline(const WGPURenderPipelineDescriptor& descriptor);
+        WGPUComputePipeline getComputePipeline(const WGPUComputePipelineDescriptor& descriptor);
+
+        // releases every cached object, the handles returned so far become invalid
+        void clear();
+
+        const ShaderSourceCache::Stats& getSourceStats() const;
+        const Stats& getModuleStats() const;
+        const Stats& getLayoutStats() const;
+        const Stats& getPipelineStats() const;  // render and compute
+
+    private:
+        WGPUShaderModule getShaderModuleLocked(const std::string& code, const char* label);
+
+        RendererResource* mResources;
+        ShaderSourceCache mSources;
+        std::unordered_map<std::string, WGPUShaderModule> mModules;  // by source
+        std::unordered_map<std::string, WGPUPipelineLayout> mLayouts;
+        std::unordered_map<std::string, WGPURenderPipeline> mRenderPipelines;
+        std::unordered_map<std::string, WGPUComputePipeline> mComputePipelines;
+        Stats mModuleStats;
+        Stats mLayoutStats;
+        Stats mPipelineStats;
+        std::mutex mMutex;  // models may create their pipelines from the loader threads
+};
+
+#endif  // WORLD_EXPLORER_PIPELINE_CACHE_H
@@ -53,6 +53,9 @@ class LightManager {
         std::vector<std::string>& getLightsNames();
         uint32_t boxId = std::numeric_limits<uint32_t>().max();
 
+        // capacity of the light storage buffer, lights past it are not shaded
+        static inline const size_t MAX_LIGHTS = 256;
+
     private:
         void updateCount();
         Application* mApp;
@@ -7,6 +7,9 @@
 #include <webgpu/webgpu.h>
 #include <webgpu/wgpu.h>
 
+class PipelineCache;
+class UploadRing;
+
 /*
  * A struct to gather primitives for our renderer
  * Note: Pipelines and bindgroups are not part of this struct
@@ -19,5 +22,7 @@ struct RendererResource {
         WGPUSurface surface;
         GLFWwindow* window;
         WGPUCommandEncoder commandEncoder;
+        UploadRing* uploads = nullptr;  // Buffer::queueWrite stages through it when set
+        PipelineCache* pipelines = nullptr;  // shader modules and pipelines are created through it
 };
 #endif  // !WORLD_EXPLORER_CORE_RENDERERRESOURCE_H
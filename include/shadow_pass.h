@@ -1,6 +1,9 @@
 #ifndef WEBGPUTEST_SHADOW_PASS_H
 #define WEBGPUTEST_SHADOW_PASS_H
 
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "../webgpu/webgpu.h"
@@ -14,6 +17,7 @@
 #include "model_registery.h"
 #include "pipeline.h"
 #include "renderpass.h"
+#include "static_casters.h"
 #include "texture.h"
 
 class Application;
@@ -39,6 +43,7 @@ class ShadowPass : public RenderPass {
 
         Pipeline* getPipeline();
         WGPUTextureView getShadowMapView();
+        // draws the visible models reaching the light frustum of cascade `which`
         void render(ModelRegistry::ModelContainer& models, WGPURenderPassEncoder encoder, size_t which);
         void renderAllCascades(WGPUCommandEncoder encoder);
         WGPUTextureView getTextureView(size_t level, size_t count);
@@ -58,6 +63,21 @@ class ShadowPass : public RenderPass {
         std::vector<ShadowFrustum*> mSubFrustums;
         float mPushBackFactor = 1.0;
 
+        // skip the models whose bounds miss a cascade's light frustum
+        bool mCullPerCascade = true;
+        // static casters are drawn once into a depth cache per cascade and copied in every frame, only the dynamic
+        // ones are redrawn on top. A cascade's cache is rebuilt when its light frustum moves or the set of static
+        // casters changes. The cascades are fit to texel snapped bounding spheres while it is on, so they stand
+        // still with the camera
+        bool mCacheStaticCasters = true;
+
+        struct Stats {
+                size_t drawnCasters = 0;   // model draws over all cascades in the last frame
+                size_t culledCasters = 0;  // models skipped for a cascade they do not reach
+                size_t cacheRebuilds = 0;  // cascades whose static cache was redrawn
+        };
+        const Stats& getStats() const;
+
     private:
         Application* mApp;
         // pipeline
@@ -81,16 +101,49 @@ class ShadowPass : public RenderPass {
         Texture* mRenderTarget;
         Texture* mShadowDepthTexture;
         Texture* mShadowDepthTexture2;
+        Texture* mStaticDepthTexture;
+
+        struct CasterBounds {
+                glm::vec3 min{0.0f};
+                glm::vec3 max{0.0f};
+                bool bounded = false;  // instanced models are never culled
+        };
+
+        struct CascadeCache {
+                glm::mat4 viewProjection{0.0f};
+                bool valid = false;
+        };
+
+        // sorts the models into static and dynamic casters, true when the static caster caches have to be redrawn
+        bool updateCasters(ModelRegistry::ModelContainer& models);
+        // begins a pass with `descriptor` and draws `casters` into cascade `which`
+        void drawCascade(WGPUCommandEncoder encoder, WGPURenderPassDescriptor* descriptor,
+                         const std::vector<Model*>& casters, size_t which);
+        void renderCasters(const std::vector<Model*>& casters, WGPURenderPassEncoder encoder, size_t which);
+        bool reachesCascade(Model* model, size_t which) const;
 
         Scene calculateFrustumScene(const std::vector<glm::vec4>& frustum, float farZ, size_t cascadeIdx);
         // scene
         std::vector<Scene> mScenes;
+        std::vector<Scene> mSceneUniforms;  // mScenes with the view folded into the projection
+        std::vector<Frustum> mCascadeFrustums;
+
+        StaticCasters mCasterStates;
+        std::unordered_map<Model*, CasterBounds> mCasterBounds;
+        std::vector<Model*> mStaticCasters;
+        std::vector<Model*> mDynamicCasters;
+        std::vector<Model*> mCascadeCasters;
+        std::vector<CascadeCache> mCascadeCaches;
+        std::vector<ShadowFrustum*> mStaticFrustums;   // clear and draw the static casters into the cache
+        std::vector<ShadowFrustum*> mDynamicFrustums;  // draw the dynamic casters over the copied cache
+        bool mCachedWithCulling = false;
+        Stats mStats;
 };
 
 class ShadowFrustum {
     public:
         ShadowFrustum(Application* app, WGPUTextureView renderTarget, WGPUTextureView depthTexture,
-                      const std::string& name);
+                      const std::string& name, LoadOp depthLoadOp = LoadOp::Clear);
         WGPURenderPassDescriptor* getRenderPassDescriptor();
 
         WGPUTextureView mShadowDepthTexture;
@@ -109,12 +162,45 @@ class DepthPrePass : public RenderPass {
 
         void createRenderPass(WGPUTextureFormat textureFormat) override;
 
-        void render(ModelRegistry::ModelContainer& models, WGPURenderPassEncoder encoder);
+        // lays down the depth of the opaque models that shade through the default pipeline, nearest first
+        void render(const std::vector<Model*>& opaques, const glm::vec3& cameraPosition,
+                    WGPURenderPassEncoder encoder);
+        // whether `model` got its depth from the last render, it can then be shaded with depth equal
+        bool hasDepth(Model* model) const;
         WGPURenderPassDescriptor mDesc;
         WGPURenderPassDescriptor& getRenderDesc(WGPUTextureView texture);
 
+        struct Stats {
+                size_t drawnModels = 0;
+                size_t foliageMeshes = 0;
+                size_t skippedModels = 0;
+        };
+        const Stats& getStats() const;
+
+        // the prepass and the depth equal shading of what it drew are off until they have been checked on hardware,
+        // the pipelines are only created once the prepass is turned on. Occlusion culling builds its Hi-Z pyramid
+        // from this depth, Application skips it and the late culling pass while the prepass is off
+        bool mEnabled = false;
+        bool mDepthEqualShading = false;
+        size_t mMaxOccluders = 0;  // only the largest models on screen are drawn, 0 draws every one
+
     private:
+        struct Occluder {
+                Model* model;
+                float coverage;  // bounding sphere radius over its distance
+                float distance;
+        };
+
+        Pipeline* createPipeline(const char* shader, const char* name, bool alphaTest);
+        // world bounds of everything the model draws, its instances included
+        std::pair<glm::vec3, glm::vec3> getDrawnBounds(Model* model);
+
         Application* mApp;
+        Pipeline* mAlphaTestPipeline = nullptr;
+        WGPUFragmentState mAlphaTestFragmentState = {};
+        std::vector<Occluder> mOccluders;
+        std::unordered_set<Model*> mDrawnModels;
+        Stats mStats;
 
         // bindings
         BindingGroup mBindingGroup;
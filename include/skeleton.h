@@ -0,0 +1,120 @@
+#ifndef WORLD_EXPLORER_SKELETON_H
+#define WORLD_EXPLORER_SKELETON_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "assimp/scene.h"
+#include "glm/ext.hpp"
+#include "glm/glm.hpp"
+
+glm::mat4 AiToGlm(const aiMatrix4x4& aiMat);
+
+template <typename T>
+struct Keyframe {
+        float time;
+        T value;  // could be vec3, quat
+};
+
+struct AnimationChannel {
+        std::vector<Keyframe<glm::vec3>> translations;
+        std::vector<Keyframe<glm::quat>> quats;
+        std::vector<Keyframe<glm::vec3>> scales;
+};
+
+struct Bone {
+        int id;
+        std::string name;
+        glm::mat4 offsetMatrix;
+        int parentIndex = -1;
+        std::vector<int> childrens;
+        AnimationChannel channel;
+        bool hasSkining = false;
+};
+
+// Node hierarchy of a scene flattened in depth-first order, so a joint's parent always comes before it
+struct Skeleton {
+        std::vector<std::string> names;
+        std::vector<int32_t> parents;  // -1 for the root
+        // node transforms decomposed once, used by joints that have no keys
+        std::vector<glm::vec3> bindTranslations;
+        std::vector<glm::quat> bindRotations;
+        std::vector<glm::vec3> bindScales;
+        glm::mat4 rootInverse{1.0};
+        std::unordered_map<std::string, int32_t> jointIndices;  // only for name lookups at setup time
+
+        void build(const aiNode* root);
+        // -1 when there is no node with that name, duplicated names resolve to the last one
+        int32_t getJointIndex(const std::string& name) const;
+        size_t size() const;
+};
+
+// One key track for every joint of a skeleton in contiguous arrays, joint j owns the keys
+// [ranges[j].begin, ranges[j].begin + ranges[j].count)
+template <typename T>
+struct KeyTrack {
+        struct Range {
+                uint32_t begin = 0;
+                uint32_t count = 0;
+        };
+        std::vector<float> times;
+        std::vector<T> values;
+        std::vector<Range> ranges;
+        // per joint, the key found by the previous sample. Only a starting point for the next search
+        mutable std::vector<uint32_t> cursors;
+};
+
+struct SkinJoint {
+        int32_t joint;
+        int32_t boneId;
+        glm::mat4 offsetMatrix;
+};
+
+struct Action;
+
+// An Action resolved against a Skeleton, everything is indexed by joint
+struct CompiledAction {
+        KeyTrack<glm::vec3> translations;
+        KeyTrack<glm::quat> rotations;
+        KeyTrack<glm::vec3> scales;
+        std::vector<uint8_t> animated;       // joint has a channel in this action
+        std::vector<const Action*> sources;  // action sampled for each joint, another one for MixedActions
+        std::vector<SkinJoint> skin;         // Bonemap entries that exist in the skeleton
+        const Skeleton* skeleton = nullptr;
+};
+
+struct Action {
+        std::unordered_map<std::string, Bone*> Bonemap;
+        std::unordered_map<std::string, Action*> MixedActions;
+        double mAnimationSecond = 0.0;
+        double mAnimationDuration = 0.0;
+        bool loop = false;
+        bool hasSkining = false;
+        std::string name;
+        CompiledAction compiled;
+};
+
+// index of the first of the `count` keys in `times` after `time`, or of the last one. The search starts from `cursor`,
+// the previous result for the same track, and updates it
+uint32_t findKey(const float* times, uint32_t count, double time, uint32_t& cursor);
+
+// Resolves `action` and its MixedActions against `skeleton`, nothing is done when it already is
+void compileAction(const Skeleton& skeleton, Action& action);
+
+// Samples every joint of `skeleton` for `action` at `time` (ms) in one pass, `locals` and `globals` have to hold
+// skeleton.size() matrices. Does not allocate, `action` must be compiled against `skeleton`
+void sampleSkeleton(const Skeleton& skeleton, const Action& action, double time, std::vector<glm::mat4>& locals,
+                    std::vector<glm::mat4>& globals);
+
+// String keyed evaluation over the aiNode tree, the reference sampleSkeleton is checked against. `globals` are
+// relative to the scene root like the ones of sampleSkeleton
+void sampleReference(const aiNode* root, const Action& action, double time,
+                     std::unordered_map<std::string, glm::mat4>& locals,
+                     std::unordered_map<std::string, glm::mat4>& globals);
+
+// largest element difference between sampleSkeleton and sampleReference, `action` must be compiled against `skeleton`
+float compareWithReference(const Skeleton& skeleton, const Action& action, const aiNode* root, double time);
+
+#endif  //! WORLD_EXPLORER_SKELETON_H
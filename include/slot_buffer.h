@@ -0,0 +1,75 @@
+#ifndef WORLD_EXPLORER_SLOT_BUFFER_H
+#define WORLD_EXPLORER_SLOT_BUFFER_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dirty_slots.h"
+#include "gpu_buffer.h"
+#include "rendererResource.h"
+#include "webgpu/webgpu.h"
+
+/*
+ * Uniform data of many objects in a few shared buffers. Every object owns a slot aligned to the uniform offset
+ * alignment and binds it with an offset, so the shaders still see one struct. write() only updates the CPU copy,
+ * flush() uploads the slots written since the last flush with one queue write per coalesced range. Pages are added
+ * when the ones there are full, existing slots and the bind groups referencing them stay valid.
+ */
+class SlotBuffer {
+    public:
+        struct Slot {
+                uint32_t page = UINT32_MAX;
+                uint32_t index = 0;
+
+                bool isValid() const;
+        };
+
+        // of the last flush()
+        struct Stats {
+                size_t slotWrites = 0;
+                size_t queueWrites = 0;
+                size_t bytes = 0;
+        };
+
+        static inline const uint64_t UNIFORM_OFFSET_ALIGNMENT = 256;
+
+        SlotBuffer& setLabel(const std::string& label);
+        // `elementSize` is rounded up to UNIFORM_OFFSET_ALIGNMENT, a page holds `slotsPerPage` slots
+        void create(RendererResource* resource, uint64_t elementSize, uint32_t slotsPerPage);
+
+        Slot allocate();
+        void free(Slot& slot);
+        // `size` bytes at `offset` within the slot, uploaded by the next flush()
+        void write(const Slot& slot, const void* data, size_t size, uint64_t offset = 0);
+        void flush();
+
+        WGPUBuffer getBuffer(const Slot& slot);
+        uint64_t getOffset(const Slot& slot) const;
+        uint64_t getElementSize() const;
+        const Stats& getStats() const;
+
+    private:
+        struct Page {
+                Buffer buffer;
+                std::vector<uint8_t> data;
+                DirtySlots dirty;
+                std::vector<uint32_t> freeSlots;
+                uint32_t used = 0;  // slots handed out at least once
+        };
+
+        std::string mLabel;
+        RendererResource* mResources = nullptr;
+        uint64_t mElementSize = 0;
+        uint64_t mStride = 0;
+        uint32_t mSlotsPerPage = 0;
+        std::vector<std::unique_ptr<Page>> mPages;
+        std::vector<DirtySlots::Range> mRanges;  // reused by flush()
+        size_t mPendingWrites = 0;
+        Stats mStats;
+        std::mutex mMutex;  // models allocate and write their slots from the loader threads
+};
+
+#endif  // WORLD_EXPLORER_SLOT_BUFFER_H
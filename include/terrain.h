@@ -15,14 +15,18 @@ class TerrainModel : public Model {
         Model& load(std::string name, Application* app, const std::filesystem::path& path,
                     WGPUBindGroupLayout layout) override;
 
-        void update(Application* app, float dt, float physicSimulating = true) override;
-        void getCustomBindGroup(Application* app, WGPURenderPassEncoder encoder, Mesh& mesh) override;
+        void updateState(Application* app, float dt, float physicSimulating = true) override;
+        void writeBuffers(Application* app) override;
+        const MaterialTable::Binding& getMaterialBinding(Application* app, Mesh& mesh) override;
         Pipeline* getPipeline(Application* app) override;
 
         void drawGraph(Application* app, WGPURenderPassEncoder encoder, Node* node);
         void drawHirarchy(Application* app, WGPURenderPassEncoder encoder) override;
 
         LineGroup wireFrame;
+
+    private:
+        MaterialTable::Binding mMaterialBinding;  // custom_bindgroup, no dynamic offset
 };
 
 class Cube : public Model {
@@ -32,7 +36,7 @@ class Cube : public Model {
         Model& load(std::string name, Application* app, const std::filesystem::path& path,
                     WGPUBindGroupLayout layout) override;
 
-        void update(Application* app, float dt, float physicSimulating = true) override;
+        void writeBuffers(Application* app) override;
 
         void drawGraph(Application* app, WGPURenderPassEncoder encoder, Node* node);
         void drawHirarchy(Application* app, WGPURenderPassEncoder encoder) override;
@@ -8,6 +8,7 @@
 #include <future>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <queue>
 #include <sstream>
 #include <string>
@@ -15,7 +16,10 @@
 #include <vector>
 
 #include "../webgpu/webgpu.h"
+#include "block_compression.h"
 #include "material.h"
+#include "mip_chain.h"
+#include "mpsc_queue.h"
 #include "rendererResource.h"
 
 class Model;
@@ -27,6 +31,9 @@ class Registery;
 enum class TextureDimension { TEX_UNDEFINED, TEX_1D, TEX_2D, TEX_3D };
 
 void initializeMipmapCompute(Application* app);
+// records the mips of every texture that uploaded only level 0 since the last call into `encoder`, one compute pass
+// for all of them
+void generatePendingMipmaps(WGPUCommandEncoder encoder);
 
 class Texture {
     public:
@@ -37,7 +44,7 @@ class Texture {
 
         Texture(WGPUDevice wgpuDevice, const std::filesystem::path& path,
                 WGPUTextureFormat textureFormat = WGPUTextureFormat_RGBA8Unorm, uint32_t extent = 1,
-                size_t mipLevels = 0);
+                size_t mipLevels = 0, bool streamed = false);
 
         Texture(WGPUDevice wgpuDevice, std::vector<std::filesystem::path> paths,
                 WGPUTextureFormat textureFormat = WGPUTextureFormat_RGBA8Unorm, uint32_t extent = 1);
@@ -65,6 +72,30 @@ class Texture {
         void uploadToGPU(WGPUQueue deviceQueue);
         bool isTransparent();
         bool isValid() const;
+        // bytes of CPU side data uploadToGPU() writes
+        size_t getUploadSize() const;
+
+        // streamed textures keep the levels before getFirstResidentMip() on the CPU and the ones from it on in VRAM,
+        // starting with the mip tail. Evicted levels are read back from the GPU before they can stream in again
+        bool isStreamed() const;
+        // true once uploadToGPU() wrote the mip tail
+        bool isStreamReady() const;
+        // false while evicted levels are read back, or when a read back failed and the levels are lost
+        bool canStreamIn() const;
+        // changes whenever getTextureView() does, bind groups built with an older view have to be rebuilt
+        uint32_t getViewVersion() const;
+        uint32_t getFullMipCount() const;
+        uint32_t getFirstResidentMip() const;
+        // size of the blocks the texture is stored in on the GPU, 1x1 texels of 4 bytes unless block compressed
+        uint32_t getBlockBytes() const;
+        uint32_t getBlockSize() const;
+        // recreates the texture with the levels from `firstMip` on, the ones both textures share are copied with
+        // `encoder`, the others are written from the CPU chain. Evicted levels are copied to a read back buffer with
+        // `encoder`, mapEvictedMips() has to follow once it is submitted. Views and bind groups of the old texture go
+        // stale
+        void setResidentMip(WGPUDevice device, WGPUQueue queue, WGPUCommandEncoder encoder, uint32_t firstMip);
+        // maps the read back buffers of the submitted evictions, the levels land in the CPU chain on a later poll
+        void mapEvictedMips();
 
         // Remove the texture from the VRAM
         void Destroy();
@@ -73,9 +104,26 @@ class Texture {
 
         static std::shared_ptr<Texture> asyncLoadTexture(Registery<std::string, Texture>* registery,
                                                          RendererResource& rc, std::string path,
-                                                         const std::string& name = "");
+                                                         const std::string& name = "", bool streamed = false,
+                                                         bool srgb = false);
+
+        // set once the device was created with texture-compression-bc, otherwise KTX2 blocks are decoded on the CPU
+        static inline bool mBlockCompressionSupported = false;
+        // filter of the mips built on the loader threads, for the textures loaded afterwards
+        static inline MipFilter mMipFilter = MipFilter::Kaiser;
 
     private:
+        struct MipReadback;
+
+        // writes `level` of the full chain from mMipData
+        void writeMip(WGPUQueue queue, uint32_t level);
+        static void onMipsReadBack(WGPUMapAsyncStatus status, WGPUStringView message, void* userdata1,
+                                   void* userdata2);
+        // size of `level` of the full chain, rounded up to whole blocks
+        WGPUExtent3D levelExtent(uint32_t level) const;
+        // fills mMipData from mCompressedPath, decoding the blocks when the GPU texture is not block compressed
+        bool loadCompressedMips();
+
         std::string mLabel;
         std::filesystem::path mPath;
         WGPUTexture mTexture;
@@ -83,8 +131,20 @@ class Texture {
         WGPUTextureView mArrayTextureView = nullptr;
         WGPUTextureDescriptor mDescriptor;
         std::vector<std::vector<uint8_t>> mBufferData;
+        // full chain built on the CPU, a streamed texture only keeps the levels that are not resident
+        std::vector<std::vector<uint8_t>> mMipData;
+        std::vector<MipReadback*> mReadbacks;  // evictions whose levels are not back in mMipData yet
+        bool mIsStreamed = false;
+        bool mIsStreamReady = false;
+        bool mLostMips = false;
+        uint32_t mViewVersion = 0;
+        uint32_t mFullMipCount = 1;
+        uint32_t mFirstResidentMip = 0;
+        std::filesystem::path mCompressedPath;    // KTX2 baked by the exporter, empty when there is none
+        std::optional<bc::Format> mBlockFormat;  // set when the GPU texture holds the blocks as they are
         bool mIsTextureAlive = false;  // Indicate whether the texure is still valid on VRAM or not
         bool mHasAlphaChannel = false;
+        bool mIsSrgb = false;  // color data, its mips are filtered in linear light
         size_t mWidth = 0;
         size_t mHeight = 0;
 };
@@ -106,14 +166,20 @@ class TextureLoader {
                                                         std::shared_ptr<Texture> baseTexture,
                                                         std::function<void(TextureLoader*, LoadRequest*)> cb,
                                                         void* userData = nullptr);
+        // thread safe, called by the workers when the CPU side of a texture is ready
         void addToUploadQueue(TextureLoader::LoadRequest&& request);
-        void fetchQueue();
+        // uploads ready textures until `budgetBytes` are written, always at least one so a texture larger than the
+        // budget still goes through. Main thread only
+        void fetchQueue(size_t budgetBytes = UPLOAD_BUDGET_BYTES);
         WGPUDevice device;
 
+        static inline const size_t UPLOAD_BUDGET_BYTES = 16 * 1024 * 1024;
+
     private:
         std::vector<std::thread> workers;
         std::queue<LoadRequest> requests;
-        std::queue<LoadRequest> uploadQueue;
+        MpscQueue<LoadRequest> uploadQueue;
+        std::optional<LoadRequest> mDeferredUpload;  // popped but over the budget of its frame
         std::mutex queueMutex;
         std::condition_variable cv;
         bool shouldTerminate = false;
@@ -0,0 +1,44 @@
+#ifndef WORLD_EXPLORER_TEXTURE_BIND_GROUPS_H
+#define WORLD_EXPLORER_TEXTURE_BIND_GROUPS_H
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "webgpu/webgpu.h"
+
+/*
+ * The texture bind groups of the meshes, one per distinct set of diffuse, roughness and normal views instead of one
+ * per mesh. Meshes without own textures all share the group of the default views, so do meshes sharing a material.
+ * A group is released with its last mesh. Acquired from the loader threads.
+ */
+class TextureBindGroups {
+    public:
+        using Views = std::array<WGPUTextureView, 3>;
+
+        // `entries` are the three texture entries of `layout`
+        WGPUBindGroup acquire(WGPUDevice device, WGPUBindGroupLayout layout,
+                              const std::vector<WGPUBindGroupEntry>& entries);
+        // `group` is set to nullptr
+        void release(WGPUBindGroup& group);
+
+        size_t getCount();
+        size_t getReferenceCount();
+
+    private:
+        struct Entry {
+                WGPUBindGroup group = nullptr;
+                uint32_t references = 0;
+        };
+
+        // the views are referenced by their entry, so a freed view can not come back under the same handle
+        std::map<Views, Entry> mGroups;
+        std::unordered_map<WGPUBindGroup, Views> mViews;
+        size_t mReferences = 0;
+        std::mutex mMutex;
+};
+
+#endif  // WORLD_EXPLORER_TEXTURE_BIND_GROUPS_H
@@ -0,0 +1,40 @@
+#ifndef WEBGPUTEST_TEXTURE_STREAMER_H
+#define WEBGPUTEST_TEXTURE_STREAMER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include "texture_residency.h"
+
+class Application;
+class Texture;
+
+/*
+ * Streams the mips of the model textures in and out of VRAM. Every frame the textures of the models in view are
+ * requested at the level matching their screen size, the residency plans the changes under the VRAM budget and the
+ * touched textures are recreated at their new size. Meshes pick up the new views through Model::getTextureBindGroup.
+ */
+class TextureStreamer {
+    public:
+        explicit TextureStreamer(size_t budgetBytes = DEFAULT_BUDGET_BYTES);
+
+        // has to run before the frame records draws, the views of recreated textures change
+        void update(Application* app);
+
+        TextureResidency& getResidency();
+
+        static inline const size_t DEFAULT_BUDGET_BYTES = 512ull * 1024 * 1024;
+        static inline const size_t UPLOAD_BYTES_PER_FRAME = 16 * 1024 * 1024;
+
+    private:
+        TextureResidency mResidency;
+        // owner based, an expired entry never matches a new texture at the same address
+        std::map<std::weak_ptr<Texture>, TextureResidency::Handle, std::owner_less<>> mHandles;
+        std::unordered_map<TextureResidency::Handle, std::weak_ptr<Texture>> mTextures;
+        uint64_t mFrame = 0;
+};
+
+#endif  // WEBGPUTEST_TEXTURE_STREAMER_H
@@ -0,0 +1,41 @@
+#ifndef WORLD_EXPLORER_TRANSFORM_HIERARCHY_H
+#define WORLD_EXPLORER_TRANSFORM_HIERARCHY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+/*
+ * Transforms of a node tree flattened so a parent is always stored before its children. Local and world matrices
+ * live in contiguous arrays, setLocal() only flags the node and update() recomputes the flagged subtrees in one
+ * sweep in storage order. A world transform is the one of its parent times its local, like Node::getGlobalTransform
+ */
+class TransformHierarchy {
+    public:
+        // `parent` has to be added already, -1 for a root. Returns the index of the node
+        int32_t add(int32_t parent, const glm::mat4& local);
+        void clear();
+
+        void setLocal(int32_t node, const glm::mat4& local);
+        const glm::mat4& getLocal(int32_t node) const;
+        // as of the last update()
+        const glm::mat4& getWorld(int32_t node) const;
+        int32_t getParent(int32_t node) const;
+        size_t size() const;
+        bool isDirty() const;
+
+        // returns the number of recomputed world transforms
+        size_t update();
+
+    private:
+        std::vector<int32_t> mParents;
+        std::vector<glm::mat4> mLocals;
+        std::vector<glm::mat4> mWorlds;
+        std::vector<uint8_t> mDirty;
+        size_t mFirstDirty = std::numeric_limits<size_t>::max();  // nothing before it has to be visited
+};
+
+#endif  // WORLD_EXPLORER_TRANSFORM_HIERARCHY_H
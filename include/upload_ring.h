@@ -0,0 +1,85 @@
+#ifndef WORLD_EXPLORER_UPLOAD_RING_H
+#define WORLD_EXPLORER_UPLOAD_RING_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "rendererResource.h"
+#include "staging_ring.h"
+#include "webgpu/webgpu.h"
+
+/*
+ * Staging memory behind Buffer::queueWrite. Writes are copied into mapped MapWrite blocks and turned into
+ * CopyBufferToBuffer commands, flush() unmaps the blocks and submits all copies in one command buffer. A submitted
+ * block is mapped again right away and can be reused as soon as the mapping completes, that is when the GPU is done
+ * with the frame that used it. Writes that can not be copied (unaligned, bigger than a block or no free block) are
+ * kept aside and go to wgpuQueueWriteBuffer in flush(), between the copies queued before and after them, so all
+ * writes land in order and only flush() submits. copy() queues a buffer to buffer copy in the same order, so a buffer
+ * can be moved while writes to it are still staged.
+ */
+class UploadRing {
+    public:
+        static inline const uint64_t BLOCK_SIZE = 4 * 1024 * 1024;
+        static inline const uint32_t MAX_BLOCKS = 16;
+        static inline const uint64_t COPY_ALIGNMENT = 4;
+
+        // of the last finished frame
+        struct Stats {
+                size_t writes = 0;
+                size_t bytes = 0;
+                size_t copies = 0;
+                size_t directWrites = 0;  // went to wgpuQueueWriteBuffer
+                size_t submits = 0;
+        };
+
+        explicit UploadRing(RendererResource* resource);
+
+        void write(WGPUBuffer destination, uint64_t offset, const void* data, size_t size);
+        // both buffers are kept alive until the copy is recorded
+        void copy(WGPUBuffer source, uint64_t sourceOffset, WGPUBuffer destination, uint64_t destinationOffset,
+                  uint64_t size);
+        // has to run before every submit that may read the written buffers
+        void flush();
+        // flushes and starts counting the next frame
+        void endFrame();
+
+        const Stats& getStats() const;
+        uint32_t getBlockCount();
+        uint32_t getInFlightCount();
+
+    private:
+        struct Block {
+                WGPUBuffer buffer = nullptr;
+                uint8_t* mapped = nullptr;
+        };
+
+        // a deferred direct write when neither `block` nor `source` is set, `blockOffset` is into mDeferred then
+        struct Copy {
+                WGPUBuffer destination;
+                uint64_t destinationOffset;
+                uint32_t block;
+                uint64_t blockOffset;  // or the offset into `source`
+                uint64_t size;
+                WGPUBuffer source = nullptr;  // a staging block when not set
+        };
+
+        void flushLocked();
+        static void onBlockMapped(WGPUMapAsyncStatus status, WGPUStringView message, void* userdata1,
+                                  void* userdata2);
+
+        RendererResource* mResources;
+        StagingRing mRing;
+        std::vector<Block> mBlocks;
+        std::vector<Copy> mCopies;
+        std::vector<uint8_t> mDeferred;  // data of the direct writes until flush()
+        std::vector<uint32_t> mSubmitted;  // reused by flush()
+        uint64_t mFrame = 0;
+        Stats mCounting;
+        Stats mStats;
+        // models upload from the loader threads, a map callback may fire inside the submit of flush(). Only the thread
+        // calling flush() or endFrame() submits
+        std::recursive_mutex mMutex;
+};
+
+#endif  // WORLD_EXPLORER_UPLOAD_RING_H
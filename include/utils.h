@@ -106,6 +106,9 @@ enum class VertexStepMode {
 struct VertexBufferLayout {
         VertexBufferLayout& addAttribute(uint64_t offset, uint32_t location, WGPUVertexFormat format);
         WGPUVertexBufferLayout configure(uint64_t arrayStride, VertexStepMode stepMode);
+        // layouts of PackedVertex and PackedSkin, matching PackedVertexInput in vertex_packing.wgsl
+        WGPUVertexBufferLayout configurePackedVertex();
+        WGPUVertexBufferLayout configurePackedSkin();
 
         // Getters
         WGPUVertexBufferLayout getLayout();
@@ -135,6 +138,8 @@ std::pair<bool, glm::vec3> testIntersectionWithBox(Camera& camera, size_t width,
                                                    const glm::vec3& max);
 // Terrain generateTerrainVertices(size_t gridSize);
 std::vector<glm::vec4> generateAABBLines(const glm::vec3& min, const glm::vec3& max);
+// axis aligned box enclosing the box [min, max] after `transform`
+std::pair<glm::vec3, glm::vec3> transformAABB(const glm::mat4& transform, const glm::vec3& min, const glm::vec3& max);
 std::vector<glm::vec4> generateCone();
 std::vector<glm::vec4> generateBox(const glm::vec3& center = {0, 0, 0}, const glm::vec3& halfExtents = {1.0, 1.0, 1.0});
 std::vector<glm::vec4> generateSphere(uint8_t numLong = 16, uint8_t numLat = 12, uint8_t numLongSegments = 8);
@@ -77,6 +77,7 @@ struct ObjectLoaderParam {
         std::string defaultClip;
         bool isDefaultActor = false;
         bool isPhysicEnabled = false;
+        bool packedVertices = false;
         MaterialList materialList;
         MaterialPropsMap matPropMap;
 
@@ -1,6 +1,6 @@
 
 struct VertexOutput {
-    @builtin(position) position: vec4f,
+    @builtin(position) @invariant position: vec4f,
     @location(5) shadowPos: vec4f,
     @location(0) color: vec3f,
     @location(1) normal: vec3f,
@@ -28,6 +28,34 @@ struct VertexInput {
     @location(7) boneWeights: vec4f,
 };
 
+#include "vertex_packing.wgsl"
+
+fn unpackVertex(in: PackedVertexInput) -> VertexInput {
+    var out: VertexInput;
+    out.position = in.position;
+    out.normal = octDecode(in.normal);
+    out.color = in.color.xyz;
+    out.tangent = octDecode(in.tangent);
+    out.biTangent = cross(out.normal, out.tangent) * bitangentSign(in.color);
+    out.uv = in.uv;
+    out.boneIds = vec4i(in.boneIds);
+    out.boneWeights = in.boneWeights;
+    return out;
+}
+
+fn unpackStaticVertex(in: PackedStaticVertexInput) -> VertexInput {
+    var out: VertexInput;
+    out.position = in.position;
+    out.normal = octDecode(in.normal);
+    out.color = in.color.xyz;
+    out.tangent = octDecode(in.tangent);
+    out.biTangent = cross(out.normal, out.tangent) * bitangentSign(in.color);
+    out.uv = in.uv;
+    out.boneIds = vec4i(0);
+    out.boneWeights = vec4f(1.0, 0.0, 0.0, 0.0);
+    return out;
+}
+
 
 struct MyUniform {
     projectionMatrix: mat4x4f,
@@ -93,6 +121,13 @@ struct WindParams {
     heightFactor: f32,
 };
 
+// what a mesh draw reads besides its material, bound with a dynamic offset next to the material table
+struct DrawData {
+    materialIndex: u32,
+    meshIdx: i32,
+    windParams: WindParams,
+};
+
 struct OffsetData {
     transformation: mat4x4f,
     minAABB: vec4f,
@@ -100,6 +135,17 @@ struct OffsetData {
     windParams: WindParams,
 };
 
+// light clusters of the main camera, see LightClusters on the cpu side
+struct ClusterParams {
+    tilesX: u32,
+    tilesY: u32,
+    slices: u32,
+    maxLightsPerCluster: u32,
+    screenSize: vec2f,
+    zNear: f32,
+    sliceScale: f32,
+};
+
 struct MeshTransformations {
     global: array<mat4x4f>,
 };
@@ -110,13 +156,16 @@ struct MeshTransformations {
 @group(0) @binding(1) var<uniform> lightCount: i32;
 @group(0) @binding(2) var textureSampler: sampler;
 @group(0) @binding(3) var<uniform> lightingInfos: LightingUniforms;
-@group(0) @binding(4) var<uniform> pointLight: array<PointLight,10>;
+@group(0) @binding(4) var<storage, read> pointLight: array<PointLight>;
 @group(0) @binding(5) var<uniform> numOfCascades: u32;
 @group(0) @binding(6) var depth_texture: texture_depth_2d_array;
 @group(0) @binding(7) var<uniform> lightSpaceTrans: array<Scene, 5>;
 @group(0) @binding(8) var shadowMapSampler: sampler_comparison;
 @group(0) @binding(9) var<storage, read> offsetInstance: array<OffsetData>;
 @group(0) @binding(10) var<uniform> time: f32;
+@group(0) @binding(11) var<uniform> clusterParams: ClusterParams;
+@group(0) @binding(12) var<storage, read> clusterGrid: array<vec2u>;
+@group(0) @binding(13) var<storage, read> clusterLightIndices: array<u32>;
 
 @group(1) @binding(0) var<uniform> objectTranformation: ObjectInfo;
 @group(1) @binding(1) var<uniform> bonesFinalTransform: array<mat4x4f, 100>;
@@ -149,3 +198,14 @@ fn calculateShadow(fragPosLightSpace: vec4f, distance: f32, cascadeIdx: u32) ->
     return shadow;
 }
 
+
+// cluster of a fragment of the main camera, frag coords grow downwards while the tiles grow upwards
+fn clusterIndex(fragCoord: vec2f, viewDepth: f32) -> u32 {
+    let tiles = vec2u(clusterParams.tilesX, clusterParams.tilesY);
+    let tile = min(vec2u(fragCoord / clusterParams.screenSize * vec2f(tiles)), tiles - vec2u(1u));
+    var slice = 0u;
+    if viewDepth > clusterParams.zNear {
+        slice = min(u32(log(viewDepth / clusterParams.zNear) * clusterParams.sliceScale), clusterParams.slices - 1u);
+    }
+    return (slice * clusterParams.tilesY + (clusterParams.tilesY - 1u - tile.y)) * clusterParams.tilesX + tile.x;
+}
@@ -0,0 +1,71 @@
+#include "common.wgsl"
+
+// Depth prepass for foliage, texels the PBR pass would discard must not leave depth behind
+
+@group(2) @binding(0) var diffuse_map: texture_2d<f32>;
+
+@group(3) @binding(0) var<uniform> myuniformindex: u32;
+
+@group(5) @binding(0) var<storage, read> visible_instances_indices: array<u32>;
+
+@group(6) @binding(0) var<storage, read> materials: array<Material>;
+@group(6) @binding(1) var<uniform> drawData: DrawData;
+
+#include "world_position.wgsl"
+
+struct PositionInput {
+    @location(0) position: vec3f,
+    @location(5) uv: vec2f,
+    @location(6) boneIds: vec4i,
+    @location(7) boneWeights: vec4f,
+};
+
+struct PackedPositionInput {
+    @location(0) position: vec3f,
+    @location(5) uv: vec2f,
+    @location(6) boneIds: vec4u,
+    @location(7) boneWeights: vec4f,
+};
+
+struct PackedStaticPositionInput {
+    @location(0) position: vec3f,
+    @location(5) uv: vec2f,
+};
+
+struct DepthOutput {
+    @builtin(position) @invariant position: vec4f,
+    @location(0) uv: vec2f,
+};
+
+fn depthMain(position: vec3f, uv: vec2f, boneIds: vec4i, boneWeights: vec4f, instance_index: u32) -> DepthOutput {
+    var out: DepthOutput;
+    let world_position = worldPosition(position, boneIds, boneWeights, meshPlacement(instance_index));
+    let view_space_pos = uMyUniform[myuniformindex].viewMatrix * world_position;
+    out.position = uMyUniform[myuniformindex].projectionMatrix * view_space_pos;
+    out.uv = uv;
+    return out;
+}
+
+@vertex
+fn vs_main(in: PositionInput, @builtin(instance_index) instance_index: u32) -> DepthOutput {
+    return depthMain(in.position, in.uv, in.boneIds, in.boneWeights, instance_index);
+}
+
+@vertex
+fn vs_main_packed(in: PackedPositionInput, @builtin(instance_index) instance_index: u32) -> DepthOutput {
+    return depthMain(in.position, in.uv, vec4i(in.boneIds), in.boneWeights, instance_index);
+}
+
+@vertex
+fn vs_main_packed_static(in: PackedStaticPositionInput, @builtin(instance_index) instance_index: u32) -> DepthOutput {
+    return depthMain(in.position, in.uv, vec4i(0), vec4f(1.0, 0.0, 0.0, 0.0), instance_index);
+}
+
+// same cut as fs_main in shader.wgsl
+@fragment
+fn fs_main(in: DepthOutput) {
+    let alpha = textureSample(diffuse_map, textureSampler, in.uv * materials[drawData.materialIndex].uvMultiplier.xy).a;
+    if (materials[drawData.materialIndex].materialProps & (1u << 0u)) != 0u && alpha < 0.001 {
+        discard;
+    }
+}
@@ -0,0 +1,35 @@
+// Hi-Z pyramid of the depth prepass, same reduction as HiZPyramid::build. Every texel keeps the farthest depth below
+// it, the last texel of a row or column also takes the odd one left over so no depth is lost.
+
+@group(0) @binding(0) var depthTexture: texture_depth_2d;
+@group(0) @binding(1) var baseLevel: texture_storage_2d<r32float, write>;
+
+@compute @workgroup_size(8, 8)
+fn copyDepth(@builtin(global_invocation_id) id: vec3u) {
+    let size = textureDimensions(baseLevel);
+    if (id.x >= size.x || id.y >= size.y) {
+        return;
+    }
+    textureStore(baseLevel, id.xy, vec4f(textureLoad(depthTexture, id.xy, 0), 0.0, 0.0, 0.0));
+}
+
+@group(0) @binding(2) var srcLevel: texture_2d<f32>;
+@group(0) @binding(3) var dstLevel: texture_storage_2d<r32float, write>;
+
+@compute @workgroup_size(8, 8)
+fn reduceLevel(@builtin(global_invocation_id) id: vec3u) {
+    let dst_size = textureDimensions(dstLevel);
+    if (id.x >= dst_size.x || id.y >= dst_size.y) {
+        return;
+    }
+    let src_size = textureDimensions(srcLevel);
+    let last = select(min(2u * id.xy + 1u, src_size - 1u), src_size - 1u, id.xy == dst_size - 1u);
+
+    var farthest = 0.0;
+    for (var y = 2u * id.y; y <= last.y; y++) {
+        for (var x = 2u * id.x; x <= last.x; x++) {
+            farthest = max(farthest, textureLoad(srcLevel, vec2u(x, y), 0).r);
+        }
+    }
+    textureStore(dstLevel, id.xy, vec4f(farthest, 0.0, 0.0, 0.0));
+}
@@ -11,9 +11,10 @@
 
 @group(5) @binding(0) var<storage, read> visible_instances_indices: array<u32>;
 
-@group(6) @binding(0) var<uniform> meshMaterial: Material;
-@group(6) @binding(1) var<uniform> meshIdx: i32;
-@group(6) @binding(2) var<uniform> windParams: WindParams;
+@group(6) @binding(0) var<storage, read> materials: array<Material>;
+@group(6) @binding(1) var<uniform> drawData: DrawData;
+
+#include "world_position.wgsl"
 
 const PI: f32 = 3.141592653589793;
 
@@ -33,37 +34,14 @@ fn decideColor(default_color: vec3f, is_flat: i32, Y: f32) -> vec3f {
 }
 
 
-@vertex
-fn vs_main(in: VertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {
+fn vertexMain(in: VertexInput, instance_index: u32) -> VertexOutput {
     var out: VertexOutput;
-    let off_id: u32 = objectTranformation.offsetId * 100000;
-    var transform: mat4x4f;
-    var wind_params: WindParams;
-
-    if instance_index != 0 {
-        //let original_instance_idx = visible_instances_indices[off_id + instance_index];
-        transform = offsetInstance[instance_index + off_id].transformation * meshTransformation.global[meshIdx];
-        wind_params = offsetInstance[instance_index + off_id].windParams;
-    } else {
-        transform = objectTranformation.transformations * meshTransformation.global[meshIdx];
-        wind_params = windParams;
-    }
+    let placement = meshPlacement(instance_index);
+    let transform = placement.transform;
 
-    var world_position: vec4f;
     if objectTranformation.isAnimated == 0u {
-
-        world_position = transform * vec4f(in.position, 1.0);
         out.normal = (transform * vec4f(in.normal, 0.0f)).xyz;
     } else {
-
-        var skinned_position = vec4f(0.0, 0.0, 0.0, 0.0);
-        skinned_position += bonesFinalTransform[in.boneIds.x] * vec4f(in.position, 1.0) * in.boneWeights.x;
-        skinned_position += bonesFinalTransform[in.boneIds.y] * vec4f(in.position, 1.0) * in.boneWeights.y;
-        skinned_position += bonesFinalTransform[in.boneIds.z] * vec4f(in.position, 1.0) * in.boneWeights.z;
-        skinned_position += bonesFinalTransform[in.boneIds.w] * vec4f(in.position, 1.0) * in.boneWeights.w;
-
-        world_position = transform * skinned_position;
-
         var skinned_normal = vec4f(0.0, 0.0, 0.0, 0.0);
         skinned_normal += bonesFinalTransform[in.boneIds.x] * vec4f(in.normal, 0.0) * in.boneWeights.x;
         skinned_normal += bonesFinalTransform[in.boneIds.y] * vec4f(in.normal, 0.0) * in.boneWeights.y;
@@ -73,16 +51,7 @@ fn vs_main(in: VertexInput, @builtin(instance_index) instance_index: u32) -> Ver
         out.normal = (transform * skinned_normal).xyz;
     }
 
-    let height_factor = pow(clamp(world_position.z / wind_params.heightFactor, 0.0, 1.0), 2.0);
-    let phase = world_position.x * 0.8 + world_position.y * 0.6;
-    let wave = sin(f32(time) * 2.5 + phase) * 1.0 + sin(f32(time) * 3.7 + phase * 1.4) * 0.3 + sin(f32(time) * 7.1 + phase * 2.8) * 0.08;
-
-    world_position += vec4(
-        wave * wind_params.strength * height_factor,
-        0.0,
-        0.0,
-        0.0
-    );
+    let world_position = worldPosition(in.position, in.boneIds, in.boneWeights, placement);
 
     out.viewSpacePos = uMyUniform[myuniformindex].viewMatrix * world_position;
     out.position = uMyUniform[myuniformindex].projectionMatrix * out.viewSpacePos;
@@ -111,11 +80,26 @@ fn vs_main(in: VertexInput, @builtin(instance_index) instance_index: u32) -> Ver
     // if length(out.viewSpacePos) > ElapsedTime { index = 1;}
     out.shadowPos = lightSpaceTrans[index].projection * lightSpaceTrans[index].view * world_position;
     out.shadowIdx = index;
-    out.materialProps = meshMaterial.materialProps;
-    out.userSpecular = meshMaterial.metallicness;
+    out.materialProps = materials[drawData.materialIndex].materialProps;
+    out.userSpecular = materials[drawData.materialIndex].metallicness;
     return out;
 }
 
+@vertex
+fn vs_main(in: VertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {
+    return vertexMain(in, instance_index);
+}
+
+@vertex
+fn vs_main_packed(in: PackedVertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {
+    return vertexMain(unpackVertex(in), instance_index);
+}
+
+@vertex
+fn vs_main_packed_static(in: PackedStaticVertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {
+    return vertexMain(unpackStaticVertex(in), instance_index);
+}
+
 
 
 fn calculateSpotLight(light: PointLight, N: vec3f, V: vec3f, pos: vec3f, albedo: vec3f, roughness: f32, metallic: f32, F0: vec3f) -> vec3f {
@@ -181,6 +165,15 @@ fn fresnelSchlick(cosTheta: f32, F0: vec3f) -> vec3f {
 }
 
 
+fn calculateLight(light: PointLight, N: vec3f, V: vec3f, pos: vec3f, albedo: vec3f, roughness: f32, metallic: f32, F0: vec3f) -> vec3f {
+    if light.ftype == 3i {
+        return calculatePointLight(light, N, V, pos, albedo, roughness, metallic, F0);
+    } else if light.ftype == 2i {
+        return calculateSpotLight(light, N, V, pos, albedo, roughness, metallic, F0);
+    }
+    return vec3f(0.0);
+}
+
 fn distributionGGX(N: vec3f, H: vec3f, roughness: f32) -> f32 {
     let a = roughness * roughness;
     let a2 = a * a ;
@@ -224,7 +217,7 @@ fn fs_main(in: VertexOutput) -> @location(0) vec4f {
     }
     var shadowPos = lightSpaceTrans[cascadeIndex].projection * lightSpaceTrans[cascadeIndex].view * vec4f(in.worldPos, 1.0);
 
-    let uv = in.uv * meshMaterial.uvMultiplier.xy;
+    let uv = in.uv * materials[drawData.materialIndex].uvMultiplier.xy;
     let d = dot(in.worldPos, clipping_plane.xyz) + clipping_plane.w;
     if d > 0.0 {
 	    discard;
@@ -244,7 +237,9 @@ fn fs_main(in: VertexOutput) -> @location(0) vec4f {
     var metallic = material.b;
 
 
-    var normal = textureSample(normal_map, textureSampler, uv).rgb * 2.0 - 1.0;
+    // z is rebuilt from xy, BC5 normal maps only store two channels
+    let normal_xy = textureSample(normal_map, textureSampler, uv).rg * 2.0 - 1.0;
+    var normal = vec3f(normal_xy, sqrt(max(0.0, 1.0 - dot(normal_xy, normal_xy))));
     //normal = normal * 2.0 - 1.0;
     //let TBN = mat3x3f(normalize(in.tangent), normalize(in.biTangent), normalize(in.normal));
 
@@ -287,12 +282,16 @@ fn fs_main(in: VertexOutput) -> @location(0) vec4f {
 
     ////////////// Calculations for point lights
 
-    for (var i = 0u; i < u32(lightCount); i += 1u) {
-        let light = pointLight[i];
-        if light.ftype == 3i {
-            lo += calculatePointLight(light, N, V, in.worldPos, albedo, roughness, metallic, F0);
-        } else if light.ftype == 2i {
-            lo += calculateSpotLight(light, N, V, in.worldPos, albedo, roughness, metallic, F0);
+    if myuniformindex == 0u {
+        // main camera: only the lights binned into this fragment's cluster
+        let cluster = clusterGrid[clusterIndex(in.position.xy, -in.viewSpacePos.z)];
+        for (var i = 0u; i < cluster.y; i += 1u) {
+            let light = pointLight[clusterLightIndices[cluster.x + i]];
+            lo += calculateLight(light, N, V, in.worldPos, albedo, roughness, metallic, F0);
+        }
+    } else {
+        for (var i = 0u; i < u32(lightCount); i += 1u) {
+            lo += calculateLight(pointLight[i], N, V, in.worldPos, albedo, roughness, metallic, F0);
         }
     }
 
@@ -329,7 +328,7 @@ fn fs_main(in: VertexOutput) -> @location(0) vec4f {
 
     var color = ambient + lo;
 
-    if meshMaterial.isFlat == 1u {
+    if materials[drawData.materialIndex].isFlat == 1u {
         color = vec3f(100.0, 100.0, 100.0);
     }
 
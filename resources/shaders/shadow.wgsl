@@ -17,6 +17,8 @@ struct Vertex {
     @location(7) boneWeights: vec4f,
 };
 
+#include "vertex_packing.wgsl"
+
 struct VSOutput {
     @builtin(position) position: vec4f,
     @location(0) uv: vec2f,
@@ -53,6 +55,12 @@ struct Material {
     uvMultiplier: vec3f,
 }
 
+struct DrawData {
+    materialIndex: u32,
+    meshIdx: i32,
+    windParams: WindParams,
+};
+
 struct MeshTransformations {
     global: array<mat4x4f>,
 };
@@ -79,13 +87,11 @@ struct MeshTransformations {
 
 @group(4) @binding(0) var<uniform> sceneIndex: u32;
 
-@group(5) @binding(0) var<uniform> meshMaterial: Material;
-@group(5) @binding(1) var<uniform> meshIdx: i32;
-@group(5) @binding(2) var<uniform> windParams: WindParams;
+@group(5) @binding(0) var<storage, read> materials: array<Material>;
+@group(5) @binding(1) var<uniform> drawData: DrawData;
 
 
-@vertex
-fn vs_main(vertex: Vertex) -> VSOutput {
+fn vertexMain(vertex: Vertex) -> VSOutput {
 
     let off_id: u32 = objectTranformation.offsetId * 100000;
 
@@ -93,9 +99,9 @@ fn vs_main(vertex: Vertex) -> VSOutput {
     if vertex.instance_index != 0 {
         let original_instance_idx = visible_instances_indices[off_id + vertex.instance_index];
         // transform = offsetInstance[original_instance_idx + off_id].transformation;
-        transform = offsetInstance[off_id + vertex.instance_index].transformation * meshTransformation.global[meshIdx];
+        transform = offsetInstance[off_id + vertex.instance_index].transformation * meshTransformation.global[drawData.meshIdx];
     } else {
-        transform = objectTranformation.transformations * meshTransformation.global[meshIdx];
+        transform = objectTranformation.transformations * meshTransformation.global[drawData.meshIdx];
     }
 
 
@@ -118,12 +124,12 @@ fn vs_main(vertex: Vertex) -> VSOutput {
         world_position = transform * bone_matrix * vec4f(vertex.position, 1.0);
     }
 
-    let height_factor = pow(clamp(world_position.z / windParams.heightFactor, 0.0, 1.0), 2.0);
+    let height_factor = pow(clamp(world_position.z / drawData.windParams.heightFactor, 0.0, 1.0), 2.0);
     let phase = world_position.x * 0.8 + world_position.y * 0.6;
     let wave = sin(f32(time) * 2.5 + phase) * 1.0 + sin(f32(time) * 3.7 + phase * 1.4) * 0.3 + sin(f32(time) * 7.1 + phase * 2.8) * 0.08;
 
     world_position += vec4(
-        wave * windParams.strength * height_factor,
+        wave * drawData.windParams.strength * height_factor,
         0.0,
         0.0,
         0.0
@@ -136,6 +142,34 @@ fn vs_main(vertex: Vertex) -> VSOutput {
     return vsOut;
 }
 
+@vertex
+fn vs_main(vertex: Vertex) -> VSOutput {
+    return vertexMain(vertex);
+}
+
+// only position, uv and skinning matter for the shadow map
+@vertex
+fn vs_main_packed(in: PackedVertexInput, @builtin(instance_index) instance_index: u32) -> VSOutput {
+    var vertex: Vertex;
+    vertex.position = in.position;
+    vertex.uv = in.uv;
+    vertex.instance_index = instance_index;
+    vertex.boneIds = vec4i(in.boneIds);
+    vertex.boneWeights = in.boneWeights;
+    return vertexMain(vertex);
+}
+
+@vertex
+fn vs_main_packed_static(in: PackedStaticVertexInput, @builtin(instance_index) instance_index: u32) -> VSOutput {
+    var vertex: Vertex;
+    vertex.position = in.position;
+    vertex.uv = in.uv;
+    vertex.instance_index = instance_index;
+    vertex.boneIds = vec4i(0);
+    vertex.boneWeights = vec4f(1.0, 0.0, 0.0, 0.0);
+    return vertexMain(vertex);
+}
+
 @fragment
 fn fs_main(in: VSOutput) -> @location(0) vec4f {
 
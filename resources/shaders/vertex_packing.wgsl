@@ -0,0 +1,31 @@
+// Packed vertex formats, see PackedVertex and PackedSkin in mesh.h
+
+struct PackedVertexInput {
+    @location(0) position: vec3f,
+    @location(1) normal: vec2f,     // octahedral
+    @location(2) color: vec4f,      // w: bitangent sign
+    @location(3) tangent: vec2f,    // octahedral
+    @location(5) uv: vec2f,
+    @location(6) boneIds: vec4u,
+    @location(7) boneWeights: vec4f,
+};
+
+struct PackedStaticVertexInput {
+    @location(0) position: vec3f,
+    @location(1) normal: vec2f,
+    @location(2) color: vec4f,
+    @location(3) tangent: vec2f,
+    @location(5) uv: vec2f,
+};
+
+fn octDecode(e: vec2f) -> vec3f {
+    var n = vec3f(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    let t = max(-n.z, 0.0);
+    n.x += select(t, -t, n.x >= 0.0);
+    n.y += select(t, -t, n.y >= 0.0);
+    return normalize(n);
+}
+
+fn bitangentSign(color: vec4f) -> f32 {
+    return select(-1.0, 1.0, color.w > 0.5);
+}
@@ -32,8 +32,7 @@ fn decideColor(default_color: vec3f, is_flat: i32, Y: f32) -> vec3f {
 
     //@location(6) boneIds: vec4i,
     //@location(7) boneWeights: vec4f,
-@vertex
-fn vs_main(in: VertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {
+fn vertexMain(in: VertexInput, instance_index: u32) -> VertexOutput {
     var out: VertexOutput;
     let off_id: u32 = objectTranformation.offsetId * 100000;
     var transform: mat4x4f;
@@ -99,6 +98,21 @@ fn vs_main(in: VertexInput, @builtin(instance_index) instance_index: u32) -> Ver
     return out;
 }
 
+@vertex
+fn vs_main(in: VertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {
+    return vertexMain(in, instance_index);
+}
+
+@vertex
+fn vs_main_packed(in: PackedVertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {
+    return vertexMain(unpackVertex(in), instance_index);
+}
+
+@vertex
+fn vs_main_packed_static(in: PackedStaticVertexInput, @builtin(instance_index) instance_index: u32) -> VertexOutput {
+    return vertexMain(unpackStaticVertex(in), instance_index);
+}
+
 fn calculateShadow(fragPosLightSpace: vec4f, distance: f32, cascadeIdx: u32) -> f32 {
 
     var projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
@@ -0,0 +1,51 @@
+// Vertex placement shared by the PBR pass and the depth prepass. The main pass tests depth for equality against the
+// prepass, so both have to run exactly this code. The including shader declares visible_instances_indices and
+// drawData.
+
+struct MeshPlacement {
+    transform: mat4x4f,
+    wind: WindParams,
+};
+
+fn meshPlacement(instance_index: u32) -> MeshPlacement {
+    var placement: MeshPlacement;
+    let off_id: u32 = objectTranformation.offsetId * 100000;
+
+    if instance_index != 0 {
+        let original_instance_idx = visible_instances_indices[off_id + instance_index];
+        placement.transform = offsetInstance[original_instance_idx + off_id].transformation * meshTransformation.global[drawData.meshIdx];
+        placement.wind = offsetInstance[original_instance_idx + off_id].windParams;
+    } else {
+        placement.transform = objectTranformation.transformations * meshTransformation.global[drawData.meshIdx];
+        placement.wind = drawData.windParams;
+    }
+    return placement;
+}
+
+fn skinnedPosition(position: vec3f, boneIds: vec4i, boneWeights: vec4f) -> vec4f {
+    if objectTranformation.isAnimated == 0u {
+        return vec4f(position, 1.0);
+    }
+    var skinned_position = vec4f(0.0, 0.0, 0.0, 0.0);
+    skinned_position += bonesFinalTransform[boneIds.x] * vec4f(position, 1.0) * boneWeights.x;
+    skinned_position += bonesFinalTransform[boneIds.y] * vec4f(position, 1.0) * boneWeights.y;
+    skinned_position += bonesFinalTransform[boneIds.z] * vec4f(position, 1.0) * boneWeights.z;
+    skinned_position += bonesFinalTransform[boneIds.w] * vec4f(position, 1.0) * boneWeights.w;
+    return skinned_position;
+}
+
+fn worldPosition(position: vec3f, boneIds: vec4i, boneWeights: vec4f, placement: MeshPlacement) -> vec4f {
+    var world_position = placement.transform * skinnedPosition(position, boneIds, boneWeights);
+
+    let height_factor = pow(clamp(world_position.z / placement.wind.heightFactor, 0.0, 1.0), 2.0);
+    let phase = world_position.x * 0.8 + world_position.y * 0.6;
+    let wave = sin(f32(time) * 2.5 + phase) * 1.0 + sin(f32(time) * 3.7 + phase * 1.4) * 0.3 + sin(f32(time) * 7.1 + phase * 2.8) * 0.08;
+
+    world_position += vec4(
+        wave * placement.wind.strength * height_factor,
+        0.0,
+        0.0,
+        0.0
+    );
+    return world_position;
+}
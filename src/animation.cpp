@@ -1,6 +1,7 @@
 
 #include "animation.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <functional>
@@ -14,11 +15,6 @@
 #include "glm/gtx/string_cast.hpp"
 #include "utils.h"
 
-glm::mat4 AiToGlm(const aiMatrix4x4& aiMat) {
-    return glm::mat4(aiMat.a1, aiMat.b1, aiMat.c1, aiMat.d1, aiMat.a2, aiMat.b2, aiMat.c2, aiMat.d2, aiMat.a3, aiMat.b3,
-                     aiMat.c3, aiMat.d3, aiMat.a4, aiMat.b4, aiMat.c4, aiMat.d4);
-}
-
 void printAnimationInfos(const std::string& name, const aiScene* scene) {
     if (scene->mAnimations != nullptr) {
         for (size_t i = 0; i < scene->mNumAnimations; i++) {
@@ -44,144 +40,6 @@ inline glm::quat assimpToGlmQuat(aiQuaternion quat) {
     return q;
 }
 
-size_t findPositionKey(double time, const Bone* bone) {
-    const auto& t = bone->channel.translations;
-    for (size_t i = 0; i < t.size(); i++) {
-        if (time < t[i].time) {
-            return i;
-        }
-    }
-    return t.size() - 1;
-}
-
-size_t findScaleKey(double time, const Bone* bone) {
-    const auto& s = bone->channel.scales;
-    for (size_t i = 0; i < s.size(); i++) {
-        if (time < s[i].time) {
-            return i;
-        }
-    }
-    return s.size() - 1;
-}
-
-size_t findRotationKey(double time, const Bone* bone) {
-    const auto& r = bone->channel.quats;
-    for (size_t i = 0; i < r.size(); ++i) {
-        if (time < r[i].time) {
-            return i;
-        }
-    }
-    return r.size() - 1;
-}
-
-static void decompose(const aiMatrix4x4& m, glm::vec3& t, glm::quat& r, glm::vec3& s) {
-    aiVector3D aiS, aiT;
-    aiQuaternion aiR;
-    m.Decompose(aiS, aiR, aiT);
-    t = glm::vec3(aiT.x, aiT.y, aiT.z);
-    r = glm::quat(aiR.w, aiR.x, aiR.y, aiR.z);
-    s = glm::vec3(aiS.x, aiS.y, aiS.z);
-}
-
-glm::vec3 calculateInterpolatedPosition(double time, const Bone* bone, const aiNode* node) {
-    glm::vec3 t;
-    glm::quat r;
-    glm::vec3 s{};
-    decompose(node->mTransformation, t, r, s);
-
-    if (!bone) {
-        return t;
-    }
-
-    if (bone->channel.translations.size() == 0) {
-        return t;
-    }
-
-    if (bone->channel.translations.size() == 1) {
-        return bone->channel.translations[0].value;
-    }
-
-    size_t pose_idx = findPositionKey(time, bone);
-    if (pose_idx == bone->channel.translations.size() - 1) {
-        auto v = bone->channel.translations[pose_idx].value;
-
-        return v;
-    }
-
-    double deltatime = bone->channel.translations[pose_idx + 1].time - bone->channel.translations[pose_idx].time;
-    double factor = (time - bone->channel.translations[pose_idx].time) / deltatime;
-    const glm::vec3& start = bone->channel.translations[pose_idx].value;
-    const glm::vec3& end = bone->channel.translations[pose_idx + 1].value;
-
-    return glm::mix(start, end, factor);
-}
-
-glm::vec3 calculateInterpolatedScale(double time, const Bone* bone, const aiNode* node) {
-    glm::vec3 t;
-    glm::quat r;
-    glm::vec3 s{};
-    decompose(node->mTransformation, t, r, s);
-
-    if (!bone) {
-        return s;
-    }
-
-    auto& scales = bone->channel.scales;
-    if (scales.size() == 0) {
-        return glm::vec3(1.0f);  // default scale
-    }
-
-    if (scales.size() == 1) {
-        return scales[0].value;
-    }
-
-    size_t pose_idx = findScaleKey(time, bone);
-    if (pose_idx == scales.size() - 1) {
-        return scales[pose_idx].value;
-    }
-
-    double deltatime = scales[pose_idx + 1].time - scales[pose_idx].time;
-    double factor = (time - scales[pose_idx].time) / deltatime;
-    const glm::vec3& start = scales[pose_idx].value;
-    const glm::vec3& end = scales[pose_idx + 1].value;
-    return glm::mix(start, end, factor);
-}
-
-glm::quat CalcInterpolatedRotation(double time, const Bone* bone, const aiNode* node) {
-    glm::vec3 t;
-    glm::quat r{};
-    glm::vec3 s;
-    decompose(node->mTransformation, t, r, s);
-
-    if (!bone) {
-        return r;
-    }
-
-    auto& quats = bone->channel.quats;
-    if (quats.size() == 0) {
-        return r;
-    }
-
-    if (quats.size() == 1) {
-        return quats[0].value;
-    }
-
-    unsigned int idx = findRotationKey(time, bone);
-    if (idx == quats.size() - 1) {
-        auto v = quats[idx].value;
-        // std::cout << "here " << glm::to_string(v) << std::endl;
-        return v;
-    }
-
-    double deltaTime = quats[idx + 1].time - quats[idx].time;
-    double factor = (time - quats[idx].time) / deltaTime;
-    auto start = quats[idx].value;
-    auto end = quats[idx + 1].value;
-    glm::quat out = glm::slerp(start, end, (float)factor);
-
-    return out;
-}
-
 aiMatrix4x4 GetGlobalTransform(aiNode* node) {
     aiMatrix4x4 transform = node->mTransformation;
     aiNode* parent = node->mParent;
@@ -193,68 +51,26 @@ aiMatrix4x4 GetGlobalTransform(aiNode* node) {
     return transform;
 }
 
-extern bool runBlenTest;
-extern std::map<std::string, Action*> selectedanimation;
-
-glm::mat4 Animation::getLocalTransformAtTime(const aiNode* node, double time) {
-    const Bone* bone = nullptr;
-
-    Action* action = getActiveAction();
-    double newtime = time;
-
-    if (action->MixedActions.size() > 0 && action->MixedActions.count(node->mName.C_Str()) > 0) {
-        action = action->MixedActions[node->mName.C_Str()];
-        if (newtime >= action->mAnimationDuration * 1000.0f) {
-            newtime = std::fmod(newtime, action->mAnimationDuration * 1000.0f);
-        }
-    }
-
-    // if (runBlenTest && selectedanimation.count(node->mName.C_Str()) > 0) {
-    //     action = selectedanimation[node->mName.C_Str()];
-    //     if (newtime >= action->mAnimationDuration * 1000.0f) {
-    //         newtime = std::fmod(newtime, action->mAnimationDuration * 1000.0f);
-    //     }
-    // }
-    // if (action == nullptr) {
-    //     action = getActiveAction();
-    //     newtime = time;
-    // }
-
-    // auto* action = getActiveAction();
-    if (action->Bonemap.contains(node->mName.C_Str())) {
-        bone = action->Bonemap[node->mName.C_Str()];
+float Animation::compareWithReference(const aiNode* root) {
+    auto* action = getActiveAction();
+    if (action == nullptr || root == nullptr) {
+        return 0.0f;
     }
-
-    glm::vec3 pos = calculateInterpolatedPosition(newtime, bone, node);
-    glm::quat rotation = CalcInterpolatedRotation(newtime, bone, node);
-    glm::vec3 scale = calculateInterpolatedScale(newtime, bone, node);
-
-    glm::mat4 translation_mat = glm::translate(glm::mat4(1.0f), pos);
-    glm::mat4 rotation_mat = glm::mat4(rotation);
-    glm::mat4 scale_mat = glm::scale(glm::mat4(1.0f), scale);
-
-    return translation_mat * rotation_mat * scale_mat;
+    compileAction(action);
+    return ::compareWithReference(skeleton, *action, root, action->mAnimationSecond);
 }
 
-void Animation::computeGlobalTransforms(const aiNode* node, const glm::mat4& parentGlobal, double time,
-                                        std::unordered_map<std::string, glm::mat4>& outGlobalMap,
-                                        std::unordered_map<std::string, glm::mat4>& outLocalMap) {
-    glm::mat4 local = getLocalTransformAtTime(node, time);
-    glm::mat4 global = parentGlobal * local;
-
-    outLocalMap[node->mName.C_Str()] = local;
-    outGlobalMap[node->mName.C_Str()] = global;
-
-    for (unsigned int i = 0; i < node->mNumChildren; ++i) {
-        computeGlobalTransforms(node->mChildren[i], global, time, outGlobalMap, outLocalMap);
-    }
-}
+void Animation::compileAction(Action* action) { ::compileAction(skeleton, *action); }
 
 bool Animation::initAnimation(const aiScene* scene, std::string name) {
     activeActionIdx = 0;
     mFinalTransformations.reserve(100);
     mFinalTransformations.resize(100);
 
+    skeleton.build(scene->mRootNode);
+    mLocalTransforms.assign(skeleton.size(), glm::mat4{1.0});
+    mGlobalTransforms.assign(skeleton.size(), glm::mat4{1.0});
+
     if (scene->HasAnimations()) {
         for (size_t a = 0; a < scene->mNumAnimations; ++a) {
             Action* action = new Action{};
@@ -322,23 +138,23 @@ bool Animation::initAnimation(const aiScene* scene, std::string name) {
             actions[anim->mName.C_Str()] = action;
             // activeAction = action;
         }
+        for (auto& [action_name, action] : actions) {
+            compileAction(action);
+        }
 
         return true;
     }
     return false;
 }
 
-void Animation::update(aiNode* root) {
-    // const aiMatrix4x4 rootTransform = root->mTransformation;
-
-    // 2. Convert to glm and invert
-    // Use a helper function for conversion from Assimp's aiMatrix4x4 to glm::mat4
-    glm::mat4 globalInverseMatrix = glm::inverse(AiToGlm(root->mTransformation));
-    // globalInverseMatrix = glm::inverse(globalInverseMatrix);
+void Animation::update() {
     auto* action = getActiveAction();
-
-    computeGlobalTransforms(root, std::move(globalInverseMatrix), action->mAnimationSecond, calculatedTransform,
-                            localTransformation);
+    if (action == nullptr || skeleton.size() == 0) {
+        return;
+    }
+    // actions made after load, like the masked ones, are compiled on first use
+    compileAction(action);
+    sampleSkeleton(skeleton, *action, action->mAnimationSecond, mLocalTransforms, mGlobalTransforms);
 }
 
 Action* Animation::getActiveAction() { return activeAction; }
@@ -396,9 +212,12 @@ glm::mat4 BoneSocket::update() {
     auto* animation = base->getAnimation();
     glm::mat4 final_transform = glm::mat4{1.0};
     if (type == AnchorType::Bone && animation != nullptr && animation->getActiveAction() != nullptr) {
-        auto& base_transforms = animation->calculatedTransform;
-        if (base_transforms.contains(anchorName)) {
-            const auto& trans = base_transforms[anchorName];
+        if (mResolvedAnchor != anchorName) {
+            mResolvedAnchor = anchorName;
+            mJointIndex = animation->skeleton.getJointIndex(anchorName);
+        }
+        if (mJointIndex >= 0) {
+            const auto& trans = animation->mGlobalTransforms[mJointIndex];
             final_transform = base->mTransform.mTransformMatrix * trans * transform;
         }
     } else if (type == AnchorType::Model) {
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "skeleton.h"
+
+using Clock = std::chrono::steady_clock;
+
+/*
+ * Headless animation sampling benchmark: plays a synthetic skeleton forward through sampleSkeleton and through the
+ * string keyed reference evaluation the engine used before, and reports the time per skeleton sample of both, and
+ * the time per key lookup of findKey's cursor against the reference's linear scan.
+ */
+
+constexpr const float DURATION_MS = 2000.0f;
+constexpr const double FRAME_MS = 1000.0 / 60.0;
+
+// a chain every 4 joints, so the tree is both deep and wide like a humanoid rig with fingers
+static void buildNodes(aiNode* root, uint32_t jointCount, std::vector<aiNode*>& nodes) {
+    nodes.push_back(root);
+    for (uint32_t i = 1; i < jointCount; i++) {
+        aiNode* parent = nodes[i % 4 == 0 ? i / 4 : i - 1];
+        auto* node = new aiNode("joint" + std::to_string(i));
+        node->mTransformation = aiMatrix4x4(aiVector3D(1.0f), aiQuaternion(aiVector3D(0.0f, 1.0f, 0.0f), 0.1f * i),
+                                            aiVector3D(0.0f, 0.2f, 0.0f));
+        parent->addChildren(1, &node);
+        nodes.push_back(node);
+    }
+}
+
+static std::unique_ptr<Bone> makeBone(int id, uint32_t keyCount) {
+    auto bone = std::make_unique<Bone>();
+    bone->id = id;
+    bone->offsetMatrix = glm::mat4{1.0f};
+    for (uint32_t i = 0; i < keyCount; i++) {
+        float time = DURATION_MS * static_cast<float>(i) / static_cast<float>(keyCount - 1);
+        float angle = static_cast<float>(id + i) * 0.3f;
+        bone->channel.translations.push_back({time, glm::vec3{std::sin(angle), 0.2f, std::cos(angle)}});
+        bone->channel.quats.push_back({time, glm::angleAxis(angle, glm::vec3{0.0f, 0.0f, 1.0f})});
+        bone->channel.scales.push_back({time, glm::vec3{1.0f}});
+    }
+    return bone;
+}
+
+template <typename Sample>
+static double timePerSample(uint32_t frames, Sample&& sample) {
+    auto start = Clock::now();
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        sample(std::fmod(frame * FRAME_MS, static_cast<double>(DURATION_MS)));
+    }
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / frames;
+}
+
+// the scan findPositionKey does for the reference, over the compiled times
+static uint32_t linearKey(const float* times, uint32_t count, double time) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (time < times[i]) {
+            return i;
+        }
+    }
+    return count - 1;
+}
+
+// the key lookups alone, every joint's translation track once per frame. Sums the keys into `checksum` so the two
+// methods can be compared and the lookups are not optimized away
+template <typename Lookup>
+static double timePerLookup(const KeyTrack<glm::vec3>& track, uint32_t frames, uint64_t& checksum, Lookup&& lookup) {
+    uint64_t lookups = 0;
+    checksum = 0;
+    auto start = Clock::now();
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        double time = std::fmod(frame * FRAME_MS, static_cast<double>(DURATION_MS));
+        for (size_t joint = 0; joint < track.ranges.size(); joint++) {
+            const auto& range = track.ranges[joint];
+            if (range.count > 1) {
+                checksum += lookup(track.times.data() + range.begin, range.count, time, joint);
+                lookups++;
+            }
+        }
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / std::max<uint64_t>(lookups, 1);
+}
+
+int main(int argc, char** argv) {
+    uint32_t joint_count = argc > 1 ? static_cast<uint32_t>(std::max(2, std::atoi(argv[1]))) : 64;
+    uint32_t frames = argc > 2 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2]))) : 10000;
+    uint32_t key_count = argc > 3 ? static_cast<uint32_t>(std::max(2, std::atoi(argv[3]))) : 10000;
+
+    std::unique_ptr<aiNode> root{new aiNode("root")};
+    std::vector<aiNode*> nodes;
+    buildNodes(root.get(), joint_count, nodes);
+
+    std::vector<std::unique_ptr<Bone>> bones;
+    Action action;
+    action.mAnimationDuration = DURATION_MS / 1000.0;
+    for (uint32_t i = 1; i < joint_count; i++) {
+        bones.push_back(makeBone(static_cast<int>(i), key_count));
+        action.Bonemap[nodes[i]->mName.C_Str()] = bones.back().get();
+    }
+
+    Skeleton skeleton;
+    skeleton.build(root.get());
+    compileAction(skeleton, action);
+
+    std::vector<glm::mat4> locals(skeleton.size());
+    std::vector<glm::mat4> globals(skeleton.size());
+    std::unordered_map<std::string, glm::mat4> reference_locals;
+    std::unordered_map<std::string, glm::mat4> reference_globals;
+
+    // one untimed pass each, so the maps and cursors are warm
+    sampleSkeleton(skeleton, action, 0.0, locals, globals);
+    sampleReference(root.get(), action, 0.0, reference_locals, reference_globals);
+
+    double reference_us = timePerSample(
+        frames, [&](double time) { sampleReference(root.get(), action, time, reference_locals, reference_globals); });
+    double skeleton_us =
+        timePerSample(frames, [&](double time) { sampleSkeleton(skeleton, action, time, locals, globals); });
+
+    const auto& track = action.compiled.translations;
+    std::vector<uint32_t> cursors(track.ranges.size(), 0);
+    uint64_t cursor_sum = 0;
+    uint64_t linear_sum = 0;
+    double cursor_ns = timePerLookup(track, frames, cursor_sum, [&](const float* times, uint32_t count, double time,
+                                                                    size_t joint) {
+        return findKey(times, count, time, cursors[joint]);
+    });
+    double linear_ns = timePerLookup(track, frames, linear_sum, [](const float* times, uint32_t count, double time,
+                                                                   size_t) { return linearKey(times, count, time); });
+
+    float max_error = 0.0f;
+    for (uint32_t frame = 0; frame < 240; frame++) {
+        max_error = std::max(max_error, compareWithReference(skeleton, action, root.get(), frame * FRAME_MS));
+    }
+
+    std::cout << joint_count << " joints, " << key_count << " keys per channel, " << frames << " frames\n";
+    std::cout << "reference:      " << reference_us << " us per sample\n";
+    std::cout << "sampleSkeleton: " << skeleton_us << " us per sample (" << reference_us / skeleton_us << "x)\n";
+    std::cout << "linear scan:    " << linear_ns << " ns per lookup\n";
+    std::cout << "cursor:         " << cursor_ns << " ns per lookup (" << linear_ns / cursor_ns << "x)\n";
+    if (cursor_sum != linear_sum) {
+        std::cout << "cursor and linear scan picked different keys\n";
+    }
+    std::cout << "max difference: " << max_error << std::endl;
+    return 0;
+}
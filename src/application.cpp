@@ -20,6 +20,7 @@
 #include "binding_group.h"
 #include "camera.h"
 #include "full_quad_converter.h"
+#include "geometry_arena.h"
 #include "glm/detail/qualifier.hpp"
 #include "glm/gtc/quaternion.hpp"
 #include "glm/gtx/quaternion.hpp"
@@ -62,6 +63,7 @@
 #include "model.h"
 #include "model_registery.h"
 #include "pipeline.h"
+#include "pipeline_cache.h"
 #include "point_light.h"
 #include "profiling.h"
 #include "rendererResource.h"
@@ -69,7 +71,9 @@
 #include "shapes.h"
 #include "terrain_pass.h"
 #include "texture.h"
+#include "texture_streamer.h"
 #include "transparency_pass.h"
+#include "upload_ring.h"
 #include "utils.h"
 #include "water_pass.h"
 #include "webgpu/webgpu.h"
@@ -84,7 +88,8 @@ extern std::string selectedBone;
 namespace {
 
 // ParticleSystem* particle_system;
-bool cull_frustum = false;
+bool cull_frustum = true;
+bool cull_occlusion = true;
 bool simulate_particles = false;
 bool show_physic_objects = true;
 bool show_physic_debugs = false;
@@ -256,7 +261,8 @@ void Application::initializePipeline() {
             .addBuffer(1, BindGroupEntryVisibility::FRAGMENT, BufferBindingType::UNIFORM, sizeof(uint32_t))
             .addSampler(2, BindGroupEntryVisibility::FRAGMENT, SampleType::Filtering)
             .addBuffer(3, BindGroupEntryVisibility::FRAGMENT, BufferBindingType::UNIFORM, sizeof(LightingUniforms))
-            .addBuffer(4, BindGroupEntryVisibility::FRAGMENT, BufferBindingType::UNIFORM, sizeof(Light) * 10)
+            .addBuffer(4, BindGroupEntryVisibility::FRAGMENT, BufferBindingType::STORAGE_READONLY,
+                       sizeof(Light) * LightManager::MAX_LIGHTS)
             .addBuffer(5, BindGroupEntryVisibility::VERTEX_FRAGMENT, BufferBindingType::UNIFORM, sizeof(uint32_t))
             .addTexture(6, BindGroupEntryVisibility::FRAGMENT, TextureSampleType::DEPTH, TextureViewDimension::ARRAY_2D)
             .addBuffer(7, BindGroupEntryVisibility::VERTEX_FRAGMENT, BufferBindingType::UNIFORM, sizeof(Scene) * 5)
@@ -264,6 +270,12 @@ void Application::initializePipeline() {
             .addBuffer(9, BindGroupEntryVisibility::VERTEX, BufferBindingType::STORAGE_READONLY,
                        mInstanceManager->mBufferSize)
             .addBuffer(10, BindGroupEntryVisibility::VERTEX_FRAGMENT, BufferBindingType::UNIFORM, sizeof(uint32_t))
+            .addBuffer(11, BindGroupEntryVisibility::FRAGMENT, BufferBindingType::UNIFORM,
+                       sizeof(LightClusters::Uniform))
+            .addBuffer(12, BindGroupEntryVisibility::FRAGMENT, BufferBindingType::STORAGE_READONLY,
+                       sizeof(uint32_t) * 2 * LightClusters::CLUSTER_COUNT)
+            .addBuffer(13, BindGroupEntryVisibility::FRAGMENT, BufferBindingType::STORAGE_READONLY,
+                       sizeof(uint32_t) * LightClusters::CLUSTER_COUNT * LightClusters::MAX_LIGHTS_PER_CLUSTER)
             .createLayout(resource, "binding group layout");
 
     /* Default textures for the render pass, if a model doenst have textures, these will be used */
@@ -306,10 +318,11 @@ void Application::initializePipeline() {
     BindingGroup default_mesh_information;
     WGPUBindGroupLayout default_mesh_mat_layout =
         default_mesh_information
-            .addBuffer(0, BindGroupEntryVisibility::VERTEX_FRAGMENT, BufferBindingType::UNIFORM, sizeof(ShaderMaterial))
-            .addBuffer(1, BindGroupEntryVisibility::VERTEX_FRAGMENT, BufferBindingType::UNIFORM, sizeof(uint32_t))
-            .addBuffer(2, BindGroupEntryVisibility::VERTEX_FRAGMENT, BufferBindingType::UNIFORM, sizeof(WindParams))
-            .createLayout(resource, "mesh material Matrix uniform");
+            .addBuffer(0, BindGroupEntryVisibility::VERTEX_FRAGMENT, BufferBindingType::STORAGE_READONLY,
+                       sizeof(ShaderMaterial) * MaterialTable::INITIAL_MATERIALS)
+            .addBuffer(1, BindGroupEntryVisibility::VERTEX_FRAGMENT, BufferBindingType::UNIFORM, sizeof(DrawData), true)
+            .createLayout(resource, "material table layout");
+    mMaterials.create(mRendererResource, default_mesh_mat_layout);
 
     mBindGroupLayouts = {bind_group_layout,        obj_transform_layout,        texture_bind_group_layout,
                          camera_bind_group_layout, clipplane_bind_group_layout, visible_bind_group_layout,
@@ -325,8 +338,26 @@ void Application::initializePipeline() {
     setDefaultActiveStencil(mPipeline->getDepthStencilState());
     mPipeline->setColorTargetState(WGPUTextureFormat_RGBA16Float);
     mPipeline->setDepthStencilState(mPipeline->getDepthStencilState());
+    mPipeline->enablePackedVertexVariants();
     mPipeline->createPipeline(resource);
 
+    // shades what the depth prepass drew, only the visible surface passes and depth is already written
+    mDepthEqualPipeline = new Pipeline{this,
+                                       {bind_group_layout, mBindGroupLayouts[1], mBindGroupLayouts[2],
+                                        mBindGroupLayouts[3], mBindGroupLayouts[4], mBindGroupLayouts[5],
+                                        mBindGroupLayouts[6]},
+                                       "standard depth equal pipeline"};
+    mDepthEqualPipeline->defaultConfiguration(
+        resource, mSurfaceFormat, WGPUTextureFormat_Depth24Plus,
+        (getBinaryPathAbsolute() / ".." / "resources" / "shaders" / "shader.wgsl").string().c_str());
+    setDefaultActiveStencil(mDepthEqualPipeline->getDepthStencilState());
+    mDepthEqualPipeline->getDepthStencilState().depthCompare = WGPUCompareFunction_Equal;
+    mDepthEqualPipeline->getDepthStencilState().depthWriteEnabled = WGPUOptionalBool_False;
+    mDepthEqualPipeline->setColorTargetState(WGPUTextureFormat_RGBA16Float);
+    mDepthEqualPipeline->setDepthStencilState(mDepthEqualPipeline->getDepthStencilState());
+    mDepthEqualPipeline->enablePackedVertexVariants();
+    mDepthEqualPipeline->createPipeline(resource);
+
     mHDRPipeline = new Pipeline{this,
                                 {bind_group_layout, mBindGroupLayouts[1], mBindGroupLayouts[2], mBindGroupLayouts[3],
                                  mBindGroupLayouts[4], mBindGroupLayouts[5], mBindGroupLayouts[6]},
@@ -468,7 +499,7 @@ void Application::initializePipeline() {
     mBindingData[4].binding = 4;
     mBindingData[4].buffer = mLightBuffer.getBuffer();
     mBindingData[4].offset = 0;
-    mBindingData[4].size = sizeof(Light) * 10;
+    mBindingData[4].size = sizeof(Light) * LightManager::MAX_LIGHTS;
 
     mTimeBuffer.setLabel("number of cascades buffer")
         .setSize(sizeof(uint32_t))
@@ -526,18 +557,42 @@ void Application::initializePipeline() {
     mBindingData[10].offset = 0;
     mBindingData[10].size = sizeof(float);
 
+    mBindingData[11] = {};
+    mBindingData[11].nextInChain = nullptr;
+    mBindingData[11].buffer = mClusterParamsBuffer.getBuffer();
+    mBindingData[11].binding = 11;
+    mBindingData[11].offset = 0;
+    mBindingData[11].size = sizeof(LightClusters::Uniform);
+
+    mBindingData[12] = {};
+    mBindingData[12].nextInChain = nullptr;
+    mBindingData[12].buffer = mClusterGridBuffer.getBuffer();
+    mBindingData[12].binding = 12;
+    mBindingData[12].offset = 0;
+    mBindingData[12].size = sizeof(uint32_t) * 2 * LightClusters::CLUSTER_COUNT;
+
+    mBindingData[13] = {};
+    mBindingData[13].nextInChain = nullptr;
+    mBindingData[13].buffer = mClusterIndexBuffer.getBuffer();
+    mBindingData[13].binding = 13;
+    mBindingData[13].offset = 0;
+    mBindingData[13].size = sizeof(uint32_t) * LightClusters::CLUSTER_COUNT * LightClusters::MAX_LIGHTS_PER_CLUSTER;
+
     mDefaultVisibleBGData[0] = {};
     mDefaultVisibleBGData[0].nextInChain = nullptr;
     mDefaultVisibleBGData[0].buffer = mVisibleIndexBuffer.getBuffer();
     mDefaultVisibleBGData[0].binding = 0;
     mDefaultVisibleBGData[0].offset = 0;
-    mDefaultVisibleBGData[0].size = sizeof(uint32_t) * 100'000 * 5;
+    mDefaultVisibleBGData[0].size = sizeof(uint32_t) * InstanceManager::MAX_INSTANCE_COUNT * 10;
 
     mBindingGroup.create(resource, mBindingData);
     mDefaultTextureBindingGroup.create(resource, mDefaultTextureBindingData);
     mDefaultCameraIndexBindgroup.create(resource, mDefaultCameraIndexBindingData);
     mDefaultClipPlaneBG.create(resource, mDefaultClipPlaneBGData);
     mDefaultVisibleBuffer.create(resource, mDefaultVisibleBGData);
+    std::vector<WGPUBindGroupEntry> all_instances_bg_data = mDefaultVisibleBGData;
+    all_instances_bg_data[0].buffer = mAllInstancesIndexBuffer.getBuffer();
+    mAllInstancesBindGroup = mDefaultVisibleBuffer.createNew(resource, all_instances_bg_data);
 
     mSkybox = new SkyBox{this, getBinaryPathAbsolute() / ".." / RESOURCE_DIR / "skybox"};
 }
@@ -547,6 +602,9 @@ void Application::initializeBuffers() {
     // initialize The instancing buffer
     mLightManager = LightManager::init(this);
     mInstanceManager = new InstanceManager{mRendererResource, sizeof(InstanceData) * 100000 * 10, 100000};
+    mGeometryArena = new GeometryArena{mRendererResource};
+    mObjectSlots.setLabel("Object info slots").create(mRendererResource, sizeof(ObjectInfo), 256);
+    mBoneSlots.setLabel("Bone slots").create(mRendererResource, 100 * sizeof(glm::mat4), 32);
 
     mUniformBuffer.setLabel("MVP matrices matrix")
         .setSize(sizeof(CameraInfo) * 10)
@@ -575,8 +633,26 @@ void Application::initializeBuffers() {
     mDirectionalLightBuffer.queueWrite(0, &mLightingUniforms, sizeof(LightingUniforms));
 
     mLightBuffer.setLabel("Lights Buffer")
+        .setUsage(WGPUBufferUsage_CopyDst | WGPUBufferUsage_Storage)
+        .setSize(sizeof(Light) * LightManager::MAX_LIGHTS)
+        .setMappedAtCraetion(false)
+        .create(mRendererResource);
+
+    mClusterParamsBuffer.setLabel("Light cluster params buffer")
         .setUsage(WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform)
-        .setSize(sizeof(Light) * 10)
+        .setSize(sizeof(LightClusters::Uniform))
+        .setMappedAtCraetion(false)
+        .create(mRendererResource);
+
+    mClusterGridBuffer.setLabel("Light cluster grid buffer")
+        .setUsage(WGPUBufferUsage_CopyDst | WGPUBufferUsage_Storage)
+        .setSize(sizeof(uint32_t) * 2 * LightClusters::CLUSTER_COUNT)
+        .setMappedAtCraetion(false)
+        .create(mRendererResource);
+
+    mClusterIndexBuffer.setLabel("Light cluster index buffer")
+        .setUsage(WGPUBufferUsage_CopyDst | WGPUBufferUsage_Storage)
+        .setSize(sizeof(uint32_t) * LightClusters::CLUSTER_COUNT * LightClusters::MAX_LIGHTS_PER_CLUSTER)
         .setMappedAtCraetion(false)
         .create(mRendererResource);
 
@@ -584,6 +660,20 @@ void Application::initializeBuffers() {
 
     setupComputePass(this, mInstanceManager->getInstancingBuffer().getBuffer());
 
+    // same layout as the visible index buffer, every instance slot maps to itself
+    {
+        std::vector<uint32_t> all_instances(InstanceManager::MAX_INSTANCE_COUNT * 10);
+        for (size_t i = 0; i < all_instances.size(); i++) {
+            all_instances[i] = static_cast<uint32_t>(i % InstanceManager::MAX_INSTANCE_COUNT);
+        }
+        mAllInstancesIndexBuffer.setLabel("all instances index buffer")
+            .setUsage(WGPUBufferUsage_CopyDst | WGPUBufferUsage_Storage)
+            .setSize(sizeof(uint32_t) * all_instances.size())
+            .setMappedAtCraetion(false)
+            .create(mRendererResource);
+        mAllInstancesIndexBuffer.queueWrite(0, all_instances.data(), sizeof(uint32_t) * all_instances.size());
+    }
+
     mDefaultBoneFinalTransformData.setLabel("default bone final transform")
         .setSize(100 * sizeof(glm::mat4))
         .setUsage(WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst)
@@ -689,6 +779,7 @@ bool Application::initialize(const char* windowName, uint16_t width, uint16_t he
     // requesting device from adaptor
     WGPUDevice render_device;
     render_device = requestDeviceSync(adapter, GetRequiredLimits(adapter));
+    Texture::mBlockCompressionSupported = wgpuDeviceHasFeature(render_device, WGPUFeatureName_TextureCompressionBC);
     inspectDevice(render_device);
 
     // relase the adapter
@@ -701,9 +792,15 @@ bool Application::initialize(const char* windowName, uint16_t width, uint16_t he
     this->getRendererResource().queue = render_queue;
     this->getRendererResource().surface = provided_surface;
     this->getRendererResource().window = provided_window;
+    mUploadRing = new UploadRing{mRendererResource};
+    this->getRendererResource().uploads = mUploadRing;
+    mPipelineCache = new PipelineCache{mRendererResource};
+    mPipelineCache->setDiskDirectory(getBinaryPathAbsolute() / "shader_cache");
+    this->getRendererResource().pipelines = mPipelineCache;
 
     mTextureRegistery = new Registery<std::string, Texture>{};
     mTextureRegistery->mLoader.device = render_device;
+    mTextureStreamer = new TextureStreamer{};
 
     initializeMipmapCompute(this);
 
@@ -816,6 +913,41 @@ bool Application::initialize(const char* windowName, uint16_t width, uint16_t he
     return true;
 }
 
+void Application::updateLightClusters() {
+    ZoneScopedN("Light clusters");
+    auto projection = mCamera.getProjection();
+    auto view = mCamera.getView();
+    mLightClusters.setProjection(projection[0][0], projection[1][1], mCamera.mZnear, mCamera.mZfar);
+
+    auto& lights = mLightManager->getLights();
+    size_t light_count = std::min(lights.size(), LightManager::MAX_LIGHTS);
+    static std::vector<LightClusters::Sphere> spheres;
+    spheres.resize(light_count);
+    for (size_t i = 0; i < light_count; ++i) {
+        const auto& light = lights[i];
+        auto position = view * glm::vec4{glm::vec3{light.mPosition}, 1.0f};
+        // spot lights are binned by the sphere around their cone
+        float radius = 0.0f;
+        if (light.type == POINT || light.type == SPOT) {
+            float brightest = std::max({light.mAmbient.r, light.mAmbient.g, light.mAmbient.b});
+            radius = LightClusters::attenuationRange(light.mConstant, light.mLinear, light.mQuadratic,
+                                                     light.intensity * brightest);
+        }
+        spheres[i] = {position.x, position.y, position.z, radius};
+    }
+    mLightClusters.build(spheres);
+
+    auto [width, height] = getWindowSize();
+    auto uniform = mLightClusters.getUniform(width, height);
+    mClusterParamsBuffer.queueWrite(0, &uniform, sizeof(LightClusters::Uniform));
+    const auto& grid = mLightClusters.getGrid();
+    mClusterGridBuffer.queueWrite(0, grid.data(), sizeof(uint32_t) * grid.size());
+    const auto& indices = mLightClusters.getIndices();
+    if (!indices.empty()) {
+        mClusterIndexBuffer.queueWrite(0, indices.data(), sizeof(uint32_t) * indices.size());
+    }
+}
+
 void Application::mainLoop() {
     double time = glfwGetTime();
     glfwPollEvents();
@@ -827,6 +959,19 @@ void Application::mainLoop() {
         glfwPollEvents();
     }
 
+    {
+        // the GPU may lag behind by up to the max latency, the CPU only waits when it is further ahead
+        ZoneScopedNC("wait for frame in flight", 0xFF0000);
+        double wait_start = glfwGetTime();
+        wgpuDevicePoll(getRendererResource().device, false, nullptr);
+        while (mFramePacer.mustWait()) {
+            WGPUSubmissionIndex oldest = mFramePacer.getOldestSubmission();
+            wgpuDevicePoll(getRendererResource().device, true, &oldest);
+            mFramePacer.completed(mFramePacer.getOldestFrame());
+        }
+        mFrameWaitTime = glfwGetTime() - wait_start;
+    }
+
     double delta_time = time - last_frame_time;
     last_frame_time = time;
     mWorld->delta = delta_time;
@@ -846,19 +991,11 @@ void Application::mainLoop() {
 
     {
         // PerfTimer timer{"tick"};
-        std::unordered_map<Model*, bool> calculated_transformation;
-        for (auto* model : ModelRegistry::instance().getLoadedModel(Visibility_User)) {
-            // First update model transformation based on their socket property. if they are socket to other models
-            model->updateSocketTransformation(calculated_transformation);
-
-            // Update heirarchy, if a model is child to another model
-            reinterpret_cast<BaseModel*>(model)->updateHirarchy();
-
-            // Update physics and other systems like animations
-            model->update(this, delta_time, runPhysics);
-        }
+        updateModels(this, ModelRegistry::instance().getLoadedModel(Visibility_User), delta_time, runPhysics);
     }
 
+    mTextureStreamer->update(this);
+
     if (mSelectedModel != nullptr) {
         auto [min, max] = mSelectedModel->getWorldSpaceAABB();
         aabbDebugLines.updateLines(generateAABBLines(min, max));
@@ -896,7 +1033,7 @@ void Application::mainLoop() {
             if (physic_model != nullptr) {
                 if (physic_model->mDebugLines.has_value()) {
                     {
-                        auto [pos, rot] = physics::getPositionAndRotationyId(physic_model->bodyId);
+                        auto [pos, rot] = physics::getInterpolatedPositionAndRotation(physic_model->bodyId);
 
                         physic_model->mDebugLines
                             .value()
@@ -914,7 +1051,7 @@ void Application::mainLoop() {
                                     continue;
                                 }
                                 auto [pos, rot] =
-                                    physics::getPositionAndRotationyId(ins->mPhysicsComponents[i]->bodyId);
+                                    physics::getInterpolatedPositionAndRotation(ins->mPhysicsComponents[i]->bodyId);
 
                                 // std::cout << "Instance #" << i << " With rot: " << glm::to_string(rot)
                                 //           << " And pos:" << glm::to_string(pos) << std::endl;
@@ -932,7 +1069,7 @@ void Application::mainLoop() {
                 } else {
                     auto [min, max] = selectedPhysicModel->getPhysicsAABB();
                     auto half_extent = (max - min) * 0.5f;
-                    auto [pos, rot] = physics::getPositionAndRotationyId(physic_model->bodyId);
+                    auto [pos, rot] = physics::getInterpolatedPositionAndRotation(physic_model->bodyId);
                     debuglinegroup
                         .updateTransformation(glm::translate(glm::mat4{1.0}, pos) * glm::toMat4(rot) *
                                               glm::scale(glm::mat4{1.0}, half_extent))
@@ -954,13 +1091,11 @@ void Application::mainLoop() {
 
     // Dispaching Compute shaders to cull everything that is outside the frustum
     // -------------------------------------------------------------------------
-    auto fp = create2FrustumPlanes(corners);
-    getFrustumPlaneBuffer().queueWrite(0, fp.data(), sizeof(FrustumPlanesUniform));
-
-    if (cull_frustum) {
-        // runFrustumCullingTask(this, encoder);
-    }
-    mipmap::createMipMapComputShader(this);
+    // instanced draws always go through the culled draw args, zero planes let every instance through
+    auto fp = cull_frustum ? createFrustumPlanes(Frustum::fromMatrix(mCamera.getProjection() * mCamera.getView()))
+                           : FrustumPlanesUniform{};
+    getFrustumPlaneBuffer().queueWrite(0, &fp, sizeof(FrustumPlanesUniform));
+    runFrustumCullingTask(this, encoder);
 
     // -------------------------------------------------------------------------
 
@@ -993,6 +1128,10 @@ void Application::mainLoop() {
 
     mUniforms.setCamera(mCamera);
     mUniformBuffer.queueWrite(0, &mUniforms, sizeof(CameraInfo));
+    // the Hi-Z pyramid is built from the prepass depth, without the prepass it would cull against a cleared buffer
+    const bool occlusion_culling = cull_occlusion && mDepthPrePass->mEnabled;
+    updateOcclusionCulling(occlusion_culling, mUniforms.projectMatrix * mUniforms.viewMatrix);
+    updateLightClusters();
 
     // mWaterRenderPass->drawWater();
     // for (const auto& model : ModelRegistry::instance().getLoadedModel(Visibility_User)) {
@@ -1001,9 +1140,17 @@ void Application::mainLoop() {
     // }
 
     // Depth pre-pass to reduce number of overdraws
+    std::vector<Model*> opaques;
+    std::vector<Model*> transparents;
+    for (const auto& model : ModelRegistry::instance().getLoadedModel(ModelVisibility::Visibility_User)) {
+        if (model->isTransparent()) {
+            transparents.push_back(model);
+        } else {
+            opaques.push_back(model);
+        }
+    }
     {
         WGPURenderPassEncoder render_pass_encoder = wgpuCommandEncoderBeginRenderPass(encoder, &mDepthPrePass->mDesc);
-        wgpuRenderPassEncoderSetPipeline(render_pass_encoder, mDepthPrePass->getPipeline()->getPipeline());
         wgpuRenderPassEncoderSetBindGroup(render_pass_encoder, 0, mBindingGroup.getBindGroup(), 0, nullptr);
 
         wgpuRenderPassEncoderSetBindGroup(render_pass_encoder, 3, mDefaultCameraIndexBindgroup.getBindGroup(), 0,
@@ -1011,17 +1158,12 @@ void Application::mainLoop() {
         wgpuRenderPassEncoderSetBindGroup(render_pass_encoder, 4, mDefaultClipPlaneBG.getBindGroup(), 0, nullptr);
         wgpuRenderPassEncoderSetBindGroup(render_pass_encoder, 5, mDefaultVisibleBuffer.getBindGroup(), 0, nullptr);
 
-        {
-            // PerfTimer timer{"test"};
-            wgpuRenderPassEncoderSetPipeline(render_pass_encoder, mDepthPrePass->getPipeline()->getPipeline());
-            // for (const auto& model : ModelRegistry::instance().getLoadedModel(ModelVisibility::Visibility_User)) {
-            // model->drawHirarchy(this, render_pass_encoder);
-            // }
-        }
+        mDepthPrePass->render(opaques, mCamera.getPos(), render_pass_encoder);
 
         wgpuRenderPassEncoderEnd(render_pass_encoder);
         wgpuRenderPassEncoderRelease(render_pass_encoder);
     }
+    runOcclusionCullingTask(this, encoder);
     // ----------------------------------------------
 
     // ---- Skybox and PBR render pass
@@ -1086,41 +1228,24 @@ void Application::mainLoop() {
     {
         // {
         ZoneScopedNC("Color Pass", 0xFF);
-        std::vector<Model*> opaques;
-        std::vector<Model*> transparents;
         for (const auto& model : ModelRegistry::instance().getLoadedModel(ModelVisibility::Visibility_User)) {
-            if (model->isTransparent()) {
-                transparents.push_back(model);
-            } else {
-                opaques.push_back(model);
-            }
             if (model->mBehaviour != nullptr && model != mWorld->actor) {
                 model->mBehaviour->onTick(model, delta_time);
             }
         }
+        mDrawList.begin(mCamera.getPos(), mCamera.mZfar);
         for (const auto& model : opaques) {
-            wgpuRenderPassEncoderSetPipeline(render_pass_encoder, model->getPipeline(this)->getPipeline());
-            model->drawHirarchy(this, render_pass_encoder);
+            // instances the second culling phase brings back have no depth in the prepass
+            mShadeDepthEqual = mDepthPrePass->mDepthEqualShading && mDepthPrePass->hasDepth(model) &&
+                               (model->instance == nullptr || !occlusion_culling);
+            mDrawList.add(this, model, false);
         }
-
-        // sorting transparent models
-        glm::vec3 camera_pos = mCamera.getPos();  // adjust to your camera API
-
-        // Sort transparent models back to front (farthest first)
-        std::sort(transparents.begin(), transparents.end(), [&](const Model* a, const Model* b) {
-            glm::vec3 pos_a = a->mTransform.mPosition;
-            glm::vec3 pos_b = b->mTransform.mPosition;
-
-            float dist_a = glm::length2(pos_a - camera_pos);
-            float dist_b = glm::length2(pos_b - camera_pos);
-
-            return dist_a > dist_b;  // farthest first
-        });
-
+        mShadeDepthEqual = false;
+        // back to front, sorted by the draw list
         for (const auto& model : transparents) {
-            wgpuRenderPassEncoderSetPipeline(render_pass_encoder, model->getPipeline(this)->getPipeline());
-            model->drawHirarchy(this, render_pass_encoder);
+            mDrawList.add(this, model, true);
         }
+        mDrawList.draw(this, render_pass_encoder);
     }
 
     wgpuRenderPassEncoderEnd(render_pass_encoder);
@@ -1231,6 +1356,7 @@ void Application::mainLoop() {
     ModelRegistry::instance().tick(this);
 
     mTextureRegistery->mLoader.fetchQueue();
+    generatePendingMipmaps(encoder);
 
     // ------------ 3- Transparent pass
     // Calculate the Accumulation Buffer from the transparent object, this pass does not draw
@@ -1269,25 +1395,25 @@ void Application::mainLoop() {
     command_buffer_descriptor.label = {"command buffer", WGPU_STRLEN};
     WGPUCommandBuffer command = wgpuCommandEncoderFinish(encoder, &command_buffer_descriptor);
 
-    {
-        // {
-        ZoneScopedNC("terrain for refraction", 0x00F00F);
-        // }
-        // PerfTimer timer{"test"};
-        wgpuDevicePoll(this->getRendererResource().device, true, nullptr);
-    }
-    wgpuQueueSubmit(this->getRendererResource().queue, 1, &command);
-    // static WGPUQueueWorkDoneCallbackInfo cbinfo{};
-    // cbinfo.nextInChain = nullptr;
-    // cbinfo.callback = [](WGPUQueueWorkDoneStatus status, void* userdata1, void* userdata2) {
-    //     Application* app = (Application*)userdata1;
-    //     if (status == WGPUQueueWorkDoneStatus_Success) {
-    //     }
-    // };
-    //
-    // cbinfo.userdata1 = this;
-
-    // wgpuQueueOnSubmittedWorkDone(this->getRendererResource().queue, cbinfo);
+    // ranges freed by re-uploaded meshes leave holes, the moves are recorded by the upload ring before the submit and
+    // the passes above still read the old buffers
+    mGeometryArena->defragment();
+    mObjectSlots.flush();
+    mMaterials.flush();
+    mBoneSlots.flush();
+    mUploadRing->endFrame();
+    uint64_t frame = mFramePacer.submitted(wgpuQueueSubmitForIndex(this->getRendererResource().queue, 1, &command));
+    WGPUQueueWorkDoneCallbackInfo work_done = {};
+    work_done.nextInChain = nullptr;
+    work_done.mode = WGPUCallbackMode_AllowProcessEvents;
+    work_done.callback = [](WGPUQueueWorkDoneStatus status, void* userdata1, void* userdata2) {
+        if (status == WGPUQueueWorkDoneStatus_Success) {
+            static_cast<FramePacer*>(userdata1)->completed(reinterpret_cast<uintptr_t>(userdata2));
+        }
+    };
+    work_done.userdata1 = &mFramePacer;
+    work_done.userdata2 = reinterpret_cast<void*>(static_cast<uintptr_t>(frame));
+    wgpuQueueOnSubmittedWorkDone(this->getRendererResource().queue, work_done);
     wgpuCommandBufferRelease(command);
     wgpuCommandEncoderRelease(encoder);
 
@@ -1307,9 +1433,15 @@ void Application::mainLoop() {
 
 void Application::terminate() {
     wgpuBufferRelease(mLightBuffer.getBuffer());
+    wgpuBufferRelease(mClusterParamsBuffer.getBuffer());
+    wgpuBufferRelease(mClusterGridBuffer.getBuffer());
+    wgpuBufferRelease(mClusterIndexBuffer.getBuffer());
+    wgpuBindGroupRelease(mAllInstancesBindGroup);
+    wgpuBufferRelease(mAllInstancesIndexBuffer.getBuffer());
     wgpuBufferRelease(mUniformBuffer.getBuffer());
     terminateGui();
-    wgpuRenderPipelineRelease(mPipeline->getPipeline());
+    // the pipelines are owned by the cache
+    mPipelineCache->clear();
     wgpuSurfaceUnconfigure(this->getRendererResource().surface);
     wgpuQueueRelease(this->getRendererResource().queue);
     wgpuSurfaceRelease(this->getRendererResource().surface);
@@ -1420,6 +1552,8 @@ bool Application::initDepthBuffer() {
     depthViewDesc.label = createStringView("Depth-Only View");  // Label for debugging
 
     mDepthTextureViewDepthOnly = wgpuTextureCreateView(mDepthTexture->getTexture(), &depthViewDesc);
+    resizeOcclusionCulling(this, mDepthTextureViewDepthOnly, static_cast<uint32_t>(mWindow->mWindowSize.x),
+                           static_cast<uint32_t>(mWindow->mWindowSize.y));
 
     return mDepthTextureView != nullptr;
 }
@@ -1494,6 +1628,12 @@ void Application::updateGui(WGPURenderPassEncoder renderPass, double time) {
     if (ImGui::BeginTabBar("ObjectTabs")) {
         if (ImGui::BeginTabItem("Scene")) {
             ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", time * 1000.0f, 1.0 / time);
+            int max_latency = static_cast<int>(mFramePacer.getMaxLatency());
+            if (ImGui::SliderInt("max frames in flight", &max_latency, 1, FramePacer::MAX_FRAMES_IN_FLIGHT)) {
+                mFramePacer.setMaxLatency(static_cast<uint32_t>(max_latency));
+            }
+            ImGui::Text("%u frames in flight, waited %.3f ms", mFramePacer.getInFlightCount(),
+                        mFrameWaitTime * 1000.0);
 
             ImGui::Checkbox("simulate particles", &simulate_particles);
 
@@ -1512,6 +1652,71 @@ void Application::updateGui(WGPURenderPassEncoder renderPass, double time) {
                 }
 
                 ImGui::Checkbox("cull frustum", &cull_frustum);
+                ImGui::Checkbox("cull occlusion", &cull_occlusion);
+                if (cull_occlusion && !mDepthPrePass->mEnabled) {
+                    ImGui::SameLine();
+                    ImGui::TextDisabled("(needs the depth prepass)");
+                }
+            }
+
+            if (ImGui::CollapsingHeader("Texture Streaming")) {
+                auto& residency = mTextureStreamer->getResidency();
+                int budget_mb = residency.getBudget() / (1024 * 1024);
+                if (ImGui::SliderInt("VRAM budget (MB)", &budget_mb, 64, 8192)) {
+                    residency.setBudget(static_cast<size_t>(budget_mb) * 1024 * 1024);
+                }
+                ImGui::Text("%zu textures, %.1f MB resident", residency.getTextureCount(),
+                            residency.getResidentBytes() / (1024.0 * 1024.0));
+                int mip_filter = static_cast<int>(Texture::mMipFilter);
+                if (ImGui::Combo("Mip filter", &mip_filter, "Box\0Kaiser\0")) {
+                    Texture::mMipFilter = static_cast<MipFilter>(mip_filter);
+                }
+            }
+
+            if (ImGui::CollapsingHeader("Light Clusters")) {
+                ImGui::Text("%ux%ux%u clusters, %zu light references", LightClusters::TILES_X, LightClusters::TILES_Y,
+                            LightClusters::SLICES, mLightClusters.getIndices().size());
+                ImGui::Text("%zu dropped from full clusters", mLightClusters.getOverflowCount());
+            }
+
+            if (ImGui::CollapsingHeader("Buffer Uploads")) {
+                const auto& ring_stats = mUploadRing->getStats();
+                ImGui::Text("%zu writes, %.1f KB staged", ring_stats.writes, ring_stats.bytes / 1024.0);
+                ImGui::Text("%zu copies in %zu submits, %zu direct writes", ring_stats.copies, ring_stats.submits,
+                            ring_stats.directWrites);
+                ImGui::Text("%u staging blocks, %u in flight", mUploadRing->getBlockCount(),
+                            mUploadRing->getInFlightCount());
+                std::array<std::pair<const char*, SlotBuffer*>, 3> uploads = {
+                    {{"objects", &mObjectSlots}, {"draws", &mMaterials.getDrawSlots()}, {"bones", &mBoneSlots}}};
+                for (auto [name, slots] : uploads) {
+                    const auto& stats = slots->getStats();
+                    ImGui::Text("%s: %zu writes in %zu queue writes, %.1f KB", name, stats.slotWrites,
+                                stats.queueWrites, stats.bytes / 1024.0);
+                }
+                const auto& material_stats = mMaterials.getStats();
+                ImGui::Text("materials: %u of %u, %zu writes in %zu queue writes", mMaterials.getMaterialCount(),
+                            mMaterials.getCapacity(), material_stats.slotWrites, material_stats.queueWrites);
+                ImGui::Text("texture bind groups: %zu for %zu meshes", mTextureBindGroups.getCount(),
+                            mTextureBindGroups.getReferenceCount());
+            }
+
+            if (ImGui::CollapsingHeader("Pipeline Cache")) {
+                const auto& source_stats = mPipelineCache->getSourceStats();
+                ImGui::Text("sources: %zu hits, %zu misses, %zu from disk", source_stats.hits, source_stats.misses,
+                            source_stats.diskHits);
+                std::array<std::pair<const char*, const PipelineCache::Stats*>, 3> caches = {
+                    {{"modules", &mPipelineCache->getModuleStats()},
+                     {"layouts", &mPipelineCache->getLayoutStats()},
+                     {"pipelines", &mPipelineCache->getPipelineStats()}}};
+                for (auto [name, stats] : caches) {
+                    ImGui::Text("%s: %zu hits, %zu misses", name, stats->hits, stats->misses);
+                }
+            }
+
+            if (ImGui::CollapsingHeader("Render Queue")) {
+                const auto& queue_stats = mDrawList.getStats();
+                ImGui::Text("%zu color pass draws", queue_stats.draws);
+                ImGui::Text("%zu state changes issued, %zu elided", queue_stats.issued, queue_stats.elided);
             }
 
             if (ImGui::CollapsingHeader("Sun", ImGuiTreeNodeFlags_DefaultOpen)) {
@@ -1565,6 +1770,11 @@ void Application::updateGui(WGPURenderPassEncoder renderPass, double time) {
 #ifdef DEVELOPMENT_BUILD
                 mSelectedModel->userInterface();
 #endif  // DEVELOPMENT_BUILD
+                if (mSelectedModel != mWorld->actor && ImGui::Button("Unload")) {
+                    mSelectedModel->selected(false);
+                    ModelRegistry::instance().unloadModel(static_cast<Model*>(mSelectedModel));
+                    mSelectedModel = nullptr;
+                }
             }
             ImGui::EndTabItem();
         }
@@ -1594,12 +1804,28 @@ void Application::updateGui(WGPURenderPassEncoder renderPass, double time) {
                 ImGui::SliderFloat("frustum split factor", &middle_plane_length, 1.0, 100);
                 ImGui::SliderFloat("far split factor", &far_plane_length, 1.0, 200);
                 ImGui::DragFloat("push back factor", &mShadowPass->mPushBackFactor, 0.0, 100, 0.1);
+                ImGui::Checkbox("cull casters per cascade", &mShadowPass->mCullPerCascade);
+                ImGui::Checkbox("cache static casters", &mShadowPass->mCacheStaticCasters);
+                const auto& shadow_stats = mShadowPass->getStats();
+                ImGui::Text("%zu caster draws, %zu culled, %zu cache rebuilds", shadow_stats.drawnCasters,
+                            shadow_stats.culledCasters, shadow_stats.cacheRebuilds);
 
                 ImGui::Image((ImTextureID)(intptr_t)shadow_converterd->getTextureView(), ImVec2(200.0, 200.0));
                 ImGui::SameLine();
                 if (ImGui::Button("Zoom")) {
                 }
             }
+            if (ImGui::CollapsingHeader("Depth Prepass", ImGuiTreeNodeFlags_DefaultOpen)) {
+                ImGui::Checkbox("prepass enabled", &mDepthPrePass->mEnabled);
+                ImGui::Checkbox("shade prepass depth with depth equal", &mDepthPrePass->mDepthEqualShading);
+                int max_occluders = static_cast<int>(mDepthPrePass->mMaxOccluders);
+                if (ImGui::SliderInt("largest occluders (0 = all)", &max_occluders, 0, 256)) {
+                    mDepthPrePass->mMaxOccluders = static_cast<size_t>(max_occluders);
+                }
+                const auto& prepass_stats = mDepthPrePass->getStats();
+                ImGui::Text("%zu models, %zu foliage meshes, %zu skipped", prepass_stats.drawnModels,
+                            prepass_stats.foliageMeshes, prepass_stats.skippedModels);
+            }
 
             ImGui::EndTabItem();
         }
@@ -1761,6 +1987,15 @@ void Application::updateGui(WGPURenderPassEncoder renderPass, double time) {
             if (ImGui::Checkbox("Run Physics", &runPhysics) && runPhysics == true) {
                 std::cout << " place holder !\n";
             }
+            {
+                auto& timestep = physics::getFixedTimestep();
+                float rate = timestep.getRate();
+                int max_substeps = timestep.getMaxSubSteps();
+                if (ImGui::SliderFloat("Step rate", &rate, 15.0f, 240.0f, "%.0f Hz") ||
+                    ImGui::SliderInt("Max substeps", &max_substeps, 1, 16)) {
+                    physics::setFixedTimestep(rate, max_substeps);
+                }
+            }
 
             ImGui::NewLine();
             ImGui::Separator();
@@ -1876,14 +2111,14 @@ void Application::updateGui(WGPURenderPassEncoder renderPass, double time) {
                     ImGui::PushID(i);
                     if (ins->mPhysicsComponents[i] != nullptr) {
                         if (ImGui::Button(selectedPhysicModel->getName().c_str())) {
-                            // auto [pos, rot] = physics::getPositionAndRotationyId(ins->mPhysicsComponents[i]->bodyId);
+                            // auto [pos, rot] = physics::getInterpolatedPositionAndRotation(ins->mPhysicsComponents[i]->bodyId);
                             // instancedebuglinegroup
                             //     .updateTransformation(glm::translate(glm::mat4{1.0}, pos) * glm::toMat4(rot) *
                             //                           glm::scale(glm::mat4{1.0}, glm::vec3{0.2}))
                             //     .updateVisibility(true);
                             if (ins->mPhysicsComponents[i]->mDebugLines.has_value()) {
                                 auto [pos, rot] =
-                                    physics::getPositionAndRotationyId(ins->mPhysicsComponents[i]->bodyId);
+                                    physics::getInterpolatedPositionAndRotation(ins->mPhysicsComponents[i]->bodyId);
 
                                 ins->mPhysicsComponents[i]
                                     ->mDebugLines.value()
@@ -2163,6 +2398,6 @@ std::filesystem::path Application::getBinaryPathAbsolute() const {
 }
 std::filesystem::path Application::getBinaryPathRelative() const { return mBinaryPath; }
 
-Pipeline* Application::getPipeline() { return mPipeline; }
+Pipeline* Application::getPipeline() { return mShadeDepthEqual ? mDepthEqualPipeline : mPipeline; }
 
 AudioEngine* Application::getAudioEngine() { return audioEngine; }
@@ -45,6 +45,10 @@ WGPUTextureSampleType sampleTypeFrom(TextureSampleType type) {
             ret = WGPUTextureSampleType_Uint;
             break;
 
+        case TextureSampleType::UNFILTERABLE_FLOAT:
+            ret = WGPUTextureSampleType_UnfilterableFloat;
+            break;
+
         default:
             break;
     }
@@ -167,13 +171,14 @@ BindingGroup& BindingGroup::addTexture(uint32_t bindingNumber, BindGroupEntryVis
 }
 
 BindingGroup& BindingGroup::addStorageTexture(uint32_t bindingNumber, BindGroupEntryVisibility visibleTo,
-                                              StorageTextureAccessMode access, TextureViewDimension viewDim) {
+                                              StorageTextureAccessMode access, TextureViewDimension viewDim,
+                                              WGPUTextureFormat format) {
     WGPUBindGroupLayoutEntry entry_layout = {};
     setDefaultValue(entry_layout);
     entry_layout.binding = bindingNumber;
     entry_layout.visibility = visibilityFrom(visibleTo);
     entry_layout.storageTexture.access = accessFrom(access);
-    entry_layout.storageTexture.format = WGPUTextureFormat_RGBA8Unorm;
+    entry_layout.storageTexture.format = format;
     entry_layout.storageTexture.viewDimension = viewDimensionFrom(viewDim);
     // std::cout << "binding at " << bindingNumber << " " << entry_layout.buffer.type << std::endl;
     this->add(entry_layout);
@@ -181,13 +186,14 @@ BindingGroup& BindingGroup::addStorageTexture(uint32_t bindingNumber, BindGroupE
 }
 
 BindingGroup& BindingGroup::addBuffer(uint32_t bindingNumber, BindGroupEntryVisibility visibleTo,
-                                      BufferBindingType type, uint64_t minBindingSize) {
+                                      BufferBindingType type, uint64_t minBindingSize, bool hasDynamicOffset) {
     WGPUBindGroupLayoutEntry entry_layout = {};
     setDefaultValue(entry_layout);
     entry_layout.binding = bindingNumber;
     entry_layout.visibility = visibilityFrom(visibleTo);
     entry_layout.buffer.type = bufferTypeFrom(type);
     entry_layout.buffer.minBindingSize = minBindingSize;
+    entry_layout.buffer.hasDynamicOffset = hasDynamicOffset;
     this->add(entry_layout);
     return *this;
 }
@@ -1407,7 +1407,7 @@ struct TreeBehaviour : public PawnBehaviour {
             for (auto& [id, mesh] : model->mFlattenMeshes) {
                 mesh.mWindParams.heightFactor = 5.f;
                 mesh.mWindParams.strength = 0.2f;
-                mesh.mWindBuffer.queueWrite(0, &mesh.mWindParams, sizeof(WindParams));
+                model->writeMaterial(model->mApp, mesh);
             }
 
             this->model = model;
@@ -1489,7 +1489,7 @@ struct OakTreeBehaviour : public PawnBehaviour {
             for (auto& [id, mesh] : model->mFlattenMeshes) {
                 mesh.mWindParams.heightFactor = 5.f;
                 mesh.mWindParams.strength = 0.2f;
-                mesh.mWindBuffer.queueWrite(0, &mesh.mWindParams, sizeof(WindParams));
+                model->writeMaterial(model->mApp, mesh);
             }
 
             this->model = model;
@@ -0,0 +1,590 @@
+#include "block_compression.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace bc {
+
+namespace {
+
+using Texels = std::array<std::array<uint8_t, 4>, 16>;
+
+void fetchBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY,
+                Texels& texels) {
+    for (uint32_t y = 0; y < BLOCK_SIZE; ++y) {
+        uint32_t src_y = std::min(blockY * BLOCK_SIZE + y, height - 1);
+        for (uint32_t x = 0; x < BLOCK_SIZE; ++x) {
+            uint32_t src_x = std::min(blockX * BLOCK_SIZE + x, width - 1);
+            std::memcpy(texels[y * BLOCK_SIZE + x].data(), &rgba[4 * ((size_t)src_y * width + src_x)], 4);
+        }
+    }
+}
+
+void storeBlock(const Texels& texels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY,
+                uint8_t* rgba) {
+    for (uint32_t y = 0; y < BLOCK_SIZE; ++y) {
+        uint32_t dst_y = blockY * BLOCK_SIZE + y;
+        for (uint32_t x = 0; x < BLOCK_SIZE; ++x) {
+            uint32_t dst_x = blockX * BLOCK_SIZE + x;
+            if (dst_x < width && dst_y < height) {
+                std::memcpy(&rgba[4 * ((size_t)dst_y * width + dst_x)], texels[y * BLOCK_SIZE + x].data(), 4);
+            }
+        }
+    }
+}
+
+// endpoints at the extremes of the texels along their principal axis, through power iteration on the covariance
+template <int N>
+void fitEndpoints(const Texels& texels, std::array<float, N>& e0, std::array<float, N>& e1) {
+    std::array<float, N> mean{};
+    std::array<float, N> lo;
+    std::array<float, N> hi;
+    lo.fill(255.0f);
+    hi.fill(0.0f);
+    for (const auto& texel : texels) {
+        for (int c = 0; c < N; ++c) {
+            mean[c] += texel[c] / 16.0f;
+            lo[c] = std::min<float>(lo[c], texel[c]);
+            hi[c] = std::max<float>(hi[c], texel[c]);
+        }
+    }
+
+    float cov[N][N] = {};
+    for (const auto& texel : texels) {
+        for (int i = 0; i < N; ++i) {
+            for (int j = 0; j < N; ++j) {
+                cov[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+            }
+        }
+    }
+
+    std::array<float, N> axis;
+    for (int c = 0; c < N; ++c) {
+        axis[c] = hi[c] - lo[c];
+    }
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        std::array<float, N> next{};
+        float length = 0.0f;
+        for (int i = 0; i < N; ++i) {
+            for (int j = 0; j < N; ++j) {
+                next[i] += cov[i][j] * axis[j];
+            }
+            length += next[i] * next[i];
+        }
+        if (length < 1e-12f) {
+            break;
+        }
+        length = std::sqrt(length);
+        for (int c = 0; c < N; ++c) {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float t_min = std::numeric_limits<float>::max();
+    float t_max = std::numeric_limits<float>::lowest();
+    for (const auto& texel : texels) {
+        float t = 0.0f;
+        for (int c = 0; c < N; ++c) {
+            t += (texel[c] - mean[c]) * axis[c];
+        }
+        t_min = std::min(t_min, t);
+        t_max = std::max(t_max, t);
+    }
+    for (int c = 0; c < N; ++c) {
+        e0[c] = std::clamp(mean[c] + axis[c] * t_max, 0.0f, 255.0f);
+        e1[c] = std::clamp(mean[c] + axis[c] * t_min, 0.0f, 255.0f);
+    }
+}
+
+// least squares endpoints for texels at `weights` (0 is e0, 1 is e1), false when the weights are degenerate
+template <int N>
+bool refineEndpoints(const Texels& texels, const std::array<float, 16>& weights, std::array<float, N>& e0,
+                     std::array<float, N>& e1) {
+    float a = 0.0f, b = 0.0f, c = 0.0f;
+    std::array<float, N> d0{};
+    std::array<float, N> d1{};
+    for (int i = 0; i < 16; ++i) {
+        float w1 = weights[i];
+        float w0 = 1.0f - w1;
+        a += w0 * w0;
+        b += w0 * w1;
+        c += w1 * w1;
+        for (int ch = 0; ch < N; ++ch) {
+            d0[ch] += w0 * texels[i][ch];
+            d1[ch] += w1 * texels[i][ch];
+        }
+    }
+    float det = a * c - b * b;
+    if (std::abs(det) < 1e-6f) {
+        return false;
+    }
+    for (int ch = 0; ch < N; ++ch) {
+        e0[ch] = std::clamp((c * d0[ch] - b * d1[ch]) / det, 0.0f, 255.0f);
+        e1[ch] = std::clamp((a * d1[ch] - b * d0[ch]) / det, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+template <int N>
+uint32_t texelError(const std::array<uint8_t, 4>& texel, const int* color) {
+    uint32_t error = 0;
+    for (int c = 0; c < N; ++c) {
+        int d = texel[c] - color[c];
+        error += d * d;
+    }
+    return error;
+}
+
+// BC1 colors and the texel weights it uses
+
+uint16_t packRGB565(const std::array<float, 3>& color) {
+    auto r = static_cast<uint16_t>(std::lround(color[0] * 31.0f / 255.0f));
+    auto g = static_cast<uint16_t>(std::lround(color[1] * 63.0f / 255.0f));
+    auto b = static_cast<uint16_t>(std::lround(color[2] * 31.0f / 255.0f));
+    return (r << 11) | (g << 5) | b;
+}
+
+void unpackRGB565(uint16_t packed, int* color) {
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+void bc1Palette(uint16_t c0, uint16_t c1, bool fourColor, int palette[4][4]) {
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    palette[0][3] = palette[1][3] = 255;
+    for (int c = 0; c < 3; ++c) {
+        if (fourColor) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = fourColor ? 255 : 0;
+}
+
+struct ColorBlock {
+        uint16_t c0 = 0;
+        uint16_t c1 = 0;
+        uint32_t indices = 0;
+        uint32_t error = std::numeric_limits<uint32_t>::max();
+        std::array<float, 16> weights{};
+};
+
+ColorBlock quantizeBC1(const Texels& texels, const std::array<float, 3>& e0, const std::array<float, 3>& e1) {
+    static constexpr float INDEX_WEIGHTS[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+    ColorBlock block;
+    block.c0 = packRGB565(e0);
+    block.c1 = packRGB565(e1);
+    if (block.c0 < block.c1) {
+        std::swap(block.c0, block.c1);
+    }
+    // equal endpoints read as the three color mode, index 0 is the same color in both
+    int palette[4][4];
+    bc1Palette(block.c0, block.c1, true, palette);
+    int candidates = block.c0 == block.c1 ? 1 : 4;
+
+    block.error = 0;
+    for (int i = 0; i < 16; ++i) {
+        uint32_t best = 0;
+        uint32_t best_error = std::numeric_limits<uint32_t>::max();
+        for (int p = 0; p < candidates; ++p) {
+            uint32_t error = texelError<3>(texels[i], palette[p]);
+            if (error < best_error) {
+                best_error = error;
+                best = p;
+            }
+        }
+        block.indices |= best << (2 * i);
+        block.weights[i] = INDEX_WEIGHTS[best];
+        block.error += best_error;
+    }
+    return block;
+}
+
+void encodeBC1Block(const Texels& texels, uint8_t* out) {
+    std::array<float, 3> e0;
+    std::array<float, 3> e1;
+    fitEndpoints<3>(texels, e0, e1);
+    ColorBlock best = quantizeBC1(texels, e0, e1);
+    for (int iteration = 0; iteration < 2; ++iteration) {
+        if (!refineEndpoints<3>(texels, best.weights, e0, e1)) {
+            break;
+        }
+        ColorBlock refined = quantizeBC1(texels, e0, e1);
+        if (refined.error >= best.error) {
+            break;
+        }
+        best = refined;
+    }
+    std::memcpy(out, &best.c0, 2);
+    std::memcpy(out + 2, &best.c1, 2);
+    std::memcpy(out + 4, &best.indices, 4);
+}
+
+void decodeBC1Block(const uint8_t* in, bool forceFourColor, Texels& texels) {
+    uint16_t c0, c1;
+    uint32_t indices;
+    std::memcpy(&c0, in, 2);
+    std::memcpy(&c1, in + 2, 2);
+    std::memcpy(&indices, in + 4, 4);
+    int palette[4][4];
+    bc1Palette(c0, c1, forceFourColor || c0 > c1, palette);
+    for (int i = 0; i < 16; ++i) {
+        const int* color = palette[(indices >> (2 * i)) & 3];
+        for (int c = 0; c < 4; ++c) {
+            texels[i][c] = static_cast<uint8_t>(color[c]);
+        }
+    }
+}
+
+// BC4, one channel with 3 bit indices
+
+void bc4Palette(int a0, int a1, int palette[8]) {
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1) {
+        for (int i = 2; i < 8; ++i) {
+            palette[i] = ((8 - i) * a0 + (i - 1) * a1 + 3) / 7;
+        }
+    } else {
+        for (int i = 2; i < 6; ++i) {
+            palette[i] = ((6 - i) * a0 + (i - 1) * a1 + 2) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+void encodeBC4Block(const Texels& texels, int channel, uint8_t* out) {
+    int lo = 255, hi = 0;
+    for (const auto& texel : texels) {
+        lo = std::min<int>(lo, texel[channel]);
+        hi = std::max<int>(hi, texel[channel]);
+    }
+    int palette[8];
+    bc4Palette(hi, lo, palette);
+    uint64_t indices = 0;
+    for (int i = 0; i < 16; ++i) {
+        int value = texels[i][channel];
+        uint64_t best = 0;
+        int best_error = std::numeric_limits<int>::max();
+        for (int p = 0; p < (hi == lo ? 1 : 8); ++p) {
+            int error = std::abs(value - palette[p]);
+            if (error < best_error) {
+                best_error = error;
+                best = p;
+            }
+        }
+        indices |= best << (3 * i);
+    }
+    out[0] = static_cast<uint8_t>(hi);
+    out[1] = static_cast<uint8_t>(lo);
+    for (int i = 0; i < 6; ++i) {
+        out[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+    }
+}
+
+void decodeBC4Block(const uint8_t* in, int channel, Texels& texels) {
+    int palette[8];
+    bc4Palette(in[0], in[1], palette);
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i) {
+        indices |= static_cast<uint64_t>(in[2 + i]) << (8 * i);
+    }
+    for (int i = 0; i < 16; ++i) {
+        texels[i][channel] = static_cast<uint8_t>(palette[(indices >> (3 * i)) & 7]);
+    }
+}
+
+// BC7 mode 6: 7 bit RGBA endpoints with a p-bit each and 4 bit indices
+
+constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct Bc7Endpoint {
+        int q[4];  // 7 bit
+        int p;
+        int value(int c) const { return (q[c] << 1) | p; }
+};
+
+Bc7Endpoint quantizeBC7Endpoint(const std::array<float, 4>& color) {
+    Bc7Endpoint best{};
+    float best_error = std::numeric_limits<float>::max();
+    for (int p = 0; p < 2; ++p) {
+        Bc7Endpoint endpoint{};
+        endpoint.p = p;
+        float error = 0.0f;
+        for (int c = 0; c < 4; ++c) {
+            endpoint.q[c] = std::clamp(static_cast<int>(std::lround((color[c] - p) / 2.0f)), 0, 127);
+            float d = endpoint.value(c) - color[c];
+            error += d * d;
+        }
+        if (error < best_error) {
+            best_error = error;
+            best = endpoint;
+        }
+    }
+    return best;
+}
+
+struct Bc7Block {
+        Bc7Endpoint e0;
+        Bc7Endpoint e1;
+        std::array<int, 16> indices{};
+        uint32_t error = std::numeric_limits<uint32_t>::max();
+        std::array<float, 16> weights{};
+};
+
+void bc7Palette(const Bc7Endpoint& e0, const Bc7Endpoint& e1, int palette[16][4]) {
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 4; ++c) {
+            palette[i][c] = ((64 - BC7_WEIGHTS[i]) * e0.value(c) + BC7_WEIGHTS[i] * e1.value(c) + 32) >> 6;
+        }
+    }
+}
+
+Bc7Block quantizeBC7(const Texels& texels, const std::array<float, 4>& e0, const std::array<float, 4>& e1) {
+    Bc7Block block;
+    block.e0 = quantizeBC7Endpoint(e0);
+    block.e1 = quantizeBC7Endpoint(e1);
+    int palette[16][4];
+    bc7Palette(block.e0, block.e1, palette);
+
+    block.error = 0;
+    for (int i = 0; i < 16; ++i) {
+        int best = 0;
+        uint32_t best_error = std::numeric_limits<uint32_t>::max();
+        for (int p = 0; p < 16; ++p) {
+            uint32_t error = texelError<4>(texels[i], palette[p]);
+            if (error < best_error) {
+                best_error = error;
+                best = p;
+            }
+        }
+        block.indices[i] = best;
+        block.weights[i] = BC7_WEIGHTS[best] / 64.0f;
+        block.error += best_error;
+    }
+    return block;
+}
+
+class BitWriter {
+    public:
+        explicit BitWriter(uint8_t* out) : mOut(out) { std::memset(mOut, 0, 16); }
+        void write(uint32_t value, int bits) {
+            for (int i = 0; i < bits; ++i, ++mPos) {
+                mOut[mPos / 8] |= ((value >> i) & 1) << (mPos % 8);
+            }
+        }
+
+    private:
+        uint8_t* mOut;
+        int mPos = 0;
+};
+
+class BitReader {
+    public:
+        explicit BitReader(const uint8_t* in) : mIn(in) {}
+        uint32_t read(int bits) {
+            uint32_t value = 0;
+            for (int i = 0; i < bits; ++i, ++mPos) {
+                value |= ((mIn[mPos / 8] >> (mPos % 8)) & 1) << i;
+            }
+            return value;
+        }
+
+    private:
+        const uint8_t* mIn;
+        int mPos = 0;
+};
+
+void encodeBC7Block(const Texels& texels, uint8_t* out) {
+    std::array<float, 4> e0;
+    std::array<float, 4> e1;
+    fitEndpoints<4>(texels, e0, e1);
+    Bc7Block best = quantizeBC7(texels, e0, e1);
+    for (int iteration = 0; iteration < 2; ++iteration) {
+        if (!refineEndpoints<4>(texels, best.weights, e0, e1)) {
+            break;
+        }
+        Bc7Block refined = quantizeBC7(texels, e0, e1);
+        if (refined.error >= best.error) {
+            break;
+        }
+        best = refined;
+    }
+
+    // the top bit of the first index is implicit zero
+    if (best.indices[0] >= 8) {
+        std::swap(best.e0, best.e1);
+        for (auto& index : best.indices) {
+            index = 15 - index;
+        }
+    }
+
+    BitWriter writer(out);
+    writer.write(1 << 6, 7);
+    for (int c = 0; c < 4; ++c) {
+        writer.write(best.e0.q[c], 7);
+        writer.write(best.e1.q[c], 7);
+    }
+    writer.write(best.e0.p, 1);
+    writer.write(best.e1.p, 1);
+    writer.write(best.indices[0], 3);
+    for (int i = 1; i < 16; ++i) {
+        writer.write(best.indices[i], 4);
+    }
+}
+
+bool decodeBC7Block(const uint8_t* in, Texels& texels) {
+    if ((in[0] & 0x7F) != 0x40) {
+        for (auto& texel : texels) {
+            texel = {255, 0, 255, 255};
+        }
+        return false;
+    }
+    BitReader reader(in);
+    reader.read(7);
+    Bc7Endpoint e0{};
+    Bc7Endpoint e1{};
+    for (int c = 0; c < 4; ++c) {
+        e0.q[c] = reader.read(7);
+        e1.q[c] = reader.read(7);
+    }
+    e0.p = reader.read(1);
+    e1.p = reader.read(1);
+    int palette[16][4];
+    bc7Palette(e0, e1, palette);
+    for (int i = 0; i < 16; ++i) {
+        const int* color = palette[reader.read(i == 0 ? 3 : 4)];
+        for (int c = 0; c < 4; ++c) {
+            texels[i][c] = static_cast<uint8_t>(color[c]);
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+size_t blockBytes(Format format) { return format == Format::BC1 || format == Format::BC4 ? 8 : 16; }
+
+size_t imageBytes(Format format, uint32_t width, uint32_t height) {
+    size_t blocks_x = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    size_t blocks_y = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    return blocks_x * blocks_y * blockBytes(format);
+}
+
+uint32_t channelCount(Format format) {
+    switch (format) {
+        case Format::BC1:
+            return 3;
+        case Format::BC4:
+            return 1;
+        case Format::BC5:
+            return 2;
+        case Format::BC3:
+        case Format::BC7:
+            return 4;
+    }
+    return 4;
+}
+
+std::vector<uint8_t> encode(Format format, const uint8_t* rgba, uint32_t width, uint32_t height) {
+    std::vector<uint8_t> blocks(imageBytes(format, width, height));
+    uint32_t blocks_x = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    uint32_t blocks_y = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    Texels texels;
+    uint8_t* out = blocks.data();
+    for (uint32_t by = 0; by < blocks_y; ++by) {
+        for (uint32_t bx = 0; bx < blocks_x; ++bx) {
+            fetchBlock(rgba, width, height, bx, by, texels);
+            switch (format) {
+                case Format::BC1:
+                    encodeBC1Block(texels, out);
+                    break;
+                case Format::BC3:
+                    encodeBC4Block(texels, 3, out);
+                    encodeBC1Block(texels, out + 8);
+                    break;
+                case Format::BC4:
+                    encodeBC4Block(texels, 0, out);
+                    break;
+                case Format::BC5:
+                    encodeBC4Block(texels, 0, out);
+                    encodeBC4Block(texels, 1, out + 8);
+                    break;
+                case Format::BC7:
+                    encodeBC7Block(texels, out);
+                    break;
+            }
+            out += blockBytes(format);
+        }
+    }
+    return blocks;
+}
+
+bool decode(Format format, const uint8_t* blocks, uint32_t width, uint32_t height, std::vector<uint8_t>& rgba) {
+    rgba.assign(4 * (size_t)width * height, 0);
+    uint32_t blocks_x = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    uint32_t blocks_y = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    bool supported = true;
+    Texels texels;
+    const uint8_t* in = blocks;
+    for (uint32_t by = 0; by < blocks_y; ++by) {
+        for (uint32_t bx = 0; bx < blocks_x; ++bx) {
+            for (auto& texel : texels) {
+                texel = {0, 0, 0, 255};
+            }
+            switch (format) {
+                case Format::BC1:
+                    decodeBC1Block(in, false, texels);
+                    break;
+                case Format::BC3:
+                    decodeBC1Block(in + 8, true, texels);
+                    decodeBC4Block(in, 3, texels);
+                    break;
+                case Format::BC4:
+                    decodeBC4Block(in, 0, texels);
+                    break;
+                case Format::BC5:
+                    decodeBC4Block(in, 0, texels);
+                    decodeBC4Block(in + 8, 1, texels);
+                    break;
+                case Format::BC7:
+                    supported = decodeBC7Block(in, texels) && supported;
+                    break;
+            }
+            storeBlock(texels, width, height, bx, by, rgba.data());
+            in += blockBytes(format);
+        }
+    }
+    return supported;
+}
+
+double psnr(const uint8_t* expected, const uint8_t* actual, uint32_t width, uint32_t height, uint32_t channels) {
+    double squared_error = 0.0;
+    size_t texels = (size_t)width * height;
+    for (size_t i = 0; i < texels; ++i) {
+        for (uint32_t c = 0; c < channels; ++c) {
+            double d = double(expected[4 * i + c]) - double(actual[4 * i + c]);
+            squared_error += d * d;
+        }
+    }
+    if (squared_error == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double mse = squared_error / (double(texels) * channels);
+    return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+}  // namespace bc
@@ -0,0 +1,36 @@
+#ifndef WORLD_EXPLORER_CORE_BLOCK_COMPRESSION_H
+#define WORLD_EXPLORER_CORE_BLOCK_COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * CPU encoder and decoder for the BC block formats the exporter bakes textures into. Images are RGBA8, blocks are
+ * 4x4 texels stored row by row. BC4 and BC5 carry the red and red/green channels, BC7 is always written with mode 6
+ * (one subset, RGBA endpoints, 4 bit indices). The decoder is the fallback when the device has no
+ * texture-compression-bc and understands every block the encoder writes, other BC7 modes are not supported.
+ */
+namespace bc {
+
+enum class Format : uint8_t { BC1, BC3, BC4, BC5, BC7 };
+
+inline constexpr uint32_t BLOCK_SIZE = 4;
+
+size_t blockBytes(Format format);
+// bytes of a width x height image, partial blocks at the edges count as whole ones
+size_t imageBytes(Format format, uint32_t width, uint32_t height);
+
+// texels past the right and bottom edge repeat the last column and row
+std::vector<uint8_t> encode(Format format, const uint8_t* rgba, uint32_t width, uint32_t height);
+// false when a block uses an encoding this decoder does not know, it is filled with magenta
+bool decode(Format format, const uint8_t* blocks, uint32_t width, uint32_t height, std::vector<uint8_t>& rgba);
+
+// peak signal to noise ratio over the first `channels` channels of two RGBA8 images, infinite when they are equal
+double psnr(const uint8_t* expected, const uint8_t* actual, uint32_t width, uint32_t height, uint32_t channels);
+// channels a format keeps, the ones psnr() should compare
+uint32_t channelCount(Format format);
+
+}  // namespace bc
+
+#endif  //! WORLD_EXPLORER_CORE_BLOCK_COMPRESSION_H
@@ -0,0 +1,20 @@
+#include "cache_key.h"
+
+CacheKey& CacheKey::addString(std::string_view value) {
+    add(value.size());
+    mBytes.append(value);
+    return *this;
+}
+
+const std::string& CacheKey::getBytes() const { return mBytes; }
+
+uint64_t CacheKey::getHash() const { return hash(mBytes); }
+
+uint64_t CacheKey::hash(std::string_view data) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (unsigned char byte : data) {
+        hash ^= byte;
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
@@ -0,0 +1,37 @@
+#ifndef WORLD_EXPLORER_CORE_CACHE_KEY_H
+#define WORLD_EXPLORER_CORE_CACHE_KEY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/*
+ * Byte string identifying a cached object, built from the fields of its descriptor. The bytes are compared on lookup
+ * so a hash collision never returns the wrong object. Only scalars, enums and handles may be added, padding bytes of
+ * whole structs are indeterminate.
+ */
+class CacheKey {
+    public:
+        template <typename T>
+        CacheKey& add(const T& value) {
+            static_assert(std::is_scalar_v<T>, "add the fields of a struct one by one");
+            mBytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+            return *this;
+        }
+
+        // length prefixed, so consecutive strings can not run into each other
+        CacheKey& addString(std::string_view value);
+
+        const std::string& getBytes() const;
+        uint64_t getHash() const;
+
+        // 64 bit FNV-1a
+        static uint64_t hash(std::string_view data);
+
+    private:
+        std::string mBytes;
+};
+
+#endif  //! WORLD_EXPLORER_CORE_CACHE_KEY_H
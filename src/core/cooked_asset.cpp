@@ -0,0 +1,837 @@
+#include "cooked_asset.h"
+
+#include <assimp/material.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace cooked {
+
+static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "cooked format expects packed aiVector3D");
+static_assert(sizeof(aiMatrix4x4) == 16 * sizeof(float), "cooked format expects packed aiMatrix4x4");
+static_assert(sizeof(Vertex) == 112, "Vertex has to match VertexAttributes");
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const fs::path& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+    mData = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (mData == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    mFile = file;
+    mMapping = mapping;
+    mSize = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* ptr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps its own reference to the file
+    ::close(fd);
+    if (ptr == MAP_FAILED) {
+        return false;
+    }
+    mData = static_cast<const uint8_t*>(ptr);
+    mSize = static_cast<size_t>(st.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (mData == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(mData);
+    CloseHandle(mMapping);
+    CloseHandle(mFile);
+    mMapping = nullptr;
+    mFile = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(mData), mSize);
+#endif
+    mData = nullptr;
+    mSize = 0;
+}
+
+const uint8_t* MappedFile::data() const { return mData; }
+size_t MappedFile::size() const { return mSize; }
+
+namespace {
+
+class Writer {
+    public:
+        template <typename T>
+        void put(const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            putBytes(&value, sizeof(T));
+        }
+
+        template <typename T>
+        void putArray(const T* values, size_t count) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            if (values != nullptr && count > 0) {
+                putBytes(values, sizeof(T) * count);
+            }
+        }
+
+        void putString(const aiString& str) {
+            put<uint32_t>(str.length);
+            putBytes(str.data, str.length);
+        }
+
+        void putBytes(const void* data, size_t size) {
+            auto* bytes = static_cast<const uint8_t*>(data);
+            mBuffer.insert(mBuffer.end(), bytes, bytes + size);
+        }
+
+        std::vector<uint8_t> mBuffer;
+};
+
+class Reader {
+    public:
+        Reader(const uint8_t* data, size_t size) : mCursor(data), mEnd(data + size) {}
+
+        template <typename T>
+        bool get(T& out) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            return getBytes(&out, sizeof(T));
+        }
+
+        template <typename T>
+        bool getArray(T* out, size_t count) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            return getBytes(out, sizeof(T) * count);
+        }
+
+        bool getString(aiString& out) {
+            uint32_t length = 0;
+            if (!get(length) || length >= sizeof(out.data) || static_cast<size_t>(mEnd - mCursor) < length) {
+                return false;
+            }
+            out.Set(std::string{reinterpret_cast<const char*>(mCursor), length});
+            mCursor += length;
+            return true;
+        }
+
+        // `at` points into the mapped data, which stays where it is
+        bool skip(size_t size, const uint8_t*& at) {
+            if (static_cast<size_t>(mEnd - mCursor) < size) {
+                return false;
+            }
+            at = mCursor;
+            mCursor += size;
+            return true;
+        }
+
+        bool getBytes(void* out, size_t size) {
+            if (static_cast<size_t>(mEnd - mCursor) < size) {
+                return false;
+            }
+            // mapped data has no alignment guarantee, always go through memcpy
+            std::memcpy(out, mCursor, size);
+            mCursor += size;
+            return true;
+        }
+
+    private:
+        const uint8_t* mCursor;
+        const uint8_t* mEnd;
+};
+
+void collectNodes(const aiNode* node, int32_t parent, std::vector<std::pair<const aiNode*, int32_t>>& out) {
+    int32_t index = static_cast<int32_t>(out.size());
+    out.emplace_back(node, parent);
+    for (uint32_t i = 0; i < node->mNumChildren; ++i) {
+        collectNodes(node->mChildren[i], index, out);
+    }
+}
+
+// index into scene->mTextures of the embedded texture `path` refers to, by "*N" or by its file name, -1 if none
+int32_t findEmbeddedTexture(const aiScene* scene, const aiString& path) {
+    if (path.length > 1 && path.data[0] == '*') {
+        int32_t index = std::atoi(path.C_Str() + 1);
+        return index >= 0 && static_cast<uint32_t>(index) < scene->mNumTextures ? index : -1;
+    }
+    auto name = fs::path(path.C_Str()).filename();
+    for (uint32_t i = 0; i < scene->mNumTextures && !name.empty(); ++i) {
+        if (fs::path(scene->mTextures[i]->mFilename.C_Str()).filename() == name) {
+            return static_cast<int32_t>(i);
+        }
+    }
+    return -1;
+}
+
+// the path a material stores for `path`, embedded textures are loaded from their cooked file next to the model
+aiString getTexturePath(const aiScene* scene, const aiString& path, const fs::path& cookedPath) {
+    int32_t index = findEmbeddedTexture(scene, path);
+    if (index < 0) {
+        return path;
+    }
+    return aiString{getEmbeddedTexturePath(cookedPath, scene->mTextures[index], index).filename().string()};
+}
+
+bool writeEmbeddedTexture(const aiTexture* texture, const fs::path& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (texture->mHeight == 0) {
+        // compressed, mWidth is the size of the file in bytes
+        out.write(reinterpret_cast<const char*>(texture->pcData), texture->mWidth);
+        return out.good();
+    }
+    // aiTexel is BGRA like an uncompressed 32 bit TGA, stored top to bottom
+    uint8_t header[18] = {};
+    header[2] = 2;
+    header[12] = texture->mWidth & 0xff;
+    header[13] = (texture->mWidth >> 8) & 0xff;
+    header[14] = texture->mHeight & 0xff;
+    header[15] = (texture->mHeight >> 8) & 0xff;
+    header[16] = 32;
+    header[17] = 0x28;
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(texture->pcData),
+              static_cast<std::streamsize>(texture->mWidth) * texture->mHeight * sizeof(aiTexel));
+    return out.good();
+}
+
+void writeMesh(Writer& w, const aiMesh* mesh, const aiMaterial* material) {
+    w.putString(mesh->mName);
+    w.put<uint32_t>(mesh->mMaterialIndex);
+    w.put<uint32_t>(mesh->mPrimitiveTypes);
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    flattenMesh(mesh, material, vertices, indices);
+    w.put(static_cast<uint32_t>(vertices.size()));
+    w.putArray(vertices.data(), vertices.size());
+    w.put(static_cast<uint32_t>(indices.size()));
+    w.putArray(indices.data(), indices.size());
+
+    w.put<uint32_t>(mesh->mNumBones);
+    for (uint32_t i = 0; i < mesh->mNumBones; ++i) {
+        const aiBone* bone = mesh->mBones[i];
+        w.putString(bone->mName);
+        w.put(bone->mOffsetMatrix);
+        w.put<uint32_t>(bone->mNumWeights);
+        for (uint32_t j = 0; j < bone->mNumWeights; ++j) {
+            w.put<uint32_t>(bone->mWeights[j].mVertexId);
+            w.put<float>(bone->mWeights[j].mWeight);
+        }
+    }
+}
+
+void writeMaterial(Writer& w, const aiMaterial* material, const aiScene* scene, const fs::path& path) {
+    w.putString(material->GetName());
+
+    aiColor4D diffuse(1.0f, 0.0f, 1.0f, 1.0f);
+    uint8_t has_diffuse = material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse) == AI_SUCCESS ? 1 : 0;
+    w.put(has_diffuse);
+    w.put(diffuse);
+
+    uint32_t texture_count = 0;
+    for (uint32_t type = aiTextureType_NONE + 1; type <= AI_TEXTURE_TYPE_MAX; ++type) {
+        texture_count += material->GetTextureCount(static_cast<aiTextureType>(type));
+    }
+    w.put(texture_count);
+    for (uint32_t type = aiTextureType_NONE + 1; type <= AI_TEXTURE_TYPE_MAX; ++type) {
+        auto tex_type = static_cast<aiTextureType>(type);
+        for (uint32_t i = 0; i < material->GetTextureCount(tex_type); ++i) {
+            aiString texture_path;
+            material->GetTexture(tex_type, i, &texture_path);
+            w.put(type);
+            w.put(i);
+            w.putString(getTexturePath(scene, texture_path, path));
+        }
+    }
+}
+
+void writeAnimation(Writer& w, const aiAnimation* animation) {
+    w.putString(animation->mName);
+    w.put<double>(animation->mDuration);
+    w.put<double>(animation->mTicksPerSecond);
+    w.put<uint32_t>(animation->mNumChannels);
+    for (uint32_t c = 0; c < animation->mNumChannels; ++c) {
+        const aiNodeAnim* channel = animation->mChannels[c];
+        w.putString(channel->mNodeName);
+        w.put<uint32_t>(channel->mPreState);
+        w.put<uint32_t>(channel->mPostState);
+
+        w.put<uint32_t>(channel->mNumPositionKeys);
+        for (uint32_t i = 0; i < channel->mNumPositionKeys; ++i) {
+            w.put<double>(channel->mPositionKeys[i].mTime);
+            w.put(channel->mPositionKeys[i].mValue);
+        }
+        w.put<uint32_t>(channel->mNumRotationKeys);
+        for (uint32_t i = 0; i < channel->mNumRotationKeys; ++i) {
+            const auto& q = channel->mRotationKeys[i].mValue;
+            w.put<double>(channel->mRotationKeys[i].mTime);
+            w.put<float>(q.w);
+            w.put<float>(q.x);
+            w.put<float>(q.y);
+            w.put<float>(q.z);
+        }
+        w.put<uint32_t>(channel->mNumScalingKeys);
+        for (uint32_t i = 0; i < channel->mNumScalingKeys; ++i) {
+            w.put<double>(channel->mScalingKeys[i].mTime);
+            w.put(channel->mScalingKeys[i].mValue);
+        }
+    }
+}
+
+aiMesh* readMesh(Reader& r, Mesh& flat, bool& ok) {
+    auto* mesh = new aiMesh{};
+    ok = ok && r.getString(mesh->mName) && r.get(mesh->mMaterialIndex) && r.get(mesh->mPrimitiveTypes) &&
+         r.get(flat.vertexCount) && r.skip(sizeof(Vertex) * flat.vertexCount, flat.vertices) &&
+         r.get(flat.indexCount) && r.skip(sizeof(uint32_t) * flat.indexCount, flat.indices);
+
+    uint32_t num_bones = 0;
+    ok = ok && r.get(num_bones);
+    if (!ok || num_bones == 0) return mesh;
+    mesh->mNumBones = num_bones;
+    mesh->mBones = new aiBone*[num_bones]{};
+    for (uint32_t i = 0; i < num_bones && ok; ++i) {
+        auto* bone = new aiBone{};
+        mesh->mBones[i] = bone;
+        ok = r.getString(bone->mName) && r.get(bone->mOffsetMatrix) && r.get(bone->mNumWeights);
+        if (!ok) break;
+        bone->mWeights = new aiVertexWeight[bone->mNumWeights];
+        for (uint32_t j = 0; j < bone->mNumWeights && ok; ++j) {
+            ok = r.get(bone->mWeights[j].mVertexId) && r.get(bone->mWeights[j].mWeight);
+        }
+    }
+    return mesh;
+}
+
+aiMaterial* readMaterial(Reader& r, bool& ok) {
+    auto* material = new aiMaterial{};
+    aiString name;
+    uint8_t has_diffuse = 0;
+    aiColor4D diffuse;
+    uint32_t texture_count = 0;
+    ok = ok && r.getString(name) && r.get(has_diffuse) && r.get(diffuse) && r.get(texture_count);
+    if (!ok) return material;
+
+    material->AddProperty(&name, AI_MATKEY_NAME);
+    if (has_diffuse) {
+        material->AddProperty(&diffuse, 1, AI_MATKEY_COLOR_DIFFUSE);
+    }
+    for (uint32_t t = 0; t < texture_count && ok; ++t) {
+        uint32_t type = 0;
+        uint32_t index = 0;
+        aiString path;
+        ok = r.get(type) && r.get(index) && r.getString(path);
+        if (ok) {
+            material->AddProperty(&path, AI_MATKEY_TEXTURE(type, index));
+        }
+    }
+    return material;
+}
+
+aiAnimation* readAnimation(Reader& r, bool& ok) {
+    auto* animation = new aiAnimation{};
+    uint32_t num_channels = 0;
+    ok = ok && r.getString(animation->mName) && r.get(animation->mDuration) && r.get(animation->mTicksPerSecond) &&
+         r.get(num_channels);
+    if (!ok || num_channels == 0) return animation;
+
+    animation->mNumChannels = num_channels;
+    animation->mChannels = new aiNodeAnim*[num_channels]{};
+    for (uint32_t c = 0; c < num_channels && ok; ++c) {
+        auto* channel = new aiNodeAnim{};
+        animation->mChannels[c] = channel;
+        uint32_t pre_state = 0;
+        uint32_t post_state = 0;
+        ok = r.getString(channel->mNodeName) && r.get(pre_state) && r.get(post_state);
+        channel->mPreState = static_cast<aiAnimBehaviour>(pre_state);
+        channel->mPostState = static_cast<aiAnimBehaviour>(post_state);
+
+        ok = ok && r.get(channel->mNumPositionKeys);
+        if (!ok) break;
+        channel->mPositionKeys = new aiVectorKey[channel->mNumPositionKeys];
+        for (uint32_t i = 0; i < channel->mNumPositionKeys && ok; ++i) {
+            ok = r.get(channel->mPositionKeys[i].mTime) && r.get(channel->mPositionKeys[i].mValue);
+        }
+
+        ok = ok && r.get(channel->mNumRotationKeys);
+        if (!ok) break;
+        channel->mRotationKeys = new aiQuatKey[channel->mNumRotationKeys];
+        for (uint32_t i = 0; i < channel->mNumRotationKeys && ok; ++i) {
+            auto& q = channel->mRotationKeys[i].mValue;
+            ok = r.get(channel->mRotationKeys[i].mTime) && r.get(q.w) && r.get(q.x) && r.get(q.y) && r.get(q.z);
+        }
+
+        ok = ok && r.get(channel->mNumScalingKeys);
+        if (!ok) break;
+        channel->mScalingKeys = new aiVectorKey[channel->mNumScalingKeys];
+        for (uint32_t i = 0; i < channel->mNumScalingKeys && ok; ++i) {
+            ok = r.get(channel->mScalingKeys[i].mTime) && r.get(channel->mScalingKeys[i].mValue);
+        }
+    }
+    return animation;
+}
+
+}  // namespace
+
+void flattenMesh(const aiMesh* mesh, const aiMaterial* material, std::vector<Vertex>& vertices,
+                 std::vector<uint32_t>& indices) {
+    // the 90 degree rotation around X Model::processMesh turns the Y up assets with, in the same float math
+    const float angle = 90.0f * 0.01745329251994329576923690768489f;
+    const float c = std::cos(angle);
+    const float s = std::sin(angle);
+    auto to_z_up = [c, s](const aiVector3D& v) { return aiVector3D{v.x, c * v.y - s * v.z, s * v.y + c * v.z}; };
+    auto store = [](float* out, const aiVector3D& v) {
+        out[0] = v.x;
+        out[1] = v.y;
+        out[2] = v.z;
+    };
+
+    // the diffuse color is per material, not per vertex
+    aiColor4D diffuse(1.0f, 0.0f, 1.0f, 1.0f);
+    if (material != nullptr) {
+        material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
+    }
+
+    // zeroed, padding included, so cooking the same scene twice gives the same bytes
+    vertices.resize(mesh->mNumVertices);
+    std::memset(static_cast<void*>(vertices.data()), 0, sizeof(Vertex) * vertices.size());
+    for (uint32_t i = 0; i < mesh->mNumVertices; ++i) {
+        Vertex& vertex = vertices[i];
+        vertex.weights[0] = 1.0f;
+        store(vertex.position, to_z_up(mesh->mVertices[i]));
+        aiVector3D normal;
+        if (mesh->HasNormals()) {
+            normal = to_z_up(mesh->mNormals[i]);
+            store(vertex.normal, normal);
+        }
+        vertex.color[0] = diffuse.r;
+        vertex.color[1] = diffuse.g;
+        vertex.color[2] = diffuse.b;
+        if (mesh->mTextureCoords[0] != nullptr) {
+            vertex.uv[0] = mesh->mTextureCoords[0][i].x;
+            vertex.uv[1] = mesh->mTextureCoords[0][i].y;
+            if (mesh->mTangents != nullptr && mesh->mBitangents != nullptr) {
+                aiVector3D tangent = to_z_up(mesh->mTangents[i]);
+                tangent = (tangent - normal * (normal * tangent)).Normalize();
+                store(vertex.tangent, tangent);
+                store(vertex.biTangent, normal ^ tangent);
+            }
+        }
+    }
+
+    // meshes are triangulated on import
+    indices.clear();
+    indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
+    for (uint32_t i = 0; i < mesh->mNumFaces; ++i) {
+        const aiFace& face = mesh->mFaces[i];
+        indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
+    }
+}
+
+fs::path getEmbeddedTexturePath(const fs::path& path, const aiTexture* texture, uint32_t index) {
+    // compressed textures name their format in the hint, uncompressed ones are written as TGA
+    std::string extension = texture->mHeight == 0 ? std::string{texture->achFormatHint} : "tga";
+    auto texture_path = path;
+    texture_path.replace_filename(path.stem().string() + "_embedded" + std::to_string(index) + "." +
+                                  (extension.empty() ? "bin" : extension));
+    return texture_path;
+}
+
+bool writeScene(const aiScene* scene, const fs::path& path) {
+    if (scene == nullptr || scene->mRootNode == nullptr) {
+        return false;
+    }
+
+    std::vector<std::pair<const aiNode*, int32_t>> nodes;
+    collectNodes(scene->mRootNode, -1, nodes);
+
+    Writer w;
+    for (const auto& [node, parent] : nodes) {
+        w.putString(node->mName);
+        w.put(node->mTransformation);
+        w.put<int32_t>(parent);
+        w.put<uint32_t>(node->mNumMeshes);
+        w.putArray(node->mMeshes, node->mNumMeshes);
+    }
+    for (uint32_t i = 0; i < scene->mNumMeshes; ++i) {
+        const aiMesh* mesh = scene->mMeshes[i];
+        writeMesh(w, mesh, mesh->mMaterialIndex < scene->mNumMaterials ? scene->mMaterials[mesh->mMaterialIndex]
+                                                                        : nullptr);
+    }
+    for (uint32_t i = 0; i < scene->mNumMaterials; ++i) {
+        writeMaterial(w, scene->mMaterials[i], scene, path);
+    }
+    for (uint32_t i = 0; i < scene->mNumAnimations; ++i) {
+        writeAnimation(w, scene->mAnimations[i]);
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.importFlags = IMPORT_FLAGS;
+    header.numNodes = static_cast<uint32_t>(nodes.size());
+    header.numMeshes = scene->mNumMeshes;
+    header.numMaterials = scene->mNumMaterials;
+    header.numAnimations = scene->mNumAnimations;
+    header.payloadSize = w.mBuffer.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cout << "Cooked - Failed to open " << path.string() << " for writing\n";
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    out.write(reinterpret_cast<const char*>(w.mBuffer.data()), static_cast<std::streamsize>(w.mBuffer.size()));
+    if (!out.good()) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < scene->mNumTextures; ++i) {
+        auto texture_path = getEmbeddedTexturePath(path, scene->mTextures[i], i);
+        if (!writeEmbeddedTexture(scene->mTextures[i], texture_path)) {
+            std::cout << "Cooked - Failed to write embedded texture " << texture_path.string() << '\n';
+            return false;
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<Asset> loadAsset(const fs::path& path) {
+    auto asset = std::make_unique<Asset>();
+    MappedFile& file = asset->file;
+    if (!file.open(path)) {
+        std::cout << "Cooked - Failed to map " << path.string() << '\n';
+        return nullptr;
+    }
+
+    Header header{};
+    if (file.size() < sizeof(Header)) {
+        std::cout << "Cooked - " << path.string() << " is truncated\n";
+        return nullptr;
+    }
+    std::memcpy(&header, file.data(), sizeof(Header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+        header.importFlags != IMPORT_FLAGS || header.numNodes == 0 ||
+        header.payloadSize != file.size() - sizeof(Header)) {
+        std::cout << "Cooked - " << path.string() << " is not a compatible cooked asset, re-run the exporter\n";
+        return nullptr;
+    }
+
+    Reader r{file.data() + sizeof(Header), static_cast<size_t>(header.payloadSize)};
+    auto scene = std::make_unique<aiScene>();
+    bool ok = true;
+
+    std::vector<aiNode*> nodes(header.numNodes, nullptr);
+    std::vector<int32_t> parents(header.numNodes, -1);
+    std::vector<uint32_t> child_counts(header.numNodes, 0);
+    for (uint32_t i = 0; i < header.numNodes && ok; ++i) {
+        auto* node = new aiNode{};
+        nodes[i] = node;
+        uint32_t num_meshes = 0;
+        ok = r.getString(node->mName) && r.get(node->mTransformation) && r.get(parents[i]) && r.get(num_meshes);
+        // nodes are stored in pre-order, so a parent always comes before its children
+        ok = ok && (i == 0 ? parents[i] == -1 : parents[i] >= 0 && static_cast<uint32_t>(parents[i]) < i);
+        if (!ok) break;
+        if (num_meshes > 0) {
+            node->mNumMeshes = num_meshes;
+            node->mMeshes = new unsigned int[num_meshes];
+            ok = r.getArray(node->mMeshes, num_meshes);
+        }
+        if (i > 0) {
+            child_counts[parents[i]]++;
+        }
+    }
+    if (!ok) {
+        // nothing is linked yet, so the scene can't free these for us
+        for (auto* node : nodes) delete node;
+        std::cout << "Cooked - " << path.string() << " is corrupted (node hierarchy)\n";
+        return nullptr;
+    }
+    for (uint32_t i = 0; i < header.numNodes; ++i) {
+        if (child_counts[i] > 0) {
+            nodes[i]->mChildren = new aiNode*[child_counts[i]];
+        }
+    }
+    for (uint32_t i = 1; i < header.numNodes; ++i) {
+        aiNode* parent = nodes[parents[i]];
+        nodes[i]->mParent = parent;
+        parent->mChildren[parent->mNumChildren++] = nodes[i];
+    }
+    scene->mRootNode = nodes[0];
+
+    if (header.numMeshes > 0) {
+        scene->mMeshes = new aiMesh*[header.numMeshes]{};
+        asset->meshes.resize(header.numMeshes);
+        for (; scene->mNumMeshes < header.numMeshes && ok; ++scene->mNumMeshes) {
+            scene->mMeshes[scene->mNumMeshes] = readMesh(r, asset->meshes[scene->mNumMeshes], ok);
+        }
+    }
+    if (header.numMaterials > 0) {
+        scene->mMaterials = new aiMaterial*[header.numMaterials]{};
+        for (; scene->mNumMaterials < header.numMaterials && ok; ++scene->mNumMaterials) {
+            scene->mMaterials[scene->mNumMaterials] = readMaterial(r, ok);
+        }
+    }
+    if (header.numAnimations > 0) {
+        scene->mAnimations = new aiAnimation*[header.numAnimations]{};
+        for (; scene->mNumAnimations < header.numAnimations && ok; ++scene->mNumAnimations) {
+            scene->mAnimations[scene->mNumAnimations] = readAnimation(r, ok);
+        }
+    }
+
+    if (!ok) {
+        std::cout << "Cooked - " << path.string() << " is corrupted\n";
+        return nullptr;
+    }
+    asset->scene = std::move(scene);
+    return asset;
+}
+
+fs::path findCookedAsset(const fs::path& path) {
+    std::error_code ec;
+    if (path.extension() == EXTENSION) {
+        return fs::exists(path, ec) ? path : fs::path{};
+    }
+
+    auto cooked_path = path;
+    cooked_path.replace_extension(EXTENSION);
+    if (!fs::exists(cooked_path, ec)) {
+        return {};
+    }
+    // a stale cook is worse than a slow load
+    if (fs::exists(path, ec) && fs::last_write_time(cooked_path, ec) < fs::last_write_time(path, ec)) {
+        std::cout << "Cooked - " << cooked_path.string() << " is older than its source, ignoring it\n";
+        return {};
+    }
+    return cooked_path;
+}
+
+namespace {
+
+bool mismatch(std::string_view what, const aiString& owner) {
+    std::cout << "Cooked - mismatch in " << what << " of '" << owner.C_Str() << "'\n";
+    return false;
+}
+
+bool nearlyEqual(const aiVector3D* a, const aiVector3D* b, uint32_t count, float epsilon) {
+    if ((a == nullptr) != (b == nullptr)) return false;
+    for (uint32_t i = 0; a != nullptr && i < count; ++i) {
+        if (std::abs(a[i].x - b[i].x) > epsilon || std::abs(a[i].y - b[i].y) > epsilon ||
+            std::abs(a[i].z - b[i].z) > epsilon) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool nearlyEqual(const aiMatrix4x4& a, const aiMatrix4x4& b, float epsilon) {
+    for (uint32_t i = 0; i < 16; ++i) {
+        if (std::abs(a[i / 4][i % 4] - b[i / 4][i % 4]) > epsilon) return false;
+    }
+    return true;
+}
+
+bool compareNodes(const aiNode* a, const aiNode* b, float epsilon) {
+    if (a->mName != b->mName || a->mNumChildren != b->mNumChildren || a->mNumMeshes != b->mNumMeshes) {
+        return mismatch("node layout", a->mName);
+    }
+    if (!nearlyEqual(a->mTransformation, b->mTransformation, epsilon)) {
+        return mismatch("node transformation", a->mName);
+    }
+    if (a->mNumMeshes > 0 && std::memcmp(a->mMeshes, b->mMeshes, sizeof(unsigned int) * a->mNumMeshes) != 0) {
+        return mismatch("node mesh indices", a->mName);
+    }
+    for (uint32_t i = 0; i < a->mNumChildren; ++i) {
+        if (!compareNodes(a->mChildren[i], b->mChildren[i], epsilon)) return false;
+    }
+    return true;
+}
+
+bool nearlyEqual(const float* a, const float* b, uint32_t count, float epsilon) {
+    for (uint32_t i = 0; i < count; ++i) {
+        if (std::abs(a[i] - b[i]) > epsilon) return false;
+    }
+    return true;
+}
+
+bool compareMeshes(const aiMesh* a, const aiMaterial* material, const aiMesh* b, const Mesh& flat, float epsilon) {
+    if (a->mName != b->mName || a->mMaterialIndex != b->mMaterialIndex) {
+        return mismatch("mesh header", a->mName);
+    }
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    flattenMesh(a, material, vertices, indices);
+    if (vertices.size() != flat.vertexCount || indices.size() != flat.indexCount) {
+        return mismatch("vertex or index count", a->mName);
+    }
+    for (uint32_t i = 0; i < flat.vertexCount; ++i) {
+        Vertex vertex;
+        std::memcpy(&vertex, flat.vertices + sizeof(Vertex) * i, sizeof(Vertex));
+        const Vertex& expected = vertices[i];
+        if (!nearlyEqual(expected.position, vertex.position, 3, epsilon) ||
+            !nearlyEqual(expected.normal, vertex.normal, 3, epsilon) ||
+            !nearlyEqual(expected.color, vertex.color, 3, epsilon) ||
+            !nearlyEqual(expected.tangent, vertex.tangent, 3, epsilon) ||
+            !nearlyEqual(expected.biTangent, vertex.biTangent, 3, epsilon) ||
+            !nearlyEqual(expected.uv, vertex.uv, 2, epsilon)) {
+            return mismatch("vertex attributes", a->mName);
+        }
+    }
+    if (!indices.empty() && std::memcmp(indices.data(), flat.indices, sizeof(uint32_t) * indices.size()) != 0) {
+        return mismatch("indices", a->mName);
+    }
+    if (a->mNumBones != b->mNumBones) return mismatch("bone count", a->mName);
+    for (uint32_t i = 0; i < a->mNumBones; ++i) {
+        const aiBone* ba = a->mBones[i];
+        const aiBone* bb = b->mBones[i];
+        if (ba->mName != bb->mName || ba->mNumWeights != bb->mNumWeights ||
+            !nearlyEqual(ba->mOffsetMatrix, bb->mOffsetMatrix, epsilon)) {
+            return mismatch("bone", ba->mName);
+        }
+        for (uint32_t j = 0; j < ba->mNumWeights; ++j) {
+            if (ba->mWeights[j].mVertexId != bb->mWeights[j].mVertexId ||
+                std::abs(ba->mWeights[j].mWeight - bb->mWeights[j].mWeight) > epsilon) {
+                return mismatch("bone weights", ba->mName);
+            }
+        }
+    }
+    return true;
+}
+
+bool compareMaterials(const aiMaterial* a, const aiMaterial* b, const aiScene* scene, const fs::path& path) {
+    if (a->GetName() != b->GetName()) return mismatch("material name", a->GetName());
+    for (uint32_t type = aiTextureType_NONE + 1; type <= AI_TEXTURE_TYPE_MAX; ++type) {
+        auto tex_type = static_cast<aiTextureType>(type);
+        if (a->GetTextureCount(tex_type) != b->GetTextureCount(tex_type)) {
+            return mismatch("material textures", a->GetName());
+        }
+        for (uint32_t i = 0; i < a->GetTextureCount(tex_type); ++i) {
+            aiString pa, pb;
+            a->GetTexture(tex_type, i, &pa);
+            b->GetTexture(tex_type, i, &pb);
+            if (getTexturePath(scene, pa, path) != pb) return mismatch("material texture path", a->GetName());
+        }
+    }
+    return true;
+}
+
+bool compareAnimations(const aiAnimation* a, const aiAnimation* b, float epsilon) {
+    if (a->mName != b->mName || a->mNumChannels != b->mNumChannels || a->mDuration != b->mDuration ||
+        a->mTicksPerSecond != b->mTicksPerSecond) {
+        return mismatch("animation header", a->mName);
+    }
+    for (uint32_t c = 0; c < a->mNumChannels; ++c) {
+        const aiNodeAnim* ca = a->mChannels[c];
+        const aiNodeAnim* cb = b->mChannels[c];
+        if (ca->mNodeName != cb->mNodeName || ca->mNumPositionKeys != cb->mNumPositionKeys ||
+            ca->mNumRotationKeys != cb->mNumRotationKeys || ca->mNumScalingKeys != cb->mNumScalingKeys) {
+            return mismatch("channel layout", ca->mNodeName);
+        }
+        for (uint32_t i = 0; i < ca->mNumPositionKeys; ++i) {
+            if (ca->mPositionKeys[i].mTime != cb->mPositionKeys[i].mTime ||
+                !nearlyEqual(&ca->mPositionKeys[i].mValue, &cb->mPositionKeys[i].mValue, 1, epsilon)) {
+                return mismatch("position keys", ca->mNodeName);
+            }
+        }
+        for (uint32_t i = 0; i < ca->mNumRotationKeys; ++i) {
+            const auto& qa = ca->mRotationKeys[i].mValue;
+            const auto& qb = cb->mRotationKeys[i].mValue;
+            if (ca->mRotationKeys[i].mTime != cb->mRotationKeys[i].mTime || std::abs(qa.w - qb.w) > epsilon ||
+                std::abs(qa.x - qb.x) > epsilon || std::abs(qa.y - qb.y) > epsilon ||
+                std::abs(qa.z - qb.z) > epsilon) {
+                return mismatch("rotation keys", ca->mNodeName);
+            }
+        }
+        for (uint32_t i = 0; i < ca->mNumScalingKeys; ++i) {
+            if (ca->mScalingKeys[i].mTime != cb->mScalingKeys[i].mTime ||
+                !nearlyEqual(&ca->mScalingKeys[i].mValue, &cb->mScalingKeys[i].mValue, 1, epsilon)) {
+                return mismatch("scaling keys", ca->mNodeName);
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+bool compareScenes(const aiScene* expected, const Asset& asset, const fs::path& path, float epsilon) {
+    const aiScene* actual = asset.scene.get();
+    if (expected == nullptr || actual == nullptr || asset.meshes.size() != actual->mNumMeshes) {
+        return false;
+    }
+    if (expected->mNumMeshes != actual->mNumMeshes || expected->mNumMaterials != actual->mNumMaterials ||
+        expected->mNumAnimations != actual->mNumAnimations) {
+        std::cout << "Cooked - mismatch in scene counts\n";
+        return false;
+    }
+    if (!compareNodes(expected->mRootNode, actual->mRootNode, epsilon)) return false;
+    for (uint32_t i = 0; i < expected->mNumMeshes; ++i) {
+        const aiMesh* mesh = expected->mMeshes[i];
+        const aiMaterial* material =
+            mesh->mMaterialIndex < expected->mNumMaterials ? expected->mMaterials[mesh->mMaterialIndex] : nullptr;
+        if (!compareMeshes(mesh, material, actual->mMeshes[i], asset.meshes[i], epsilon)) return false;
+    }
+    for (uint32_t i = 0; i < expected->mNumMaterials; ++i) {
+        if (!compareMaterials(expected->mMaterials[i], actual->mMaterials[i], expected, path)) return false;
+    }
+    for (uint32_t i = 0; i < expected->mNumTextures; ++i) {
+        const aiTexture* texture = expected->mTextures[i];
+        auto texture_path = getEmbeddedTexturePath(path, texture, i);
+        uintmax_t size = texture->mHeight == 0 ? texture->mWidth
+                                               : 18 + static_cast<uintmax_t>(texture->mWidth) * texture->mHeight * 4;
+        std::error_code ec;
+        if (fs::file_size(texture_path, ec) != size || ec) {
+            std::cout << "Cooked - mismatch in embedded texture " << texture_path.string() << '\n';
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < expected->mNumAnimations; ++i) {
+        if (!compareAnimations(expected->mAnimations[i], actual->mAnimations[i], epsilon)) return false;
+    }
+    return true;
+}
+
+}  // namespace cooked
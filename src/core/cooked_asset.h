@@ -0,0 +1,114 @@
+#ifndef WORLD_EXPLORER_CORE_COOKED_ASSET_H
+#define WORLD_EXPLORER_CORE_COOKED_ASSET_H
+
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * Cooked model format (.wexc)
+ * A flat, versioned dump of the post-processed assimp scene. The meshes are stored flattened, their vertices already
+ * in the layout and axes Model::processMesh produces, so loading one is a copy out of the mapped file. Nodes, bone
+ * tables, materials and animation channels are rebuilt into an aiScene for the node and animation code, its meshes
+ * keep their name, material and bones but no vertices. Embedded textures are written next to the cooked file and
+ * the materials point at them.
+ */
+namespace cooked {
+
+inline constexpr char MAGIC[4] = {'W', 'E', 'X', 'C'};
+inline constexpr uint32_t VERSION = 2;
+inline constexpr const char* EXTENSION = ".wexc";
+
+// Post-processing used by both Model::load and the cooker, cooked files made with other flags are rejected
+inline constexpr uint32_t IMPORT_FLAGS =
+    aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices;
+
+struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t importFlags;
+        uint32_t numNodes;
+        uint32_t numMeshes;
+        uint32_t numMaterials;
+        uint32_t numAnimations;
+        uint64_t payloadSize;
+};
+
+// VertexAttributes in mesh.h, Model::load copies the vertices into it as they are
+struct alignas(16) Vertex {
+        float position[3];
+        float normal[3];
+        float color[3];
+        float tangent[3];
+        float biTangent[3];
+        float uv[2];
+        int32_t boneIds[4] = {0, 0, 0, 0};
+        float weights[4] = {1.0f, 0.0f, 0.0f, 0.0f};
+};
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const std::filesystem::path& path);
+        void close();
+        const uint8_t* data() const;
+        size_t size() const;
+
+    private:
+        const uint8_t* mData = nullptr;
+        size_t mSize = 0;
+#ifdef _WIN32
+        void* mFile = nullptr;
+        void* mMapping = nullptr;
+#endif
+};
+
+// a flattened mesh inside the mapped file. The arrays have no alignment guarantee, they are copied out with memcpy
+struct Mesh {
+        const uint8_t* vertices = nullptr;  // vertexCount Vertex
+        uint32_t vertexCount = 0;
+        const uint8_t* indices = nullptr;  // indexCount uint32_t
+        uint32_t indexCount = 0;
+};
+
+struct Asset {
+        MappedFile file;
+        std::unique_ptr<aiScene> scene;
+        std::vector<Mesh> meshes;  // like scene->mMeshes, valid while `file` is open
+};
+
+// the vertices of `mesh` as Model::processMesh flattens them for a Y up model, without bone weights. Model::load
+// applies the Z up swap and the weights, both depend on the model rather than the file
+void flattenMesh(const aiMesh* mesh, const aiMaterial* material, std::vector<Vertex>& vertices,
+                 std::vector<uint32_t>& indices);
+
+// the file the embedded texture `index` of the model cooked to `path` is written to, next to it
+std::filesystem::path getEmbeddedTexturePath(const std::filesystem::path& path, const aiTexture* texture,
+                                             uint32_t index);
+
+// writes the embedded textures next to `path` as well
+bool writeScene(const aiScene* scene, const std::filesystem::path& path);
+std::unique_ptr<Asset> loadAsset(const std::filesystem::path& path);
+
+// returns the cooked file to load for `path`, or an empty path if there is none (or it is older than the source)
+std::filesystem::path findCookedAsset(const std::filesystem::path& path);
+
+// compares what the engine consumes of an imported scene with the cooked asset loaded from `path`, prints the first
+// mismatch
+bool compareScenes(const aiScene* expected, const Asset& actual, const std::filesystem::path& path,
+                   float epsilon = 1e-5f);
+
+}  // namespace cooked
+
+#endif  //! WORLD_EXPLORER_CORE_COOKED_ASSET_H
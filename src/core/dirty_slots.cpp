@@ -0,0 +1,31 @@
+#include "dirty_slots.h"
+
+#include <algorithm>
+
+DirtySlots::DirtySlots(uint32_t mergeGap) : mMergeGap(mergeGap) {}
+
+void DirtySlots::mark(uint32_t slot) {
+    if (slot >= mMarked.size()) {
+        mMarked.resize(static_cast<size_t>(slot) + 1, 0);
+    }
+    if (mMarked[slot] == 0) {
+        mMarked[slot] = 1;
+        mSlots.push_back(slot);
+    }
+}
+
+bool DirtySlots::empty() const { return mSlots.empty(); }
+
+void DirtySlots::takeRanges(std::vector<Range>& ranges) {
+    ranges.clear();
+    std::sort(mSlots.begin(), mSlots.end());
+    for (uint32_t slot : mSlots) {
+        mMarked[slot] = 0;
+        if (!ranges.empty() && slot - ranges.back().end <= mMergeGap) {
+            ranges.back().end = slot + 1;
+        } else {
+            ranges.push_back({slot, slot + 1});
+        }
+    }
+    mSlots.clear();
+}
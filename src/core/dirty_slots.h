@@ -0,0 +1,32 @@
+#ifndef WORLD_EXPLORER_CORE_DIRTY_SLOTS_H
+#define WORLD_EXPLORER_CORE_DIRTY_SLOTS_H
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Slots of a shared upload buffer written since the last takeRanges(), coalesced into as few contiguous ranges as
+ * possible. Dirty ranges separated by at most `mergeGap` clean slots become one, uploading the clean slots between
+ * them again is cheaper than another queue write.
+ */
+class DirtySlots {
+    public:
+        struct Range {
+                uint32_t begin;
+                uint32_t end;  // exclusive
+        };
+
+        explicit DirtySlots(uint32_t mergeGap = 4);
+
+        void mark(uint32_t slot);
+        bool empty() const;
+        // the marked slots as ranges in slot order, clears the marks. `ranges` is overwritten
+        void takeRanges(std::vector<Range>& ranges);
+
+    private:
+        std::vector<uint32_t> mSlots;  // in marking order, each slot once
+        std::vector<uint8_t> mMarked;  // by slot
+        uint32_t mMergeGap;
+};
+
+#endif  //! WORLD_EXPLORER_CORE_DIRTY_SLOTS_H
@@ -10,13 +10,26 @@
 #include "assmip/include/assimp/Importer.hpp"
 #include "assmip/include/assimp/postprocess.h"
 #include "assmip/include/assimp/scene.h"
+#include "block_compression.h"
+#include "cooked_asset.h"
 #include "json.hpp"
+#include "ktx2.h"
+#include "mip_chain.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
 
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
 using loadTextureResType = std::vector<std::array<std::string, 3>>;
 
+// order of the texture slots in loadTextureResType and of the material maps
+enum TextureRole { TextureRole_Diffuse = 0, TextureRole_Normal = 1, TextureRole_Specular = 2 };
+
+// decoded level 0 below this is reported as a failed verification
+constexpr const double MIN_TEXTURE_PSNR = 30.0;
+
 loadTextureResType loadModelTextures(const std::filesystem::path& path) {
     // load model from disk
     //
@@ -90,7 +103,94 @@ void createExportDir(const fs::path& path) {
     fs::create_directories(path);
 }
 
-bool exportModels(const fs::path& assetDir, json& objects) {
+// Bake the model into the cooked binary format next to the exported copy, so the engine can skip assimp entirely
+bool cookModel(const fs::path& source, const fs::path& target, bool verify) {
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(source.string().c_str(), cooked::IMPORT_FLAGS);
+    if (scene == nullptr || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || scene->mRootNode == nullptr) {
+        std::cout << "Failed to import " << source << " for cooking: " << importer.GetErrorString() << '\n';
+        return false;
+    }
+    if (!cooked::writeScene(scene, target)) {
+        std::cout << "Failed to write cooked asset " << target << '\n';
+        return false;
+    }
+    std::cout << "Cooked: " << target << "\n";
+
+    if (verify) {
+        // round trip: the cooked scene must match what assimp hands to Model::load
+        auto loaded = cooked::loadAsset(target);
+        if (loaded == nullptr || !cooked::compareScenes(scene, *loaded, target)) {
+            std::cout << "Verification failed for " << target << '\n';
+            return false;
+        }
+        std::cout << "Verified: " << target << "\n";
+    }
+    return true;
+}
+
+// Bake the texture and its mip chain into BC blocks in a KTX2 next to it, Texture loads that instead of the image.
+// Normal maps go to BC5 (the shader rebuilds z), packed material maps to BC7 and colors to BC1, or BC3 with alpha
+bool compressTexture(const fs::path& source, int role, bool verify) {
+    static const char* format_names[] = {"BC1", "BC3", "BC4", "BC5", "BC7"};
+
+    auto target = source;
+    target.replace_extension(ktx2::EXTENSION);
+    if (!verify && !ktx2::findCompressedTexture(source).empty()) {
+        std::cout << "Skipped (up to date): " << target << "\n";
+        return true;
+    }
+
+    int width, height, channels;
+    unsigned char* pixels = stbi_load(source.string().c_str(), &width, &height, &channels, 4);
+    if (pixels == nullptr) {
+        std::cout << "Failed to load " << source << " for compression\n";
+        return false;
+    }
+    std::vector<uint8_t> base(pixels, pixels + 4 * (size_t)width * height);
+    stbi_image_free(pixels);
+
+    bool has_alpha = false;
+    for (size_t i = 3; i < base.size() && !has_alpha; i += 4) {
+        has_alpha = base[i] < 255;
+    }
+    bc::Format format = role == TextureRole_Normal     ? bc::Format::BC5
+                        : role == TextureRole_Specular ? bc::Format::BC7
+                        : has_alpha                    ? bc::Format::BC3
+                                                       : bc::Format::BC1;
+
+    auto chain = buildMipChainRGBA8(std::move(base), width, height, MipFilter::Kaiser, role == TextureRole_Diffuse);
+    ktx2::Image image;
+    image.vkFormat = ktx2::toVkFormat(format);
+    image.width = width;
+    image.height = height;
+    image.levelCount = chain.size();
+    for (uint32_t level = 0; level < chain.size(); ++level) {
+        image.levels.push_back(bc::encode(format, chain[level].data(), std::max(1, width >> level),
+                                          std::max(1, height >> level)));
+    }
+
+    if (verify) {
+        std::vector<uint8_t> decoded;
+        bc::decode(format, image.levels[0].data(), width, height, decoded);
+        double quality = bc::psnr(chain[0].data(), decoded.data(), width, height, bc::channelCount(format));
+        std::cout << "PSNR of " << source.filename() << " in " << format_names[static_cast<int>(format)] << ": "
+                  << quality << " dB\n";
+        if (quality < MIN_TEXTURE_PSNR) {
+            std::cout << "Verification failed for " << target << '\n';
+            return false;
+        }
+    }
+
+    if (!ktx2::write(target, image)) {
+        std::cout << "Failed to write compressed texture " << target << '\n';
+        return false;
+    }
+    std::cout << "Compressed: " << target << " (" << format_names[static_cast<int>(format)] << ")\n";
+    return true;
+}
+
+bool exportModels(const fs::path& assetDir, json& objects, bool cook, bool compress, bool verify) {
     std::error_code ec;
     auto models_dir = assetDir / "models";
     fs::create_directories(models_dir, ec);
@@ -166,6 +266,20 @@ bool exportModels(const fs::path& assetDir, json& objects) {
                 if (!copied) {
                     std::cout << "Failed :: Texture at  " << textures[type] << " " << texture_path.string() << '\n';
                 }
+                if (compress && !textures[type].empty() && fs::is_regular_file(texture_target_path, ec)) {
+                    if (!compressTexture(texture_target_path, type, verify) && verify) {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        if (cook) {
+            auto cooked_path = models_dir / entry.stem() / (entry.stem().string() + cooked::EXTENSION);
+            if (cookModel(entry, cooked_path, verify)) {
+                obj["path"] = "rc://" + std::filesystem::relative(cooked_path, assetDir).string();
+            } else if (verify) {
+                return false;
             }
         }
     }
@@ -216,7 +330,7 @@ bool exportAudios(const fs::path& assetDir, json& audios) {
     return true;
 }
 
-bool exportMaterials(const fs::path& assetDir, json& materials) {
+bool exportMaterials(const fs::path& assetDir, json& materials, bool compress, bool verify) {
     std::error_code ec;
     auto mat_dir = assetDir / "materials";
     fs::create_directories(mat_dir, ec);
@@ -246,8 +360,8 @@ bool exportMaterials(const fs::path& assetDir, json& materials) {
             int index = 0;
             for (const auto& path : paths) {
                 if (path.is_null()) {
-                    continue;
                     index++;
+                    continue;
                 }
                 auto entry = fs::path(path.get<std::string>());
                 auto target_path = mat_dir / name / entry.filename();
@@ -255,6 +369,11 @@ bool exportMaterials(const fs::path& assetDir, json& materials) {
                 if (copied) {
                     mat[keys[index]] = "rc://" + std::filesystem::relative(target_path, assetDir).string();
                 }
+                if (compress && fs::is_regular_file(target_path, ec)) {
+                    if (!compressTexture(target_path, index, verify) && verify) {
+                        return false;
+                    }
+                }
                 index++;
             }
         }
@@ -265,10 +384,29 @@ bool exportMaterials(const fs::path& assetDir, json& materials) {
 int main(int argc, char** argv) {
     if (argc < 2) {
         std::cerr << "Not enough argument, at least provide the scene file path" << std::endl;
+        std::cerr << "Usage: exporter <scene.json> [--cook] [--compress] [--verify]" << std::endl;
         return 2;
     }
 
     std::string scene_file_name = argv[1];
+    bool cook = false;
+    bool compress = false;
+    bool verify = false;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--cook") {
+            cook = true;
+        } else if (arg == "--compress") {
+            compress = true;
+        } else if (arg == "--verify") {
+            // verifying implies cooking
+            cook = true;
+            verify = true;
+        } else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 2;
+        }
+    }
 
     auto target_scene = fs::path(RESOURCE_DIR) / scene_file_name;
     std::cout << "Target Scene is " << target_scene << std::endl;
@@ -280,8 +418,12 @@ int main(int argc, char** argv) {
     json j;
     json res = j.parse(world_file);
 
-    exportModels(asset_dir, res["objects"]);
-    exportMaterials(asset_dir, res["materials"]);
+    if (!exportModels(asset_dir, res["objects"], cook, compress, verify)) {
+        return 1;
+    }
+    if (!exportMaterials(asset_dir, res["materials"], compress, verify)) {
+        return 1;
+    }
     exportAudios(asset_dir, res["audios"]);
 
     std::ofstream out;
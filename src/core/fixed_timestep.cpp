@@ -0,0 +1,43 @@
+#include "fixed_timestep.h"
+
+#include <algorithm>
+
+FixedTimestep::FixedTimestep(float stepsPerSecond, int maxSubSteps) {
+    setRate(stepsPerSecond);
+    setMaxSubSteps(maxSubSteps);
+}
+
+int FixedTimestep::advance(double frameDelta) {
+    mAccumulator += std::max(frameDelta, 0.0);
+
+    int steps = 0;
+    while (mAccumulator >= mStep && steps < mMaxSubSteps) {
+        mAccumulator -= mStep;
+        ++steps;
+    }
+    // behind by more than maxSubSteps, slow the simulation down instead of catching up later
+    if (mAccumulator >= mStep) {
+        mAccumulator = 0.0;
+    }
+    return steps;
+}
+
+void FixedTimestep::reset() { mAccumulator = 0.0; }
+
+FixedTimestep& FixedTimestep::setRate(float stepsPerSecond) {
+    mStep = 1.0f / std::max(stepsPerSecond, 1.0f);
+    return *this;
+}
+
+FixedTimestep& FixedTimestep::setMaxSubSteps(int maxSubSteps) {
+    mMaxSubSteps = std::max(maxSubSteps, 1);
+    return *this;
+}
+
+float FixedTimestep::getStep() const { return mStep; }
+
+float FixedTimestep::getRate() const { return 1.0f / mStep; }
+
+int FixedTimestep::getMaxSubSteps() const { return mMaxSubSteps; }
+
+float FixedTimestep::getAlpha() const { return static_cast<float>(mAccumulator / mStep); }
@@ -0,0 +1,30 @@
+#ifndef WORLD_EXPLORER_CORE_FIXED_TIMESTEP_H
+#define WORLD_EXPLORER_CORE_FIXED_TIMESTEP_H
+
+/*
+ * Accumulator for running a simulation at a fixed rate from variable frame deltas. advance() returns how many
+ * steps to take this frame, time that does not fit in maxSubSteps steps is dropped so a long frame can not snowball
+ * into longer ones. getAlpha() is how far the frame is between the last two steps, for interpolating the render.
+ */
+class FixedTimestep {
+    public:
+        explicit FixedTimestep(float stepsPerSecond = 60.0f, int maxSubSteps = 4);
+
+        int advance(double frameDelta);
+        void reset();
+
+        FixedTimestep& setRate(float stepsPerSecond);
+        FixedTimestep& setMaxSubSteps(int maxSubSteps);
+
+        float getStep() const;
+        float getRate() const;
+        int getMaxSubSteps() const;
+        float getAlpha() const;
+
+    private:
+        float mStep;
+        int mMaxSubSteps;
+        double mAccumulator = 0.0;
+};
+
+#endif  //! WORLD_EXPLORER_CORE_FIXED_TIMESTEP_H
@@ -0,0 +1,28 @@
+#include "frame_pacer.h"
+
+#include <algorithm>
+
+FramePacer::FramePacer(uint32_t maxLatency) { setMaxLatency(maxLatency); }
+
+void FramePacer::setMaxLatency(uint32_t maxLatency) {
+    mMaxLatency = std::clamp<uint32_t>(maxLatency, 1, MAX_FRAMES_IN_FLIGHT);
+}
+
+uint32_t FramePacer::getMaxLatency() const { return mMaxLatency; }
+
+bool FramePacer::mustWait() const { return getInFlightCount() >= mMaxLatency; }
+
+uint64_t FramePacer::getOldestFrame() const { return mCompleted; }
+
+uint64_t FramePacer::getOldestSubmission() const { return mSubmissions[mCompleted % MAX_FRAMES_IN_FLIGHT]; }
+
+uint64_t FramePacer::submitted(uint64_t submission) {
+    mSubmissions[mFrame % MAX_FRAMES_IN_FLIGHT] = submission;
+    return mFrame++;
+}
+
+void FramePacer::completed(uint64_t frame) { mCompleted = std::clamp(frame + 1, mCompleted, mFrame); }
+
+uint64_t FramePacer::getFrame() const { return mFrame; }
+
+uint32_t FramePacer::getInFlightCount() const { return static_cast<uint32_t>(mFrame - mCompleted); }
@@ -0,0 +1,42 @@
+#ifndef WORLD_EXPLORER_CORE_FRAME_PACER_H
+#define WORLD_EXPLORER_CORE_FRAME_PACER_H
+
+#include <array>
+#include <cstdint>
+
+/*
+ * Bookkeeping of the frames submitted to the GPU but not finished yet. The CPU may record a new frame while fewer
+ * than the max latency are in flight, otherwise it waits for the oldest one. Frames finish in submission order.
+ */
+class FramePacer {
+    public:
+        static inline const uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
+        explicit FramePacer(uint32_t maxLatency = 2);
+
+        // clamped to [1, MAX_FRAMES_IN_FLIGHT], 1 waits for every frame before the next one is recorded
+        void setMaxLatency(uint32_t maxLatency);
+        uint32_t getMaxLatency() const;
+
+        bool mustWait() const;
+        // the oldest frame in flight and its submission index, only valid while one is
+        uint64_t getOldestFrame() const;
+        uint64_t getOldestSubmission() const;
+
+        // the frame being recorded was submitted with `submission`, returns its frame index
+        uint64_t submitted(uint64_t submission);
+        // the GPU finished `frame` and with it every older one
+        void completed(uint64_t frame);
+
+        // the frame being recorded
+        uint64_t getFrame() const;
+        uint32_t getInFlightCount() const;
+
+    private:
+        uint32_t mMaxLatency;
+        uint64_t mFrame = 0;      // frames submitted so far
+        uint64_t mCompleted = 0;  // frames finished so far
+        std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> mSubmissions = {};  // by frame % MAX_FRAMES_IN_FLIGHT
+};
+
+#endif  //! WORLD_EXPLORER_CORE_FRAME_PACER_H
@@ -0,0 +1,104 @@
+#include "hi_z.h"
+
+#include <algorithm>
+#include <bit>
+
+uint32_t HiZPyramid::levelSize(uint32_t size, uint32_t level) { return std::max(1u, size >> level); }
+
+uint32_t HiZPyramid::levelCount(uint32_t width, uint32_t height) {
+    return static_cast<uint32_t>(std::bit_width(std::max({width, height, 1u})));
+}
+
+void HiZPyramid::build(const float* depth, uint32_t width, uint32_t height) {
+    mWidth = width;
+    mHeight = height;
+    mLevels.assign(levelCount(width, height), {});
+    mLevels[0].assign(depth, depth + static_cast<size_t>(width) * height);
+
+    for (uint32_t level = 1; level < mLevels.size(); ++level) {
+        uint32_t src_width = levelSize(width, level - 1);
+        uint32_t src_height = levelSize(height, level - 1);
+        uint32_t dst_width = levelSize(width, level);
+        uint32_t dst_height = levelSize(height, level);
+        const auto& src = mLevels[level - 1];
+        auto& dst = mLevels[level];
+        dst.resize(static_cast<size_t>(dst_width) * dst_height);
+
+        for (uint32_t y = 0; y < dst_height; ++y) {
+            uint32_t last_y = y == dst_height - 1 ? src_height - 1 : std::min(2 * y + 1, src_height - 1);
+            for (uint32_t x = 0; x < dst_width; ++x) {
+                uint32_t last_x = x == dst_width - 1 ? src_width - 1 : std::min(2 * x + 1, src_width - 1);
+                float farthest = 0.0f;
+                for (uint32_t sy = 2 * y; sy <= last_y; ++sy) {
+                    for (uint32_t sx = 2 * x; sx <= last_x; ++sx) {
+                        farthest = std::max(farthest, src[static_cast<size_t>(sy) * src_width + sx]);
+                    }
+                }
+                dst[static_cast<size_t>(y) * dst_width + x] = farthest;
+            }
+        }
+    }
+}
+
+uint32_t HiZPyramid::getLevelCount() const { return static_cast<uint32_t>(mLevels.size()); }
+
+uint32_t HiZPyramid::getWidth(uint32_t level) const { return levelSize(mWidth, level); }
+
+uint32_t HiZPyramid::getHeight(uint32_t level) const { return levelSize(mHeight, level); }
+
+float HiZPyramid::getDepth(uint32_t level, uint32_t x, uint32_t y) const {
+    return mLevels[level][static_cast<size_t>(y) * getWidth(level) + x];
+}
+
+float HiZPyramid::getFarthestDepth(uint32_t firstX, uint32_t firstY, uint32_t lastX, uint32_t lastY) const {
+    uint32_t extent = std::max(lastX - firstX, lastY - firstY) + 1;
+    uint32_t level = std::min(static_cast<uint32_t>(std::bit_width(std::max(extent, 2u) - 2)), getLevelCount() - 1);
+
+    uint32_t max_x = getWidth(level) - 1;
+    uint32_t max_y = getHeight(level) - 1;
+    float farthest = 0.0f;
+    for (uint32_t y = std::min(firstY >> level, max_y); y <= std::min(lastY >> level, max_y); ++y) {
+        for (uint32_t x = std::min(firstX >> level, max_x); x <= std::min(lastX >> level, max_x); ++x) {
+            farthest = std::max(farthest, getDepth(level, x, y));
+        }
+    }
+    return farthest;
+}
+
+bool HiZPyramid::isOccluded(const float* viewProjection, const float* boxMin, const float* boxMax) const {
+    if (mLevels.empty()) {
+        return false;
+    }
+    float min_uv[2] = {1.0f, 1.0f};
+    float max_uv[2] = {0.0f, 0.0f};
+    float nearest = 1.0f;
+    for (uint32_t corner = 0; corner < 8; ++corner) {
+        float point[4] = {(corner & 1) ? boxMax[0] : boxMin[0], (corner & 2) ? boxMax[1] : boxMin[1],
+                          (corner & 4) ? boxMax[2] : boxMin[2], 1.0f};
+        float clip[4] = {};
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                clip[row] += viewProjection[column * 4 + row] * point[column];
+            }
+        }
+        if (clip[3] <= 0.0f) {
+            return false;
+        }
+        float u = clip[0] / clip[3] * 0.5f + 0.5f;
+        float v = 0.5f - clip[1] / clip[3] * 0.5f;
+        min_uv[0] = std::min(min_uv[0], u);
+        min_uv[1] = std::min(min_uv[1], v);
+        max_uv[0] = std::max(max_uv[0], u);
+        max_uv[1] = std::max(max_uv[1], v);
+        nearest = std::min(nearest, clip[2] / clip[3]);
+    }
+
+    auto to_texel = [](float uv, uint32_t size) {
+        return std::min(static_cast<uint32_t>(std::clamp(uv, 0.0f, 1.0f) * size), size - 1);
+    };
+    uint32_t first_x = to_texel(min_uv[0], mWidth);
+    uint32_t first_y = to_texel(min_uv[1], mHeight);
+    uint32_t last_x = to_texel(max_uv[0], mWidth);
+    uint32_t last_y = to_texel(max_uv[1], mHeight);
+    return nearest > getFarthestDepth(first_x, first_y, last_x, last_y);
+}
@@ -0,0 +1,39 @@
+#ifndef WORLD_EXPLORER_CORE_HI_Z_H
+#define WORLD_EXPLORER_CORE_HI_Z_H
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Hierarchical depth for occlusion culling, the CPU reference of hi_z.wgsl and of the occlusion test in the culling
+ * compute. Level 0 is the depth buffer, every texel above keeps the farthest depth of the texels it covers, the last
+ * texel of an odd row or column also takes the one left over. A box is hidden when its nearest depth is behind the
+ * farthest depth under its screen rectangle. Depth grows away from the camera, uv starts at the top left.
+ */
+class HiZPyramid {
+    public:
+        void build(const float* depth, uint32_t width, uint32_t height);
+
+        uint32_t getLevelCount() const;
+        uint32_t getWidth(uint32_t level) const;
+        uint32_t getHeight(uint32_t level) const;
+        float getDepth(uint32_t level, uint32_t x, uint32_t y) const;
+
+        // farthest depth under the level 0 texels [firstX, lastX] x [firstY, lastY], read from the first level where
+        // they span at most 2x2 texels
+        float getFarthestDepth(uint32_t firstX, uint32_t firstY, uint32_t lastX, uint32_t lastY) const;
+
+        // `viewProjection` is column major, a box reaching behind the camera is never occluded
+        bool isOccluded(const float* viewProjection, const float* boxMin, const float* boxMax) const;
+
+        // texel count of one side of level `level` for a level 0 side of `size`
+        static uint32_t levelSize(uint32_t size, uint32_t level);
+        static uint32_t levelCount(uint32_t width, uint32_t height);
+
+    private:
+        std::vector<std::vector<float>> mLevels;
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+};
+
+#endif  //! WORLD_EXPLORER_CORE_HI_Z_H
@@ -0,0 +1,41 @@
+#include "indirect_draw_args.h"
+
+#include <algorithm>
+
+bool IndirectDrawArgs::setMesh(uint32_t slot, uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex) {
+    if (slot >= mArgs.size()) {
+        mArgs.resize(slot + 1, DrawIndexedIndirectArgs{0, 0, 0, 0, 0});
+    }
+    auto& args = mArgs[slot];
+    if (args.indexCount == indexCount && args.firstIndex == firstIndex && args.baseVertex == baseVertex) {
+        return false;
+    }
+    args.indexCount = indexCount;
+    args.firstIndex = firstIndex;
+    args.baseVertex = baseVertex;
+    mDirtyBegin = std::min(mDirtyBegin, slot);
+    mDirtyEnd = std::max(mDirtyEnd, slot + 1);
+    return true;
+}
+
+void IndirectDrawArgs::setInstanceCount(uint32_t visibleCount) {
+    for (auto& args : mArgs) {
+        args.instanceCount = visibleCount;
+    }
+}
+
+std::pair<uint32_t, uint32_t> IndirectDrawArgs::takeDirtyRange() {
+    if (mDirtyBegin >= mDirtyEnd) {
+        return {0, 0};
+    }
+    std::pair<uint32_t, uint32_t> range = {mDirtyBegin, mDirtyEnd};
+    mDirtyBegin = UINT32_MAX;
+    mDirtyEnd = 0;
+    return range;
+}
+
+const std::vector<DrawIndexedIndirectArgs>& IndirectDrawArgs::getArgs() const { return mArgs; }
+
+size_t IndirectDrawArgs::size() const { return mArgs.size(); }
+
+uint64_t IndirectDrawArgs::getOffset(uint32_t slot) { return slot * sizeof(DrawIndexedIndirectArgs); }
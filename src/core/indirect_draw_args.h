@@ -0,0 +1,42 @@
+#ifndef WORLD_EXPLORER_CORE_INDIRECT_DRAW_ARGS_H
+#define WORLD_EXPLORER_CORE_INDIRECT_DRAW_ARGS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct alignas(4) DrawIndexedIndirectArgs {
+        uint32_t indexCount;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        int32_t baseVertex;
+        uint32_t firstInstance;
+};
+
+/*
+ * CPU side of the per mesh draw args of an instanced model, one DrawIndexedIndirectArgs per slot. The index range of
+ * every mesh lives here and is uploaded when it changes (the geometry arena moves meshes when it compacts), the
+ * instance counts are filled on the GPU by the culling pass. setInstanceCount() does the same on the CPU.
+ */
+class IndirectDrawArgs {
+    public:
+        // returns true when the entry of `slot` changed and has to be uploaded again
+        bool setMesh(uint32_t slot, uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex);
+        // what the culling pass writes into every entry, `visibleCount` includes the model itself at instance 0
+        void setInstanceCount(uint32_t visibleCount);
+        // slots changed since the last call as [begin, end), empty when nothing changed
+        std::pair<uint32_t, uint32_t> takeDirtyRange();
+
+        const std::vector<DrawIndexedIndirectArgs>& getArgs() const;
+        size_t size() const;
+        // byte offset of `slot` in the uploaded buffer
+        static uint64_t getOffset(uint32_t slot);
+
+    private:
+        std::vector<DrawIndexedIndirectArgs> mArgs;
+        uint32_t mDirtyBegin = UINT32_MAX;
+        uint32_t mDirtyEnd = 0;
+};
+
+#endif  //! WORLD_EXPLORER_CORE_INDIRECT_DRAW_ARGS_H
@@ -0,0 +1,298 @@
+#include "ktx2.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace ktx2 {
+
+namespace {
+
+constexpr uint8_t IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+// the file puts the 64 bit sgd fields at offset 60, unaligned
+#pragma pack(push, 1)
+struct Header {
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        uint64_t sgdByteOffset;
+        uint64_t sgdByteLength;
+};
+#pragma pack(pop)
+static_assert(sizeof(Header) == 68);
+
+struct LevelIndex {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+};
+
+// Khronos data format descriptor values
+constexpr uint8_t KHR_DF_MODEL_RGBSDA = 1;
+constexpr uint8_t KHR_DF_MODEL_BC1A = 128;
+constexpr uint8_t KHR_DF_MODEL_BC3 = 130;
+constexpr uint8_t KHR_DF_MODEL_BC4 = 131;
+constexpr uint8_t KHR_DF_MODEL_BC5 = 132;
+constexpr uint8_t KHR_DF_MODEL_BC7 = 134;
+constexpr uint8_t KHR_DF_PRIMARIES_BT709 = 1;
+constexpr uint8_t KHR_DF_TRANSFER_LINEAR = 1;
+constexpr uint8_t KHR_DF_CHANNEL_ALPHA = 15;
+
+struct Sample {
+        uint16_t bitOffset;
+        uint16_t bitLength;
+        uint8_t channel;
+};
+
+std::vector<uint32_t> makeDataFormatDescriptor(uint32_t vkFormat) {
+    uint8_t model = KHR_DF_MODEL_RGBSDA;
+    uint8_t block_dimension = 0;  // stored minus one
+    uint32_t bytes_plane = 4;
+    std::vector<Sample> samples;
+    switch (vkFormat) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            model = KHR_DF_MODEL_BC1A;
+            samples = {{0, 64, 0}};
+            break;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+            model = KHR_DF_MODEL_BC3;
+            samples = {{0, 64, KHR_DF_CHANNEL_ALPHA}, {64, 64, 0}};
+            break;
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+            model = KHR_DF_MODEL_BC4;
+            samples = {{0, 64, 0}};
+            break;
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+            model = KHR_DF_MODEL_BC5;
+            samples = {{0, 64, 0}, {64, 64, 1}};
+            break;
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+            model = KHR_DF_MODEL_BC7;
+            samples = {{0, 128, 0}};
+            break;
+        default:
+            samples = {{0, 8, 0}, {8, 8, 1}, {16, 8, 2}, {24, 8, KHR_DF_CHANNEL_ALPHA}};
+            break;
+    }
+    bool compressed = model != KHR_DF_MODEL_RGBSDA;
+    if (compressed) {
+        block_dimension = bc::BLOCK_SIZE - 1;
+        bytes_plane = samples.back().bitOffset / 8 + samples.back().bitLength / 8;
+    }
+
+    uint32_t block_size = 24 + 16 * samples.size();
+    std::vector<uint32_t> words;
+    words.push_back(4 + block_size);  // dfdTotalSize
+    words.push_back(0);               // vendorId, descriptorType
+    words.push_back(2 | (block_size << 16));
+    words.push_back(model | (KHR_DF_PRIMARIES_BT709 << 8) | (KHR_DF_TRANSFER_LINEAR << 16));
+    words.push_back(block_dimension | (block_dimension << 8));
+    words.push_back(bytes_plane);
+    words.push_back(0);
+    for (const auto& sample : samples) {
+        words.push_back(sample.bitOffset | ((sample.bitLength - 1u) << 16) | (uint32_t(sample.channel) << 24));
+        words.push_back(0);  // sample position
+        words.push_back(0);  // lower
+        words.push_back(compressed ? 0xFFFFFFFFu : 0xFFu);
+    }
+    return words;
+}
+
+size_t levelAlignment(uint32_t vkFormat) {
+    auto format = toBlockFormat(vkFormat);
+    return format.has_value() ? bc::blockBytes(*format) : 4;
+}
+
+}  // namespace
+
+uint32_t toVkFormat(bc::Format format) {
+    switch (format) {
+        case bc::Format::BC1:
+            return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        case bc::Format::BC3:
+            return VK_FORMAT_BC3_UNORM_BLOCK;
+        case bc::Format::BC4:
+            return VK_FORMAT_BC4_UNORM_BLOCK;
+        case bc::Format::BC5:
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+        case bc::Format::BC7:
+            return VK_FORMAT_BC7_UNORM_BLOCK;
+    }
+    return VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+std::optional<bc::Format> toBlockFormat(uint32_t vkFormat) {
+    switch (vkFormat) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            return bc::Format::BC1;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+            return bc::Format::BC3;
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+            return bc::Format::BC4;
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+            return bc::Format::BC5;
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+            return bc::Format::BC7;
+        default:
+            return std::nullopt;
+    }
+}
+
+size_t levelBytes(const Image& image, uint32_t level) {
+    uint32_t width = std::max(1u, image.width >> level);
+    uint32_t height = std::max(1u, image.height >> level);
+    auto format = toBlockFormat(image.vkFormat);
+    return format.has_value() ? bc::imageBytes(*format, width, height) : 4 * (size_t)width * height;
+}
+
+bool write(const fs::path& path, const Image& image) {
+    if (image.levels.empty() || image.levels.size() != image.levelCount) {
+        std::cout << "KTX2 - " << path.string() << " has no levels to write\n";
+        return false;
+    }
+    auto dfd = makeDataFormatDescriptor(image.vkFormat);
+    uint32_t level_count = image.levelCount;
+
+    Header header{};
+    header.vkFormat = image.vkFormat;
+    header.typeSize = 1;
+    header.pixelWidth = image.width;
+    header.pixelHeight = image.height;
+    header.faceCount = 1;
+    header.levelCount = level_count;
+    header.dfdByteOffset = sizeof(IDENTIFIER) + sizeof(Header) + sizeof(LevelIndex) * level_count;
+    header.dfdByteLength = dfd.size() * sizeof(uint32_t);
+
+    // mip data goes smallest level first, every level aligned to its block size
+    std::vector<LevelIndex> index(level_count);
+    size_t alignment = levelAlignment(image.vkFormat);
+    size_t offset = header.dfdByteOffset + header.dfdByteLength;
+    for (uint32_t level = level_count; level-- > 0;) {
+        if (image.levels[level].size() != levelBytes(image, level)) {
+            std::cout << "KTX2 - level " << level << " of " << path.string() << " has the wrong size\n";
+            return false;
+        }
+        offset = (offset + alignment - 1) / alignment * alignment;
+        index[level] = {offset, image.levels[level].size(), image.levels[level].size()};
+        offset += image.levels[level].size();
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "KTX2 - failed to open " << path.string() << " for writing\n";
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(IDENTIFIER), sizeof(IDENTIFIER));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(reinterpret_cast<const char*>(index.data()), sizeof(LevelIndex) * index.size());
+    file.write(reinterpret_cast<const char*>(dfd.data()), header.dfdByteLength);
+    for (uint32_t level = level_count; level-- > 0;) {
+        size_t padding = index[level].byteOffset - static_cast<size_t>(file.tellp());
+        static const std::array<char, 16> zeros{};
+        file.write(zeros.data(), padding);
+        file.write(reinterpret_cast<const char*>(image.levels[level].data()), image.levels[level].size());
+    }
+    return file.good();
+}
+
+bool read(const fs::path& path, Image& image, bool headerOnly) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cout << "KTX2 - failed to open " << path.string() << '\n';
+        return false;
+    }
+    std::error_code ec;
+    uint64_t file_size = fs::file_size(path, ec);
+
+    uint8_t identifier[sizeof(IDENTIFIER)];
+    Header header{};
+    file.read(reinterpret_cast<char*>(identifier), sizeof(identifier));
+    file.read(reinterpret_cast<char*>(&header), sizeof(Header));
+    if (!file || std::memcmp(identifier, IDENTIFIER, sizeof(IDENTIFIER)) != 0) {
+        std::cout << "KTX2 - " << path.string() << " is not a KTX2 file\n";
+        return false;
+    }
+    if (header.pixelDepth != 0 || header.layerCount > 1 || header.faceCount != 1 || header.pixelWidth == 0 ||
+        header.pixelHeight == 0 || header.levelCount == 0 || header.levelCount > 32) {
+        std::cout << "KTX2 - " << path.string() << " is not a single 2D image with a mip chain\n";
+        return false;
+    }
+    if (header.supercompressionScheme != 0) {
+        std::cout << "KTX2 - " << path.string() << " is supercompressed, which is not supported\n";
+        return false;
+    }
+    if (header.vkFormat != VK_FORMAT_R8G8B8A8_UNORM && !toBlockFormat(header.vkFormat).has_value()) {
+        std::cout << "KTX2 - " << path.string() << " has the unsupported vkFormat " << header.vkFormat << '\n';
+        return false;
+    }
+
+    image = {};
+    image.vkFormat = header.vkFormat;
+    image.width = header.pixelWidth;
+    image.height = header.pixelHeight;
+    image.levelCount = header.levelCount;
+
+    std::vector<LevelIndex> index(header.levelCount);
+    file.read(reinterpret_cast<char*>(index.data()), sizeof(LevelIndex) * index.size());
+    if (!file) {
+        std::cout << "KTX2 - " << path.string() << " is truncated\n";
+        return false;
+    }
+    for (uint32_t level = 0; level < header.levelCount; ++level) {
+        if (index[level].byteLength != levelBytes(image, level) || index[level].byteOffset > file_size ||
+            index[level].byteLength > file_size - index[level].byteOffset) {
+            std::cout << "KTX2 - level " << level << " of " << path.string() << " is out of bounds\n";
+            return false;
+        }
+    }
+    if (headerOnly) {
+        return true;
+    }
+
+    image.levels.resize(header.levelCount);
+    for (uint32_t level = 0; level < header.levelCount; ++level) {
+        image.levels[level].resize(index[level].byteLength);
+        file.seekg(index[level].byteOffset);
+        file.read(reinterpret_cast<char*>(image.levels[level].data()), index[level].byteLength);
+    }
+    if (!file) {
+        std::cout << "KTX2 - failed to read the levels of " << path.string() << '\n';
+        return false;
+    }
+    return true;
+}
+
+fs::path findCompressedTexture(const fs::path& path) {
+    std::error_code ec;
+    if (path.extension() == EXTENSION) {
+        return fs::exists(path, ec) ? path : fs::path{};
+    }
+
+    auto compressed_path = path;
+    compressed_path.replace_extension(EXTENSION);
+    if (!fs::exists(compressed_path, ec)) {
+        return {};
+    }
+    if (fs::exists(path, ec) && fs::last_write_time(compressed_path, ec) < fs::last_write_time(path, ec)) {
+        std::cout << "KTX2 - " << compressed_path.string() << " is older than its source, ignoring it\n";
+        return {};
+    }
+    return compressed_path;
+}
+
+}  // namespace ktx2
@@ -0,0 +1,52 @@
+#ifndef WORLD_EXPLORER_CORE_KTX2_H
+#define WORLD_EXPLORER_CORE_KTX2_H
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "block_compression.h"
+
+/*
+ * Minimal KTX2 container: one 2D image with its mip chain, no array layers, no cube faces and no supercompression,
+ * which is what the exporter writes. The data format descriptor is written for other tools and ignored on read, the
+ * vkFormat alone decides how the levels are interpreted.
+ */
+namespace ktx2 {
+
+inline constexpr const char* EXTENSION = ".ktx2";
+
+// the vkFormat values used here
+inline constexpr uint32_t VK_FORMAT_R8G8B8A8_UNORM = 37;
+inline constexpr uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+inline constexpr uint32_t VK_FORMAT_BC3_UNORM_BLOCK = 137;
+inline constexpr uint32_t VK_FORMAT_BC4_UNORM_BLOCK = 139;
+inline constexpr uint32_t VK_FORMAT_BC5_UNORM_BLOCK = 141;
+inline constexpr uint32_t VK_FORMAT_BC7_UNORM_BLOCK = 145;
+
+struct Image {
+        uint32_t vkFormat = VK_FORMAT_R8G8B8A8_UNORM;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t levelCount = 0;
+        std::vector<std::vector<uint8_t>> levels;  // level 0 is the largest, empty after a header only read
+};
+
+uint32_t toVkFormat(bc::Format format);
+// nullopt for RGBA8 and for formats bc:: does not know
+std::optional<bc::Format> toBlockFormat(uint32_t vkFormat);
+// bytes of one level of `image`
+size_t levelBytes(const Image& image, uint32_t level);
+
+bool write(const std::filesystem::path& path, const Image& image);
+// validates the header and the level index, `headerOnly` skips reading the level data
+bool read(const std::filesystem::path& path, Image& image, bool headerOnly = false);
+
+// the compressed texture to load for `path`: the path itself when it is a .ktx2 file, otherwise a .ktx2 next to it
+// that is not older than the source. Empty when there is none
+std::filesystem::path findCompressedTexture(const std::filesystem::path& path);
+
+}  // namespace ktx2
+
+#endif  //! WORLD_EXPLORER_CORE_KTX2_H
@@ -0,0 +1,174 @@
+#include "light_clusters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// distance from `center` to [min, max] along one axis
+float axisDistance(float min, float max, float center) { return std::max({0.0f, min - center, center - max}); }
+
+}  // namespace
+
+LightClusters::LightClusters() { setProjection(mXScale, mYScale, mZNear, mZFar); }
+
+void LightClusters::setProjection(float xScale, float yScale, float zNear, float zFar) {
+    mXScale = xScale;
+    mYScale = yScale;
+    mZNear = zNear;
+    mZFar = std::max(zFar, zNear * 1.001f);
+    mSliceDepths.resize(SLICES + 1);
+    mSliceDepths[0] = 0.0f;
+    for (uint32_t slice = 1; slice < SLICES; ++slice) {
+        mSliceDepths[slice] = mZNear * std::pow(mZFar / mZNear, static_cast<float>(slice) / SLICES);
+    }
+    mSliceDepths[SLICES] = mZFar;
+}
+
+float LightClusters::sliceDepth(uint32_t slice) const { return mSliceDepths[std::min(slice, SLICES)]; }
+
+uint32_t LightClusters::clusterIndex(uint32_t x, uint32_t y, uint32_t slice) {
+    return (slice * TILES_Y + y) * TILES_X + x;
+}
+
+LightClusters::Bounds LightClusters::getClusterBounds(uint32_t x, uint32_t y, uint32_t slice) const {
+    float near_depth = sliceDepth(slice);
+    float far_depth = sliceDepth(slice + 1);
+    // tile edges in NDC, a point at distance d on the edge is at ndc * d / scale
+    float ndc_x[2] = {-1.0f + 2.0f * x / TILES_X, -1.0f + 2.0f * (x + 1) / TILES_X};
+    float ndc_y[2] = {-1.0f + 2.0f * y / TILES_Y, -1.0f + 2.0f * (y + 1) / TILES_Y};
+
+    Bounds bounds;
+    bounds.min[0] = bounds.min[1] = std::numeric_limits<float>::max();
+    bounds.max[0] = bounds.max[1] = std::numeric_limits<float>::lowest();
+    for (float depth : {near_depth, far_depth}) {
+        for (int i = 0; i < 2; ++i) {
+            float vx = ndc_x[i] * depth / mXScale;
+            float vy = ndc_y[i] * depth / mYScale;
+            bounds.min[0] = std::min(bounds.min[0], vx);
+            bounds.max[0] = std::max(bounds.max[0], vx);
+            bounds.min[1] = std::min(bounds.min[1], vy);
+            bounds.max[1] = std::max(bounds.max[1], vy);
+        }
+    }
+    bounds.min[2] = -far_depth;
+    bounds.max[2] = -near_depth;
+    return bounds;
+}
+
+bool LightClusters::intersects(const Bounds& bounds, const Sphere& sphere) {
+    float dx = axisDistance(bounds.min[0], bounds.max[0], sphere.x);
+    float dy = axisDistance(bounds.min[1], bounds.max[1], sphere.y);
+    float dz = axisDistance(bounds.min[2], bounds.max[2], sphere.z);
+    return dx * dx + dy * dy + dz * dz <= sphere.radius * sphere.radius;
+}
+
+void LightClusters::build(const std::vector<Sphere>& lights) {
+    mHits.clear();
+    for (uint32_t light = 0; light < lights.size(); ++light) {
+        const auto& sphere = lights[light];
+        if (!(sphere.radius > 0.0f)) {
+            continue;
+        }
+        float radius_squared = sphere.radius * sphere.radius;
+
+        // a cluster can only be hit when the sphere reaches its box along every axis on its own, which narrows
+        // the slices and tiles down before the exact test
+        for (uint32_t slice = 0; slice < SLICES; ++slice) {
+            float dz = axisDistance(-sliceDepth(slice + 1), -sliceDepth(slice), sphere.z);
+            if (dz * dz > radius_squared) {
+                continue;
+            }
+            uint32_t first_x = TILES_X;
+            uint32_t last_x = 0;
+            for (uint32_t x = 0; x < TILES_X; ++x) {
+                auto bounds = getClusterBounds(x, 0, slice);
+                float dx = axisDistance(bounds.min[0], bounds.max[0], sphere.x);
+                if (dx * dx <= radius_squared) {
+                    first_x = std::min(first_x, x);
+                    last_x = x;
+                }
+            }
+            uint32_t first_y = TILES_Y;
+            uint32_t last_y = 0;
+            for (uint32_t y = 0; y < TILES_Y; ++y) {
+                auto bounds = getClusterBounds(0, y, slice);
+                float dy = axisDistance(bounds.min[1], bounds.max[1], sphere.y);
+                if (dy * dy <= radius_squared) {
+                    first_y = std::min(first_y, y);
+                    last_y = y;
+                }
+            }
+            for (uint32_t y = first_y; y <= last_y && first_y < TILES_Y; ++y) {
+                for (uint32_t x = first_x; x <= last_x && first_x < TILES_X; ++x) {
+                    if (intersects(getClusterBounds(x, y, slice), sphere)) {
+                        mHits.emplace_back(clusterIndex(x, y, slice), light);
+                    }
+                }
+            }
+        }
+    }
+
+    // counting sort by cluster, the lights of a cluster stay in ascending order
+    mCounts.assign(CLUSTER_COUNT, 0);
+    for (const auto& [cluster, light] : mHits) {
+        mCounts[cluster]++;
+    }
+    mOverflow = 0;
+    uint32_t offset = 0;
+    for (uint32_t cluster = 0; cluster < CLUSTER_COUNT; ++cluster) {
+        uint32_t count = std::min(mCounts[cluster], MAX_LIGHTS_PER_CLUSTER);
+        mOverflow += mCounts[cluster] - count;
+        mGrid[2 * cluster] = offset;
+        mGrid[2 * cluster + 1] = 0;
+        offset += count;
+    }
+    mIndices.resize(offset);
+    for (const auto& [cluster, light] : mHits) {
+        uint32_t& count = mGrid[2 * cluster + 1];
+        if (count < MAX_LIGHTS_PER_CLUSTER) {
+            mIndices[mGrid[2 * cluster] + count] = light;
+            count++;
+        }
+    }
+}
+
+const std::vector<uint32_t>& LightClusters::getGrid() const { return mGrid; }
+
+const std::vector<uint32_t>& LightClusters::getIndices() const { return mIndices; }
+
+size_t LightClusters::getOverflowCount() const { return mOverflow; }
+
+LightClusters::Uniform LightClusters::getUniform(float screenWidth, float screenHeight) const {
+    Uniform uniform;
+    uniform.tilesX = TILES_X;
+    uniform.tilesY = TILES_Y;
+    uniform.slices = SLICES;
+    uniform.maxLightsPerCluster = MAX_LIGHTS_PER_CLUSTER;
+    uniform.screenWidth = screenWidth;
+    uniform.screenHeight = screenHeight;
+    uniform.zNear = mZNear;
+    uniform.sliceScale = SLICES / std::log(mZFar / mZNear);
+    return uniform;
+}
+
+float LightClusters::attenuationRange(float constant, float linear, float quadratic, float intensity,
+                                      float cutoff) {
+    if (!(intensity > 0.0f)) {
+        return 0.0f;
+    }
+    // largest d with constant + linear d + quadratic d^2 = intensity / cutoff
+    float threshold = intensity / cutoff;
+    if (quadratic > 0.0f) {
+        float discriminant = linear * linear - 4.0f * quadratic * (constant - threshold);
+        if (discriminant < 0.0f) {
+            return 0.0f;
+        }
+        return std::max(0.0f, (-linear + std::sqrt(discriminant)) / (2.0f * quadratic));
+    }
+    if (quadratic == 0.0f && linear > 0.0f) {
+        return std::max(0.0f, (threshold - constant) / linear);
+    }
+    return std::numeric_limits<float>::infinity();
+}
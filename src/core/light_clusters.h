@@ -0,0 +1,89 @@
+#ifndef WORLD_EXPLORER_CORE_LIGHT_CLUSTERS_H
+#define WORLD_EXPLORER_CORE_LIGHT_CLUSTERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*
+ * CPU light binning for clustered forward shading. The view frustum is split in TILES_X x TILES_Y screen tiles and
+ * SLICES depth slices, exponentially spaced between the near and the far plane (the first slice starts at the
+ * camera). Every cluster gets the list of lights whose sphere of influence touches its view space bounding box, the
+ * fragment shader then only shades those. View space follows the camera: x right, y up, looking down -z, and the
+ * projection is symmetric.
+ */
+class LightClusters {
+    public:
+        LightClusters();
+
+        // a light as seen from the camera, radius is where its contribution falls under the cutoff
+        struct Sphere {
+                float x;
+                float y;
+                float z;
+                float radius;
+        };
+
+        struct Bounds {
+                float min[3];
+                float max[3];
+        };
+
+        // matches ClusterParams in common.wgsl
+        struct Uniform {
+                uint32_t tilesX;
+                uint32_t tilesY;
+                uint32_t slices;
+                uint32_t maxLightsPerCluster;
+                float screenWidth;
+                float screenHeight;
+                float zNear;
+                float sliceScale;  // slices / log(zFar / zNear)
+        };
+
+        // `xScale` and `yScale` are the first two diagonal entries of the projection matrix
+        void setProjection(float xScale, float yScale, float zNear, float zFar);
+        // lights keep their index in `lights`, a zero radius is never binned
+        void build(const std::vector<Sphere>& lights);
+
+        // per cluster the offset of its first light in getIndices() and the light count, two words each
+        const std::vector<uint32_t>& getGrid() const;
+        const std::vector<uint32_t>& getIndices() const;
+        // lights left out of full clusters during the last build
+        size_t getOverflowCount() const;
+        Uniform getUniform(float screenWidth, float screenHeight) const;
+
+        Bounds getClusterBounds(uint32_t x, uint32_t y, uint32_t slice) const;
+        static bool intersects(const Bounds& bounds, const Sphere& sphere);
+        static uint32_t clusterIndex(uint32_t x, uint32_t y, uint32_t slice);
+
+        // distance at which intensity / (constant + linear d + quadratic d^2) drops to `cutoff`, infinite when it
+        // never does
+        static float attenuationRange(float constant, float linear, float quadratic, float intensity,
+                                      float cutoff = ATTENUATION_CUTOFF);
+
+        static inline const uint32_t TILES_X = 16;
+        static inline const uint32_t TILES_Y = 9;
+        static inline const uint32_t SLICES = 24;
+        static inline const uint32_t CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+        static inline const uint32_t MAX_LIGHTS_PER_CLUSTER = 64;
+        static inline const float ATTENUATION_CUTOFF = 0.005f;
+
+    private:
+        // view distance where `slice` starts, 0 for the first one
+        float sliceDepth(uint32_t slice) const;
+
+        float mXScale = 1.0f;
+        float mYScale = 1.0f;
+        float mZNear = 0.1f;
+        float mZFar = 100.0f;
+        std::vector<float> mSliceDepths;
+        std::vector<uint32_t> mGrid = std::vector<uint32_t>(2 * CLUSTER_COUNT, 0);
+        std::vector<uint32_t> mIndices;
+        std::vector<uint32_t> mCounts;
+        std::vector<std::pair<uint32_t, uint32_t>> mHits;  // cluster, light
+        size_t mOverflow = 0;
+};
+
+#endif  //! WORLD_EXPLORER_CORE_LIGHT_CLUSTERS_H
@@ -0,0 +1,152 @@
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "assmip/include/assimp/Importer.hpp"
+#include "cooked_asset.h"
+#include "json.hpp"
+#include "loader_pool.h"
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+/*
+ * Headless load benchmark: imports every enabled model of a scene through the same LoaderPool, priorities and
+ * import cap the engine uses, without a GPU. Textures and GPU uploads are not part of it.
+ */
+
+struct SceneStats {
+        size_t models = 0;
+        size_t failed = 0;
+        double wallMs = 0.0;
+        double importMs = 0.0;  // sum over the models
+        long peakRssKb = -1;
+};
+
+#ifdef __linux__
+// writing 5 to clear_refs resets the peak resident set size of the process (VmHWM)
+static void resetPeakRss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+}
+
+static long getPeakRssKb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stol(line.substr(6));
+        }
+    }
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+#else
+static void resetPeakRss() {}
+static long getPeakRssKb() { return -1; }
+#endif
+
+static bool importModel(const fs::path& path) {
+    auto cooked_path = cooked::findCookedAsset(path);
+    if (!cooked_path.empty() && cooked::loadAsset(cooked_path) != nullptr) {
+        return true;
+    }
+    Assimp::Importer importer;
+    ImportSlot import_slot;
+    const aiScene* scene = importer.ReadFile(path.string().c_str(), cooked::IMPORT_FLAGS);
+    return scene != nullptr && !(scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) && scene->mRootNode != nullptr;
+}
+
+static SceneStats benchmarkScene(const fs::path& scenePath, LoaderPool& pool) {
+    SceneStats stats;
+    std::ifstream scene_file(scenePath);
+    if (!scene_file) {
+        std::cerr << "Failed to open " << scenePath << std::endl;
+        stats.failed = 1;
+        return stats;
+    }
+    json scene = json::parse(scene_file);
+    std::string actor = scene.contains("actor") ? scene["actor"].get<std::string>() : "";
+
+    resetPeakRss();
+    std::atomic<size_t> failed{0};
+    std::mutex import_ms_mutex;
+    double import_ms = 0.0;
+    auto start = Clock::now();
+    for (const auto& object : scene["objects"]) {
+        if (!object["enabled"].get<bool>() || object["type"].get<int>() != 0) {
+            continue;
+        }
+        std::string path = object["path"].get<std::string>();
+        if (path.starts_with("rc://")) {
+            path = (scenePath.parent_path() / path.substr(5)).string();
+        }
+        // same priorities as World::loadModel
+        int priority = object["name"].get<std::string>() == actor ? 2 : object["visible"].get<bool>() ? 1 : 0;
+        stats.models++;
+        auto import_job = [path, &failed, &import_ms, &import_ms_mutex] {
+            auto model_start = Clock::now();
+            if (!importModel(path)) {
+                std::cerr << "Failed to import " << path << std::endl;
+                failed++;
+            }
+            std::chrono::duration<double, std::milli> elapsed = Clock::now() - model_start;
+            std::lock_guard<std::mutex> lock(import_ms_mutex);
+            import_ms += elapsed.count();
+        };
+        auto on_complete = [path, &failed](LoaderPool::Status status) {
+            if (status == LoaderPool::Status::Failed) {
+                std::cerr << "Import of " << path << " threw" << std::endl;
+                failed++;
+            }
+        };
+        pool.submit(priority, import_job, on_complete);
+    }
+    pool.waitIdle();
+
+    stats.wallMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    stats.importMs = import_ms;
+    stats.failed = failed;
+    stats.peakRssKb = getPeakRssKb();
+    return stats;
+}
+
+int main(int argc, char** argv) {
+    std::vector<fs::path> scenes;
+    for (int i = 1; i < argc; i++) {
+        scenes.push_back(fs::path(RESOURCE_DIR) / argv[i]);
+    }
+    if (scenes.empty()) {
+        for (const auto& entry : fs::directory_iterator(RESOURCE_DIR)) {
+            if (entry.path().extension() == ".json") {
+                scenes.push_back(entry.path());
+            }
+        }
+    }
+
+    LoaderPool pool{LoaderPool::defaultThreadCount()};
+    std::cout << "Loader threads: " << pool.getThreadCount()
+              << ", concurrent imports: " << ImportSlot::MAX_CONCURRENT_IMPORTS << "\n";
+    std::cout << "scene, models, failed, wall ms, import ms, peak rss MB\n";
+    bool all_loaded = true;
+    for (const auto& scene : scenes) {
+        auto stats = benchmarkScene(scene, pool);
+        all_loaded = all_loaded && stats.failed == 0;
+        std::cout << scene.filename().string() << ", " << stats.models << ", " << stats.failed << ", "
+                  << stats.wallMs << ", " << stats.importMs << ", "
+                  << (stats.peakRssKb < 0 ? std::string("n/a") : std::to_string(stats.peakRssKb / 1024)) << "\n";
+    }
+    return all_loaded ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+#include "loader_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <semaphore>
+
+LoaderPool::LoaderPool(size_t numThreads) {
+    numThreads = std::max<size_t>(numThreads, 1);
+    mWorkers.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; ++i) {
+        mWorkers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+LoaderPool::~LoaderPool() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mShouldTerminate = true;
+        mQueue.clear();
+        mQueuedPriorities.clear();
+    }
+    mWorkAvailable.notify_all();
+    for (auto& worker : mWorkers) {
+        worker.join();
+    }
+}
+
+void LoaderPool::workerLoop() {
+    while (true) {
+        Entry entry;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkAvailable.wait(lock, [this] { return !mQueue.empty() || mShouldTerminate; });
+            if (mShouldTerminate) {
+                return;
+            }
+            auto next = mQueue.begin();
+            mQueuedPriorities.erase(next->first.second);
+            entry = std::move(next->second);
+            mQueue.erase(next);
+            mRunning++;
+        }
+
+        Status status = Status::Finished;
+        try {
+            entry.job();
+        } catch (const std::exception& e) {
+            std::cout << "Loader job failed: " << e.what() << std::endl;
+            status = Status::Failed;
+        } catch (...) {
+            std::cout << "Loader job failed with an unknown exception" << std::endl;
+            status = Status::Failed;
+        }
+        if (entry.onComplete) {
+            entry.onComplete(status);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mRunning--;
+            if (mRunning == 0 && mQueue.empty()) {
+                mIdle.notify_all();
+            }
+        }
+    }
+}
+
+LoaderPool::Ticket LoaderPool::submit(int priority, Job job, Completion onComplete) {
+    Ticket ticket;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ticket = mNextTicket++;
+        mQueue.emplace(Key{-priority, ticket}, Entry{std::move(job), std::move(onComplete)});
+        mQueuedPriorities.emplace(ticket, priority);
+    }
+    mWorkAvailable.notify_one();
+    return ticket;
+}
+
+bool LoaderPool::cancel(Ticket ticket) {
+    Entry entry;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mQueuedPriorities.find(ticket);
+        if (it == mQueuedPriorities.end()) {
+            return false;
+        }
+        auto queued = mQueue.find(Key{-it->second, ticket});
+        entry = std::move(queued->second);
+        mQueue.erase(queued);
+        mQueuedPriorities.erase(it);
+        if (mRunning == 0 && mQueue.empty()) {
+            mIdle.notify_all();
+        }
+    }
+    if (entry.onComplete) {
+        entry.onComplete(Status::Cancelled);
+    }
+    return true;
+}
+
+void LoaderPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdle.wait(lock, [this] { return mRunning == 0 && mQueue.empty(); });
+}
+
+size_t LoaderPool::getThreadCount() const { return mWorkers.size(); }
+
+size_t LoaderPool::getPendingCount() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mQueue.size();
+}
+
+size_t LoaderPool::getRunningCount() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mRunning;
+}
+
+size_t LoaderPool::defaultThreadCount() {
+    size_t hardware = std::thread::hardware_concurrency();
+    return std::clamp<size_t>(hardware / 2, 1, 4);
+}
+
+static std::counting_semaphore<ImportSlot::MAX_CONCURRENT_IMPORTS> import_slots{ImportSlot::MAX_CONCURRENT_IMPORTS};
+
+ImportSlot::ImportSlot() { import_slots.acquire(); }
+
+ImportSlot::~ImportSlot() { import_slots.release(); }
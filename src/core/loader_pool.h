@@ -0,0 +1,79 @@
+#ifndef WORLD_EXPLORER_CORE_LOADER_POOL_H
+#define WORLD_EXPLORER_CORE_LOADER_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Fixed size worker pool for asset loading. Jobs run highest priority first and in submission order within the same
+ * priority. A job that has not started yet can be cancelled, a running one always finishes. onComplete runs right
+ * after the job on its worker thread, or with Status::Cancelled on the cancelling thread when the job was cancelled.
+ * An exception thrown by a job is caught on the worker and reported as Status::Failed.
+ */
+class LoaderPool {
+    public:
+        using Ticket = uint64_t;
+        using Job = std::function<void()>;
+        enum class Status { Finished, Failed, Cancelled };
+        using Completion = std::function<void(Status status)>;
+
+        explicit LoaderPool(size_t numThreads);
+        // pending jobs are dropped without their completions, running ones are waited for
+        ~LoaderPool();
+
+        Ticket submit(int priority, Job job, Completion onComplete = nullptr);
+        // false when the job already started or finished
+        bool cancel(Ticket ticket);
+        // blocks until nothing is pending or running
+        void waitIdle();
+
+        size_t getThreadCount() const;
+        size_t getPendingCount();
+        size_t getRunningCount();
+
+        // a sensible pool size for loading next to the texture loader and the physics jobs
+        static size_t defaultThreadCount();
+
+    private:
+        struct Entry {
+                Job job;
+                Completion onComplete;
+        };
+        using Key = std::pair<int, Ticket>;  // (-priority, ticket), so the map begins with the next job to run
+
+        void workerLoop();
+
+        std::vector<std::thread> mWorkers;
+        std::map<Key, Entry> mQueue;
+        std::unordered_map<Ticket, int> mQueuedPriorities;
+        std::mutex mMutex;
+        std::condition_variable mWorkAvailable;
+        std::condition_variable mIdle;
+        Ticket mNextTicket = 1;
+        size_t mRunning = 0;
+        bool mShouldTerminate = false;
+};
+
+/*
+ * Scoped slot for an assimp import. Only MAX_CONCURRENT_IMPORTS imports run at once whatever the pool size is, an
+ * import holds several times its file size in memory while it post-processes.
+ */
+class ImportSlot {
+    public:
+        ImportSlot();
+        ~ImportSlot();
+        ImportSlot(const ImportSlot&) = delete;
+        ImportSlot& operator=(const ImportSlot&) = delete;
+
+        static inline const int MAX_CONCURRENT_IMPORTS = 2;
+};
+
+#endif  //! WORLD_EXPLORER_CORE_LOADER_POOL_H
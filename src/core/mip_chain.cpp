@@ -0,0 +1,332 @@
+#include "mip_chain.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIP_CHAIN_SSE2 1
+#endif
+
+namespace {
+
+// texels 2x + offset of the source weigh in dst texel x, rows the same
+struct Kernel {
+        int firstOffset;
+        std::vector<float> weights;
+};
+
+constexpr const int KAISER_TAPS = 8;
+constexpr const double KAISER_ALPHA = 4.0;
+constexpr const double KAISER_RADIUS = 2.0;  // in dst texels
+
+// zeroth order modified Bessel function of the first kind
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+Kernel makeKaiserKernel() {
+    Kernel kernel{-KAISER_TAPS / 2 + 1, {}};
+    double total = 0.0;
+    for (int i = 0; i < KAISER_TAPS; ++i) {
+        // distance from the texel center to the dst texel center (between texel 2x and 2x + 1), in dst texels
+        double t = (kernel.firstOffset + i - 0.5) / 2.0;
+        double sinc = t == 0.0 ? 1.0 : std::sin(std::numbers::pi * t) / (std::numbers::pi * t);
+        double ratio = t / KAISER_RADIUS;
+        double window =
+            besselI0(KAISER_ALPHA * std::sqrt(std::max(0.0, 1.0 - ratio * ratio))) / besselI0(KAISER_ALPHA);
+        kernel.weights.push_back(sinc * window);
+        total += sinc * window;
+    }
+    for (auto& weight : kernel.weights) {
+        weight = static_cast<float>(weight / total);
+    }
+    return kernel;
+}
+
+const Kernel& kernelFor(MipFilter filter) {
+    static const Kernel box{0, {0.5f, 0.5f}};
+    static const Kernel kaiser = makeKaiserKernel();
+    return filter == MipFilter::Kaiser ? kaiser : box;
+}
+
+float srgbToLinear(float c) { return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f); }
+
+// sRGB codes decode through a table. Encoding looks the code up in a coarse table and walks the midpoints between
+// neighbouring codes from there, which gives the nearest code as exactly as the midpoints are
+struct SrgbTables {
+        static constexpr const int COARSE_SIZE = 4096;
+
+        std::array<float, 256> toLinear;
+        std::array<float, 255> midpoints;  // linear value half way between code c and c + 1
+        std::array<uint8_t, COARSE_SIZE + 1> coarse;
+
+        SrgbTables() {
+            for (int c = 0; c < 256; ++c) {
+                toLinear[c] = srgbToLinear(c / 255.0f);
+            }
+            for (int c = 0; c < 255; ++c) {
+                midpoints[c] = srgbToLinear((c + 0.5f) / 255.0f);
+            }
+            int code = 0;
+            for (int i = 0; i <= COARSE_SIZE; ++i) {
+                float value = static_cast<float>(i) / COARSE_SIZE;
+                while (code < 255 && value >= midpoints[code]) {
+                    code++;
+                }
+                coarse[i] = static_cast<uint8_t>(code);
+            }
+        }
+
+        uint8_t encode(float linear) const {
+            linear = std::clamp(linear, 0.0f, 1.0f);
+            int code = coarse[static_cast<int>(linear * COARSE_SIZE)];
+            while (code < 255 && linear >= midpoints[code]) {
+                code++;
+            }
+            return static_cast<uint8_t>(code);
+        }
+};
+
+const SrgbTables& srgbTables() {
+    static const SrgbTables tables;
+    return tables;
+}
+
+// linear channels stay in 0..255 so that the box filter of whole numbers is exact, sRGB ones go to 0..1 linear light
+void decodeRow(const uint8_t* src, uint32_t width, bool srgb, float* dst) {
+    if (srgb) {
+        const auto& tables = srgbTables();
+        for (uint32_t i = 0; i < width; ++i) {
+            dst[4 * i + 0] = tables.toLinear[src[4 * i + 0]];
+            dst[4 * i + 1] = tables.toLinear[src[4 * i + 1]];
+            dst[4 * i + 2] = tables.toLinear[src[4 * i + 2]];
+            dst[4 * i + 3] = src[4 * i + 3];
+        }
+        return;
+    }
+    uint32_t i = 0;
+#ifdef MIP_CHAIN_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= width; i += 4) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i));
+        __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+        __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+        _mm_storeu_ps(dst + 4 * i + 0, _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_ps(dst + 4 * i + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_ps(dst + 4 * i + 8, _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_ps(dst + 4 * i + 12, _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)));
+    }
+#endif
+    for (i *= 4; i < 4 * width; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+void encodeRow(const float* src, uint32_t width, bool srgb, uint8_t* dst) {
+    if (srgb) {
+        const auto& tables = srgbTables();
+        for (uint32_t i = 0; i < width; ++i) {
+            dst[4 * i + 0] = tables.encode(src[4 * i + 0]);
+            dst[4 * i + 1] = tables.encode(src[4 * i + 1]);
+            dst[4 * i + 2] = tables.encode(src[4 * i + 2]);
+            dst[4 * i + 3] = static_cast<uint8_t>(std::clamp(src[4 * i + 3], 0.0f, 255.0f) + 0.5f);
+        }
+        return;
+    }
+    uint32_t i = 0;
+#ifdef MIP_CHAIN_SSE2
+    const __m128 low = _mm_setzero_ps();
+    const __m128 high = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; i + 4 <= width; i += 4) {
+        __m128i v[4];
+        for (int k = 0; k < 4; ++k) {
+            __m128 texel = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + 4 * (i + k)), low), high);
+            v[k] = _mm_cvttps_epi32(_mm_add_ps(texel, half));
+        }
+        __m128i words = _mm_packs_epi32(v[0], v[1]);
+        __m128i words2 = _mm_packs_epi32(v[2], v[3]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i), _mm_packus_epi16(words, words2));
+    }
+#endif
+    for (i *= 4; i < 4 * width; ++i) {
+        dst[i] = static_cast<uint8_t>(std::clamp(src[i], 0.0f, 255.0f) + 0.5f);
+    }
+}
+
+// dst[x] = sum of weights[k] * src[clamp(2x + firstOffset + k)], one RGBA texel is 4 floats
+void filterRow(const float* src, uint32_t srcWidth, uint32_t dstWidth, const Kernel& kernel, float* dst) {
+    int last = static_cast<int>(srcWidth) - 1;
+    int taps = static_cast<int>(kernel.weights.size());
+#ifdef MIP_CHAIN_SSE2
+    __m128 weights[KAISER_TAPS];
+    for (int k = 0; k < taps; ++k) {
+        weights[k] = _mm_set1_ps(kernel.weights[k]);
+    }
+#endif
+    for (uint32_t x = 0; x < dstWidth; ++x) {
+        int first = 2 * static_cast<int>(x) + kernel.firstOffset;
+        // only the texels at the edges need clamping
+        bool inside = first >= 0 && first + taps - 1 <= last;
+#ifdef MIP_CHAIN_SSE2
+        __m128 sum = _mm_setzero_ps();
+        if (inside) {
+            const float* texel = src + 4 * first;
+            for (int k = 0; k < taps; ++k) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(weights[k], _mm_loadu_ps(texel + 4 * k)));
+            }
+        } else {
+            for (int k = 0; k < taps; ++k) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(weights[k], _mm_loadu_ps(src + 4 * std::clamp(first + k, 0, last))));
+            }
+        }
+        _mm_storeu_ps(dst + 4 * x, sum);
+#else
+        float sum[4] = {};
+        for (int k = 0; k < taps; ++k) {
+            int sx = inside ? first + k : std::clamp(first + k, 0, last);
+            for (int c = 0; c < 4; ++c) {
+                sum[c] += kernel.weights[k] * src[4 * sx + c];
+            }
+        }
+        std::copy(sum, sum + 4, dst + 4 * x);
+#endif
+    }
+}
+
+// dst += weight * src over `count` floats
+void accumulateRow(const float* src, size_t count, float weight, float* dst) {
+    size_t i = 0;
+#ifdef MIP_CHAIN_SSE2
+    __m128 w = _mm_set1_ps(weight);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(w, _mm_loadu_ps(src + i))));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] += weight * src[i];
+    }
+}
+
+#ifdef MIP_CHAIN_SSE2
+// box filter of linear data straight on the bytes, 16 bit sums give the same result as the float path
+void boxRowRGBA8(const uint8_t* row0, const uint8_t* row1, uint32_t dstWidth, uint8_t* dst) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    uint32_t x = 0;
+    for (; x + 4 <= dstWidth; x += 4) {
+        __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x));
+        __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x + 16));
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x + 16));
+        // texels 0,1 | 2,3 | 4,5 | 6,7 of both rows, summed vertically
+        __m128i s01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+        __m128i s23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+        __m128i s45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+        __m128i s67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+        // neighbouring texels summed horizontally
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23));
+        __m128i hi = _mm_add_epi16(_mm_unpacklo_epi64(s45, s67), _mm_unpackhi_epi64(s45, s67));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * x), _mm_packus_epi16(lo, hi));
+    }
+    for (; x < dstWidth; ++x) {
+        for (int c = 0; c < 4; ++c) {
+            dst[4 * x + c] = (row0[8 * x + c] + row0[8 * x + 4 + c] + row1[8 * x + c] + row1[8 * x + 4 + c] + 2) >> 2;
+        }
+    }
+}
+#endif
+
+}  // namespace
+
+std::vector<uint8_t> downsampleRGBA8(const uint8_t* src, uint32_t width, uint32_t height) {
+    uint32_t dst_width = std::max(1u, width / 2);
+    uint32_t dst_height = std::max(1u, height / 2);
+    std::vector<uint8_t> dst(4 * (size_t)dst_width * dst_height);
+    for (uint32_t y = 0; y < dst_height; ++y) {
+        uint32_t y0 = std::min(2 * y, height - 1);
+        uint32_t y1 = std::min(2 * y + 1, height - 1);
+        for (uint32_t x = 0; x < dst_width; ++x) {
+            uint32_t x0 = std::min(2 * x, width - 1);
+            uint32_t x1 = std::min(2 * x + 1, width - 1);
+            const uint8_t* p00 = &src[4 * ((size_t)y0 * width + x0)];
+            const uint8_t* p01 = &src[4 * ((size_t)y0 * width + x1)];
+            const uint8_t* p10 = &src[4 * ((size_t)y1 * width + x0)];
+            const uint8_t* p11 = &src[4 * ((size_t)y1 * width + x1)];
+            uint8_t* p = &dst[4 * ((size_t)y * dst_width + x)];
+            for (int c = 0; c < 4; ++c) {
+                p[c] = (p00[c] + p01[c] + p10[c] + p11[c] + 2) >> 2;
+            }
+        }
+    }
+    return dst;
+}
+
+std::vector<uint8_t> downsampleRGBA8(const uint8_t* src, uint32_t width, uint32_t height, MipFilter filter,
+                                     bool srgb) {
+    const Kernel& kernel = kernelFor(filter);
+    uint32_t dst_width = std::max(1u, width / 2);
+    uint32_t dst_height = std::max(1u, height / 2);
+    std::vector<uint8_t> dst(4 * (size_t)dst_width * dst_height);
+
+#ifdef MIP_CHAIN_SSE2
+    if (filter == MipFilter::Box && !srgb && width > 1 && height > 1) {
+        for (uint32_t y = 0; y < dst_height; ++y) {
+            boxRowRGBA8(src + 4 * (size_t)(2 * y) * width, src + 4 * (size_t)(2 * y + 1) * width, dst_width,
+                        &dst[4 * (size_t)y * dst_width]);
+        }
+        return dst;
+    }
+#endif
+
+    // source rows filtered horizontally, in a ring: row r sits in slot r % taps
+    size_t taps = kernel.weights.size();
+    size_t row_floats = 4 * (size_t)dst_width;
+    std::vector<float> decoded(4 * (size_t)width);
+    std::vector<float> rows(taps * row_floats);
+    std::vector<int> slot_row(taps, -1);
+    std::vector<float> sum(row_floats);
+
+    int last = static_cast<int>(height) - 1;
+    for (uint32_t y = 0; y < dst_height; ++y) {
+        std::fill(sum.begin(), sum.end(), 0.0f);
+        int first = 2 * static_cast<int>(y) + kernel.firstOffset;
+        for (size_t k = 0; k < taps; ++k) {
+            int sy = std::clamp(first + static_cast<int>(k), 0, last);
+            float* row = &rows[(sy % taps) * row_floats];
+            if (slot_row[sy % taps] != sy) {
+                decodeRow(src + 4 * (size_t)sy * width, width, srgb, decoded.data());
+                filterRow(decoded.data(), width, dst_width, kernel, row);
+                slot_row[sy % taps] = sy;
+            }
+            accumulateRow(row, row_floats, kernel.weights[k], sum.data());
+        }
+        encodeRow(sum.data(), dst_width, srgb, &dst[4 * (size_t)y * dst_width]);
+    }
+    return dst;
+}
+
+std::vector<std::vector<uint8_t>> buildMipChainRGBA8(std::vector<uint8_t> base, uint32_t width, uint32_t height,
+                                                     MipFilter filter, bool srgb, uint32_t levelCount) {
+    std::vector<std::vector<uint8_t>> levels;
+    levels.push_back(std::move(base));
+    while ((width > 1 || height > 1) && (levelCount == 0 || levels.size() < levelCount)) {
+        levels.push_back(downsampleRGBA8(levels.back().data(), width, height, filter, srgb));
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+    return levels;
+}
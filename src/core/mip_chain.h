@@ -0,0 +1,29 @@
+#ifndef WORLD_EXPLORER_CORE_MIP_CHAIN_H
+#define WORLD_EXPLORER_CORE_MIP_CHAIN_H
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * CPU mip generation for RGBA8 images. Every level is filtered from the one above it, separable, in floats and with
+ * SSE2 where it is available. Color data can be filtered in linear light (`srgb`), alpha is always linear. The box
+ * filter on linear data gives the same bytes as downsampleRGBA8, the scalar reference.
+ */
+
+enum class MipFilter : uint8_t {
+    Box,     // 2x2 average
+    Kaiser,  // 8 taps of a Kaiser windowed sinc, keeps more detail in the smaller levels
+};
+
+// 2x2 box filter of an RGBA8 level, odd edges repeat their last texel
+std::vector<uint8_t> downsampleRGBA8(const uint8_t* src, uint32_t width, uint32_t height);
+
+// one level down, texels past the edges repeat the last row and column
+std::vector<uint8_t> downsampleRGBA8(const uint8_t* src, uint32_t width, uint32_t height, MipFilter filter, bool srgb);
+
+// the first `levelCount` levels of an RGBA8 image, level 0 included, 0 goes down to 1x1
+std::vector<std::vector<uint8_t>> buildMipChainRGBA8(std::vector<uint8_t> base, uint32_t width, uint32_t height,
+                                                     MipFilter filter = MipFilter::Box, bool srgb = false,
+                                                     uint32_t levelCount = 0);
+
+#endif  //! WORLD_EXPLORER_CORE_MIP_CHAIN_H
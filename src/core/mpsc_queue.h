@@ -0,0 +1,60 @@
+#ifndef WORLD_EXPLORER_CORE_MPSC_QUEUE_H
+#define WORLD_EXPLORER_CORE_MPSC_QUEUE_H
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+/*
+ * Unbounded lock-free multi producer, single consumer queue (Vyukov's node based queue). push() may be called from
+ * any thread, pop() only from the one consumer thread. A push that is still in progress can make pop() see the queue
+ * as empty, the item shows up on a later pop().
+ */
+template <typename T>
+class MpscQueue {
+    public:
+        MpscQueue() : mHead(new Node{}), mTail(mHead.load(std::memory_order_relaxed)) {}
+
+        ~MpscQueue() {
+            while (pop().has_value()) {
+            }
+            delete mTail;
+        }
+
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        void push(T value) {
+            Node* node = new Node{};
+            node->value.emplace(std::move(value));
+            Node* previous = mHead.exchange(node, std::memory_order_acq_rel);
+            previous->next.store(node, std::memory_order_release);
+        }
+
+        std::optional<T> pop() {
+            Node* next = mTail->next.load(std::memory_order_acquire);
+            if (next == nullptr) {
+                return std::nullopt;
+            }
+            T value = std::move(*next->value);
+            next->value.reset();
+            // `next` becomes the new empty stub
+            delete mTail;
+            mTail = next;
+            return value;
+        }
+
+        // consumer side only
+        bool empty() const { return mTail->next.load(std::memory_order_acquire) == nullptr; }
+
+    private:
+        struct Node {
+                std::atomic<Node*> next{nullptr};
+                std::optional<T> value;
+        };
+
+        std::atomic<Node*> mHead;  // last pushed node, producers swap themselves in here
+        Node* mTail;               // stub before the next node to pop, owned by the consumer
+};
+
+#endif  //! WORLD_EXPLORER_CORE_MPSC_QUEUE_H
@@ -0,0 +1,99 @@
+#include "range_allocator.h"
+
+#include <algorithm>
+#include <iterator>
+
+RangeAllocator::RangeAllocator(uint64_t capacity) { grow(capacity); }
+
+std::optional<uint64_t> RangeAllocator::allocate(uint64_t size) {
+    if (size == 0) {
+        return std::nullopt;
+    }
+    for (auto it = mFreeRanges.begin(); it != mFreeRanges.end(); ++it) {
+        auto [offset, free_size] = *it;
+        if (free_size < size) {
+            continue;
+        }
+        mFreeRanges.erase(it);
+        if (free_size > size) {
+            mFreeRanges.emplace(offset + size, free_size - size);
+        }
+        mFreeSize -= size;
+        return offset;
+    }
+    return std::nullopt;
+}
+
+void RangeAllocator::free(uint64_t offset, uint64_t size) {
+    if (size == 0) {
+        return;
+    }
+    mFreeSize += size;
+
+    auto next = mFreeRanges.lower_bound(offset);
+    // merge with the following range
+    if (next != mFreeRanges.end() && offset + size == next->first) {
+        size += next->second;
+        next = mFreeRanges.erase(next);
+    }
+    // merge with the preceding range
+    if (next != mFreeRanges.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            prev->second += size;
+            return;
+        }
+    }
+    mFreeRanges.emplace(offset, size);
+}
+
+void RangeAllocator::grow(uint64_t capacity) {
+    if (capacity <= mCapacity) {
+        return;
+    }
+    uint64_t old_capacity = mCapacity;
+    mCapacity = capacity;
+    free(old_capacity, capacity - old_capacity);
+}
+
+std::vector<RangeAllocator::Move> RangeAllocator::compact(std::vector<Range*>& live) {
+    std::sort(live.begin(), live.end(), [](const Range* a, const Range* b) { return a->offset < b->offset; });
+
+    std::vector<Move> moves;
+    uint64_t cursor = 0;
+    for (auto* range : live) {
+        if (range->offset != cursor) {
+            moves.push_back({range->offset, cursor, range->size});
+            range->offset = cursor;
+        }
+        cursor += range->size;
+    }
+
+    mFreeRanges.clear();
+    mFreeSize = mCapacity - cursor;
+    if (mFreeSize > 0) {
+        mFreeRanges.emplace(cursor, mFreeSize);
+    }
+    return moves;
+}
+
+uint64_t RangeAllocator::getCapacity() const { return mCapacity; }
+
+uint64_t RangeAllocator::getFreeSize() const { return mFreeSize; }
+
+uint64_t RangeAllocator::getLargestFreeRange() const {
+    uint64_t largest = 0;
+    for (const auto& [offset, size] : mFreeRanges) {
+        largest = std::max(largest, size);
+    }
+    return largest;
+}
+
+size_t RangeAllocator::getFreeRangeCount() const { return mFreeRanges.size(); }
+
+float RangeAllocator::getFragmentation() const {
+    if (mFreeSize == 0) {
+        return 0.0f;
+    }
+    return 1.0f - static_cast<float>(getLargestFreeRange()) / static_cast<float>(mFreeSize);
+}
@@ -0,0 +1,51 @@
+#ifndef WORLD_EXPLORER_CORE_RANGE_ALLOCATOR_H
+#define WORLD_EXPLORER_CORE_RANGE_ALLOCATOR_H
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+/*
+ * First-fit free-list allocator over an abstract [0, capacity) range. It knows nothing about GPU buffers, units are
+ * whatever the owner uses (vertices, indices, bytes), so it can be exercised on the CPU alone.
+ */
+class RangeAllocator {
+    public:
+        struct Range {
+                uint64_t offset;
+                uint64_t size;
+        };
+
+        // a live range that has to be copied from `from` to `to` during compaction
+        struct Move {
+                uint64_t from;
+                uint64_t to;
+                uint64_t size;
+        };
+
+        explicit RangeAllocator(uint64_t capacity = 0);
+
+        std::optional<uint64_t> allocate(uint64_t size);
+        // returns the range to the free list, merging it with its free neighbours
+        void free(uint64_t offset, uint64_t size);
+        // extends the range at the end, the new space is appended to the free list
+        void grow(uint64_t capacity);
+        // packs `live` (ranges currently allocated) to the front in offset order, updates their offsets in place
+        // and leaves a single free range at the end. Returns the copies needed to carry the data along.
+        std::vector<Move> compact(std::vector<Range*>& live);
+
+        uint64_t getCapacity() const;
+        uint64_t getFreeSize() const;
+        uint64_t getLargestFreeRange() const;
+        size_t getFreeRangeCount() const;
+        // 0 when all free space is one range, close to 1 when it is scattered in small holes
+        float getFragmentation() const;
+
+    private:
+        uint64_t mCapacity = 0;
+        uint64_t mFreeSize = 0;
+        std::map<uint64_t, uint64_t> mFreeRanges;  // offset -> size
+};
+
+#endif  //! WORLD_EXPLORER_CORE_RANGE_ALLOCATOR_H
@@ -0,0 +1,92 @@
+#include "render_queue.h"
+
+#include <algorithm>
+
+static uint64_t field(uint64_t value, uint32_t bits) { return value & ((uint64_t{1} << bits) - 1); }
+
+static uint64_t quantizeDepth(float depth) {
+    constexpr const uint64_t max_depth = (uint64_t{1} << RenderQueue::DEPTH_BITS) - 1;
+    return static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(max_depth));
+}
+
+uint64_t RenderQueue::makeOpaqueKey(uint32_t pass, uint32_t pipeline, uint32_t material, float depth) {
+    return field(pass, PASS_BITS) << (PIPELINE_BITS + MATERIAL_BITS + DEPTH_BITS) |
+           field(pipeline, PIPELINE_BITS) << (MATERIAL_BITS + DEPTH_BITS) |
+           field(material, MATERIAL_BITS) << DEPTH_BITS | quantizeDepth(depth);
+}
+
+uint64_t RenderQueue::makeTransparentKey(uint32_t pass, float depth, uint32_t pipeline, uint32_t material) {
+    constexpr const uint64_t max_depth = (uint64_t{1} << DEPTH_BITS) - 1;
+    return field(pass, PASS_BITS) << (DEPTH_BITS + PIPELINE_BITS + MATERIAL_BITS) |
+           (max_depth - quantizeDepth(depth)) << (PIPELINE_BITS + MATERIAL_BITS) |
+           field(pipeline, PIPELINE_BITS) << MATERIAL_BITS | field(material, MATERIAL_BITS);
+}
+
+void RenderQueue::clear() { mItems.clear(); }
+
+void RenderQueue::push(uint64_t key, uint32_t draw) { mItems.push_back({key, draw}); }
+
+void RenderQueue::sort() {
+    mScratch.resize(mItems.size());
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        std::array<size_t, 256> counts = {};
+        for (const auto& item : mItems) {
+            counts[(item.key >> shift) & 0xFF]++;
+        }
+        // every key has the same byte here, the pass would not move anything
+        if (std::ranges::find(counts, mItems.size()) != counts.end()) {
+            continue;
+        }
+        size_t offset = 0;
+        for (auto& count : counts) {
+            size_t bucket = count;
+            count = offset;
+            offset += bucket;
+        }
+        for (const auto& item : mItems) {
+            mScratch[counts[(item.key >> shift) & 0xFF]++] = item;
+        }
+        mItems.swap(mScratch);
+    }
+}
+
+const std::vector<RenderQueue::Item>& RenderQueue::getItems() const { return mItems; }
+
+void StateCache::reset() {
+    mPipeline = nullptr;
+    mBindGroups = {};
+    mBindGroupOffsets = {};
+    mVertexBuffers = {};
+    mIndexBuffer = nullptr;
+}
+
+bool StateCache::setPipeline(const void* pipeline) { return update(mPipeline, pipeline); }
+
+bool StateCache::setBindGroup(uint32_t index, const void* group, uint32_t dynamicOffset) {
+    bool same_offset = mBindGroupOffsets[index] == dynamicOffset;
+    mBindGroupOffsets[index] = dynamicOffset;
+    return update(mBindGroups[index], group, same_offset);
+}
+
+bool StateCache::setVertexBuffer(uint32_t slot, const void* buffer) { return update(mVertexBuffers[slot], buffer); }
+
+bool StateCache::setIndexBuffer(const void* buffer) { return update(mIndexBuffer, buffer); }
+
+bool StateCache::update(const void*& bound, const void* handle, bool sameOffset) {
+    if (sameOffset && bound == handle && handle != nullptr) {
+        mElided++;
+        return false;
+    }
+    bound = handle;
+    mIssued++;
+    return true;
+}
+
+size_t StateCache::getIssuedCount() const { return mIssued; }
+
+size_t StateCache::getElidedCount() const { return mElided; }
+
+void StateCache::resetCounters() {
+    mIssued = 0;
+    mElided = 0;
+}
@@ -0,0 +1,77 @@
+#ifndef WORLD_EXPLORER_CORE_RENDER_QUEUE_H
+#define WORLD_EXPLORER_CORE_RENDER_QUEUE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Draw submissions of a frame ordered by a packed 64 bit key. The pass is in the top bits, opaque keys continue with
+ * pipeline, material and depth front to back so state changes are grouped, transparent keys put the depth back to
+ * front right after the pass. The items live in reused arrays and are sorted with a LSD radix sort.
+ */
+class RenderQueue {
+    public:
+        static inline const uint32_t PASS_BITS = 4;
+        static inline const uint32_t PIPELINE_BITS = 12;
+        static inline const uint32_t MATERIAL_BITS = 24;
+        static inline const uint32_t DEPTH_BITS = 24;
+
+        struct Item {
+                uint64_t key;
+                uint32_t draw;  // index into the caller's draw list
+        };
+
+        // `depth` in [0, 1], clamped. Ids wrap at their bit width
+        static uint64_t makeOpaqueKey(uint32_t pass, uint32_t pipeline, uint32_t material, float depth);
+        static uint64_t makeTransparentKey(uint32_t pass, float depth, uint32_t pipeline, uint32_t material);
+
+        void clear();
+        void push(uint64_t key, uint32_t draw);
+        // stable, by ascending key
+        void sort();
+
+        const std::vector<Item>& getItems() const;
+
+    private:
+        std::vector<Item> mItems;
+        std::vector<Item> mScratch;
+};
+
+/*
+ * The pipeline, bind groups and geometry buffers bound on an encoder, to skip the set calls that would not change
+ * anything. Handles are only compared, reset() has to be called whenever the state is changed around the cache or a
+ * pass begins.
+ */
+class StateCache {
+    public:
+        static inline const uint32_t MAX_BIND_GROUPS = 8;
+        static inline const uint32_t MAX_VERTEX_BUFFERS = 2;
+
+        void reset();
+        // true if the call has to be issued, the handle counts as bound afterwards
+        bool setPipeline(const void* pipeline);
+        // a bind group with a dynamic offset is only bound again when the offset differs
+        bool setBindGroup(uint32_t index, const void* group, uint32_t dynamicOffset = 0);
+        // buffers are always bound whole
+        bool setVertexBuffer(uint32_t slot, const void* buffer);
+        bool setIndexBuffer(const void* buffer);
+
+        size_t getIssuedCount() const;
+        size_t getElidedCount() const;
+        void resetCounters();
+
+    private:
+        bool update(const void*& bound, const void* handle, bool sameOffset = true);
+
+        const void* mPipeline = nullptr;
+        std::array<const void*, MAX_BIND_GROUPS> mBindGroups = {};
+        std::array<uint32_t, MAX_BIND_GROUPS> mBindGroupOffsets = {};
+        std::array<const void*, MAX_VERTEX_BUFFERS> mVertexBuffers = {};
+        const void* mIndexBuffer = nullptr;
+        size_t mIssued = 0;
+        size_t mElided = 0;
+};
+
+#endif  //! WORLD_EXPLORER_CORE_RENDER_QUEUE_H
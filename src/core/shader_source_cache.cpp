@@ -0,0 +1,161 @@
+#include "shader_source_cache.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+
+#include "cache_key.h"
+
+// first line of the files in the disk directory, followed by the dependency count and one line per dependency
+constexpr const char* DISK_MAGIC = "// world explorer preprocessed shader v1";
+
+void ShaderSourceCache::setDiskDirectory(const std::filesystem::path& directory) {
+    mDiskDirectory = directory;
+    if (mDiskDirectory.empty()) {
+        return;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(mDiskDirectory, error);
+    if (error) {
+        std::cout << "Shader cache - Failed to create " << mDiskDirectory.string() << ": " << error.message() << '\n';
+        mDiskDirectory.clear();
+    }
+}
+
+const ShaderSourceCache::Source& ShaderSourceCache::load(const std::filesystem::path& path) {
+    auto [it, inserted] = mEntries.try_emplace(path.string());
+    Entry& entry = it->second;
+    if (!inserted && isCurrent(entry)) {
+        mStats.hits++;
+        return entry.source;
+    }
+    mStats.misses++;
+
+    if (loadFromDisk(path, entry)) {
+        mStats.diskHits++;
+        return entry.source;
+    }
+
+    std::vector<std::filesystem::path> includes;
+    entry.dependencies = {{path, getModifiedTime(path)}};
+    entry.source.code = preprocess(readFile(path), path.parent_path(), includes);
+    entry.source.hash = CacheKey::hash(entry.source.code);
+    for (const auto& include : includes) {
+        entry.dependencies.push_back({include, getModifiedTime(include)});
+    }
+    saveToDisk(path, entry);
+    return entry.source;
+}
+
+const ShaderSourceCache::Stats& ShaderSourceCache::getStats() const { return mStats; }
+
+std::string ShaderSourceCache::readFile(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    if (!file.is_open()) {
+        std::cout << "Failed to open shader at " << path << std::endl;
+        return {};
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+std::string ShaderSourceCache::preprocess(std::string code, const std::filesystem::path& basePath,
+                                          std::vector<std::filesystem::path>& includes) {
+    uint32_t expanded = 0;
+    size_t directive = code.find("#include");
+    while (directive != std::string::npos) {
+        size_t name_begin = code.find('"', directive);
+        size_t name_end = name_begin == std::string::npos ? name_begin : code.find('"', name_begin + 1);
+        if (name_end == std::string::npos) {
+            std::cout << "Shader cache - Malformed #include in " << basePath.string() << '\n';
+            break;
+        }
+        if (++expanded > MAX_INCLUDES) {
+            std::cout << "Shader cache - More than " << MAX_INCLUDES << " includes below " << basePath.string()
+                      << ", is a file including itself?\n";
+            break;
+        }
+        auto include = basePath / code.substr(name_begin + 1, name_end - name_begin - 1);
+        includes.push_back(include);
+        // the included code is searched as well, it may include files itself
+        code.replace(directive, name_end - directive + 1, readFile(include));
+        directive = code.find("#include", directive);
+    }
+    return code;
+}
+
+int64_t ShaderSourceCache::getModifiedTime(const std::filesystem::path& path) {
+    std::error_code error;
+    auto time = std::filesystem::last_write_time(path, error);
+    return error ? -1 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+bool ShaderSourceCache::isCurrent(const Entry& entry) {
+    for (const auto& dependency : entry.dependencies) {
+        if (getModifiedTime(dependency.path) != dependency.modified) {
+            return false;
+        }
+    }
+    return !entry.dependencies.empty();
+}
+
+std::filesystem::path ShaderSourceCache::getDiskPath(const std::filesystem::path& path) const {
+    std::ostringstream name;
+    name << std::hex << CacheKey::hash(path.string()) << ".wgsl";
+    return mDiskDirectory / name.str();
+}
+
+bool ShaderSourceCache::loadFromDisk(const std::filesystem::path& path, Entry& entry) const {
+    if (mDiskDirectory.empty()) {
+        return false;
+    }
+    std::ifstream file{getDiskPath(path), std::ios::binary};
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string line;
+    size_t count = 0;
+    if (!std::getline(file, line) || line != DISK_MAGIC || !(file >> line >> count) || line != "//") {
+        return false;
+    }
+    std::vector<Dependency> dependencies(count);
+    for (auto& dependency : dependencies) {
+        if (!(file >> line >> dependency.modified) || line != "//" || file.get() != ' ' || !std::getline(file, line)) {
+            return false;
+        }
+        dependency.path = line;
+    }
+    // written for another file with the same name hash
+    if (dependencies.empty() || dependencies.front().path != path) {
+        return false;
+    }
+    Entry cached{{}, std::move(dependencies)};
+    if (!isCurrent(cached)) {
+        return false;
+    }
+    std::ostringstream code;
+    code << file.rdbuf();
+    cached.source.code = code.str();
+    cached.source.hash = CacheKey::hash(cached.source.code);
+    entry = std::move(cached);
+    return true;
+}
+
+void ShaderSourceCache::saveToDisk(const std::filesystem::path& path, const Entry& entry) {
+    if (mDiskDirectory.empty()) {
+        return;
+    }
+    std::ofstream file{getDiskPath(path), std::ios::binary | std::ios::trunc};
+    if (!file.is_open()) {
+        std::cout << "Shader cache - Failed to write to " << mDiskDirectory.string() << ", disk cache disabled\n";
+        mDiskDirectory.clear();
+        return;
+    }
+    file << DISK_MAGIC << "\n// " << entry.dependencies.size() << '\n';
+    for (const auto& dependency : entry.dependencies) {
+        file << "// " << dependency.modified << ' ' << dependency.path.string() << '\n';
+    }
+    file << entry.source.code;
+}
@@ -0,0 +1,64 @@
+#ifndef WORLD_EXPLORER_CORE_SHADER_SOURCE_CACHE_H
+#define WORLD_EXPLORER_CORE_SHADER_SOURCE_CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * WGSL sources with their #include directives expanded, together with the files they were built from. A cached
+ * source is used as long as none of these files was modified since, so edited shaders are picked up on the next
+ * load. With a disk directory set, preprocessed sources survive restarts too.
+ */
+class ShaderSourceCache {
+    public:
+        static inline const uint32_t MAX_INCLUDES = 256;
+
+        struct Source {
+                std::string code;
+                uint64_t hash = 0;  // of code
+        };
+
+        struct Stats {
+                size_t hits = 0;
+                size_t misses = 0;
+                size_t diskHits = 0;  // misses served from the disk directory
+        };
+
+        // empty keeps the sources in memory only
+        void setDiskDirectory(const std::filesystem::path& directory);
+
+        const Source& load(const std::filesystem::path& path);
+        const Stats& getStats() const;
+
+        static std::string readFile(const std::filesystem::path& path);
+        // expands the #include "name" directives of `code`, names are relative to `basePath`. Nested includes are
+        // expanded as well, every included file is appended to `includes`
+        static std::string preprocess(std::string code, const std::filesystem::path& basePath,
+                                      std::vector<std::filesystem::path>& includes);
+
+    private:
+        struct Dependency {
+                std::filesystem::path path;
+                int64_t modified;  // -1 if the file did not exist
+        };
+
+        struct Entry {
+                Source source;
+                std::vector<Dependency> dependencies;  // the loaded file first
+        };
+
+        static int64_t getModifiedTime(const std::filesystem::path& path);
+        static bool isCurrent(const Entry& entry);
+        std::filesystem::path getDiskPath(const std::filesystem::path& path) const;
+        bool loadFromDisk(const std::filesystem::path& path, Entry& entry) const;
+        void saveToDisk(const std::filesystem::path& path, const Entry& entry);
+
+        std::unordered_map<std::string, Entry> mEntries;  // by path
+        std::filesystem::path mDiskDirectory;
+        Stats mStats;
+};
+
+#endif  //! WORLD_EXPLORER_CORE_SHADER_SOURCE_CACHE_H
@@ -0,0 +1,80 @@
+#include "staging_ring.h"
+
+#include <algorithm>
+
+StagingRing::StagingRing(uint64_t blockSize, uint32_t maxBlocks) : mBlockSize(blockSize), mMaxBlocks(maxBlocks) {}
+
+StagingRing::Allocation StagingRing::allocate(uint64_t size, uint64_t alignment) {
+    if (size > mBlockSize) {
+        return {};
+    }
+    if (mCurrent != NO_BLOCK) {
+        uint64_t offset = (mBlocks[mCurrent].head + alignment - 1) / alignment * alignment;
+        if (offset + size <= mBlockSize) {
+            mBlocks[mCurrent].head = offset + size;
+            return {mCurrent, offset};
+        }
+    }
+
+    uint32_t block = takeBlock();
+    if (block == NO_BLOCK) {
+        return {};
+    }
+    mCurrent = block;
+    mBlocks[block].head = size;
+    return {block, 0};
+}
+
+uint32_t StagingRing::takeBlock() {
+    uint32_t block = NO_BLOCK;
+    if (!mFree.empty()) {
+        block = mFree.back();
+        mFree.pop_back();
+    } else if (mBlocks.size() < mMaxBlocks) {
+        block = static_cast<uint32_t>(mBlocks.size());
+        mBlocks.emplace_back();
+    } else {
+        return NO_BLOCK;
+    }
+    mBlocks[block].state = State::Writing;
+    mBlocks[block].head = 0;
+    mWriting.push_back(block);
+    return block;
+}
+
+void StagingRing::submit(uint64_t frame, std::vector<uint32_t>& blocks) {
+    blocks = mWriting;
+    for (uint32_t block : mWriting) {
+        mBlocks[block].state = State::InFlight;
+        mBlocks[block].frame = frame;
+    }
+    mInFlight += static_cast<uint32_t>(mWriting.size());
+    mWriting.clear();
+    mCurrent = NO_BLOCK;
+}
+
+void StagingRing::release(uint32_t block) {
+    if (mBlocks[block].state != State::InFlight) {
+        return;
+    }
+    mBlocks[block].state = State::Free;
+    mBlocks[block].frame = NO_FRAME;
+    mFree.push_back(block);
+    mInFlight--;
+}
+
+uint64_t StagingRing::getBlockSize() const { return mBlockSize; }
+
+uint32_t StagingRing::getBlockCount() const { return static_cast<uint32_t>(mBlocks.size()); }
+
+uint32_t StagingRing::getInFlightCount() const { return mInFlight; }
+
+uint64_t StagingRing::getOldestInFlightFrame() const {
+    uint64_t oldest = NO_FRAME;
+    for (const auto& block : mBlocks) {
+        if (block.state == State::InFlight) {
+            oldest = std::min(oldest, block.frame);
+        }
+    }
+    return oldest;
+}
@@ -0,0 +1,60 @@
+#ifndef WORLD_EXPLORER_CORE_STAGING_RING_H
+#define WORLD_EXPLORER_CORE_STAGING_RING_H
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Sub-allocator of upload memory split into fixed size blocks. Allocations are bumped inside the block being written,
+ * a full block is swapped for a free one or a new one up to `maxBlocks`. submit() hands the written blocks to the GPU
+ * tagged with the frame that submitted them, they come back with release() once the GPU is done with them. The
+ * blocks cycle like a ring, a frame only waits for memory when all of them are still in flight.
+ */
+class StagingRing {
+    public:
+        static inline const uint32_t NO_BLOCK = UINT32_MAX;
+        static inline const uint64_t NO_FRAME = UINT64_MAX;
+
+        struct Allocation {
+                uint32_t block = NO_BLOCK;
+                uint64_t offset = 0;
+        };
+
+        StagingRing(uint64_t blockSize, uint32_t maxBlocks);
+
+        // block is NO_BLOCK if `size` is bigger than a block or every block is in flight. A block index equal to the
+        // block count before the call is a new block
+        Allocation allocate(uint64_t size, uint64_t alignment);
+        // the blocks written since the last submit, they are in flight for `frame` from now on. `blocks` is
+        // overwritten
+        void submit(uint64_t frame, std::vector<uint32_t>& blocks);
+        // the GPU finished reading `block`
+        void release(uint32_t block);
+
+        uint64_t getBlockSize() const;
+        uint32_t getBlockCount() const;
+        uint32_t getInFlightCount() const;
+        // NO_FRAME if nothing is in flight
+        uint64_t getOldestInFlightFrame() const;
+
+    private:
+        enum class State : uint8_t { Free, Writing, InFlight };
+
+        struct Block {
+                State state = State::Free;
+                uint64_t frame = NO_FRAME;
+                uint64_t head = 0;
+        };
+
+        uint32_t takeBlock();
+
+        uint64_t mBlockSize;
+        uint32_t mMaxBlocks;
+        std::vector<Block> mBlocks;
+        std::vector<uint32_t> mFree;
+        std::vector<uint32_t> mWriting;
+        uint32_t mCurrent = NO_BLOCK;
+        uint32_t mInFlight = 0;
+};
+
+#endif  //! WORLD_EXPLORER_CORE_STAGING_RING_H
@@ -0,0 +1,55 @@
+#include "static_casters.h"
+
+#include <algorithm>
+
+bool StaticCasters::update(const void* key, uint64_t signature, bool canBeStatic) {
+    auto [entry, inserted] = mStates.try_emplace(key);
+    auto& state = entry->second;
+    bool unchanged = !inserted && state.signature == signature;
+    state.stillFrames = unchanged ? std::min(state.stillFrames + 1, STATIC_FRAMES) : 0;
+    state.signature = signature;
+    state.lastFrame = mFrame;
+
+    bool is_static = canBeStatic && state.stillFrames >= STATIC_FRAMES;
+    // a caster that settled joins the cache, a static one that changed has to leave it
+    if (is_static != state.isStatic) {
+        mChanged = true;
+        mStaticCount += is_static ? 1 : -1;
+        state.isStatic = is_static;
+    }
+    return is_static;
+}
+
+bool StaticCasters::endFrame() {
+    std::erase_if(mStates, [this](const auto& entry) {
+        if (entry.second.lastFrame == mFrame) {
+            return false;
+        }
+        if (entry.second.isStatic) {
+            mChanged = true;
+            mStaticCount--;
+        }
+        return true;
+    });
+    mFrame++;
+    bool changed = mChanged;
+    mChanged = false;
+    return changed;
+}
+
+void StaticCasters::invalidate() { mChanged = true; }
+
+bool StaticCasters::isStatic(const void* key) const {
+    auto state = mStates.find(key);
+    return state != mStates.end() && state->second.isStatic;
+}
+
+size_t StaticCasters::getStaticCount() const { return mStaticCount; }
+
+uint64_t StaticCasters::mix(uint64_t signature, const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        signature = (signature ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return signature;
+}
@@ -0,0 +1,45 @@
+#ifndef WORLD_EXPLORER_CORE_STATIC_CASTERS_H
+#define WORLD_EXPLORER_CORE_STATIC_CASTERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+/*
+ * Sorts shadow casters into static and dynamic ones for the cached shadow maps. A caster is described by a signature
+ * of everything it puts into the shadow map (transform, visible meshes, bounds), it turns static once the signature
+ * held for STATIC_FRAMES frames and dynamic again as soon as it changes. The cache has to be redrawn whenever the set
+ * of static casters changed, a static caster that moved or disappeared included.
+ */
+class StaticCasters {
+    public:
+        // `key` identifies the caster across frames, casters that can never be static are always dynamic
+        bool update(const void* key, uint64_t signature, bool canBeStatic);
+        // forgets the casters that were not updated this frame, true when the static set changed since the last call
+        bool endFrame();
+        // the next endFrame reports a change
+        void invalidate();
+        bool isStatic(const void* key) const;
+        size_t getStaticCount() const;
+
+        // FNV-1a of `size` bytes on top of `signature`
+        static uint64_t mix(uint64_t signature, const void* data, size_t size);
+
+        static inline const uint64_t EMPTY_SIGNATURE = 0xcbf29ce484222325ull;
+        static inline const uint32_t STATIC_FRAMES = 30;
+
+    private:
+        struct State {
+                uint64_t signature = 0;
+                uint64_t lastFrame = 0;
+                uint32_t stillFrames = 0;
+                bool isStatic = false;
+        };
+
+        std::unordered_map<const void*, State> mStates;
+        uint64_t mFrame = 1;
+        size_t mStaticCount = 0;
+        bool mChanged = true;
+};
+
+#endif  //! WORLD_EXPLORER_CORE_STATIC_CASTERS_H
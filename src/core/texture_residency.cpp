@@ -0,0 +1,198 @@
+#include "texture_residency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static constexpr const TextureResidency::Handle NO_TEXTURE = std::numeric_limits<TextureResidency::Handle>::max();
+
+TextureResidency::TextureResidency(size_t budgetBytes) : mBudget(budgetBytes) {}
+
+uint32_t TextureResidency::mipCount(uint32_t width, uint32_t height) {
+    uint32_t size = std::max({width, height, 1u});
+    uint32_t count = 1;
+    while (size > 1) {
+        size >>= 1;
+        count++;
+    }
+    return count;
+}
+
+uint32_t TextureResidency::tailMip(uint32_t width, uint32_t height) {
+    uint32_t size = std::max(width, height);
+    uint32_t level = 0;
+    while ((size >> level) > TAIL_SIZE) {
+        level++;
+    }
+    return std::min(level, mipCount(width, height) - 1);
+}
+
+size_t TextureResidency::levelBytes(uint32_t width, uint32_t height, uint32_t blockBytes, uint32_t blockSize,
+                                    uint32_t level) {
+    size_t blocks_x = (std::max(1u, width >> level) + blockSize - 1) / blockSize;
+    size_t blocks_y = (std::max(1u, height >> level) + blockSize - 1) / blockSize;
+    return blocks_x * blocks_y * blockBytes;
+}
+
+uint32_t TextureResidency::desiredMip(uint32_t size, float screenPixels) {
+    if (screenPixels <= 0.0f) {
+        return std::numeric_limits<uint32_t>::max();
+    }
+    float level = std::floor(std::log2(static_cast<float>(size) / screenPixels));
+    return level <= 0.0f ? 0 : static_cast<uint32_t>(level);
+}
+
+size_t TextureResidency::residentBytes(const Entry& entry, uint32_t firstMip) const {
+    size_t bytes = 0;
+    uint32_t count = mipCount(entry.width, entry.height);
+    for (uint32_t level = firstMip; level < count; ++level) {
+        bytes += levelBytes(entry.width, entry.height, entry.blockBytes, entry.blockSize, level);
+    }
+    return bytes;
+}
+
+TextureResidency::Handle TextureResidency::add(uint32_t width, uint32_t height, uint32_t blockBytes,
+                                               uint32_t blockSize) {
+    Handle handle;
+    if (!mFreeHandles.empty()) {
+        handle = mFreeHandles.back();
+        mFreeHandles.pop_back();
+    } else {
+        handle = static_cast<Handle>(mEntries.size());
+        mEntries.emplace_back();
+    }
+
+    auto& entry = mEntries[handle];
+    entry = {};
+    entry.width = width;
+    entry.height = height;
+    entry.blockBytes = blockBytes;
+    entry.blockSize = blockSize;
+    entry.tailMip = tailMip(width, height);
+    entry.firstMip = entry.tailMip;
+    entry.requestedMip = entry.tailMip;
+    entry.alive = true;
+    mResident += residentBytes(entry, entry.firstMip);
+    return handle;
+}
+
+void TextureResidency::remove(Handle handle) {
+    if (handle >= mEntries.size() || !mEntries[handle].alive) {
+        return;
+    }
+    auto& entry = mEntries[handle];
+    mResident -= residentBytes(entry, entry.firstMip);
+    entry.alive = false;
+    mFreeHandles.push_back(handle);
+}
+
+void TextureResidency::request(Handle handle, uint32_t mip, float priority, uint64_t frame) {
+    if (handle >= mEntries.size() || !mEntries[handle].alive) {
+        return;
+    }
+    auto& entry = mEntries[handle];
+    // several users in the same frame: the finest level and the highest priority win
+    if (entry.lastUsed != frame) {
+        entry.requestedMip = entry.tailMip;
+        entry.priority = priority;
+    }
+    entry.requestedMip = std::min({entry.requestedMip, mip, entry.tailMip});
+    entry.priority = std::max(entry.priority, priority);
+    entry.lastUsed = frame;
+}
+
+void TextureResidency::setFirstMip(Handle handle, uint32_t firstMip, std::vector<Change>& changes) {
+    auto& entry = mEntries[handle];
+    mResident -= residentBytes(entry, entry.firstMip);
+    mResident += residentBytes(entry, firstMip);
+
+    auto change = std::find_if(changes.begin(), changes.end(), [&](const Change& c) { return c.handle == handle; });
+    if (change == changes.end()) {
+        changes.push_back({handle, entry.firstMip, firstMip});
+    } else {
+        change->newFirstMip = firstMip;
+    }
+    entry.firstMip = firstMip;
+}
+
+bool TextureResidency::makeRoom(size_t bytes, Handle self, float priority, uint64_t frame,
+                                std::vector<Change>& changes) {
+    while (mResident + bytes > mBudget) {
+        Handle victim = NO_TEXTURE;
+        for (Handle handle = 0; handle < mEntries.size(); ++handle) {
+            const auto& entry = mEntries[handle];
+            if (handle == self || !entry.alive || entry.firstMip >= entry.tailMip) {
+                continue;
+            }
+            bool evictable = entry.lastUsed < frame || entry.firstMip < entry.requestedMip || entry.priority < priority;
+            if (!evictable) {
+                continue;
+            }
+            if (victim == NO_TEXTURE) {
+                victim = handle;
+                continue;
+            }
+            const auto& best = mEntries[victim];
+            if (entry.lastUsed < best.lastUsed || (entry.lastUsed == best.lastUsed && entry.priority < best.priority)) {
+                victim = handle;
+            }
+        }
+        if (victim == NO_TEXTURE) {
+            return false;
+        }
+        setFirstMip(victim, mEntries[victim].firstMip + 1, changes);
+    }
+    return true;
+}
+
+std::vector<TextureResidency::Change> TextureResidency::update(uint64_t frame, size_t uploadBytes) {
+    std::vector<Change> changes;
+
+    // the budget may have been lowered since the last update
+    makeRoom(0, NO_TEXTURE, std::numeric_limits<float>::max(), frame, changes);
+
+    std::vector<Handle> wanted;
+    for (Handle handle = 0; handle < mEntries.size(); ++handle) {
+        const auto& entry = mEntries[handle];
+        if (entry.alive && entry.lastUsed == frame && entry.requestedMip < entry.firstMip) {
+            wanted.push_back(handle);
+        }
+    }
+    std::stable_sort(wanted.begin(), wanted.end(),
+                     [&](Handle a, Handle b) { return mEntries[a].priority > mEntries[b].priority; });
+
+    size_t uploaded = 0;
+    for (Handle handle : wanted) {
+        auto& entry = mEntries[handle];
+        while (entry.firstMip > entry.requestedMip) {
+            size_t bytes =
+                levelBytes(entry.width, entry.height, entry.blockBytes, entry.blockSize, entry.firstMip - 1);
+            if (uploaded > 0 && uploaded + bytes > uploadBytes) {
+                break;
+            }
+            if (!makeRoom(bytes, handle, entry.priority, frame, changes)) {
+                break;
+            }
+            setFirstMip(handle, entry.firstMip - 1, changes);
+            uploaded += bytes;
+        }
+        if (uploaded >= uploadBytes) {
+            break;
+        }
+    }
+
+    std::erase_if(changes, [](const Change& c) { return c.oldFirstMip == c.newFirstMip; });
+    return changes;
+}
+
+void TextureResidency::setBudget(size_t budgetBytes) { mBudget = budgetBytes; }
+
+size_t TextureResidency::getBudget() const { return mBudget; }
+
+size_t TextureResidency::getResidentBytes() const { return mResident; }
+
+size_t TextureResidency::getTextureCount() const { return mEntries.size() - mFreeHandles.size(); }
+
+uint32_t TextureResidency::getFirstMip(Handle handle) const { return mEntries[handle].firstMip; }
+
+uint32_t TextureResidency::getTailMip(Handle handle) const { return mEntries[handle].tailMip; }
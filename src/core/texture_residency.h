@@ -0,0 +1,80 @@
+#ifndef WORLD_EXPLORER_CORE_TEXTURE_RESIDENCY_H
+#define WORLD_EXPLORER_CORE_TEXTURE_RESIDENCY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Book keeping of which mips of the streamed textures are in VRAM, without touching the GPU. A texture always keeps
+ * its mip tail (the levels not larger than TAIL_SIZE) resident, finer levels are streamed in one after another for
+ * the textures requested during a frame, highest priority first. When the next level does not fit in the budget the
+ * least recently used textures give up their finest levels, textures used in the same frame only when they have
+ * lower priority or more levels than they asked for.
+ */
+class TextureResidency {
+    public:
+        using Handle = uint32_t;
+
+        struct Change {
+                Handle handle;
+                uint32_t oldFirstMip;
+                uint32_t newFirstMip;
+        };
+
+        explicit TextureResidency(size_t budgetBytes);
+
+        // starts with the mip tail resident, its bytes count even when they go over the budget. Uncompressed
+        // textures are blocks of 1x1 texels, block compressed ones of 4x4
+        Handle add(uint32_t width, uint32_t height, uint32_t blockBytes, uint32_t blockSize = 1);
+        void remove(Handle handle);
+
+        // `mip` is the finest level the texture needs this frame, larger `priority` streams first
+        void request(Handle handle, uint32_t mip, float priority, uint64_t frame);
+
+        // streams in at most `uploadBytes` of new levels (one level always goes through) and evicts what is needed
+        // to stay in the budget. The caller applies the returned changes, one per texture
+        std::vector<Change> update(uint64_t frame, size_t uploadBytes);
+
+        void setBudget(size_t budgetBytes);
+        size_t getBudget() const;
+        size_t getResidentBytes() const;
+        size_t getTextureCount() const;
+        uint32_t getFirstMip(Handle handle) const;
+        uint32_t getTailMip(Handle handle) const;
+
+        static uint32_t mipCount(uint32_t width, uint32_t height);
+        static uint32_t tailMip(uint32_t width, uint32_t height);
+        static size_t levelBytes(uint32_t width, uint32_t height, uint32_t blockBytes, uint32_t blockSize,
+                                 uint32_t level);
+        // level whose texels map about 1:1 to `screenPixels` pixels, 0 when the texture is magnified
+        static uint32_t desiredMip(uint32_t size, float screenPixels);
+
+        static inline const uint32_t TAIL_SIZE = 64;
+
+    private:
+        struct Entry {
+                uint32_t width = 0;
+                uint32_t height = 0;
+                uint32_t blockBytes = 0;
+                uint32_t blockSize = 1;
+                uint32_t tailMip = 0;
+                uint32_t firstMip = 0;
+                uint32_t requestedMip = 0;
+                float priority = 0.0f;
+                uint64_t lastUsed = 0;
+                bool alive = false;
+        };
+
+        size_t residentBytes(const Entry& entry, uint32_t firstMip) const;
+        // drops levels of other textures until `bytes` more fit, false when not enough of them can go
+        bool makeRoom(size_t bytes, Handle self, float priority, uint64_t frame, std::vector<Change>& changes);
+        void setFirstMip(Handle handle, uint32_t firstMip, std::vector<Change>& changes);
+
+        std::vector<Entry> mEntries;
+        std::vector<Handle> mFreeHandles;
+        size_t mBudget = 0;
+        size_t mResident = 0;
+};
+
+#endif  //! WORLD_EXPLORER_CORE_TEXTURE_RESIDENCY_H
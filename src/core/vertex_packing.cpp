@@ -0,0 +1,135 @@
+#include "vertex_packing.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace packing {
+
+static uint32_t packSnorm16(float value) {
+    return static_cast<uint16_t>(static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f)));
+}
+
+static float unpackSnorm16(uint32_t value) {
+    return std::max(static_cast<float>(static_cast<int16_t>(value & 0xFFFF)) / 32767.0f, -1.0f);
+}
+
+static uint16_t toHalf(float value) {
+    uint32_t bits = std::bit_cast<uint32_t>(value);
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t magnitude = bits & 0x7FFFFFFF;
+    if (magnitude >= 0x7F800000) {
+        return static_cast<uint16_t>(sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0));
+    }
+    // 65520 and up round to infinity
+    if (magnitude >= 0x477FF000) {
+        return static_cast<uint16_t>(sign | 0x7C00);
+    }
+    // below the smallest normal half, the subnormal steps are 2^-24
+    if (magnitude < 0x38800000) {
+        float steps = std::nearbyint(std::bit_cast<float>(magnitude) * 16777216.0f);
+        return static_cast<uint16_t>(sign | static_cast<uint32_t>(steps));
+    }
+    uint32_t rounded = magnitude + 0xFFF + ((magnitude >> 13) & 1);
+    return static_cast<uint16_t>(sign | ((rounded - 0x38000000) >> 13));
+}
+
+static float fromHalf(uint16_t half) {
+    uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    if (exponent == 0) {
+        float value = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign != 0 ? -value : value;
+    }
+    if (exponent == 31) {
+        return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+    }
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+uint32_t packOctahedral(float x, float y, float z) {
+    float l1 = std::abs(x) + std::abs(y) + std::abs(z);
+    if (l1 < 1e-8f) {
+        return 0;
+    }
+    x /= l1;
+    y /= l1;
+    float u = x;
+    float v = y;
+    if (z < 0.0f) {
+        // fold the lower hemisphere over the diagonals
+        u = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        v = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return packSnorm16(u) | packSnorm16(v) << 16;
+}
+
+std::array<float, 3> unpackOctahedral(uint32_t packed) {
+    float x = unpackSnorm16(packed);
+    float y = unpackSnorm16(packed >> 16);
+    float z = 1.0f - std::abs(x) - std::abs(y);
+    float t = std::max(-z, 0.0f);
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+    float length = std::sqrt(x * x + y * y + z * z);
+    return {x / length, y / length, z / length};
+}
+
+uint32_t packHalf2(float x, float y) { return toHalf(x) | static_cast<uint32_t>(toHalf(y)) << 16; }
+
+std::array<float, 2> unpackHalf2(uint32_t packed) {
+    return {fromHalf(static_cast<uint16_t>(packed)), fromHalf(static_cast<uint16_t>(packed >> 16))};
+}
+
+uint32_t packUnorm4(float x, float y, float z, float w) {
+    uint32_t packed = 0;
+    std::array<float, 4> values = {x, y, z, w};
+    for (uint32_t i = 0; i < 4; i++) {
+        packed |= static_cast<uint32_t>(std::round(std::clamp(values[i], 0.0f, 1.0f) * 255.0f)) << (8 * i);
+    }
+    return packed;
+}
+
+std::array<float, 4> unpackUnorm4(uint32_t packed) {
+    std::array<float, 4> values;
+    for (uint32_t i = 0; i < 4; i++) {
+        values[i] = static_cast<float>((packed >> (8 * i)) & 0xFF) / 255.0f;
+    }
+    return values;
+}
+
+uint32_t packWeights(std::array<float, 4> weights) {
+    float sum = 0.0f;
+    for (auto& weight : weights) {
+        weight = std::max(weight, 0.0f);
+        sum += weight;
+    }
+    if (sum <= 0.0f) {
+        weights = {1.0f, 0.0f, 0.0f, 0.0f};
+        sum = 1.0f;
+    }
+    // round, then hand the rounding error to the heaviest influence so the weights still add up to one
+    std::array<int32_t, 4> quantized;
+    for (uint32_t i = 0; i < 4; i++) {
+        quantized[i] = static_cast<int32_t>(std::round(weights[i] / sum * 255.0f));
+    }
+    auto heaviest = std::ranges::max_element(quantized);
+    *heaviest += 255 - (quantized[0] + quantized[1] + quantized[2] + quantized[3]);
+
+    uint32_t packed = 0;
+    for (uint32_t i = 0; i < 4; i++) {
+        packed |= static_cast<uint32_t>(std::clamp(quantized[i], 0, 255)) << (8 * i);
+    }
+    return packed;
+}
+
+uint32_t packBoneIds(std::array<int32_t, 4> ids) {
+    uint32_t packed = 0;
+    for (uint32_t i = 0; i < 4; i++) {
+        packed |= static_cast<uint32_t>(std::clamp(ids[i], 0, MAX_PACKED_BONE_ID)) << (8 * i);
+    }
+    return packed;
+}
+
+}  // namespace packing
@@ -0,0 +1,34 @@
+#ifndef WORLD_EXPLORER_CORE_VERTEX_PACKING_H
+#define WORLD_EXPLORER_CORE_VERTEX_PACKING_H
+
+#include <array>
+#include <cstdint>
+
+/*
+ * Encoding of the packed vertex attributes (PackedVertex and PackedSkin in mesh.h). Every function packs into the
+ * 32 bit word the GPU reads with the matching vertex format, the unpack functions decode like the GPU does.
+ */
+namespace packing {
+// half floats keep UVs in [-2, 2] within half a texel of a 1024px texture, larger ones stay in the full layout
+inline constexpr float MAX_PACKED_UV = 2.0f;
+inline constexpr int32_t MAX_PACKED_BONE_ID = 255;
+
+// octahedral encoding of a direction as snorm16x2, the zero vector decodes to +Z
+uint32_t packOctahedral(float x, float y, float z);
+std::array<float, 3> unpackOctahedral(uint32_t packed);
+
+// float16x2, rounded to nearest even
+uint32_t packHalf2(float x, float y);
+std::array<float, 2> unpackHalf2(uint32_t packed);
+
+// unorm8x4, clamped to [0, 1]
+uint32_t packUnorm4(float x, float y, float z, float w);
+std::array<float, 4> unpackUnorm4(uint32_t packed);
+
+// unorm8x4 of the normalized weights, the bytes add up to exactly 255
+uint32_t packWeights(std::array<float, 4> weights);
+// uint8x4, clamped to [0, MAX_PACKED_BONE_ID]
+uint32_t packBoneIds(std::array<int32_t, 4> ids);
+}  // namespace packing
+
+#endif  //! WORLD_EXPLORER_CORE_VERTEX_PACKING_H
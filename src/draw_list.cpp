@@ -0,0 +1,97 @@
+#include "draw_list.h"
+
+#include <algorithm>
+
+#include "application.h"
+#include "model.h"
+#include "profiling.h"
+
+void DrawList::begin(const glm::vec3& cameraPos, float far) {
+    mCameraPos = cameraPos;
+    mFar = std::max(far, 0.001f);
+    mQueue.clear();
+    mDraws.clear();
+    // ids only order the draws of one frame, released handles must not keep their slots
+    mPipelineIds.clear();
+    mMaterialIds.clear();
+}
+
+uint32_t DrawList::getId(std::unordered_map<const void*, uint32_t>& ids, const void* handle) {
+    return ids.try_emplace(handle, static_cast<uint32_t>(ids.size())).first->second;
+}
+
+void DrawList::add(Application* app, Model* model, bool transparent) {
+    if (!model->getVisible() || model->mRootNode == nullptr) {
+        return;
+    }
+    const glm::mat4& world = model->getGlobalTransform();
+
+    std::vector<Node*> nodes = {model->mRootNode};
+    while (!nodes.empty()) {
+        Node* node = nodes.back();
+        nodes.pop_back();
+        nodes.insert(nodes.end(), node->mChildrens.begin(), node->mChildrens.end());
+
+        for (auto mid : node->mMeshIndices) {
+            auto& mesh = model->mFlattenMeshes[mid];
+            if (!mesh.getVisible()) {
+                continue;
+            }
+            // the centre of the mesh's bounds, a big model's meshes can be far apart. The origin for an empty mesh
+            glm::vec3 center{0.0f};
+            if (mesh.mBoundsMin.x <= mesh.mBoundsMax.x) {
+                center = (mesh.mBoundsMin + mesh.mBoundsMax) * 0.5f;
+            }
+            center = glm::vec3{world * glm::vec4{center, 1.0f}};
+            float depth = glm::distance(mCameraPos, center) / mFar;
+            WGPURenderPipeline pipeline = model->getMeshPipeline(app, mesh);
+            uint32_t pipeline_id = getId(mPipelineIds, pipeline);
+            uint32_t material_id = getId(mMaterialIds, model->getTextureBindGroup(app, mesh));
+            uint64_t key = transparent ? RenderQueue::makeTransparentKey(1, depth, pipeline_id, material_id)
+                                       : RenderQueue::makeOpaqueKey(0, pipeline_id, material_id, depth);
+            mQueue.push(key, static_cast<uint32_t>(mDraws.size()));
+            mDraws.push_back({model, static_cast<int>(mid), pipeline});
+        }
+    }
+}
+
+void DrawList::draw(Application* app, WGPURenderPassEncoder encoder) {
+    ZoneScopedNC("Draw list", 0xFF);
+    mQueue.sort();
+    mState.reset();
+    mState.resetCounters();
+
+    WGPUBindGroup app_group = app->getBindingGroup().getBindGroup();
+    for (const auto& item : mQueue.getItems()) {
+        auto& draw = mDraws[item.draw];
+        auto& mesh = draw.model->mFlattenMeshes[draw.meshId];
+
+        if (mState.setPipeline(draw.pipeline)) {
+            wgpuRenderPassEncoderSetPipeline(encoder, draw.pipeline);
+        }
+        WGPUBindGroup groups[] = {app_group, draw.model->getObjectInfoBindGroup(),
+                                  draw.model->getTextureBindGroup(app, mesh)};
+        for (uint32_t index = 0; index < 3; index++) {
+            if (mState.setBindGroup(index, groups[index])) {
+                wgpuRenderPassEncoderSetBindGroup(encoder, index, groups[index], 0, nullptr);
+            }
+        }
+        const auto& material = draw.model->getMaterialBinding(app, mesh);
+        if (mState.setBindGroup(6, material.group, material.dynamicOffset)) {
+            material.set(encoder, 6);
+        }
+
+        mesh.bindGeometry(encoder, app->mGeometryArena, &mState);
+        if (draw.model->instance != nullptr) {
+            draw.model->drawInstances(app, encoder, draw.meshId, mesh);
+        } else {
+            mesh.drawIndexed(encoder);
+        }
+    }
+
+    mStats.draws = mDraws.size();
+    mStats.issued = mState.getIssuedCount();
+    mStats.elided = mState.getElidedCount();
+}
+
+const DrawList::Stats& DrawList::getStats() const { return mStats; }
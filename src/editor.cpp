@@ -366,8 +366,8 @@ struct GizmoModelY : public IModel {
                 .create(&app->getRendererResource());
 
             auto& databuffer = mModel->mGlobalMeshTransformationData;
-            wgpuQueueWriteBuffer(app->getRendererResource().queue, mModel->mGlobalMeshTransformationBuffer.getBuffer(),
-                                 0, databuffer.data(), sizeof(glm::mat4) * databuffer.size());
+            mModel->mGlobalMeshTransformationBuffer.queueWrite(0, databuffer.data(),
+                                                               sizeof(glm::mat4) * databuffer.size());
             mModel->createSomeBinding(app, app->getDefaultTextureBindingData());
         }
 
@@ -424,9 +424,8 @@ struct BoneModel : public IModel {
                 positions, rotations, scales, hasPhysics, glm::vec4{mModel->min, 1.0f}, glm::vec4{mModel->max, 1.0f},
                 {}};
 
-            wgpuQueueWriteBuffer(app->getRendererResource().queue,
-                                 app->mInstanceManager->getInstancingBuffer().getBuffer(), 0,
-                                 ins->mInstanceBuffer.data(), sizeof(InstanceData) * (ins->mInstanceBuffer.size() - 1));
+            app->mInstanceManager->getInstancingBuffer().queueWrite(
+                0, ins->mInstanceBuffer.data(), sizeof(InstanceData) * (ins->mInstanceBuffer.size() - 1));
 
             mModel->mIndirectDrawArgsBuffer.setLabel(("indirect draw args buffer for bone indicator "))
                 .setUsage(WGPUBufferUsage_Storage | WGPUBufferUsage_Indirect | WGPUBufferUsage_CopySrc |
@@ -436,22 +435,7 @@ struct BoneModel : public IModel {
                 .create(&app->getRendererResource());
 
             auto indirect = DrawIndexedIndirectArgs{0, 0, 0, 0, 0};
-            wgpuQueueWriteBuffer(app->getRendererResource().queue, mModel->mIndirectDrawArgsBuffer.getBuffer(), 0,
-                                 &indirect, sizeof(DrawIndexedIndirectArgs));
-
-            for (auto& [mat_id, mesh] : mModel->mFlattenMeshes) {
-                mesh.mIndirectDrawArgsBuffer.setLabel(("indirect_draw_args_mesh_ " + mModel->getName()).c_str())
-                    .setUsage(WGPUBufferUsage_Storage | WGPUBufferUsage_Indirect | WGPUBufferUsage_CopyDst)
-                    .setSize(sizeof(DrawIndexedIndirectArgs))
-                    .setMappedAtCraetion()
-                    .create(&app->getRendererResource());
-
-                std::cout << ")))))))))))) For " << mModel->getName() << &mesh << " Index count is "
-                          << static_cast<uint32_t>(mesh.mIndexData.size()) << std::endl;
-                auto indirect = DrawIndexedIndirectArgs{static_cast<uint32_t>(mesh.mIndexData.size()), 0, 0, 0, 0};
-                wgpuQueueWriteBuffer(app->getRendererResource().queue, mesh.mIndirectDrawArgsBuffer.getBuffer(), 0,
-                                     &indirect, sizeof(DrawIndexedIndirectArgs));
-            }
+            mModel->mIndirectDrawArgsBuffer.queueWrite(0, &indirect, sizeof(DrawIndexedIndirectArgs));
 
             // this needs to be elevated above the buffer update call for instance manager insatnce buffer
             //
@@ -493,8 +477,8 @@ struct GizmoModelX : public IModel {
                 .create(&app->getRendererResource());
 
             auto& databuffer = mModel->mGlobalMeshTransformationData;
-            wgpuQueueWriteBuffer(app->getRendererResource().queue, mModel->mGlobalMeshTransformationBuffer.getBuffer(),
-                                 0, databuffer.data(), sizeof(glm::mat4) * databuffer.size());
+            mModel->mGlobalMeshTransformationBuffer.queueWrite(0, databuffer.data(),
+                                                               sizeof(glm::mat4) * databuffer.size());
             mModel->createSomeBinding(app, app->getDefaultTextureBindingData());
         }
 
@@ -531,8 +515,8 @@ struct GizmoModelCenter : public IModel {
                 .create(&app->getRendererResource());
 
             auto& databuffer = mModel->mGlobalMeshTransformationData;
-            wgpuQueueWriteBuffer(app->getRendererResource().queue, mModel->mGlobalMeshTransformationBuffer.getBuffer(),
-                                 0, databuffer.data(), sizeof(glm::mat4) * databuffer.size());
+            mModel->mGlobalMeshTransformationBuffer.queueWrite(0, databuffer.data(),
+                                                               sizeof(glm::mat4) * databuffer.size());
 
             mModel->createSomeBinding(app, app->getDefaultTextureBindingData());
         }
@@ -0,0 +1,84 @@
+#include "frustum.h"
+
+// p-vertex test, only the corner furthest along the plane normal has to be checked
+bool isBoxOutsidePlane(const frustum::Plane& plane, const glm::vec3& min, const glm::vec3& max) {
+    glm::vec3 p_vertex = {plane.normal.x >= 0.0f ? max.x : min.x, plane.normal.y >= 0.0f ? max.y : min.y,
+                          plane.normal.z >= 0.0f ? max.z : min.z};
+    return dot(plane.normal, p_vertex) + plane.distance < 0.0f;
+}
+
+bool Frustum::AABBTest(const glm::vec3& min, const glm::vec3& max) const {
+    for (size_t i = 0; i < 6; i++) {
+        if (isBoxOutsidePlane(faces[i], min, max)) {
+            return false;  // Culled
+        }
+    }
+    return true;  // Visible or intersecting
+}
+
+Frustum Frustum::fromMatrix(const glm::mat4& viewProjection) {
+    // Gribb/Hartmann, glm matrices are column major so a row is gathered from the columns
+    auto row = [&viewProjection](int i) {
+        return glm::vec4{viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]};
+    };
+    FrustumPlanesUniform planes = {};
+    const glm::vec4 rows[6] = {row(3) + row(0), row(3) - row(0), row(3) + row(1),
+                               row(3) - row(1), row(3) + row(2), row(3) - row(2)};
+    for (size_t i = 0; i < 6; i++) {
+        planes.planes[i].N_D = rows[i];
+    }
+
+    Frustum frustum = fromPlanes(planes);
+    for (auto& face : frustum.faces) {
+        face.normalize();
+    }
+    frustum.leftFace = frustum.faces[0];
+    frustum.rightFace = frustum.faces[1];
+    frustum.bottomFace = frustum.faces[2];
+    frustum.topFace = frustum.faces[3];
+    frustum.nearFace = frustum.faces[4];
+    frustum.farFace = frustum.faces[5];
+    return frustum;
+}
+
+Frustum Frustum::fromPlanes(const FrustumPlanesUniform& planes) {
+    Frustum frustum;
+    for (size_t i = 0; i < 6; i++) {
+        frustum.faces[i] = frustum::Plane{planes.planes[i].N_D.w, glm::vec3(planes.planes[i].N_D)};
+    }
+    return frustum;
+}
+
+FrustumPlanesUniform createFrustumPlanes(const Frustum& frustum) {
+    FrustumPlanesUniform uniform{};
+    for (size_t i = 0; i < 6; i++) {
+        uniform.planes[i].N_D = glm::vec4{frustum.faces[i].normal, frustum.faces[i].distance};
+    }
+    return uniform;
+}
+
+void cullInstances(const FrustumPlanesUniform& planes, std::span<const InstanceBounds> instances,
+                   std::vector<uint8_t>& visible, std::vector<uint32_t>& indices) {
+    Frustum frustum = Frustum::fromPlanes(planes);
+    visible.assign(instances.size(), 0);
+    indices.clear();
+    for (size_t i = 0; i < instances.size(); i++) {
+        visible[i] = i == 0 || frustum.AABBTest(glm::vec3(instances[i].minAABB), glm::vec3(instances[i].maxAABB));
+        if (i != 0 && visible[i]) {
+            indices.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+namespace frustum {
+Plane::Plane(const glm::vec3& p1, const glm::vec3& norm) : normal(glm::normalize(norm)), distance(glm::dot(norm, p1)) {}
+Plane::Plane(float d, const glm::vec3& norm) : normal(norm), distance(d) {}
+
+void Plane::normalize() {
+    float length = glm::length(normal);
+    if (length > 0.0f) {
+        normal /= length;
+        distance /= length;
+    }
+}
+}  // namespace frustum
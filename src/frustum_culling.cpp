@@ -1,6 +1,7 @@
 
 #include "frustum_culling.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <format>
 
@@ -10,24 +11,14 @@
 #include "glm/fwd.hpp"
 #include "glm/gtc/type_ptr.hpp"
 #include "glm/trigonometric.hpp"
+#include "hi_z.h"
 #include "instance.h"
+#include "pipeline_cache.h"
+#include "profiling.h"
 #include "rendererResource.h"
-#include "shader.h"
 #include "shapes.h"
 #include "webgpu/webgpu.h"
 
-WGPUShaderModule createComputeShaderModule(WGPUDevice device, const char* shaderSrc, const char* label) {
-    WGPUShaderSourceWGSL shader_wgsl_desc = {};
-    shader_wgsl_desc.chain.next = nullptr;
-    shader_wgsl_desc.chain.sType = WGPUSType_ShaderSourceWGSL;
-    shader_wgsl_desc.code = {shaderSrc, strlen(shaderSrc)};
-    WGPUShaderModuleDescriptor shader_module_desc = {};
-    shader_module_desc.nextInChain = &shader_wgsl_desc.chain;
-    shader_module_desc.label = {label, WGPU_STRLEN};
-    WGPUShaderModule shader_module = wgpuDeviceCreateShaderModule(device, &shader_module_desc);
-    return shader_module;
-}
-
 std::ostream& operator<<(std::ostream& os, const frustum::Plane& plane) {
     os << "Plane(normal: [" << plane.normal.x << ", " << plane.normal.y << ", " << plane.normal.z
        << "], d: " << plane.distance << ")";
@@ -40,28 +31,6 @@ frustum::Plane makePlane(const glm::vec3& a, const glm::vec3& b, const glm::vec3
     return frustum::Plane{d, normal};  // plane: normal.x * x + normal.y * y + normal.z * z + d = 0
 }
 
-bool isBoxOutsidePlane(const frustum::Plane& plane, const glm::vec3& min, const glm::vec3& max) {
-    (void)max;
-    if (dot(plane.normal, min) + plane.distance > 0) {
-        return false;  // at least one corner is inside this plane
-    }
-    return true;  // all corners are outside this plane
-}
-
-bool Frustum::AABBTest(const glm::vec3& min, const glm::vec3& max) {
-    for (size_t i = 0; i < 6; i++) {
-        if (isBoxOutsidePlane(faces[i], min, max)) {
-            return false;  // Culled
-        }
-    }
-    return true;  // Visible or intersecting
-}
-
-namespace frustum {
-Plane::Plane(const glm::vec3& p1, const glm::vec3& norm) : normal(glm::normalize(norm)), distance(glm::dot(norm, p1)) {}
-Plane::Plane(float d, const glm::vec3& norm) : normal(norm), distance(d) {}
-}  // namespace frustum
-
 Buffer inputBuffer;          // copy dst, storage
 Buffer outputBuffer;         // copy dst, map read
 Buffer frustumPlanesBuffer;  // copy dst, map read
@@ -69,6 +38,7 @@ size_t data_size_bytes = 0;  //
 WGPUBindGroup computeBindGroup;
 // WGPUBindGroup computeBindGroup2;
 WGPUComputePipeline computePipeline;
+WGPUComputePipeline drawArgsPipeline;
 WGPUBindGroupLayout objectinfo_bg_layout;
 
 std::vector<uint32_t> input_values = {10, 20, 30, 40, 50, 60, 70, 80, 90, 100};
@@ -77,6 +47,193 @@ Buffer& getFrustumPlaneBuffer() { return frustumPlanesBuffer; }
 
 BindingGroup mBindingGroup;
 BindingGroup mObjectInfoBindgroup;
+
+struct alignas(16) HiZParams {
+        glm::mat4 previousViewProjection;
+        glm::mat4 viewProjection;
+        uint32_t width;
+        uint32_t height;
+        uint32_t levelCount;
+        uint32_t flags;
+};
+
+constexpr const uint32_t HIZ_ENABLED = 1u << 0;
+constexpr const uint32_t HIZ_PREVIOUS_VALID = 1u << 1;
+
+struct HiZTexture {
+        WGPUTexture texture = nullptr;
+        WGPUTextureView view = nullptr;               // every level, read by the culling
+        std::vector<WGPUTextureView> levels;          // one per level, written by the build
+        std::vector<WGPUBindGroup> buildBindGroups;  // level 0 copies the depth, the others reduce the level below
+};
+
+struct {
+        BindingGroup copyBindingGroup;
+        BindingGroup reduceBindingGroup;
+        BindingGroup cullBindingGroup;
+        WGPUComputePipeline copyPipeline = nullptr;
+        WGPUComputePipeline reducePipeline = nullptr;
+        WGPUComputePipeline latePipeline = nullptr;
+        Buffer paramsBuffer;
+        // ping pong, the one built this frame and the one of the last frame
+        HiZTexture pyramids[2];
+        // [i] reads pyramids[i] as this frame's pyramid and the other one as the last frame's
+        WGPUBindGroup cullBindGroups[2] = {};
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t levelCount = 0;
+        uint32_t current = 0;
+        bool enabled = false;
+        bool previousValid = false;
+        glm::mat4 previousViewProjection{1.0f};
+} hi_z;
+
+static void releaseHiZTexture(HiZTexture& pyramid) {
+    for (auto bind_group : pyramid.buildBindGroups) {
+        wgpuBindGroupRelease(bind_group);
+    }
+    for (auto view : pyramid.levels) {
+        wgpuTextureViewRelease(view);
+    }
+    if (pyramid.view != nullptr) {
+        wgpuTextureViewRelease(pyramid.view);
+        wgpuTextureDestroy(pyramid.texture);
+        wgpuTextureRelease(pyramid.texture);
+    }
+    pyramid = HiZTexture{};
+}
+
+static WGPUTextureView createHiZView(WGPUTexture texture, uint32_t baseMip, uint32_t mipLevelCount) {
+    WGPUTextureViewDescriptor view_desc = {};
+    view_desc.format = WGPUTextureFormat_R32Float;
+    view_desc.dimension = WGPUTextureViewDimension_2D;
+    view_desc.baseMipLevel = baseMip;
+    view_desc.mipLevelCount = mipLevelCount;
+    view_desc.baseArrayLayer = 0;
+    view_desc.arrayLayerCount = 1;
+    view_desc.aspect = WGPUTextureAspect_All;
+    return wgpuTextureCreateView(texture, &view_desc);
+}
+
+static void createHiZTexture(Application* app, HiZTexture& pyramid, WGPUTextureView depthView) {
+    auto& rc = app->getRendererResource();
+    WGPUTextureDescriptor texture_desc = {};
+    texture_desc.label = {"Hi-Z pyramid", WGPU_STRLEN};
+    texture_desc.dimension = WGPUTextureDimension_2D;
+    texture_desc.format = WGPUTextureFormat_R32Float;
+    texture_desc.size = {hi_z.width, hi_z.height, 1};
+    texture_desc.mipLevelCount = hi_z.levelCount;
+    texture_desc.sampleCount = 1;
+    texture_desc.usage = WGPUTextureUsage_StorageBinding | WGPUTextureUsage_TextureBinding;
+    pyramid.texture = wgpuDeviceCreateTexture(rc.device, &texture_desc);
+    pyramid.view = createHiZView(pyramid.texture, 0, hi_z.levelCount);
+
+    for (uint32_t level = 0; level < hi_z.levelCount; ++level) {
+        pyramid.levels.push_back(createHiZView(pyramid.texture, level, 1));
+
+        // copyDepth binds 0 and 1, reduceLevel 2 and 3
+        uint32_t first_binding = level == 0 ? 0 : 2;
+        std::vector<WGPUBindGroupEntry> entries(2);
+        entries[0].binding = first_binding;
+        entries[0].textureView = level == 0 ? depthView : pyramid.levels[level - 1];
+        entries[1].binding = first_binding + 1;
+        entries[1].textureView = pyramid.levels[level];
+        auto& binding_group = level == 0 ? hi_z.copyBindingGroup : hi_z.reduceBindingGroup;
+        pyramid.buildBindGroups.push_back(binding_group.createNew(rc, entries));
+    }
+}
+
+void resizeOcclusionCulling(Application* app, WGPUTextureView depthView, uint32_t width, uint32_t height) {
+    // the first depth buffer is created before the culling, setupComputePass() picks it up
+    if (hi_z.copyPipeline == nullptr) {
+        return;
+    }
+    for (size_t i = 0; i < 2; ++i) {
+        releaseHiZTexture(hi_z.pyramids[i]);
+        if (hi_z.cullBindGroups[i] != nullptr) {
+            wgpuBindGroupRelease(hi_z.cullBindGroups[i]);
+        }
+    }
+
+    hi_z.width = std::max(1u, width);
+    hi_z.height = std::max(1u, height);
+    hi_z.levelCount = HiZPyramid::levelCount(hi_z.width, hi_z.height);
+    hi_z.previousValid = false;
+    createHiZTexture(app, hi_z.pyramids[0], depthView);
+    createHiZTexture(app, hi_z.pyramids[1], depthView);
+
+    for (size_t i = 0; i < 2; ++i) {
+        std::vector<WGPUBindGroupEntry> entries(3);
+        entries[0].binding = 0;
+        entries[0].buffer = hi_z.paramsBuffer.getBuffer();
+        entries[0].offset = 0;
+        entries[0].size = sizeof(HiZParams);
+        entries[1].binding = 1;
+        entries[1].textureView = hi_z.pyramids[1 - i].view;
+        entries[2].binding = 2;
+        entries[2].textureView = hi_z.pyramids[i].view;
+        hi_z.cullBindGroups[i] = hi_z.cullBindingGroup.createNew(app->getRendererResource(), entries);
+    }
+}
+
+static WGPUComputePipeline createHiZBuildPipeline(PipelineCache* pipelines, WGPUShaderModule shaderModule,
+                                                  WGPUBindGroupLayout layout, const char* entryPoint) {
+    WGPUPipelineLayoutDescriptor pipeline_layout_desc = {};
+    pipeline_layout_desc.label = {"Hi-Z pipeline layout", WGPU_STRLEN};
+    pipeline_layout_desc.bindGroupLayoutCount = 1;
+    pipeline_layout_desc.bindGroupLayouts = &layout;
+    WGPUPipelineLayout pipeline_layout = pipelines->getPipelineLayout(pipeline_layout_desc);
+
+    WGPUComputePipelineDescriptor compute_pipeline_desc = {};
+    compute_pipeline_desc.label = {entryPoint, WGPU_STRLEN};
+    compute_pipeline_desc.layout = pipeline_layout;
+    compute_pipeline_desc.compute.module = shaderModule;
+    compute_pipeline_desc.compute.entryPoint = {entryPoint, WGPU_STRLEN};
+    return pipelines->getComputePipeline(compute_pipeline_desc);
+}
+
+static WGPUBindGroupLayout setupOcclusionCulling(Application* app) {
+    auto& rc = app->getRendererResource();
+    hi_z.paramsBuffer.setLabel("Hi-Z params buffer")
+        .setUsage(WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform)
+        .setSize(sizeof(HiZParams))
+        .setMappedAtCraetion(false)
+        .create(&rc);
+
+    auto shader_module =
+        rc.pipelines->getShaderModule(app->getBinaryPathAbsolute() / ".." / "resources" / "shaders" / "hi_z.wgsl");
+
+    auto copy_layout =
+        hi_z.copyBindingGroup
+            .addTexture(0, BindGroupEntryVisibility::COMPUTE, TextureSampleType::DEPTH, TextureViewDimension::VIEW_2D)
+            .addStorageTexture(1, BindGroupEntryVisibility::COMPUTE, StorageTextureAccessMode::WRITE_ONLY,
+                               TextureViewDimension::VIEW_2D, WGPUTextureFormat_R32Float)
+            .createLayout(rc, "Hi-Z copy bind group layout");
+    auto reduce_layout = hi_z.reduceBindingGroup
+                             .addTexture(2, BindGroupEntryVisibility::COMPUTE, TextureSampleType::UNFILTERABLE_FLOAT,
+                                         TextureViewDimension::VIEW_2D)
+                             .addStorageTexture(3, BindGroupEntryVisibility::COMPUTE,
+                                                StorageTextureAccessMode::WRITE_ONLY, TextureViewDimension::VIEW_2D,
+                                                WGPUTextureFormat_R32Float)
+                             .createLayout(rc, "Hi-Z reduce bind group layout");
+    hi_z.copyPipeline = createHiZBuildPipeline(rc.pipelines, shader_module, copy_layout, "copyDepth");
+    hi_z.reducePipeline = createHiZBuildPipeline(rc.pipelines, shader_module, reduce_layout, "reduceLevel");
+
+    return hi_z.cullBindingGroup.addBuffer(0, BindGroupEntryVisibility::COMPUTE, BufferBindingType::UNIFORM, 0)
+        .addTexture(1, BindGroupEntryVisibility::COMPUTE, TextureSampleType::UNFILTERABLE_FLOAT,
+                    TextureViewDimension::VIEW_2D)
+        .addTexture(2, BindGroupEntryVisibility::COMPUTE, TextureSampleType::UNFILTERABLE_FLOAT,
+                    TextureViewDimension::VIEW_2D)
+        .createLayout(rc, "Hi-Z culling bind group layout");
+}
+
+void updateOcclusionCulling(bool enabled, const glm::mat4& viewProjection) {
+    hi_z.enabled = enabled;
+    HiZParams params{hi_z.previousViewProjection, viewProjection, hi_z.width, hi_z.height, hi_z.levelCount,
+                     (enabled ? HIZ_ENABLED : 0u) | (hi_z.previousValid ? HIZ_PREVIOUS_VALID : 0u)};
+    hi_z.paramsBuffer.queueWrite(0, &params, sizeof(HiZParams));
+    hi_z.previousViewProjection = viewProjection;
+}
 void setupComputePass(Application* app, WGPUBuffer instanceDataBuffer) {
     data_size_bytes = input_values.size() * sizeof(uint32_t);
 
@@ -86,13 +243,20 @@ void setupComputePass(Application* app, WGPUBuffer instanceDataBuffer) {
 	    N_D: vec4f, // (Normal.xyz, D.w)
 	};
 	struct FrustumPlanesUniform {
-	    planes: array<FrustumPlane, 2>,
+	    planes: array<FrustumPlane, 6>,
+	};
+
+	struct WindParams {
+	    offset: vec4f,
+	    strength: f32,
+	    heightFactor: f32,
 	};
 
 	struct OffsetData {
-	    transformation: mat4x4f, // Array of 10 offset vectors
+	    transformation: mat4x4f,
 	    minAABB: vec4f,
-	    maxAABB: vec4f
+	    maxAABB: vec4f,
+	    windParams: WindParams,
 	};
 
 	struct DrawIndexedIndirectArgs {
@@ -103,11 +267,20 @@ void setupComputePass(Application* app, WGPUBuffer instanceDataBuffer) {
 	    firstInstance: u32,
 	};
 
+	struct MeshDrawArgs {
+	    indexCount: u32,
+	    instanceCount: u32,
+	    firstIndex: u32,
+	    baseVertex: i32,
+	    firstInstance: u32,
+	};
+
     struct ObjectInfo {
         transformations: mat4x4f,
         offsetId: u32,
         isHovered: u32,
         isAnimated: u32,
+        instanceCount: u32,
     }
 
     struct Camera {
@@ -127,33 +300,118 @@ void setupComputePass(Application* app, WGPUBuffer instanceDataBuffer) {
 	
 	@group(1) @binding(0) var<uniform> objectTranformation: ObjectInfo;
 	@group(1) @binding(1) var<storage, read_write> indirect_draw_args: DrawIndexedIndirectArgs;
+	@group(1) @binding(2) var<storage, read_write> mesh_draw_args: array<MeshDrawArgs>;
+
+        struct HiZParams {
+            previousViewProjection: mat4x4f,
+            viewProjection: mat4x4f,
+            size: vec2u,
+            levelCount: u32,
+            flags: u32, // 1: occlusion culling, 2: the previous pyramid was built last frame
+        };
+
+        @group(2) @binding(0) var<uniform> uHiZ: HiZParams;
+        @group(2) @binding(1) var previousHiZ: texture_2d<f32>;
+        @group(2) @binding(2) var currentHiZ: texture_2d<f32>;
+
+        // same test as Frustum::AABBTest
+        fn isVisible(minAABB: vec3f, maxAABB: vec3f) -> bool {
+            for (var i = 0u; i < 6u; i++) {
+                let plane = uFrustumPlanes.planes[i].N_D;
+                let p_vertex = select(minAABB, maxAABB, plane.xyz >= vec3f(0.0));
+                if (dot(plane.xyz, p_vertex) + plane.w < 0.0) {
+                    return false;
+                }
+            }
+            return true;
+        }
 
+        // same test as HiZPyramid::isOccluded
+        fn isOccluded(hiz: texture_2d<f32>, viewProjection: mat4x4f, minAABB: vec3f, maxAABB: vec3f) -> bool {
+            var min_uv = vec2f(1.0);
+            var max_uv = vec2f(0.0);
+            var nearest = 1.0;
+            for (var i = 0u; i < 8u; i++) {
+                let corner = select(minAABB, maxAABB, vec3u(i & 1u, i & 2u, i & 4u) != vec3u(0u));
+                let clip = viewProjection * vec4f(corner, 1.0);
+                if (clip.w <= 0.0) {
+                    return false;
+                }
+                let uv = vec2f(clip.x / clip.w * 0.5 + 0.5, 0.5 - clip.y / clip.w * 0.5);
+                min_uv = min(min_uv, uv);
+                max_uv = max(max_uv, uv);
+                nearest = min(nearest, clip.z / clip.w);
+            }
 
+            let size = uHiZ.size;
+            let first = min(vec2u(clamp(min_uv, vec2f(0.0), vec2f(1.0)) * vec2f(size)), size - 1u);
+            let last = min(vec2u(clamp(max_uv, vec2f(0.0), vec2f(1.0)) * vec2f(size)), size - 1u);
+            let extent = max(last.x - first.x, last.y - first.y) + 1u;
+            // the first level where the rectangle spans at most 2x2 texels
+            let level = min(select(firstLeadingBit(extent - 2u) + 1u, 0u, extent <= 2u), uHiZ.levelCount - 1u);
+            let level_max = max(size >> vec2u(level), vec2u(1u)) - 1u;
+            let first_texel = min(first >> vec2u(level), level_max);
+            let last_texel = min(last >> vec2u(level), level_max);
+
+            var farthest = 0.0;
+            for (var y = first_texel.y; y <= last_texel.y; y++) {
+                for (var x = first_texel.x; x <= last_texel.x; x++) {
+                    farthest = max(farthest, textureLoad(hiz, vec2u(x, y), i32(level)).r);
+                }
+            }
+            return nearest > farthest;
+        }
+
+        // culled by the first phase, against the depth the last frame left behind
+        fn isOccludedPreviously(minAABB: vec3f, maxAABB: vec3f) -> bool {
+            return (uHiZ.flags & 3u) == 3u && isOccluded(previousHiZ, uHiZ.previousViewProjection, minAABB, maxAABB);
+        }
+
+        fn appendVisible(off_id: u32, index: u32) {
+            let write_idx = atomicAdd(&indirect_draw_args.instanceCount, 1u);
+            visible_instances_indices[off_id + write_idx] = index; // Store the original global_id.x as the visible index
+        }
+
+        // instance 0 is drawn with the model's own transform, so it is never culled and the counter starts at 1
         @compute @workgroup_size(32)
         fn main(@builtin(global_invocation_id) global_id: vec3u) {
             let index = global_id.x;
-            // if (indirect_draw_args.instanceCount < 2u){
-            //if (index < 31u){
-	            let off_id: u32 = objectTranformation.offsetId * 100000u;
-		        let transform = instanceData[index + off_id].transformation;
-		        let minAABB = instanceData[index + off_id].minAABB;
-		        let maxAABB = instanceData[index + off_id].maxAABB;
-
-		        let left = dot(normalize(uFrustumPlanes.planes[0].N_D.xyz), minAABB.xyz) + uFrustumPlanes.planes[0].N_D.w;
-		        let right = dot(normalize(uFrustumPlanes.planes[1].N_D.xyz), minAABB.xyz) + uFrustumPlanes.planes[1].N_D.w;
-
-		        let max_left = dot(normalize(uFrustumPlanes.planes[0].N_D.xyz),  maxAABB.xyz) + uFrustumPlanes.planes[0].N_D.w;
-		        let max_right = dot(normalize(uFrustumPlanes.planes[1].N_D.xyz), maxAABB.xyz) + uFrustumPlanes.planes[1].N_D.w;
-
-		        let is_lod0 = uCamera[0].cameraWorldPosition - maxAABB.xyz;
-                // if (length(is_lod0) < 23.0){
-	            if (left >= -1.0 && max_left > -1.0 && right >= -1.0 && max_right >= -1.0) {
-		            let write_idx = atomicAdd(&indirect_draw_args.instanceCount, 1u);
-		            // if (write_idx < arrayLength(&visible_instances_indices)) {
-		                visible_instances_indices[off_id + write_idx] = index; // Store the original global_id.x as the visible index
-	                // }
-		        }
-            // }
+            if (index == 0u || index >= objectTranformation.instanceCount) {
+                return;
+            }
+            let off_id: u32 = objectTranformation.offsetId * 100000u;
+            let instance = instanceData[index + off_id];
+            if (isVisible(instance.minAABB.xyz, instance.maxAABB.xyz) &&
+                !isOccludedPreviously(instance.minAABB.xyz, instance.maxAABB.xyz)) {
+                appendVisible(off_id, index);
+            }
+        }
+
+        // second phase, after the depth prepass. Appends the instances main left out because of the last frame's
+        // depth but which are not behind this frame's
+        @compute @workgroup_size(32)
+        fn main_late(@builtin(global_invocation_id) global_id: vec3u) {
+            let index = global_id.x;
+            if (index == 0u || index >= objectTranformation.instanceCount) {
+                return;
+            }
+            let off_id: u32 = objectTranformation.offsetId * 100000u;
+            let instance = instanceData[index + off_id];
+            if (isVisible(instance.minAABB.xyz, instance.maxAABB.xyz) &&
+                isOccludedPreviously(instance.minAABB.xyz, instance.maxAABB.xyz) &&
+                !isOccluded(currentHiZ, uHiZ.viewProjection, instance.minAABB.xyz, instance.maxAABB.xyz)) {
+                appendVisible(off_id, index);
+            }
+        }
+
+        // same as IndirectDrawArgs::setInstanceCount, runs after main
+        @compute @workgroup_size(32)
+        fn write_args(@builtin(global_invocation_id) global_id: vec3u) {
+            let slot = global_id.x;
+            if (slot >= arrayLength(&mesh_draw_args)) {
+                return;
+            }
+            mesh_draw_args[slot].instanceCount = atomicLoad(&indirect_draw_args.instanceCount);
         }
     )";
 
@@ -170,7 +428,7 @@ void setupComputePass(Application* app, WGPUBuffer instanceDataBuffer) {
     // one buffer for input, one for output
     app->mVisibleIndexBuffer.setLabel("visible index buffer")
         .setUsage(WGPUBufferUsage_CopySrc | WGPUBufferUsage_Storage | WGPUBufferUsage_Indirect)
-        .setSize(sizeof(uint32_t) * 100000 * 5)
+        .setSize(sizeof(uint32_t) * InstanceManager::MAX_INSTANCE_COUNT * 10)
         .setMappedAtCraetion()
         .create(&resources);
 
@@ -189,7 +447,7 @@ void setupComputePass(Application* app, WGPUBuffer instanceDataBuffer) {
     // create the compute pass, bind group and pipeline
 
     /////////////////////
-    auto shader_module = createComputeShaderModule(resources.device, shader_code, "Simple Compute Shader Module");
+    auto shader_module = resources.pipelines->getShaderModule(shader_code, "Simple Compute Shader Module");
 
     auto& resource = app->getRendererResource();
     WGPUBindGroupLayout bind_group_layout =
@@ -203,15 +461,18 @@ void setupComputePass(Application* app, WGPUBuffer instanceDataBuffer) {
     objectinfo_bg_layout =
         mObjectInfoBindgroup.addBuffer(0, BindGroupEntryVisibility::COMPUTE, BufferBindingType::UNIFORM, 0)
             .addBuffer(1, BindGroupEntryVisibility::COMPUTE, BufferBindingType::STORAGE, 0)
+            .addBuffer(2, BindGroupEntryVisibility::COMPUTE, BufferBindingType::STORAGE, 0)
             .createLayout(resource, "Compute Bind Group For Object info");
 
+    WGPUBindGroupLayout hi_z_layout = setupOcclusionCulling(app);
+
     // 5. Create Pipeline Layout
-    WGPUBindGroupLayout bind_group_layouts[] = {bind_group_layout, objectinfo_bg_layout};
+    WGPUBindGroupLayout bind_group_layouts[] = {bind_group_layout, objectinfo_bg_layout, hi_z_layout};
     WGPUPipelineLayoutDescriptor pipeline_layout_desc = {};
     pipeline_layout_desc.label = {"Compute Pipeline Layout", WGPU_STRLEN};
-    pipeline_layout_desc.bindGroupLayoutCount = 2;
+    pipeline_layout_desc.bindGroupLayoutCount = 3;
     pipeline_layout_desc.bindGroupLayouts = bind_group_layouts;
-    WGPUPipelineLayout pipeline_layout = wgpuDeviceCreatePipelineLayout(resources.device, &pipeline_layout_desc);
+    WGPUPipelineLayout pipeline_layout = resources.pipelines->getPipelineLayout(pipeline_layout_desc);
 
     // 6. Create Compute Pipeline
     WGPUComputePipelineDescriptor compute_pipeline_desc = {};
@@ -219,7 +480,15 @@ void setupComputePass(Application* app, WGPUBuffer instanceDataBuffer) {
     compute_pipeline_desc.layout = pipeline_layout;
     compute_pipeline_desc.compute.module = shader_module;
     compute_pipeline_desc.compute.entryPoint = {"main", WGPU_STRLEN};  // Matches `fn main` in WGSL
-    computePipeline = wgpuDeviceCreateComputePipeline(resources.device, &compute_pipeline_desc);
+    computePipeline = resources.pipelines->getComputePipeline(compute_pipeline_desc);
+
+    compute_pipeline_desc.label = {"Culled draw args Pipeline", WGPU_STRLEN};
+    compute_pipeline_desc.compute.entryPoint = {"write_args", WGPU_STRLEN};
+    drawArgsPipeline = resources.pipelines->getComputePipeline(compute_pipeline_desc);
+
+    compute_pipeline_desc.label = {"Occlusion culling late Pipeline", WGPU_STRLEN};
+    compute_pipeline_desc.compute.entryPoint = {"main_late", WGPU_STRLEN};
+    hi_z.latePipeline = resources.pipelines->getComputePipeline(compute_pipeline_desc);
 
     // 7. Create Bind Group (linking actual buffers to shader bindings)
     WGPUBindGroupEntry bind_group_entries[5] = {};
@@ -231,7 +500,7 @@ void setupComputePass(Application* app, WGPUBuffer instanceDataBuffer) {
     bind_group_entries[1].binding = 1;
     bind_group_entries[1].buffer = app->mVisibleIndexBuffer.getBuffer();
     bind_group_entries[1].offset = 0;
-    bind_group_entries[1].size = sizeof(uint32_t) * 100000 * 5;
+    bind_group_entries[1].size = sizeof(uint32_t) * InstanceManager::MAX_INSTANCE_COUNT * 10;
 
     bind_group_entries[2].binding = 2;
     bind_group_entries[2].buffer = instanceDataBuffer;
@@ -255,14 +524,19 @@ void setupComputePass(Application* app, WGPUBuffer instanceDataBuffer) {
     bind_group_desc.entryCount = 5;
     bind_group_desc.entries = bind_group_entries;
     computeBindGroup = wgpuDeviceCreateBindGroup(resources.device, &bind_group_desc);
+
+    auto [depth_width, depth_height] = app->mDepthTexture->getTextureSize();
+    resizeOcclusionCulling(app, app->mDepthTextureViewDepthOnly, static_cast<uint32_t>(depth_width),
+                           static_cast<uint32_t>(depth_height));
 };
 
 WGPUBindGroup createObjectInfoBindGroupForComputePass(Application* app, WGPUBuffer objetcInfoBuffer,
-                                                      WGPUBuffer indirectDrawArgsBuffer) {
-    WGPUBindGroupEntry objectinfo_bg_entries[2] = {};
+                                                      uint64_t objectInfoOffset, WGPUBuffer indirectDrawArgsBuffer,
+                                                      WGPUBuffer meshDrawArgsBuffer, uint64_t meshDrawArgsSize) {
+    WGPUBindGroupEntry objectinfo_bg_entries[3] = {};
     objectinfo_bg_entries[0].binding = 0;
     objectinfo_bg_entries[0].buffer = objetcInfoBuffer;
-    objectinfo_bg_entries[0].offset = 0;
+    objectinfo_bg_entries[0].offset = objectInfoOffset;
     objectinfo_bg_entries[0].size = sizeof(ObjectInfo);
 
     objectinfo_bg_entries[1].binding = 1;
@@ -270,66 +544,142 @@ WGPUBindGroup createObjectInfoBindGroupForComputePass(Application* app, WGPUBuff
     objectinfo_bg_entries[1].offset = 0;
     objectinfo_bg_entries[1].size = sizeof(DrawIndexedIndirectArgs);
 
+    objectinfo_bg_entries[2].binding = 2;
+    objectinfo_bg_entries[2].buffer = meshDrawArgsBuffer;
+    objectinfo_bg_entries[2].offset = 0;
+    objectinfo_bg_entries[2].size = meshDrawArgsSize;
+
     WGPUBindGroupDescriptor objectinfo_bg_desc = {};
     objectinfo_bg_desc.label = {"Object info Compute Bind Group", WGPU_STRLEN};
     objectinfo_bg_desc.layout = objectinfo_bg_layout;
-    objectinfo_bg_desc.entryCount = 2;
+    objectinfo_bg_desc.entryCount = 3;
     objectinfo_bg_desc.entries = objectinfo_bg_entries;
 
     return wgpuDeviceCreateBindGroup(app->getRendererResource().device, &objectinfo_bg_desc);
 }
 
+// keeps the per mesh draw args of `model` in sync with where its meshes live in the geometry arena
+static void prepareMeshDrawArgs(Application* app, Model* model) {
+    for (auto& [mesh_id, mesh] : model->mFlattenMeshes) {
+        model->mMeshDrawArgs.setMesh(mesh_id, static_cast<uint32_t>(mesh.mIndexData.size()), mesh.getFirstIndex(),
+                                     mesh.getBaseVertex());
+    }
+
+    uint64_t size = model->mMeshDrawArgs.size() * sizeof(DrawIndexedIndirectArgs);
+    if (model->mMeshDrawArgsBuffer.getBuffer() == nullptr || model->mMeshDrawArgsBuffer.getBufferSize() != size) {
+        if (model->mMeshDrawArgsBuffer.getBuffer() != nullptr) {
+            wgpuBufferRelease(model->mMeshDrawArgsBuffer.getBuffer());
+        }
+        model->mMeshDrawArgsBuffer.setLabel("mesh draw args buffer for " + model->getName())
+            .setUsage(WGPUBufferUsage_Storage | WGPUBufferUsage_Indirect | WGPUBufferUsage_CopyDst)
+            .setSize(size)
+            .setMappedAtCraetion()
+            .create(&app->getRendererResource());
+        model->mMeshDrawArgs.takeDirtyRange();
+        model->mMeshDrawArgsBuffer.queueWrite(0, model->mMeshDrawArgs.getArgs().data(), size);
+        return;
+    }
+
+    auto [begin, end] = model->mMeshDrawArgs.takeDirtyRange();
+    if (begin < end) {
+        model->mMeshDrawArgsBuffer.queueWrite(IndirectDrawArgs::getOffset(begin),
+                                              &model->mMeshDrawArgs.getArgs()[begin],
+                                              (end - begin) * sizeof(DrawIndexedIndirectArgs));
+    }
+}
+
+// records `cullPipeline` over the instances of `model` followed by write_args in one compute pass
+static void dispatchInstanceCulling(Application* app, WGPUCommandEncoder encoder, Model* model,
+                                    WGPUComputePipeline cullPipeline, const std::string& label) {
+    uint32_t instance_count = static_cast<uint32_t>(model->instance->getInstanceCount());
+
+    WGPUComputePassDescriptor compute_pass_desc = {};
+    compute_pass_desc.label = {label.c_str(), WGPU_STRLEN};
+    compute_pass_desc.nextInChain = nullptr;
+    WGPUComputePassEncoder compute_pass_encoder = wgpuCommandEncoderBeginComputePass(encoder, &compute_pass_desc);
+
+    wgpuComputePassEncoderSetPipeline(compute_pass_encoder, cullPipeline);
+    wgpuComputePassEncoderSetBindGroup(compute_pass_encoder, 0, computeBindGroup, 0,
+                                       nullptr);  // Group 0, no dynamic offsets
+    auto objectinfo_bg = createObjectInfoBindGroupForComputePass(
+        app, model->getObjectInfoBuffer(), model->getObjectInfoOffset(), model->mIndirectDrawArgsBuffer.getBuffer(),
+        model->mMeshDrawArgsBuffer.getBuffer(), model->mMeshDrawArgsBuffer.getBufferSize());
+    wgpuComputePassEncoderSetBindGroup(compute_pass_encoder, 1, objectinfo_bg, 0, nullptr);
+    wgpuComputePassEncoderSetBindGroup(compute_pass_encoder, 2, hi_z.cullBindGroups[hi_z.current], 0, nullptr);
+
+    uint32_t workgroup_size_x = 32;  // Must match shader's @workgroup_size(32)
+    uint32_t num_workgroups_x = (instance_count + workgroup_size_x - 1) / workgroup_size_x;  // Ceil division
+    wgpuComputePassEncoderDispatchWorkgroups(compute_pass_encoder, num_workgroups_x, 1, 1);
+
+    // every dispatch is its own usage scope, so write_args sees the final counter
+    uint32_t slot_count = static_cast<uint32_t>(model->mMeshDrawArgs.size());
+    wgpuComputePassEncoderSetPipeline(compute_pass_encoder, drawArgsPipeline);
+    wgpuComputePassEncoderDispatchWorkgroups(compute_pass_encoder,
+                                             (slot_count + workgroup_size_x - 1) / workgroup_size_x, 1, 1);
+
+    wgpuComputePassEncoderEnd(compute_pass_encoder);
+    wgpuBindGroupRelease(objectinfo_bg);
+    wgpuComputePassEncoderRelease(compute_pass_encoder);
+}
+
 void runFrustumCullingTask(Application* app, WGPUCommandEncoder encoder) {
     auto& objs = ModelRegistry::instance().getLoadedModel(Visibility_User);
 
     for (auto& model : objs) {
-        if (model->instance != nullptr) {
-            auto indirect = DrawIndexedIndirectArgs{0, 0, 0, 0, 0};
-            wgpuQueueWriteBuffer(app->getRendererResource().queue, model->mIndirectDrawArgsBuffer.getBuffer(),
-                                 sizeof(uint32_t), &indirect, sizeof(uint32_t));
-
-            WGPUComputePassDescriptor compute_pass_desc = {};
-            std::string compute_name = "Simple Compute Pass for " + model->getName();
-            compute_pass_desc.label = {compute_name.c_str(), WGPU_STRLEN};
-            compute_pass_desc.nextInChain = nullptr;
-            WGPUComputePassEncoder compute_pass_encoder =
-                wgpuCommandEncoderBeginComputePass(encoder, &compute_pass_desc);
-
-            // Set the pipeline and bind group for the compute pass
-            wgpuComputePassEncoderSetPipeline(compute_pass_encoder, computePipeline);
-            wgpuComputePassEncoderSetBindGroup(compute_pass_encoder, 0, computeBindGroup, 0,
-                                               nullptr);  // Group 0, no dynamic offsets
-            auto objectinfo_bg = createObjectInfoBindGroupForComputePass(app, model->getUniformBuffer().getBuffer(),
-                                                                         model->mIndirectDrawArgsBuffer.getBuffer());
-            wgpuComputePassEncoderSetBindGroup(compute_pass_encoder, 1, objectinfo_bg, 0, nullptr);
-
-            // uint32_t workgroup_size_x = 32;  // Must match shader's @workgroup_size(32)
-            // uint32_t num_workgroups_x =
-            //     (model->instance->getInstanceCount() + workgroup_size_x - 1) / workgroup_size_x;  // Ceil division
-            // std::cout << num_workgroups_x << '\n';
-
-            // wgpuComputePassEncoderDispatchWorkgroups(compute_pass_encoder, num_workgroups_x, 1, 1);
-            //
-            uint32_t workgroup_size_x = 32;  // Must match shader's @workgroup_size(32)
-            uint32_t num_workgroups_x = ((31 * 3) + workgroup_size_x - 1) / workgroup_size_x;  // Ceil division
-            wgpuComputePassEncoderDispatchWorkgroups(compute_pass_encoder, num_workgroups_x, 1, 1);
-
-            // End the compute pass
-            wgpuComputePassEncoderEnd(compute_pass_encoder);
-            wgpuBindGroupRelease(objectinfo_bg);
-            wgpuComputePassEncoderRelease(compute_pass_encoder);
+        if (!model->hasCulledInstances()) {
+            continue;
+        }
+        uint32_t instance_count = static_cast<uint32_t>(model->instance->getInstanceCount());
+        prepareMeshDrawArgs(app, model);
+
+        // instance 0 is the model itself and always drawn
+        uint32_t visible_count = 1;
+        model->mIndirectDrawArgsBuffer.queueWrite(offsetof(DrawIndexedIndirectArgs, instanceCount), &visible_count,
+                                                  sizeof(uint32_t));
+        auto& object_info = model->mTransform.mObjectInfo;
+        if (object_info.instanceCount != instance_count) {
+            object_info.instanceCount = instance_count;
+            model->writeObjectInfo(&object_info.instanceCount, sizeof(uint32_t), offsetof(ObjectInfo, instanceCount));
         }
 
-        // perform a buffer copy for indirect draw args for mesh parts
-        if (model->instance != nullptr) {
-            for (auto& [mat_id, mesh] : model->mFlattenMeshes) {
-                wgpuCommandEncoderCopyBufferToBuffer(
-                    encoder, model->mIndirectDrawArgsBuffer.getBuffer(),
-                    offsetof(DrawIndexedIndirectArgs, instanceCount), mesh.mIndirectDrawArgsBuffer.getBuffer(),
-                    offsetof(DrawIndexedIndirectArgs, instanceCount), sizeof(uint32_t));
+        dispatchInstanceCulling(app, encoder, model, computePipeline, "Frustum culling pass for " + model->getName());
+    }
+}
+
+void runOcclusionCullingTask(Application* app, WGPUCommandEncoder encoder) {
+    if (!hi_z.enabled) {
+        hi_z.previousValid = false;
+        return;
+    }
+    ZoneScopedN("Occlusion culling");
+
+    // a compute pass synchronizes every dispatch, a level is written before the next one reads it
+    auto& pyramid = hi_z.pyramids[hi_z.current];
+    WGPUComputePassDescriptor compute_pass_desc = {};
+    compute_pass_desc.label = {"Hi-Z pyramid", WGPU_STRLEN};
+    WGPUComputePassEncoder compute_pass_encoder = wgpuCommandEncoderBeginComputePass(encoder, &compute_pass_desc);
+    for (uint32_t level = 0; level < hi_z.levelCount; ++level) {
+        wgpuComputePassEncoderSetPipeline(compute_pass_encoder, level == 0 ? hi_z.copyPipeline : hi_z.reducePipeline);
+        wgpuComputePassEncoderSetBindGroup(compute_pass_encoder, 0, pyramid.buildBindGroups[level], 0, nullptr);
+        uint32_t width = HiZPyramid::levelSize(hi_z.width, level);
+        uint32_t height = HiZPyramid::levelSize(hi_z.height, level);
+        wgpuComputePassEncoderDispatchWorkgroups(compute_pass_encoder, (width + 7) / 8, (height + 7) / 8, 1);
+    }
+    wgpuComputePassEncoderEnd(compute_pass_encoder);
+    wgpuComputePassEncoderRelease(compute_pass_encoder);
+
+    // without a pyramid of the last frame the first phase culled nothing by depth, there is nothing to bring back
+    if (hi_z.previousValid) {
+        for (auto& model : ModelRegistry::instance().getLoadedModel(Visibility_User)) {
+            if (model->hasCulledInstances()) {
+                dispatchInstanceCulling(app, encoder, model, hi_z.latePipeline,
+                                        "Occlusion culling pass for " + model->getName());
             }
         }
     }
+
+    hi_z.previousValid = true;
+    hi_z.current ^= 1;
 }
 
 FrustumCorners getFrustumCornersWorldSpace(const glm::mat4& proj, const glm::mat4& view) {
@@ -359,26 +709,6 @@ FrustumCorners getFrustumCornersWorldSpace(const glm::mat4& proj, const glm::mat
     return corners;
 }
 
-std::vector<FrustumPlane> create2FrustumPlanes(const FrustumCorners& corners) {
-    auto ab = glm::vec3(corners.nearBottomLeft - corners.farBottomLeft);
-    auto ac = glm::vec3(corners.nearBottomLeft - corners.nearTopLeft);
-    auto left_plane_normal = glm::normalize(glm::cross(ab, ac));
-    auto left_constant_sigend_distanc = -glm::dot(left_plane_normal, glm::vec3(corners.farTopLeft));
-
-    ab = glm::vec3(corners.nearBottomRight - corners.farBottomRight);
-    ac = glm::vec3(corners.nearBottomRight - corners.nearTopRight);
-    auto right_plane_normal = glm::normalize(glm::cross(ac, ab));
-    auto right_constant_sigend_distanc = -glm::dot(right_plane_normal, glm::vec3(corners.farTopRight));
-
-    FrustumPlane fr{};
-    fr.N_D = {right_plane_normal.x, right_plane_normal.y, right_plane_normal.z, right_constant_sigend_distanc};
-
-    FrustumPlane fl{};
-    fl.N_D = {left_plane_normal.x, left_plane_normal.y, left_plane_normal.z, left_constant_sigend_distanc};
-
-    return {fl, fr};
-}
-
 bool isInFrustum(const FrustumCorners& corners, BaseModel* model) {
     if (model == nullptr) {
         return false;
@@ -406,19 +736,4 @@ bool isInFrustum(const FrustumCorners& corners, BaseModel* model) {
     return (drmax < 0.0 || drmin < 0.0) && (dmin > 0.0 || dmax > 0.0);
 }
 
-void mipmap::createMipMapComputShader(Application* app) {
-    auto source =
-        readFile((app->getBinaryPathAbsolute() / ".." / "resources" / "shaders" / "mipmap.wgsl").string().c_str());
-    // WGPUShaderModule shader_module =
-    WGPUShaderSourceWGSL shader_wgsl_desc = {};
-    shader_wgsl_desc.chain.next = nullptr;
-    shader_wgsl_desc.chain.sType = WGPUSType_ShaderSourceWGSL;
-    shader_wgsl_desc.code = {source.c_str(), strlen(source.c_str())};
-    WGPUShaderModuleDescriptor shader_module_desc = {};
-    shader_module_desc.nextInChain = &shader_wgsl_desc.chain;
-    shader_module_desc.label = {"mipmap shader", WGPU_STRLEN};
-    WGPUShaderModule shader_module =
-        wgpuDeviceCreateShaderModule(app->getRendererResource().device, &shader_module_desc);
-}
-
 //
@@ -0,0 +1,206 @@
+#include "geometry_arena.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include "profiling.h"
+#include "upload_ring.h"
+
+GeometryArena::GeometryArena(RendererResource* resource) : mResource(resource) {
+    auto vertex_usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_CopySrc | WGPUBufferUsage_Vertex;
+    mVertexPools[static_cast<size_t>(VertexLayout::Full)].name = "geometry arena full vertices";
+    mVertexPools[static_cast<size_t>(VertexLayout::Full)].strides = {sizeof(VertexAttributes)};
+    mVertexPools[static_cast<size_t>(VertexLayout::Packed)].name = "geometry arena packed vertices";
+    mVertexPools[static_cast<size_t>(VertexLayout::Packed)].strides = {sizeof(PackedVertex), sizeof(PackedSkin)};
+    mVertexPools[static_cast<size_t>(VertexLayout::PackedStatic)].name = "geometry arena packed static vertices";
+    mVertexPools[static_cast<size_t>(VertexLayout::PackedStatic)].strides = {sizeof(PackedVertex)};
+    for (auto& pool : mVertexPools) {
+        pool.usage = vertex_usage;
+    }
+
+    mIndexPool.name = "geometry arena indices";
+    mIndexPool.strides = {sizeof(uint32_t)};
+    mIndexPool.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_CopySrc | WGPUBufferUsage_Index;
+}
+
+GeometryArena::Pool& GeometryArena::getPool(VertexLayout layout) { return mVertexPools[static_cast<size_t>(layout)]; }
+
+std::shared_ptr<GeometryAllocation> GeometryArena::allocate(VertexLayout layout, uint32_t vertexCount,
+                                                            uint32_t indexCount) {
+    if (vertexCount == 0 || indexCount == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto vertex_offset = allocateFrom(getPool(layout), vertexCount, INITIAL_VERTEX_CAPACITY);
+    if (!vertex_offset.has_value()) {
+        std::cout << "Geometry arena failed to allocate " << vertexCount << " vertices\n";
+        return nullptr;
+    }
+    auto index_offset = allocateFrom(mIndexPool, indexCount, INITIAL_INDEX_CAPACITY);
+    if (!index_offset.has_value()) {
+        std::cout << "Geometry arena failed to allocate " << indexCount << " indices\n";
+        getPool(layout).allocator.free(*vertex_offset, vertexCount);
+        return nullptr;
+    }
+
+    auto allocation = std::make_shared<GeometryAllocation>();
+    allocation->layout = layout;
+    allocation->vertices = {*vertex_offset, vertexCount};
+    allocation->indices = {*index_offset, indexCount};
+    mAllocations.push_back(allocation);
+    return allocation;
+}
+
+std::optional<uint64_t> GeometryArena::allocateFrom(Pool& pool, uint64_t size, uint64_t initialCapacity) {
+    auto offset = pool.allocator.allocate(size);
+    if (offset.has_value()) {
+        return offset;
+    }
+
+    // out of space, move the pool into buffers twice as large
+    uint64_t old_capacity = pool.allocator.getCapacity();
+    uint64_t capacity = std::max({initialCapacity, old_capacity * 2, old_capacity + size});
+    std::vector<RangeAllocator::Move> moves;
+    if (old_capacity > 0) {
+        moves.push_back({0, 0, old_capacity});
+    }
+    relocate(pool, capacity, moves);
+    pool.allocator.grow(capacity);
+    return pool.allocator.allocate(size);
+}
+
+void GeometryArena::relocate(Pool& pool, uint64_t capacity, const std::vector<RangeAllocator::Move>& moves) {
+    ZoneScopedN("Geometry arena relocate");
+    std::vector<Buffer> buffers(pool.strides.size());
+    for (size_t stream = 0; stream < pool.strides.size(); ++stream) {
+        buffers[stream]
+            .setLabel(pool.name)
+            .setUsage(pool.usage)
+            .setSize(capacity * pool.strides[stream])
+            .setMappedAtCraetion()
+            .create(mResource);
+    }
+
+    if (!pool.buffers.empty()) {
+        // queued behind the staged writes into the old buffers and ahead of the ones into the new buffers, the upload
+        // ring records them on the main thread before the frame is submitted
+        for (size_t stream = 0; stream < pool.strides.size(); ++stream) {
+            uint64_t stride = pool.strides[stream];
+            for (const auto& move : moves) {
+                mResource->uploads->copy(pool.buffers[stream].getBuffer(), move.from * stride,
+                                         buffers[stream].getBuffer(), move.to * stride, move.size * stride);
+            }
+        }
+        // the queued copies and the passes that still reference them keep the old buffers alive
+        for (auto& buffer : pool.buffers) {
+            wgpuBufferRelease(buffer.getBuffer());
+        }
+    }
+    pool.buffers = std::move(buffers);
+}
+
+void GeometryArena::writeVertices(const GeometryAllocation& allocation, size_t stream, const void* data,
+                                  size_t vertexCount) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& pool = getPool(allocation.layout);
+    if (stream >= pool.buffers.size() || vertexCount > allocation.vertices.size) {
+        std::cout << "Geometry arena: invalid vertex write to " << pool.name << '\n';
+        return;
+    }
+    uint64_t stride = pool.strides[stream];
+    pool.buffers[stream].queueWrite(allocation.vertices.offset * stride, data, vertexCount * stride);
+}
+
+void GeometryArena::writeIndices(const GeometryAllocation& allocation, const uint32_t* data, size_t indexCount) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mIndexPool.buffers.empty() || indexCount > allocation.indices.size) {
+        std::cout << "Geometry arena: invalid index write\n";
+        return;
+    }
+    mIndexPool.buffers[0].queueWrite(allocation.indices.offset * sizeof(uint32_t), data,
+                                     indexCount * sizeof(uint32_t));
+}
+
+void GeometryArena::free(const std::shared_ptr<GeometryAllocation>& allocation) {
+    if (allocation == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = std::find(mAllocations.begin(), mAllocations.end(), allocation);
+    if (it == mAllocations.end()) {
+        return;
+    }
+    getPool(allocation->layout).allocator.free(allocation->vertices.offset, allocation->vertices.size);
+    mIndexPool.allocator.free(allocation->indices.offset, allocation->indices.size);
+    allocation->vertices = {0, 0};
+    allocation->indices = {0, 0};
+    mAllocations.erase(it);
+}
+
+void GeometryArena::compact(Pool& pool, bool indices) {
+    std::vector<RangeAllocator::Range*> live;
+    for (auto& allocation : mAllocations) {
+        if (indices) {
+            live.push_back(&allocation->indices);
+        } else if (&getPool(allocation->layout) == &pool) {
+            live.push_back(&allocation->vertices);
+        }
+    }
+
+    // the data goes into fresh buffers, so every live range is copied and not just the ones that moved
+    std::vector<std::pair<RangeAllocator::Range*, uint64_t>> old_offsets;
+    old_offsets.reserve(live.size());
+    for (auto* range : live) {
+        old_offsets.emplace_back(range, range->offset);
+    }
+    if (pool.allocator.compact(live).empty()) {
+        return;
+    }
+
+    std::vector<RangeAllocator::Move> copies;
+    copies.reserve(old_offsets.size());
+    for (auto [range, old_offset] : old_offsets) {
+        if (range->size > 0) {
+            copies.push_back({old_offset, range->offset, range->size});
+        }
+    }
+    relocate(pool, pool.allocator.getCapacity(), copies);
+}
+
+void GeometryArena::defragment(bool force) {
+    ZoneScopedN("Geometry arena defragment");
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto needs_compaction = [force](const Pool& pool) {
+        return pool.allocator.getFreeRangeCount() > 1 &&
+               (force || pool.allocator.getFragmentation() > DEFRAGMENT_THRESHOLD);
+    };
+    for (auto& pool : mVertexPools) {
+        if (needs_compaction(pool)) {
+            compact(pool, false);
+        }
+    }
+    if (needs_compaction(mIndexPool)) {
+        compact(mIndexPool, true);
+    }
+}
+
+void GeometryArena::bind(WGPURenderPassEncoder encoder, const GeometryAllocation& allocation, StateCache* state) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& pool = getPool(allocation.layout);
+    for (size_t stream = 0; stream < pool.buffers.size(); ++stream) {
+        WGPUBuffer buffer = pool.buffers[stream].getBuffer();
+        if (state == nullptr || state->setVertexBuffer(stream, buffer)) {
+            wgpuRenderPassEncoderSetVertexBuffer(encoder, stream, buffer, 0, pool.buffers[stream].getBufferSize());
+        }
+    }
+    if (mIndexPool.buffers.empty()) {
+        return;
+    }
+    WGPUBuffer index_buffer = mIndexPool.buffers[0].getBuffer();
+    if (state == nullptr || state->setIndexBuffer(index_buffer)) {
+        wgpuRenderPassEncoderSetIndexBuffer(encoder, index_buffer, WGPUIndexFormat_Uint32, 0,
+                                            mIndexPool.buffers[0].getBufferSize());
+    }
+}
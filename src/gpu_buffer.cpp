@@ -4,6 +4,7 @@
 
 // #include "application.h"
 #include "rendererResource.h"
+#include "upload_ring.h"
 
 Buffer::Buffer() : mBufferDescriptor({}) {}
 
@@ -39,5 +40,9 @@ WGPUBuffer Buffer::create(RendererResource* resource) {
 WGPUBuffer Buffer::getBuffer() { return mBuffer; }
 
 void Buffer::queueWrite(uint64_t startOffset, const void* data, size_t writeSize) {
+    if (mResources->uploads != nullptr) {
+        mResources->uploads->write(mBuffer, startOffset, data, writeSize);
+        return;
+    }
     wgpuQueueWriteBuffer(mResources->queue, mBuffer, startOffset, data, writeSize);
 }
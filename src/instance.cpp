@@ -8,6 +8,14 @@
 #include "glm/gtx/quaternion.hpp"
 #include "mesh.h"
 #include "rendererResource.h"
+#include "utils.h"
+
+// instance bounds are kept in world space for the culling pass
+static InstanceData makeInstanceData(const glm::mat4& transform, const glm::vec3& min, const glm::vec3& max,
+                                     const WindParams& windParams) {
+    auto [world_min, world_max] = transformAABB(transform, min, max);
+    return {transform, glm::vec4{world_min, 1.0f}, glm::vec4{world_max, 1.0f}, windParams};
+}
 
 InstanceManager::InstanceManager(RendererResource* rc, size_t bufferSize, size_t maxInstancePerModel) {
     (void)maxInstancePerModel;
@@ -40,7 +48,7 @@ Instance::Instance(std::vector<glm::vec3> positions, std::vector<glm::vec3> rota
         auto rotate = glm::toMat4(glm::normalize(glm::quat(glm::radians(rotation[i]))));
         auto scale = glm::scale(glm::mat4{1.0f}, scales[i]);
         auto model_matrix = trans * rotate * scale;
-        mInstanceBuffer.emplace_back(model_matrix, model_matrix * minAABB, model_matrix * maxAABB, windParams);
+        mInstanceBuffer.push_back(makeInstanceData(model_matrix, glm::vec3(minAABB), glm::vec3(maxAABB), windParams));
     }
 }
 
@@ -63,7 +71,7 @@ uint16_t Instance::duplicateLastInstance(const Model* model) {
 
     auto wind_param =
         model->mFlattenMeshes.size() == 0 ? WindParams{} : model->mFlattenMeshes.begin()->second.mWindParams;
-    mInstanceBuffer.push_back({t, t * glm::vec4{model->min, 1.0f}, t * glm::vec4{model->max, 1.0f}, wind_param});
+    mInstanceBuffer.push_back(makeInstanceData(t, model->min, model->max, wind_param));
     mPhysicsComponents.push_back(nullptr);
 
     return new_idx;
@@ -100,8 +108,7 @@ Transformable& SingleInstance::moveTo(const glm::vec3& to) {
     auto t = trans * r * s;
 
     auto wind = instance->mInstanceBuffer[idx].windParams;
-    instance->mInstanceBuffer[idx] = {t, t * glm::vec4{instance->parent->min, 1.0f},
-                                      t * glm::vec4{instance->parent->max, 1.0f}, wind};
+    instance->mInstanceBuffer[idx] = makeInstanceData(t, instance->parent->min, instance->parent->max, wind);
 
     instance->mManager->getInstancingBuffer().queueWrite(
         ((InstanceManager::MAX_INSTANCE_COUNT * instance->mOffsetID) + idx) * sizeof(InstanceData),
@@ -121,8 +128,7 @@ Transformable& SingleInstance::rotate(const glm::vec3& to) {
     auto t = trans * r * s;
 
     auto wind = instance->mInstanceBuffer[idx].windParams;
-    instance->mInstanceBuffer[idx] = {t, t * glm::vec4{instance->parent->min, 1.0f},
-                                      t * glm::vec4{instance->parent->max, 1.0f}, wind};
+    instance->mInstanceBuffer[idx] = makeInstanceData(t, instance->parent->min, instance->parent->max, wind);
 
     instance->mManager->getInstancingBuffer().queueWrite(
         ((InstanceManager::MAX_INSTANCE_COUNT * instance->mOffsetID) + idx) * sizeof(InstanceData),
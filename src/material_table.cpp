@@ -0,0 +1,162 @@
+#include "material_table.h"
+
+#include <array>
+#include <format>
+#include <string>
+
+#include "profiling.h"
+
+void MaterialTable::create(RendererResource* resource, WGPUBindGroupLayout layout) {
+    mResources = resource;
+    mLayout = layout;
+    mMaterials.resize(INITIAL_MATERIALS, ShaderMaterial{});
+    createMaterialBuffer(INITIAL_MATERIALS);
+    mDraws.setLabel("Draw data slots").create(mResources, sizeof(DrawData), DRAWS_PER_PAGE);
+
+    // DEFAULT_MATERIAL
+    mUsedMaterials = 1;
+    mDirty.mark(DEFAULT_MATERIAL);
+}
+
+uint32_t MaterialTable::allocateMaterial() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mFreeMaterials.empty()) {
+        uint32_t material = mFreeMaterials.back();
+        mFreeMaterials.pop_back();
+        return material;
+    }
+    // the buffer grows on the next flush(), until then the new ids are not read by any draw
+    if (mUsedMaterials == mMaterials.size()) {
+        mMaterials.resize(mMaterials.size() * 2, ShaderMaterial{});
+    }
+    return mUsedMaterials++;
+}
+
+void MaterialTable::freeMaterial(uint32_t& material) {
+    if (material == NO_MATERIAL) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (material != DEFAULT_MATERIAL) {
+        mFreeMaterials.push_back(material);
+    }
+    material = NO_MATERIAL;
+}
+
+void MaterialTable::writeMaterial(uint32_t material, const ShaderMaterial& data) {
+    // the default material is shared by every mesh that did not get its own
+    if (material == DEFAULT_MATERIAL || material == NO_MATERIAL) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMaterials[material] = data;
+    mDirty.mark(material);
+    mPendingWrites++;
+}
+
+SlotBuffer::Slot MaterialTable::allocateDraw() { return mDraws.allocate(); }
+
+void MaterialTable::freeDraw(SlotBuffer::Slot& draw) { mDraws.free(draw); }
+
+void MaterialTable::writeDraw(const SlotBuffer::Slot& draw, const DrawData& data) {
+    mDraws.write(draw, &data, sizeof(DrawData));
+}
+
+const MaterialTable::Binding& MaterialTable::getBinding(Mesh& mesh) {
+    // no lock while the bind groups stay, draws only see a new generation after a flush()
+    if (mesh.mDrawBinding.generation != mGeneration.load(std::memory_order_relaxed) ||
+        mesh.mDrawBinding.group == nullptr) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mesh.mDrawBinding = lookupBinding(mesh.mDrawSlot);
+    }
+    return mesh.mDrawBinding;
+}
+
+MaterialTable::Binding MaterialTable::lookupBinding(const SlotBuffer::Slot& draw) {
+    if (draw.page >= mBindGroups.size()) {
+        mBindGroups.resize(draw.page + 1, nullptr);
+    }
+    auto& group = mBindGroups[draw.page];
+    if (group == nullptr) {
+        std::array<WGPUBindGroupEntry, 2> entries = {};
+        entries[0].binding = 0;
+        entries[0].buffer = mMaterialBuffer.getBuffer();
+        entries[0].offset = 0;
+        entries[0].size = sizeof(ShaderMaterial) * mCapacity;
+
+        entries[1].binding = 1;
+        entries[1].buffer = mDraws.getBuffer(draw);
+        entries[1].offset = 0;
+        entries[1].size = sizeof(DrawData);
+
+        std::string label = std::format("material table bind group {}", draw.page);
+        WGPUBindGroupDescriptor descriptor = {};
+        descriptor.label = {label.c_str(), label.size()};
+        descriptor.layout = mLayout;
+        descriptor.entryCount = entries.size();
+        descriptor.entries = entries.data();
+        group = wgpuDeviceCreateBindGroup(mResources->device, &descriptor);
+    }
+    return {group, 1, static_cast<uint32_t>(mDraws.getOffset(draw)), mGeneration.load()};
+}
+
+void MaterialTable::createMaterialBuffer(uint32_t capacity) {
+    WGPUBuffer old = mMaterialBuffer.getBuffer();
+    mMaterialBuffer.setLabel("material table")
+        .setUsage(WGPUBufferUsage_CopyDst | WGPUBufferUsage_Storage)
+        .setSize(sizeof(ShaderMaterial) * capacity)
+        .setMappedAtCraetion(false)
+        .create(mResources);
+    mCapacity = capacity;
+    if (old == nullptr) {
+        return;
+    }
+    // pending uploads hold their own reference to the old buffer
+    wgpuBufferRelease(old);
+    for (auto& group : mBindGroups) {
+        if (group != nullptr) {
+            wgpuBindGroupRelease(group);
+        }
+    }
+    mBindGroups.clear();
+    mGeneration++;
+    // the new buffer starts out empty
+    for (uint32_t material = 0; material < mUsedMaterials; ++material) {
+        mDirty.mark(material);
+    }
+}
+
+void MaterialTable::flush() {
+    ZoneScopedN("Material table flush");
+    mDraws.flush();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats = {};
+    mStats.slotWrites = mPendingWrites;
+    mPendingWrites = 0;
+    if (mMaterials.size() > mCapacity) {
+        createMaterialBuffer(static_cast<uint32_t>(mMaterials.size()));
+    }
+    if (mDirty.empty()) {
+        return;
+    }
+    mDirty.takeRanges(mRanges);
+    for (const auto& range : mRanges) {
+        uint64_t offset = range.begin * sizeof(ShaderMaterial);
+        uint64_t size = (range.end - range.begin) * sizeof(ShaderMaterial);
+        mMaterialBuffer.queueWrite(offset, &mMaterials[range.begin], size);
+        mStats.queueWrites++;
+        mStats.bytes += size;
+    }
+}
+
+uint32_t MaterialTable::getMaterialCount() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mUsedMaterials - static_cast<uint32_t>(mFreeMaterials.size());
+}
+
+uint32_t MaterialTable::getCapacity() const { return mCapacity; }
+
+const SlotBuffer::Stats& MaterialTable::getStats() const { return mStats; }
+
+SlotBuffer& MaterialTable::getDrawSlots() { return mDraws; }
@@ -1,5 +1,8 @@
 #include "mesh.h"
 
+#include "geometry_arena.h"
+#include "glm/glm.hpp"
+
 void Mesh::setVisible(bool visibility) { mIsVisible = visibility; }
 
 bool Mesh::getVisible() const { return mIsVisible; }
@@ -12,3 +15,77 @@ void Mesh::setMatreial(const std::shared_ptr<Material> mat) {
 }
 
 std::shared_ptr<Material> Mesh::getMatreial() { return mTextureMaterial; }
+
+void DrawBinding::set(WGPURenderPassEncoder encoder, uint32_t groupIndex) const {
+    wgpuRenderPassEncoderSetBindGroup(encoder, groupIndex, group, dynamicOffsetCount, &dynamicOffset);
+}
+
+void Mesh::bindGeometry(WGPURenderPassEncoder encoder, GeometryArena* arena, StateCache* state) {
+    if (mGeometry != nullptr) {
+        arena->bind(encoder, *mGeometry, state);
+        return;
+    }
+    if (state == nullptr || state->setVertexBuffer(0, mVertexBuffer.getBuffer())) {
+        wgpuRenderPassEncoderSetVertexBuffer(encoder, 0, mVertexBuffer.getBuffer(), 0,
+                                             wgpuBufferGetSize(mVertexBuffer.getBuffer()));
+    }
+    bool skinned = mVertexLayout == VertexLayout::Packed;
+    if (skinned && (state == nullptr || state->setVertexBuffer(1, mSkinBuffer.getBuffer()))) {
+        wgpuRenderPassEncoderSetVertexBuffer(encoder, 1, mSkinBuffer.getBuffer(), 0,
+                                             wgpuBufferGetSize(mSkinBuffer.getBuffer()));
+    }
+    if (state == nullptr || state->setIndexBuffer(mIndexBuffer.getBuffer())) {
+        wgpuRenderPassEncoderSetIndexBuffer(encoder, mIndexBuffer.getBuffer(), WGPUIndexFormat_Uint32, 0,
+                                            wgpuBufferGetSize(mIndexBuffer.getBuffer()));
+    }
+}
+
+uint32_t Mesh::getFirstIndex() const {
+    return mGeometry != nullptr ? static_cast<uint32_t>(mGeometry->indices.offset) : 0;
+}
+
+int32_t Mesh::getBaseVertex() const {
+    return mGeometry != nullptr ? static_cast<int32_t>(mGeometry->vertices.offset) : 0;
+}
+
+void Mesh::drawIndexed(WGPURenderPassEncoder encoder, uint32_t instanceCount) {
+    wgpuRenderPassEncoderDrawIndexed(encoder, mIndexData.size(), instanceCount, getFirstIndex(), getBaseVertex(), 0);
+}
+
+namespace packing {
+
+VertexLayout chooseLayout(const std::vector<VertexAttributes>& vertices, bool skinned) {
+    for (const auto& vertex : vertices) {
+        if (glm::any(glm::greaterThan(glm::abs(vertex.uv), glm::vec2{MAX_PACKED_UV})) ||
+            glm::any(glm::greaterThan(vertex.color, glm::vec3{1.0f})) ||
+            glm::any(glm::lessThan(vertex.color, glm::vec3{0.0f}))) {
+            return VertexLayout::Full;
+        }
+        if (skinned && (glm::any(glm::greaterThan(vertex.boneIds, glm::ivec4{MAX_PACKED_BONE_ID})) ||
+                        glm::any(glm::lessThan(vertex.boneIds, glm::ivec4{0})))) {
+            return VertexLayout::Full;
+        }
+    }
+    return skinned ? VertexLayout::Packed : VertexLayout::PackedStatic;
+}
+
+PackedVertex packVertex(const VertexAttributes& vertex) {
+    PackedVertex packed;
+    packed.position = vertex.position;
+    packed.normal = packOctahedral(vertex.normal.x, vertex.normal.y, vertex.normal.z);
+    packed.tangent = packOctahedral(vertex.tangent.x, vertex.tangent.y, vertex.tangent.z);
+    // the bitangent is rebuilt in the shader as cross(normal, tangent) * sign
+    float sign = glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.biTangent) < 0.0f ? 0.0f : 1.0f;
+    packed.color = packUnorm4(vertex.color.r, vertex.color.g, vertex.color.b, sign);
+    packed.uv = packHalf2(vertex.uv.x, vertex.uv.y);
+    return packed;
+}
+
+PackedSkin packSkin(const VertexAttributes& vertex) {
+    PackedSkin packed;
+    packed.boneIds = packBoneIds({vertex.boneIds.x, vertex.boneIds.y, vertex.boneIds.z, vertex.boneIds.w});
+    packed.weights = packWeights({vertex.weights.x, vertex.weights.y, vertex.weights.z, vertex.weights.w});
+    return packed;
+}
+
+}  // namespace packing
@@ -5,10 +5,12 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
+#include <algorithm>
 #include <assimp/Importer.hpp>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <format>
 #include <iostream>
 #include <map>
@@ -42,6 +44,9 @@
 
 #include "../tinyobjloader/tiny_obj_loader.h"
 #include "application.h"
+#include "cooked_asset.h"
+#include "geometry_arena.h"
+#include "loader_pool.h"
 #include "glm/ext/matrix_transform.hpp"
 #include "glm/ext/quaternion_trigonometric.hpp"
 #include "glm/fwd.hpp"
@@ -67,11 +72,10 @@ extern std::pair<LineGroup*, LineGroup*> getbonelinegroup();  // { return {boneD
 Drawable::Drawable() {}
 
 void Drawable::configure(Application* app) {
-    mUniformBuffer.setLabel("Uniform buffer for object info")
-        .setUsage(WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform)
-        .setSize(sizeof(ObjectInfo))
-        .setMappedAtCraetion()
-        .create(&app->getRendererResource());
+    mObjectSlots = &app->mObjectSlots;
+    if (!mObjectSlot.isValid()) {
+        mObjectSlot = mObjectSlots->allocate();
+    }
 }
 
 Transformable& Transformable::moveTo(const glm::vec3&) { return *this; }
@@ -107,22 +111,27 @@ Node* Node::buildNodeTree(aiNode* ainode, Node* parent, std::unordered_map<std::
     return node;
 }
 
-void populateGlobalMeshesTransformationBuffer(Application* app, Node* node, std::vector<glm::mat4>& buffer,
-                                              std::unordered_map<int, Mesh>& meshes,
-                                              const std::unordered_map<std::string, glm::mat4>& animation) {
-    if (node == nullptr) {
-        return;
+void Node::flatten(Node* node, int32_t parent, TransformHierarchy& transforms, std::vector<Node*>& nodes) {
+    node->mTransformIndex = transforms.add(parent, node->mLocalTransform);
+    nodes.push_back(node);
+    for (auto* child : node->mChildrens) {
+        flatten(child, node->mTransformIndex, transforms, nodes);
     }
+}
 
-    for (auto idx : node->mMeshIndices) {
-        glm::mat4 anim{1.0};
-        if (animation.contains(node->mName)) {
-            anim = animation.at(node->mName);
+// one pass over the flattened tree, the node world transforms are recomputed only where a local one changed
+void populateGlobalMeshesTransformationBuffer(const std::vector<Node*>& nodes, TransformHierarchy& transforms,
+                                              std::vector<glm::mat4>& buffer,
+                                              const std::vector<glm::mat4>& animation) {
+    transforms.update();
+    for (const auto* node : nodes) {
+        for (auto idx : node->mMeshIndices) {
+            glm::mat4 anim{1.0};
+            if (node->mJointIndex >= 0 && static_cast<size_t>(node->mJointIndex) < animation.size()) {
+                anim = transforms.getLocal(node->mTransformIndex) * animation[node->mJointIndex];
+            }
+            buffer[idx] = transforms.getWorld(node->mTransformIndex) * anim;
         }
-        buffer[idx] = node->getGlobalTransform() * anim;
-    }
-    for (auto* child : node->mChildrens) {
-        populateGlobalMeshesTransformationBuffer(app, child, buffer, meshes, animation);
     }
 }
 
@@ -133,7 +142,13 @@ glm::mat4 Node::getGlobalTransform() const {
     return mLocalTransform;
 }
 
-Buffer& Drawable::getUniformBuffer() { return mUniformBuffer; }
+WGPUBuffer Drawable::getObjectInfoBuffer() { return mObjectSlots->getBuffer(mObjectSlot); }
+
+uint64_t Drawable::getObjectInfoOffset() const { return mObjectSlots->getOffset(mObjectSlot); }
+
+void Drawable::writeObjectInfo(const void* data, size_t size, uint64_t offset) {
+    mObjectSlots->write(mObjectSlot, data, size, offset);
+}
 
 Model::Model(CoordinateSystem cs) : BaseModel() {
     BaseModel::setCoordinateSystem(cs);
@@ -206,23 +221,23 @@ void Model::updateAnimation(float dt) {
                 action->mAnimationSecond = duration_ms;
             }
         }
-        anim->update(mScene->mRootNode);
+        // a paused or finished action would sample the same pose, the bones stay as they are
+        if (action == mSampledAction && action->mAnimationSecond == mSampledSecond) {
+            return;
+        }
+        mSampledAction = action;
+        mSampledSecond = action->mAnimationSecond;
+        anim->update();
 
     } else {
         return;
     }
 
     if (action->hasSkining) {
+        mBonesDirty = true;
         if (action != nullptr) {
-            for (const auto& [boneName, _] : action->Bonemap) {
-                const auto& global = anim->calculatedTransform[boneName];
-                const auto& offset = action->Bonemap[boneName]->offsetMatrix;
-
-                auto final = global * offset;
-
-                // if (std::isfinite(final[0][0])) {
-                anim->mFinalTransformations[action->Bonemap[boneName]->id] = final;
-                // }
+            for (const auto& skin : action->compiled.skin) {
+                anim->mFinalTransformations[skin.boneId] = anim->mGlobalTransforms[skin.joint] * skin.offsetMatrix;
             }
         } else {
             for (auto& transformation : anim->mFinalTransformations) {
@@ -230,20 +245,10 @@ void Model::updateAnimation(float dt) {
             }
         }
     } else {
-        bool shoulddo = false;
-        std::unordered_map<std::string, glm::mat4> anims;
-        for (const auto& [node_name, node] : mNodeNameMap) {
-            shoulddo = true;
-            const auto& animation_transform = anim->localTransformation.at(node_name);
-            anims[node_name] = node->mLocalTransform * animation_transform;
-        }
-        if (shoulddo) {
-            populateGlobalMeshesTransformationBuffer(mApp, mRootNode, mGlobalMeshTransformationData, mFlattenMeshes,
-                                                     anims);
-            auto& databuffer = mGlobalMeshTransformationData;
-
-            mGlobalMeshTransformationBuffer.queueWrite(0, databuffer.data(), sizeof(glm::mat4) * databuffer.size());
-
+        if (mRootNode != nullptr) {
+            populateGlobalMeshesTransformationBuffer(mNodes, mNodeTransforms, mGlobalMeshTransformationData,
+                                                     anim->mLocalTransforms);
+            mMeshTransformsDirty = true;
             mTransform.mDirty = true;
         }
     }
@@ -290,8 +295,11 @@ void Model::processNode(Application* app, aiNode* node, const aiScene* scene, co
     // Process meshes in this node
     for (uint32_t i = 0; i < node->mNumMeshes; i++) {
         unsigned int mid = node->mMeshes[i];
-        aiMesh* mesh = scene->mMeshes[mid];
-        processMesh(app, mesh, scene, mid, globalTransform);
+        if (mCookedAsset != nullptr) {
+            processCookedMesh(app, mCookedAsset->meshes[mid], scene, mid);
+        } else {
+            processMesh(app, scene->mMeshes[mid], scene, mid, globalTransform);
+        }
     }
 
     // Recursively process child nodes
@@ -310,35 +318,28 @@ void loaderCallback(TextureLoader::LoadRequest* request) {
 void Model::processMesh(Application* app, aiMesh* mesh, const aiScene* scene, unsigned int meshId,
                         const glm::mat4& globalTransform) {
     aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-    std::map<size_t, std::vector<std::pair<size_t, float>>> vertex_weights;
-    mFlattenMeshes[mMeshNumber] = {};
-    size_t index_offset = mFlattenMeshes[mMeshNumber].mVertexData.size();
-
-    if (mesh->HasBones() && !anim->actions.empty()) {
-        Action* action = anim->actions.begin()->second;
-        for (uint32_t i = 0; i < mesh->mNumBones; ++i) {
-            const auto* bone = mesh->mBones[i];
-            for (size_t j = 0; j < bone->mNumWeights; ++j) {
-                const char* name = bone->mName.C_Str();
-
-                auto& vid = bone->mWeights[j].mVertexId;
-                if (vertex_weights.count(vid) == 0) {
-                    vertex_weights[vid] = {};
-                }
-                if (action && action->Bonemap.contains(name)) {
-                    vertex_weights[vid].emplace_back(action->Bonemap[name]->id, bone->mWeights[j].mWeight);
-                }
-            }
-        }
-    }
+    auto& mmesh = mFlattenMeshes[mMeshNumber];
+    mmesh = {};
+    size_t index_offset = mmesh.mVertexData.size();
 
     // Compute normal transformation (inverse transpose for normals)
-    glm::mat4 normalTransform = glm::transpose(glm::inverse(globalTransform));
     glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(globalTransform)));
 
     glm::mat4 yUpToZUp = glm::mat4(1.0f);
     yUpToZUp = glm::rotate(yUpToZUp, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));  // 90° around X
     glm::mat3 rot3 = glm::mat3(yUpToZUp);
+
+    glm::mat4 swap{1.0};  // identity matrix for default case
+    if (getCoordinateSystem() == CoordinateSystem::Z_UP) {
+        swap = {{1, 0, 0, 0}, {0, 0, -1, 0}, {0, 1, 0, 0}, {0, 0, 0, 1}};
+    }
+
+    // the diffuse color is per material, not per vertex
+    aiColor4D baseColor(1.0f, 0.0f, 1.0f, 1.0f);
+    material->Get(AI_MATKEY_COLOR_DIFFUSE, baseColor);
+    const glm::vec3 color = glm::vec3(baseColor.r, baseColor.g, baseColor.b);
+
+    mmesh.mVertexData.reserve(mesh->mNumVertices);
     //
     for (uint32_t i = 0; i < mesh->mNumVertices; i++) {
         VertexAttributes vertex;
@@ -346,25 +347,8 @@ void Model::processMesh(Application* app, aiMesh* mesh, const aiScene* scene, un
         // Transform vertex position
         glm::vec4 pos(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z, 1.0f);
         pos = globalTransform * pos;
-        glm::vec3 vector(pos.x, pos.y, pos.z);
         pos = yUpToZUp * pos;
-        vertex.position = glm::vec3{std::move(pos)};
-
-        glm::mat4 swap{1.0};  // identity matrix for default case
-        if (getCoordinateSystem() == CoordinateSystem::Z_UP) {
-            swap = {{1, 0, 0, 0}, {0, 0, -1, 0}, {0, 1, 0, 0}, {0, 0, 0, 1}};
-        }
-        auto temp = swap * glm::vec4{vertex.position, 1.0};
-        vertex.position = glm::vec3{temp};
-
-        size_t bid_cnt = 0;
-        if (mesh->HasBones()) {
-            for (const auto& [bid, bwg] : vertex_weights[i]) {
-                vertex.boneIds[bid_cnt % 4] = bid;
-                vertex.weights[bid_cnt % 4] = bwg;
-                ++bid_cnt;
-            }
-        }
+        vertex.position = glm::vec3{swap * pos};
 
         // Update bounding box
         min.x = std::min(min.x, vertex.position.x);
@@ -373,6 +357,8 @@ void Model::processMesh(Application* app, aiMesh* mesh, const aiScene* scene, un
         max.x = std::max(max.x, vertex.position.x);
         max.y = std::max(max.y, vertex.position.y);
         max.z = std::max(max.z, vertex.position.z);
+        mmesh.mBoundsMin = glm::min(mmesh.mBoundsMin, vertex.position);
+        mmesh.mBoundsMax = glm::max(mmesh.mBoundsMax, vertex.position);
 
         if (mesh->HasNormals()) {
             // Transform normal
@@ -383,9 +369,7 @@ void Model::processMesh(Application* app, aiMesh* mesh, const aiScene* scene, un
             vertex.normal = glm::vec3{std::move(temp)};
         }
 
-        aiColor4D baseColor(1.0f, 0.0f, 1.0f, 1.0f);
-        material->Get(AI_MATKEY_COLOR_DIFFUSE, baseColor);
-        vertex.color = glm::vec3(baseColor.r, baseColor.g, baseColor.b);
+        vertex.color = color;
 
         if (mesh->mTextureCoords[0]) {
             glm::vec2 vec;
@@ -412,19 +396,94 @@ void Model::processMesh(Application* app, aiMesh* mesh, const aiScene* scene, un
             vertex.uv = glm::vec2{0.0f, 0.0f};
         }
 
-        mFlattenMeshes[mMeshNumber].mVertexData.push_back(vertex);
+        mmesh.mVertexData.push_back(vertex);
     }
-    mFlattenMeshes[mMeshNumber].mName = mesh->mName.C_Str();
+    applyBoneWeights(mesh, mmesh);
+    mmesh.mName = mesh->mName.C_Str();
 
+    // meshes are triangulated on import (or when cooked)
+    mmesh.mIndexData.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
     for (uint32_t i = 0; i < mesh->mNumFaces; i++) {
-        aiFace face = mesh->mFaces[i];
+        const aiFace& face = mesh->mFaces[i];
         for (uint32_t j = 0; j < face.mNumIndices; j++) {
-            mFlattenMeshes[mMeshNumber].mIndexData.push_back((uint32_t)face.mIndices[j] + index_offset);
+            mmesh.mIndexData.push_back((uint32_t)face.mIndices[j] + index_offset);
         }
     }
 
+    loadMeshTextures(app, mmesh, material);
+    mFlattenMeshes[mMeshNumber].meshId = meshId;
+    mMeshNumber++;
+}
+
+// the cooked vertices are processMesh's output before the coordinate system swap, see cooked::flattenMesh
+static_assert(sizeof(cooked::Vertex) == sizeof(VertexAttributes));
+static_assert(offsetof(cooked::Vertex, normal) == offsetof(VertexAttributes, normal));
+static_assert(offsetof(cooked::Vertex, tangent) == offsetof(VertexAttributes, tangent));
+static_assert(offsetof(cooked::Vertex, uv) == offsetof(VertexAttributes, uv));
+static_assert(offsetof(cooked::Vertex, boneIds) == offsetof(VertexAttributes, boneIds));
+static_assert(offsetof(cooked::Vertex, weights) == offsetof(VertexAttributes, weights));
+
+void Model::processCookedMesh(Application* app, const cooked::Mesh& cookedMesh, const aiScene* scene,
+                              unsigned int meshId) {
+    const aiMesh* mesh = scene->mMeshes[meshId];
     auto& mmesh = mFlattenMeshes[mMeshNumber];
+    mmesh = {};
+
+    mmesh.mVertexData.resize(cookedMesh.vertexCount);
+    std::memcpy(static_cast<void*>(mmesh.mVertexData.data()), cookedMesh.vertices,
+                sizeof(VertexAttributes) * cookedMesh.vertexCount);
+    mmesh.mIndexData.resize(cookedMesh.indexCount);
+    std::memcpy(mmesh.mIndexData.data(), cookedMesh.indices, sizeof(uint32_t) * cookedMesh.indexCount);
+
+    const bool z_up = getCoordinateSystem() == CoordinateSystem::Z_UP;
+    auto swap = [](glm::vec3& v) { v = glm::vec3{v.x, v.z, -v.y}; };
+    for (auto& vertex : mmesh.mVertexData) {
+        if (z_up) {
+            swap(vertex.position);
+            swap(vertex.normal);
+            swap(vertex.tangent);
+            swap(vertex.biTangent);
+        }
+        min = glm::min(min, vertex.position);
+        max = glm::max(max, vertex.position);
+        mmesh.mBoundsMin = glm::min(mmesh.mBoundsMin, vertex.position);
+        mmesh.mBoundsMax = glm::max(mmesh.mBoundsMax, vertex.position);
+    }
+    applyBoneWeights(mesh, mmesh);
+    mmesh.mName = mesh->mName.C_Str();
+
+    loadMeshTextures(app, mmesh, scene->mMaterials[mesh->mMaterialIndex]);
+    mmesh.meshId = meshId;
+    mMeshNumber++;
+}
+
+void Model::applyBoneWeights(const aiMesh* mesh, Mesh& mmesh) {
+    if (!mesh->HasBones() || anim->actions.empty()) {
+        return;
+    }
+    // up to four influences per vertex, in bone order, a fifth one overwrites the first
+    std::vector<uint32_t> counts(mmesh.mVertexData.size(), 0);
+    Action* action = anim->actions.begin()->second;
+    for (uint32_t i = 0; i < mesh->mNumBones; ++i) {
+        const auto* bone = mesh->mBones[i];
+        auto bone_it = action->Bonemap.find(bone->mName.C_Str());
+        if (bone_it == action->Bonemap.end()) {
+            continue;
+        }
+        for (size_t j = 0; j < bone->mNumWeights; ++j) {
+            auto vid = bone->mWeights[j].mVertexId;
+            if (vid >= counts.size()) {
+                continue;
+            }
+            auto& vertex = mmesh.mVertexData[vid];
+            uint32_t slot = counts[vid]++ % 4;
+            vertex.boneIds[slot] = bone_it->second->id;
+            vertex.weights[slot] = bone->mWeights[j].mWeight;
+        }
+    }
+}
 
+void Model::loadMeshTextures(Application* app, Mesh& mmesh, const aiMaterial* material) {
     auto base_path = std::filesystem::path(mPath).parent_path();
 
     auto load_texture = [&](aiTextureType type, MaterialProps flag, std::shared_ptr<Texture>* target) {
@@ -442,8 +501,8 @@ void Model::processMesh(Application* app, aiMesh* mesh, const aiScene* scene, un
                 pos += 1;                           // move past the inserted space
             }
 
-            auto texture =
-                Texture::asyncLoadTexture(app->mTextureRegistery, app->getRendererResource(), texture_path, "");
+            auto texture = Texture::asyncLoadTexture(app->mTextureRegistery, app->getRendererResource(), texture_path,
+                                                     "", true, type == aiTextureType_DIFFUSE);
             if (texture != nullptr) {
                 *target = texture;
                 mmesh.isTransparent = (*target)->isTransparent();
@@ -464,8 +523,6 @@ void Model::processMesh(Application* app, aiMesh* mesh, const aiScene* scene, un
     if (mmesh.mNormalMapTexture == nullptr) {
         load_texture(aiTextureType_NORMALS, MaterialProps::HasNormalMap, &mmesh.mNormalMapTexture);
     }
-    mFlattenMeshes[mMeshNumber].meshId = meshId;
-    mMeshNumber++;
 }
 
 Model& Model::load(std::string name, Application* app, const std::filesystem::path& path, WGPUBindGroupLayout layout) {
@@ -479,14 +536,29 @@ Model& Model::load(std::string name, Application* app, const std::filesystem::pa
     std::string warn;
     std::string err;
 
-    const aiScene* const scene =
-        mImport.ReadFile(path.string().c_str(), aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace |
-                                                    aiProcess_JoinIdenticalVertices);
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-        std::cout << std::format("Assimp - Error while loading model {} : {}\n", (const char*)path.c_str(),
-                                 mImport.GetErrorString());
-    } else {
-        std::cout << std::format("Assimp - Succesfully loaded model {}\n", (const char*)path.c_str());
+    const aiScene* scene = nullptr;
+
+    // prefer the cooked binary produced by the exporter, it needs no importing or post-processing
+    auto cooked_path = cooked::findCookedAsset(path);
+    if (!cooked_path.empty()) {
+        mCookedAsset = cooked::loadAsset(cooked_path);
+        if (mCookedAsset != nullptr) {
+            scene = mCookedAsset->scene.get();
+            std::cout << std::format("Cooked - Succesfully loaded model {}\n", cooked_path.string());
+        }
+    }
+
+    if (scene == nullptr) {
+        {
+            ImportSlot import_slot;
+            scene = mImport.ReadFile(path.string().c_str(), cooked::IMPORT_FLAGS);
+        }
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+            std::cout << std::format("Assimp - Error while loading model {} : {}\n", (const char*)path.c_str(),
+                                     mImport.GetErrorString());
+        } else {
+            std::cout << std::format("Assimp - Succesfully loaded model {}\n", (const char*)path.c_str());
+        }
     }
     mScene = scene;
 
@@ -494,17 +566,26 @@ Model& Model::load(std::string name, Application* app, const std::filesystem::pa
     updateAnimation(0);
 
     mRootNode = Node::buildNodeTree(scene->mRootNode, nullptr, mNodeNameMap);
+    for (auto& [node_name, node] : mNodeNameMap) {
+        node->mJointIndex = anim->skeleton.getJointIndex(node_name);
+    }
 
+    mNodeTransforms.clear();
+    mNodes.clear();
     if (mRootNode != nullptr) {
-        // std::cout << "$$$$$$$$$$$$$$$$$$$$$$$$ Node hirarchy created for" << getName() << " Succesfuly\n";
-        // std::cout << glm::to_string(AiToGlm(mScene->mRootNode->mTransformation)) << "\n";
+        Node::flatten(mRootNode, -1, mNodeTransforms, mNodes);
     }
 
     processNode(app, scene->mRootNode, scene, glm::mat4{1.0});
+    if (mCookedAsset != nullptr) {
+        // the meshes are copied out, only the scene is still needed
+        mCookedAsset->meshes.clear();
+        mCookedAsset->file.close();
+    }
 
     mGlobalMeshTransformationData.reserve(mFlattenMeshes.size());
     mGlobalMeshTransformationData.resize(mFlattenMeshes.size());
-    populateGlobalMeshesTransformationBuffer(app, mRootNode, mGlobalMeshTransformationData, mFlattenMeshes, {});
+    populateGlobalMeshesTransformationBuffer(mNodes, mNodeTransforms, mGlobalMeshTransformationData, {});
 
     return *this;
 }
@@ -534,7 +615,16 @@ void BaseModel::addChildren(BaseModel* child) {
 
 Model& Model::setFoliage() {
     mTransform.mDirty = true;
-    // mTransform.mObjectInfo.isFoliage = 1;
+    // alpha tested rather than blended, so it stays in the opaque passes
+    for (auto& [id, mesh] : mFlattenMeshes) {
+        mesh.mMaterial.setFlag(MaterialProps::IsFoliage, true);
+    }
+    setTransparent(false);
+    return *this;
+}
+
+Model& Model::setVertexPacking(bool pack) {
+    mPackVertices = pack;
     return *this;
 }
 
@@ -549,8 +639,7 @@ BaseModel& BaseModel::moveBy(const glm::vec3& translationVec) {
     mTransform.mDirty = true;
     mTransform.mPosition += translationVec;
     mTransform.mTranslationMatrix = glm::translate(glm::mat4{1.0}, mTransform.mPosition);
-    // getLocalTransform();
-    getGlobalTransform();
+    transformChanged();
     return *this;
 }
 
@@ -558,21 +647,73 @@ BaseModel& BaseModel::moveTo(const glm::vec3& moveVec) {
     mTransform.mDirty = true;
     mTransform.mPosition = moveVec;
     mTransform.mTranslationMatrix = glm::translate(glm::mat4{1.0}, mTransform.mPosition);
-    // getLocalTransform();
-    getGlobalTransform();
+    transformChanged();
     return *this;
 }
 
+// Creates a vertex buffer for a single stream of `data`, used for meshes the geometry arena could not take
+template <typename T>
+static void createMeshBuffer(Buffer& buffer, const char* label, const std::vector<T>& data,
+                             RendererResource* resource) {
+    buffer.setLabel(label)
+        .setUsage(WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex)
+        .setSize((data.size() + 1) * sizeof(T))
+        .setMappedAtCraetion()
+        .create(resource);
+    buffer.queueWrite(0, data.data(), data.size() * sizeof(T));
+}
+
 Model& Model::uploadToGPU(Application* app) {
+    mHasPackedMeshes = false;
+    auto* arena = mApp->mGeometryArena;
     for (auto& [_mat_id, mesh] : mFlattenMeshes) {
         // std::cout << getName() << " mesh has " << mesh.mVertexData.size() << '\n';
-        mesh.mVertexBuffer.setLabel("Uniform buffer for object info")
-            .setUsage(WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex)
-            .setSize((mesh.mVertexData.size() + 1) * sizeof(VertexAttributes))
-            .setMappedAtCraetion()
-            .create(&mApp->getRendererResource());
+        mesh.mVertexLayout = VertexLayout::Full;
+        if (mPackVertices) {
+            // skinning data is only kept for animated models, out of range attributes keep the full layout
+            mesh.mVertexLayout = packing::chooseLayout(mesh.mVertexData, mTransform.mObjectInfo.isAnimated);
+        }
 
-        mesh.mVertexBuffer.queueWrite(0, mesh.mVertexData.data(), mesh.mVertexData.size() * sizeof(VertexAttributes));
+        std::vector<PackedVertex> packed_vertices;
+        std::vector<PackedSkin> packed_skin;
+        if (mesh.mVertexLayout != VertexLayout::Full) {
+            mHasPackedMeshes = true;
+            packed_vertices.reserve(mesh.mVertexData.size());
+            for (const auto& vertex : mesh.mVertexData) {
+                packed_vertices.push_back(packing::packVertex(vertex));
+            }
+        }
+        if (mesh.mVertexLayout == VertexLayout::Packed) {
+            packed_skin.reserve(mesh.mVertexData.size());
+            for (const auto& vertex : mesh.mVertexData) {
+                packed_skin.push_back(packing::packSkin(vertex));
+            }
+        }
+
+        arena->free(mesh.mGeometry);
+        mesh.mGeometry = arena->allocate(mesh.mVertexLayout, mesh.mVertexData.size(), mesh.mIndexData.size());
+        if (mesh.mGeometry != nullptr) {
+            if (mesh.mVertexLayout == VertexLayout::Full) {
+                arena->writeVertices(*mesh.mGeometry, 0, mesh.mVertexData.data(), mesh.mVertexData.size());
+            } else {
+                arena->writeVertices(*mesh.mGeometry, 0, packed_vertices.data(), packed_vertices.size());
+            }
+            if (mesh.mVertexLayout == VertexLayout::Packed) {
+                arena->writeVertices(*mesh.mGeometry, 1, packed_skin.data(), packed_skin.size());
+            }
+            arena->writeIndices(*mesh.mGeometry, mesh.mIndexData.data(), mesh.mIndexData.size());
+            continue;
+        }
+
+        auto* resource = &mApp->getRendererResource();
+        if (mesh.mVertexLayout == VertexLayout::Full) {
+            createMeshBuffer(mesh.mVertexBuffer, "Uniform buffer for object info", mesh.mVertexData, resource);
+        } else {
+            createMeshBuffer(mesh.mVertexBuffer, "packed vertex buffer", packed_vertices, resource);
+        }
+        if (mesh.mVertexLayout == VertexLayout::Packed) {
+            createMeshBuffer(mesh.mSkinBuffer, "packed skin buffer", packed_skin, resource);
+        }
 
         mesh.mIndexBuffer.setLabel("index buffer for object info")
             .setUsage(WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex | WGPUBufferUsage_Index)
@@ -585,6 +726,16 @@ Model& Model::uploadToGPU(Application* app) {
     return *this;
 };
 
+void Model::unloadFromGPU() {
+    auto* arena = mApp->mGeometryArena;
+    for (auto& [_mat_id, mesh] : mFlattenMeshes) {
+        arena->free(mesh.mGeometry);
+        mesh.mGeometry = nullptr;
+    }
+    // freed ranges leave holes between the other models, pack them while it is cheap
+    arena->defragment();
+}
+
 size_t BaseModel::getVertexCount() const { return mFlattenMeshes.at(0).mVertexData.size(); }
 
 Buffer BaseModel::getIndexBuffer() { return mIndexBuffer; }
@@ -604,6 +755,45 @@ void BaseModel::selected(bool selected) {
 }
 bool BaseModel::isSelected() const { return mTransform.mObjectInfo.isSelected; }
 
+// the views only ever get newer, so the sum changes whenever one of them does
+static uint32_t textureViewVersion(const Mesh& mesh) {
+    uint32_t version = 0;
+    for (const auto* texture : {mesh.mTexture.get(), mesh.mSpecularTexture.get(), mesh.mNormalMapTexture.get()}) {
+        version += texture != nullptr ? texture->getViewVersion() : 0;
+    }
+    return version;
+}
+
+void Model::createTextureBindGroup(Application* app, Mesh& mesh) {
+    auto diffuse_texture_valid = mesh.mTexture != nullptr && mesh.mTexture->isValid();
+    mesh.binding_data[0].nextInChain = nullptr;
+    mesh.binding_data[0].binding = 0;
+    mesh.binding_data[0].textureView =
+        diffuse_texture_valid ? mesh.mTexture->getTextureView() : app->mDefaultDiffuse->getTextureView();
+    mesh.mMaterial.setFlag(MaterialProps::HasDiffuseMap, diffuse_texture_valid);
+
+    auto specular_map_valid = mesh.mSpecularTexture != nullptr && mesh.mSpecularTexture->isValid();
+    mesh.binding_data[1].nextInChain = nullptr;
+    mesh.binding_data[1].binding = 1;
+    mesh.binding_data[1].textureView = specular_map_valid ? mesh.mSpecularTexture->getTextureView()
+                                                          : app->mDefaultMetallicRoughness->getTextureView();
+    mesh.mMaterial.setFlag(MaterialProps::HasRoughnessMap, specular_map_valid);
+
+    auto normal_map_valid = mesh.mNormalMapTexture != nullptr && mesh.mNormalMapTexture->isValid();
+    mesh.binding_data[2].nextInChain = nullptr;
+    mesh.binding_data[2].binding = 2;
+    mesh.binding_data[2].textureView =
+        normal_map_valid ? mesh.mNormalMapTexture->getTextureView() : app->mDefaultNormalMap->getTextureView();
+    mesh.mMaterial.setFlag(MaterialProps::HasNormalMap, normal_map_valid);
+
+    // shared with every mesh of the same views, the layout is the default texture group's
+    app->mTextureBindGroups.release(mesh.mTextureBindGroup);
+    mesh.mTextureBindGroup =
+        app->mTextureBindGroups.acquire(app->getRendererResource().device,
+                                        app->mDefaultTextureBindingGroup.getDescriptor().layout, mesh.binding_data);
+    mesh.mTextureBindVersion = textureViewVersion(mesh);
+}
+
 void Model::createSomeBinding(Application* app, std::vector<WGPUBindGroupEntry> bindingData) {
     // release the old bindgroup, if any
     if (mObjectInfoBindGroup != nullptr) {
@@ -613,15 +803,16 @@ void Model::createSomeBinding(Application* app, std::vector<WGPUBindGroupEntry>
     std::array<WGPUBindGroupEntry, 3> mBindGroupEntry = {};
     mBindGroupEntry[0].nextInChain = nullptr;
     mBindGroupEntry[0].binding = 0;
-    mBindGroupEntry[0].buffer = Drawable::getUniformBuffer().getBuffer();
-    mBindGroupEntry[0].offset = 0;
+    mBindGroupEntry[0].buffer = Drawable::getObjectInfoBuffer();
+    mBindGroupEntry[0].offset = Drawable::getObjectInfoOffset();
     mBindGroupEntry[0].size = sizeof(ObjectInfo);
 
+    bool has_bones = mTransform.mObjectInfo.isAnimated && mBoneSlot.isValid();
     mBindGroupEntry[1].nextInChain = nullptr;
-    mBindGroupEntry[1].buffer = mTransform.mObjectInfo.isAnimated ? mSkiningTransformationBuffer.getBuffer()
-                                                                  : app->mDefaultBoneFinalTransformData.getBuffer();
+    mBindGroupEntry[1].buffer = has_bones ? app->mBoneSlots.getBuffer(mBoneSlot)
+                                          : app->mDefaultBoneFinalTransformData.getBuffer();
     mBindGroupEntry[1].binding = 1;
-    mBindGroupEntry[1].offset = 0;
+    mBindGroupEntry[1].offset = has_bones ? app->mBoneSlots.getOffset(mBoneSlot) : 0;
     mBindGroupEntry[1].size = 100 * sizeof(glm::mat4);
 
     mBindGroupEntry[2].nextInChain = nullptr;
@@ -649,82 +840,16 @@ void Model::createSomeBinding(Application* app, std::vector<WGPUBindGroupEntry>
         //     continue;
         // }
 
-        auto diffuse_texture_valid = mesh.mTexture != nullptr && mesh.mTexture->isValid();
-        mesh.binding_data[0].nextInChain = nullptr;
-        mesh.binding_data[0].binding = 0;
-        mesh.binding_data[0].textureView =
-            diffuse_texture_valid ? mesh.mTexture->getTextureView() : app->mDefaultDiffuse->getTextureView();
-        mesh.mMaterial.setFlag(MaterialProps::HasDiffuseMap, diffuse_texture_valid);
-
-        auto specular_map_valid = mesh.mSpecularTexture != nullptr && mesh.mSpecularTexture->isValid();
-        mesh.binding_data[1].nextInChain = nullptr;
-        mesh.binding_data[1].binding = 1;
-        mesh.binding_data[1].textureView = specular_map_valid ? mesh.mSpecularTexture->getTextureView()
-                                                              : app->mDefaultMetallicRoughness->getTextureView();
-        mesh.mMaterial.setFlag(MaterialProps::HasRoughnessMap, specular_map_valid);
-
-        auto normal_map_valid = mesh.mNormalMapTexture != nullptr && mesh.mNormalMapTexture->isValid();
-        mesh.binding_data[2].nextInChain = nullptr;
-        mesh.binding_data[2].binding = 2;
-        mesh.binding_data[2].textureView =
-            normal_map_valid ? mesh.mNormalMapTexture->getTextureView() : app->mDefaultNormalMap->getTextureView();
-        mesh.mMaterial.setFlag(MaterialProps::HasNormalMap, normal_map_valid);
-
-        auto& desc = app->mDefaultTextureBindingGroup.getDescriptor();
-        desc.entries = mesh.binding_data.data();
-        desc.entryCount = mesh.binding_data.size();
-        mesh.mTextureBindGroup = wgpuDeviceCreateBindGroup(app->getRendererResource().device, &desc);
-
-        // Also create and initialize material buffer
-        mesh.mMaterialBuffer.setLabel("")
-            .setSize(sizeof(ShaderMaterial))
-            .setUsage(WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst)
-            .setMappedAtCraetion(false)
-            .create(&mApp->getRendererResource());
-        mesh.mMaterialBuffer.queueWrite(0, &mesh.mMaterial, sizeof(ShaderMaterial));
-
-        std::array<WGPUBindGroupEntry, 3> material_bg_entries = {};
-        material_bg_entries[0].nextInChain = nullptr;
-        material_bg_entries[0].buffer = mesh.mMaterialBuffer.getBuffer();
-        material_bg_entries[0].binding = 0;
-        material_bg_entries[0].offset = 0;
-        material_bg_entries[0].size = sizeof(ShaderMaterial);
-
-        // Also create and initialize material buffer
-        mesh.mMeshMapIdx.setLabel("mesh map index")
-            .setSize(sizeof(uint32_t))
-            .setUsage(WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst)
-            .setMappedAtCraetion(false)
-            .create(&mApp->getRendererResource());
-        mesh.mMeshMapIdx.queueWrite(0, &mesh.meshId, sizeof(uint32_t));
-
-        material_bg_entries[1].nextInChain = nullptr;
-        material_bg_entries[1].buffer = mesh.mMeshMapIdx.getBuffer();
-        material_bg_entries[1].binding = 1;
-        material_bg_entries[1].offset = 0;
-        material_bg_entries[1].size = sizeof(uint32_t);
-
-        mesh.mWindBuffer.setLabel("wind buffer")
-            .setSize(sizeof(WindParams))
-            .setUsage(WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst)
-            .setMappedAtCraetion(false)
-            .create(&mApp->getRendererResource());
-        mesh.mWindBuffer.queueWrite(0, &mesh.mWindParams, sizeof(WindParams));
-
-        material_bg_entries[2].nextInChain = nullptr;
-        material_bg_entries[2].buffer = mesh.mWindBuffer.getBuffer();
-        material_bg_entries[2].binding = 2;
-        material_bg_entries[2].offset = 0;
-        material_bg_entries[2].size = sizeof(WindParams);
-
-        WGPUBindGroupDescriptor mat_desc = {};
-        mat_desc.nextInChain = nullptr;
-        mat_desc.entries = material_bg_entries.data();
-        mat_desc.entryCount = 3;
-        mat_desc.label = WGPUStringView{"mesh material bind group", WGPU_STRLEN};
-        mat_desc.layout = app->mBindGroupLayouts[6];
+        createTextureBindGroup(app, mesh);
 
-        mesh.mMaterialBindGroup = wgpuDeviceCreateBindGroup(app->getRendererResource().device, &mat_desc);
+        if (mesh.mMaterialIndex == MaterialTable::NO_MATERIAL) {
+            mesh.mMaterialIndex = app->mMaterials.allocateMaterial();
+        }
+        if (!mesh.mDrawSlot.isValid()) {
+            mesh.mDrawSlot = app->mMaterials.allocateDraw();
+            app->mMaterials.getBinding(mesh);
+        }
+        writeMaterial(app, mesh);
     }
 }
 
@@ -739,10 +864,7 @@ void updateSocketTransformation(Model* self, BoneSocket* const socket,
             updateSocketTransformation(socket->model, socket->model->mSocket, calculatedTransform);
         }
     }
-    auto [t, s, r] = decomposeTransformation(socket->update());
-    self->moveTo(t);
-    self->scale(s);
-    self->rotate(normalize(r));
+    self->updateSocketTransformation();
     calculatedTransform[self] = true;
 }
 
@@ -752,20 +874,36 @@ void Model::updateSocketTransformation(std::unordered_map<Model*, bool>& calcula
     }
 }
 
+void Model::updateSocketTransformation() {
+    if (mSocket == nullptr) {
+        return;
+    }
+    // the anchor did not move and nothing else moved this model since, the transform is up to date
+    glm::mat4 socket_transform = mSocket->update();
+    if (socket_transform == mLastSocketTransform && mTransformVersion == mSocketVersion) {
+        return;
+    }
+    // BoneSocket::update decomposed it already
+    moveTo(mSocket->globalPosition);
+    scale(mSocket->globalScale);
+    rotate(normalize(mSocket->globalRotation));
+    mLastSocketTransform = socket_transform;
+    mSocketVersion = mTransformVersion;
+}
+
 void Model::update(Application* app, float dt, float physicSimulating) {
+    updateState(app, dt, physicSimulating);
+    writeBuffers(app);
+}
+
+void Model::updateState(Application* app, float dt, float physicSimulating) {
     (void)app;
 
     updateAnimation(dt);
 
-    if (mScene != nullptr && mScene->HasAnimations() && anim->getActiveAction() &&
-        anim->getActiveAction()->hasSkining) {
-        mSkiningTransformationBuffer.queueWrite(0, anim->mFinalTransformations.data(),
-                                                anim->mFinalTransformations.size() * sizeof(glm::mat4));
-    }
-
     // Apply position/Rotation changes to the meshes
     if (mPhysicComponent != nullptr && physicSimulating) {
-        auto [new_pos, rotation] = physics::getPositionAndRotationyId(mPhysicComponent->bodyId);
+        auto [new_pos, rotation] = physics::getInterpolatedPositionAndRotation(mPhysicComponent->bodyId);
         glm::vec3 com_pos = new_pos - rotation * mPhysicComponent->localOffset;
         moveTo(com_pos);
         glm::quat flipX = glm::angleAxis(glm::pi<float>(), glm::vec3(1, 0, 0));
@@ -773,18 +911,148 @@ void Model::update(Application* app, float dt, float physicSimulating) {
         rotation = flipY * flipX * rotation * glm::inverse(flipX * flipY);
         rotate(glm::normalize(rotation));
     }
+}
+
+void Model::writeBuffers(Application* app) {
+    if (mBonesDirty && mBoneSlot.isValid() && mScene != nullptr && mScene->HasAnimations() &&
+        anim->getActiveAction() && anim->getActiveAction()->hasSkining) {
+        size_t bone_count = std::min<size_t>(anim->mFinalTransformations.size(), 100);
+        app->mBoneSlots.write(mBoneSlot, anim->mFinalTransformations.data(), bone_count * sizeof(glm::mat4));
+        mBonesDirty = false;
+    }
+    if (mMeshTransformsDirty) {
+        auto& databuffer = mGlobalMeshTransformationData;
+        mGlobalMeshTransformationBuffer.queueWrite(0, databuffer.data(), sizeof(glm::mat4) * databuffer.size());
+        mMeshTransformsDirty = false;
+    }
 
     // If object is diry, then update its buffer
     if (mTransform.mDirty) {
-        Drawable::getUniformBuffer().queueWrite(0, &mTransform.mObjectInfo, sizeof(ObjectInfo));
+        Drawable::writeObjectInfo(&mTransform.mObjectInfo, sizeof(ObjectInfo));
         for (auto& [id, mesh] : mFlattenMeshes) {
-            // TODO, can we write all of these in one batch?
-            mesh.mMaterialBuffer.queueWrite(0, &mesh.mMaterial, sizeof(ShaderMaterial));
+            app->mMaterials.writeMaterial(mesh.mMaterialIndex, mesh.mMaterial);
         }
         mTransform.mDirty = false;
     }
 }
 
+// the physics job system is created for cMaxPhysicsJobs jobs, bigger scenes are updated serially
+constexpr const size_t MAX_UPDATE_JOBS = 1024;
+
+static void updateModelState(Application* app, Model* model, float dt, bool physicSimulating) {
+    // First update model transformation based on their socket property. if they are socket to other models
+    model->updateSocketTransformation();
+    // Update physics and other systems like animations
+    model->updateState(app, dt, physicSimulating);
+}
+
+void updateModels(Application* app, const std::vector<Model*>& models, float dt, bool physicSimulating) {
+    ZoneScopedN("Update models");
+    auto write_buffers = [&]() {
+        // parents and sockets are applied here, after every model has its local transform of the frame
+        app->mModelHierarchy.update(models);
+        for (auto* model : models) {
+            model->writeBuffers(app);
+        }
+    };
+    auto update_serially = [&]() {
+        std::unordered_map<Model*, bool> calculated_transformation;
+        for (auto* model : models) {
+            model->updateSocketTransformation(calculated_transformation);
+            model->updateState(app, dt, physicSimulating);
+        }
+        write_buffers();
+    };
+
+    auto* job_system = physics::getJobSystem();
+    if (job_system == nullptr || models.size() > MAX_UPDATE_JOBS) {
+        update_serially();
+        return;
+    }
+
+    // a socketed model reads the transform and pose of the model it is socketed to
+    std::unordered_map<const BaseModel*, size_t> indices;
+    for (size_t i = 0; i < models.size(); ++i) {
+        indices[models[i]] = i;
+    }
+    std::vector<std::vector<size_t>> dependents(models.size());
+    std::vector<uint32_t> dependency_counts(models.size(), 0);
+    auto add_dependency = [&](size_t model, const BaseModel* dependency) {
+        auto it = indices.find(dependency);
+        if (dependency != nullptr && it != indices.end() && it->second != model) {
+            dependents[it->second].push_back(model);
+            dependency_counts[model]++;
+        }
+    };
+    for (size_t i = 0; i < models.size(); ++i) {
+        if (models[i]->mSocket != nullptr) {
+            add_dependency(i, models[i]->mSocket->model);
+        }
+    }
+
+    // topological order, a cycle would leave jobs waiting forever
+    std::vector<size_t> order;
+    order.reserve(models.size());
+    std::vector<uint32_t> remaining = dependency_counts;
+    for (size_t i = 0; i < models.size(); ++i) {
+        if (remaining[i] == 0) {
+            order.push_back(i);
+        }
+    }
+    for (size_t head = 0; head < order.size(); ++head) {
+        for (size_t dependent : dependents[order[head]]) {
+            if (--remaining[dependent] == 0) {
+                order.push_back(dependent);
+            }
+        }
+    }
+    // the socket edges of the last reported cycle, so a cycle is logged once and not every frame it stays
+    static std::vector<std::pair<const BaseModel*, const BaseModel*>> reported_sockets;
+    if (order.size() != models.size()) {
+        std::vector<std::pair<const BaseModel*, const BaseModel*>> sockets;
+        for (auto* model : models) {
+            if (model->mSocket != nullptr) {
+                sockets.emplace_back(model, model->mSocket->model);
+            }
+        }
+        if (sockets != reported_sockets) {
+            std::cout << "Model update: socket cycle between models, updating serially\n";
+            reported_sockets = std::move(sockets);
+        }
+        update_serially();
+        return;
+    }
+    reported_sockets.clear();
+
+    // dependents are created first so a job can release them as soon as it finishes
+    std::vector<JPH::JobHandle> handles(models.size());
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        size_t index = *it;
+        Model* model = models[index];
+        std::vector<JPH::JobHandle> next;
+        next.reserve(dependents[index].size());
+        for (size_t dependent : dependents[index]) {
+            next.push_back(handles[dependent]);
+        }
+        handles[index] = job_system->CreateJob(
+            model->getName().c_str(), JPH::Color::sGreen,
+            [app, model, dt, physicSimulating, next = std::move(next)]() mutable {
+                updateModelState(app, model, dt, physicSimulating);
+                for (auto& handle : next) {
+                    handle.RemoveDependency();
+                }
+            },
+            dependency_counts[index]);
+    }
+
+    auto* barrier = job_system->CreateBarrier();
+    barrier->AddJobs(handles.data(), handles.size());
+    job_system->WaitForJobs(barrier);
+    job_system->DestroyBarrier(barrier);
+
+    write_buffers();
+}
+
 void Model::internalDraw(Application* app, WGPURenderPassEncoder encoder, Node* node) {
     if (!getVisible()) {
         return;
@@ -797,21 +1065,43 @@ void Model::internalDraw(Application* app, WGPURenderPassEncoder encoder, Node*
             continue;
         }
 
-        wgpuRenderPassEncoderSetVertexBuffer(encoder, 0, mesh.mVertexBuffer.getBuffer(), 0,
-                                             wgpuBufferGetSize(mesh.mVertexBuffer.getBuffer()));
-        wgpuRenderPassEncoderSetIndexBuffer(encoder, mesh.mIndexBuffer.getBuffer(), WGPUIndexFormat_Uint32, 0,
-                                            wgpuBufferGetSize(mesh.mIndexBuffer.getBuffer()));
+        if (mHasPackedMeshes) {
+            wgpuRenderPassEncoderSetPipeline(encoder, getMeshPipeline(app, mesh));
+        }
+        mesh.bindGeometry(encoder, app->mGeometryArena);
 
         getCustomBindGroup(app, encoder, mesh);
         if (this->instance != nullptr) {
-            // wgpuRenderPassEncoderDrawIndexedIndirect(encoder, mIndirectDrawArgsBuffer.getBuffer(), 0);
-            wgpuRenderPassEncoderDrawIndexed(encoder, mesh.mIndexData.size(), instance->getInstanceCount(), 0, 0, 0);
+            drawInstances(app, encoder, mid, mesh);
         } else {
-            wgpuRenderPassEncoderDrawIndexed(encoder, mesh.mIndexData.size(), 1, 0, 0, 0);
+            mesh.drawIndexed(encoder);
         }
     }
 }
 
+bool Model::hasCulledInstances() const {
+    return instance != nullptr && mIndirectDrawArgsBuffer.getBuffer() != nullptr && !mFlattenMeshes.empty() &&
+           instance->getInstanceCount() != 0;
+}
+
+void Model::drawInstances(Application* app, WGPURenderPassEncoder encoder, int meshId, Mesh& mesh,
+                          bool culledInstances) {
+    if (!culledInstances) {
+        mesh.drawIndexed(encoder, instance->getInstanceCount());
+        return;
+    }
+    if (hasCulledInstances() && mMeshDrawArgsBuffer.getBuffer() != nullptr && meshId >= 0 &&
+        static_cast<size_t>(meshId) < mMeshDrawArgs.size()) {
+        wgpuRenderPassEncoderDrawIndexedIndirect(encoder, mMeshDrawArgsBuffer.getBuffer(),
+                                                 IndirectDrawArgs::getOffset(meshId));
+        return;
+    }
+    // not culled this frame, the visible indices of this model are stale
+    wgpuRenderPassEncoderSetBindGroup(encoder, 5, app->mAllInstancesBindGroup, 0, nullptr);
+    mesh.drawIndexed(encoder, instance->getInstanceCount());
+    wgpuRenderPassEncoderSetBindGroup(encoder, 5, app->mDefaultVisibleBuffer.getBindGroup(), 0, nullptr);
+}
+
 void Model::drawGraph(Application* app, WGPURenderPassEncoder encoder, Node* node) {
     if (node == nullptr) {
         return;
@@ -827,13 +1117,26 @@ void Model::drawGraph(Application* app, WGPURenderPassEncoder encoder, Node* nod
     }
 }
 
-void Model::drawHirarchy(Application* app, WGPURenderPassEncoder encoder) { drawGraph(app, encoder, mRootNode); }
+void Model::drawHirarchy(Application* app, WGPURenderPassEncoder encoder) {
+    drawGraph(app, encoder, mRootNode);
+    if (mHasPackedMeshes) {
+        // the next model expects the full layout pipeline to be bound
+        wgpuRenderPassEncoderSetPipeline(encoder, getPipeline(app)->getPipeline());
+    }
+}
+
+void Model::draw(Application* app, WGPURenderPassEncoder encoder) { draw(app, encoder, nullptr); }
 
-void Model::draw(Application* app, WGPURenderPassEncoder encoder) {
+// `pipeline` is the one bound by the caller, packed meshes switch to its variants and it is restored afterwards.
+// Without one the model's default pipeline is assumed
+void Model::draw(Application* app, WGPURenderPassEncoder encoder, Pipeline* pipeline, bool culledInstances) {
     WGPUBindGroup active_bind_group = nullptr;
     if (!getVisible()) {
         return;
     }
+    if (pipeline == nullptr) {
+        pipeline = getPipeline(app);
+    }
 
     for (auto& [mat_id, mesh] : mFlattenMeshes) {
         if (!mesh.getVisible()) {
@@ -841,26 +1144,25 @@ void Model::draw(Application* app, WGPURenderPassEncoder encoder) {
         }
         active_bind_group = app->getBindingGroup().getBindGroup();
 
-        wgpuRenderPassEncoderSetVertexBuffer(encoder, 0, mesh.mVertexBuffer.getBuffer(), 0,
-                                             wgpuBufferGetSize(mesh.mVertexBuffer.getBuffer()));
-        wgpuRenderPassEncoderSetIndexBuffer(encoder, mesh.mIndexBuffer.getBuffer(), WGPUIndexFormat_Uint32, 0,
-                                            wgpuBufferGetSize(mesh.mIndexBuffer.getBuffer()));
+        if (mHasPackedMeshes) {
+            wgpuRenderPassEncoderSetPipeline(encoder, pipeline->getPipeline(mesh.mVertexLayout));
+        }
+        mesh.bindGeometry(encoder, app->mGeometryArena);
         wgpuRenderPassEncoderSetBindGroup(encoder, 0, active_bind_group, 0, nullptr);
 
         wgpuRenderPassEncoderSetBindGroup(encoder, 1, mObjectInfoBindGroup, 0, nullptr);
-        wgpuRenderPassEncoderSetBindGroup(encoder, 2,
-                                          mesh.mTextureBindGroup == nullptr
-                                              ? app->mDefaultTextureBindingGroup.getBindGroup()
-                                              : mesh.mTextureBindGroup,
-                                          0, nullptr);
+        wgpuRenderPassEncoderSetBindGroup(encoder, 2, getTextureBindGroup(app, mesh), 0, nullptr);
 
-        wgpuRenderPassEncoderSetBindGroup(encoder, 6, mesh.mMaterialBindGroup, 0, nullptr);
+        app->mMaterials.getBinding(mesh).set(encoder, 6);
         if (this->instance != nullptr) {
-            wgpuRenderPassEncoderDrawIndexedIndirect(encoder, mIndirectDrawArgsBuffer.getBuffer(), 0);
+            drawInstances(app, encoder, mat_id, mesh, culledInstances);
         } else {
-            wgpuRenderPassEncoderDrawIndexed(encoder, mesh.mIndexData.size(), 1, 0, 0, 0);
+            mesh.drawIndexed(encoder);
         }
     }
+    if (mHasPackedMeshes) {
+        wgpuRenderPassEncoderSetPipeline(encoder, pipeline->getPipeline());
+    }
 }
 
 #ifdef DEVELOPMENT_BUILD
@@ -940,7 +1242,6 @@ void Model::userInterface() {
         if (happend) {
             moveTo(mTransform.mPosition);
             scale(mTransform.mScale);
-            getGlobalTransform();
         }
     }
 
@@ -988,8 +1289,9 @@ void Model::userInterface() {
         std::vector<glm::vec4> linesGreen;
 
         // std::cout << "::::::::::" << std::endl;
-        for (const auto& [k, i] : anim->calculatedTransform) {
-            auto trans = mTransform.mTransformMatrix * i;
+        for (size_t joint = 0; joint < anim->skeleton.size(); ++joint) {
+            const auto& k = anim->skeleton.names[joint];
+            auto trans = mTransform.mTransformMatrix * anim->mGlobalTransforms[joint];
             auto vec = trans * glm::vec4{0.0, 0.0, 0.0, 1.0};
             auto vec2 = trans * glm::vec4{0.0, 0.0, k == selectedBone ? 0.3 : 0.2, 1.0};
             vec.w = 0;
@@ -1013,6 +1315,10 @@ void Model::userInterface() {
     if (ImGui::CollapsingHeader("Animations")) {
         if (anim != nullptr && anim->getActiveAction() != nullptr) {
             ImGui::Checkbox("Run Blend test", &runBlenTest);
+            if (ImGui::Button("Check sampler")) {
+                std::cout << std::format("Animation sampler max error against the reference for {}: {}\n", getName(),
+                                         anim->compareWithReference(mScene->mRootNode));
+            }
             for (auto& [name, bone] : anim->getActiveAction()->Bonemap) {
                 ImGui::PushID(bone);  // or &mesh
                                       //
@@ -1064,7 +1370,7 @@ void Model::userInterface() {
                 update_wind = true;
             }
             if (update_wind) {
-                mesh.mWindBuffer.queueWrite(0, &mesh.mWindParams, sizeof(WindParams));
+                writeMaterial(mApp, mesh);
             }
 
             auto diff_tex = DrawTexturePicker("Diffuse Texture", mesh.mTexture, mApp->mTextureRegistery);
@@ -1291,6 +1597,11 @@ void Model::userInterface() {
                     mesh.mMaterial.setFlag(MaterialProps::HasDiffuseMap, has_diffuse);
                     mTransform.mDirty = true;
                 }
+                bool is_foliage = mesh.mMaterial.hasFlag(MaterialProps::IsFoliage);
+                if (ImGui::Checkbox("Foliage", &is_foliage)) {
+                    mesh.mMaterial.setFlag(MaterialProps::IsFoliage, is_foliage);
+                    mTransform.mDirty = true;
+                }
                 if (ImGui::SliderFloat("Diffuse Value", &mesh.mMaterial.roughness, 0.0f, 1.0f)) {
                     mTransform.mDirty = true;
                 }
@@ -1438,7 +1749,7 @@ BaseModel& BaseModel::scale(const glm::vec3& s) {
     mTransform.mScale = s;
     mTransform.mDirty = true;
     mTransform.mScaleMatrix = glm::scale(glm::mat4{1.0}, s);
-    getGlobalTransform();
+    transformChanged();
     return *this;
 }
 
@@ -1449,16 +1760,21 @@ BaseModel& BaseModel::rotate(const glm::vec3& around, float degree) {
     glm::vec3 euler_radians = glm::radians(mTransform.mEulerRotation);
     mTransform.mRotationMatrix = glm::toMat4(glm::quat(euler_radians));
     mTransform.mOrientation = glm::normalize(glm::quat(euler_radians));
-    getGlobalTransform();
+    transformChanged();
     return *this;
 }
 BaseModel& BaseModel::rotate(const glm::quat& rot) {
     mTransform.mOrientation = glm::normalize(rot);
     mTransform.mRotationMatrix = glm::toMat4(mTransform.mOrientation);
-    getGlobalTransform();
+    transformChanged();
     return *this;
 }
 
+void BaseModel::transformChanged() {
+    mTransform.getLocalTransform();
+    mTransformVersion++;
+}
+
 void BaseModel::getCustomBindGroup(Application* app, WGPURenderPassEncoder encoder, Mesh& mesh) {
     (void)app;
     (void)encoder;
@@ -1469,22 +1785,42 @@ Pipeline* BaseModel::getPipeline(Application* app) {
     return nullptr;
 }
 
-void Model::getCustomBindGroup(Application* app, WGPURenderPassEncoder encoder, Mesh& mesh
-
-) {
+void Model::getCustomBindGroup(Application* app, WGPURenderPassEncoder encoder, Mesh& mesh) {
     wgpuRenderPassEncoderSetBindGroup(encoder, 0, app->getBindingGroup().getBindGroup(), 0, nullptr);
-
     wgpuRenderPassEncoderSetBindGroup(encoder, 1, getObjectInfoBindGroup(), 0, nullptr);
-    wgpuRenderPassEncoderSetBindGroup(
-        encoder, 2,
-        mesh.mTextureBindGroup == nullptr ? app->mDefaultTextureBindingGroup.getBindGroup() : mesh.mTextureBindGroup, 0,
-        nullptr);
-
-    wgpuRenderPassEncoderSetBindGroup(encoder, 6, mesh.mMaterialBindGroup, 0, nullptr);
+    wgpuRenderPassEncoderSetBindGroup(encoder, 2, getTextureBindGroup(app, mesh), 0, nullptr);
+    getMaterialBinding(app, mesh).set(encoder, 6);
 }
 
 Pipeline* Model::getPipeline(Application* app) { return app->getPipeline(); }
 
+WGPURenderPipeline Model::getMeshPipeline(Application* app, Mesh& mesh) {
+    return mHasPackedMeshes ? getPipeline(app)->getPipeline(mesh.mVertexLayout) : getPipeline(app)->getPipeline();
+}
+
+WGPUBindGroup Model::getTextureBindGroup(Application* app, Mesh& mesh) {
+    if (mesh.mTextureBindGroup == nullptr) {
+        return app->mDefaultTextureBindingGroup.getBindGroup();
+    }
+    if (mesh.mTextureBindVersion != textureViewVersion(mesh)) {
+        createTextureBindGroup(app, mesh);
+    }
+    return mesh.mTextureBindGroup;
+}
+
+const MaterialTable::Binding& Model::getMaterialBinding(Application* app, Mesh& mesh) {
+    return app->mMaterials.getBinding(mesh);
+}
+
+void Model::writeMaterial(Application* app, Mesh& mesh) {
+    app->mMaterials.writeMaterial(mesh.mMaterialIndex, mesh.mMaterial);
+    DrawData draw = {};
+    draw.materialIndex = mesh.mMaterialIndex;
+    draw.meshIdx = static_cast<int32_t>(mesh.meshId);
+    draw.windParams = mesh.mWindParams;
+    app->mMaterials.writeDraw(mesh.mDrawSlot, draw);
+}
+
 glm::vec3& Transform::getPosition() { return mPosition; }
 glm::vec3& Transform::getScale() { return mScale; }
 glm::vec3& Transform::getEulerRotation() { return mEulerRotation; }
@@ -1496,14 +1832,6 @@ glm::mat4& Transform::getLocalTransform() {
     return mTransformMatrix;
 }
 
-glm::mat4 Transform::getGlobalTransform(BaseModel* parent) {
-    if (parent == nullptr) {
-        return getLocalTransform();
-    } else {
-        return parent->getGlobalTransform() * getLocalTransform();
-    }
-}
-
 float AABB::calculateVolume() {
     float dx = std::abs(min.x - max.x);
     float dy = std::abs(min.y - max.y);
@@ -1536,8 +1864,9 @@ std::pair<glm::vec3, glm::vec3> BaseModel::getWorldSpaceAABB() {
     glm::vec3 world_max(std::numeric_limits<float>::lowest());  // Equivalent to -FLT_MAX
 
     // 3. Transform each corner and update worldMin/worldMax
+    const glm::mat4& world = getGlobalTransform();
     for (int i = 0; i < 8; ++i) {
-        glm::vec4 transformedCorner = getGlobalTransform() * glm::vec4(corners[i], 1.0f);
+        glm::vec4 transformedCorner = world * glm::vec4(corners[i], 1.0f);
 
         world_min.x = glm::min(world_min.x, transformedCorner.x);
         world_min.y = glm::min(world_min.y, transformedCorner.y);
@@ -1595,21 +1924,6 @@ const std::string& BaseModel::getName() { return mName; }
 
 Texture* BaseModel::getDiffuseTexture() { return mFlattenMeshes[0].mTexture.get(); }
 
-glm::mat4 BaseModel::getGlobalTransform() {
-    auto* root = mParent;
-    while (root != nullptr) {
-        root = mParent->mParent;
-    }
-
-    return mTransform.getGlobalTransform(root);
-}
-
-void BaseModel::updateHirarchy() {
-    mTransform.mDirty = true;
-    for (auto* child : mChildrens) {
-        child->updateHirarchy();
-        child->mTransform.mObjectInfo.transformation = getGlobalTransform() * child->mTransform.mTransformMatrix;
-    }
-}
+const glm::mat4& BaseModel::getGlobalTransform() const { return mTransform.mObjectInfo.transformation; }
 
 WGPUBindGroup Model::getObjectInfoBindGroup() { return mObjectInfoBindGroup; }
@@ -0,0 +1,78 @@
+#include "model_hierarchy.h"
+
+#include <unordered_map>
+
+#include "animation.h"
+#include "model.h"
+#include "profiling.h"
+
+const BaseModel* ModelHierarchy::getFrameParent(const BaseModel* model) {
+    for (uint32_t hops = 0; model->mSocket != nullptr && hops < MAX_SOCKET_CHAIN; ++hops) {
+        model = model->mSocket->model;
+    }
+    return model->mParent;
+}
+
+void ModelHierarchy::update(const std::vector<Model*>& models) {
+    ZoneScopedN("Model hierarchy");
+    bool changed = models != mModels;
+    mFrameParents.resize(models.size(), nullptr);
+    for (size_t i = 0; i < models.size(); ++i) {
+        const BaseModel* parent = getFrameParent(models[i]);
+        changed |= parent != mFrameParents[i];
+        mFrameParents[i] = parent;
+    }
+    if (changed) {
+        mModels = models;
+        rebuild(models);
+    }
+
+    for (size_t node = 0; node < mNodes.size(); ++node) {
+        Model* model = mNodes[node];
+        if (model->mTransformVersion != mVersions[node]) {
+            mVersions[node] = model->mTransformVersion;
+            mTransforms.setLocal(static_cast<int32_t>(node), model->mTransform.mTransformMatrix);
+        }
+    }
+    mTransforms.update();
+
+    // Transform::getLocalTransform() puts the local into the object info, so every node gets its world back. The
+    // object info is flagged every frame, selection and instancing change it without flagging
+    for (size_t node = 0; node < mNodes.size(); ++node) {
+        auto& transform = mNodes[node]->mTransform;
+        transform.mObjectInfo.transformation = mTransforms.getWorld(static_cast<int32_t>(node));
+        transform.mDirty = true;
+    }
+}
+
+void ModelHierarchy::rebuild(const std::vector<Model*>& models) {
+    mTransforms.clear();
+    mNodes.clear();
+    mVersions.clear();
+    std::unordered_map<const BaseModel*, size_t> indices;
+    for (size_t i = 0; i < models.size(); ++i) {
+        indices[models[i]] = i;
+    }
+
+    // parents first. A model whose frame parent is not updated along with it, or which is part of a cycle, is a root
+    std::vector<int32_t> nodes(models.size(), -1);
+    std::vector<uint8_t> visited(models.size(), 0);
+    auto add = [&](auto& self, size_t i) -> int32_t {
+        if (visited[i]) {
+            return nodes[i];
+        }
+        visited[i] = 1;
+        int32_t parent = -1;
+        auto it = indices.find(mFrameParents[i]);
+        if (it != indices.end()) {
+            parent = self(self, it->second);
+        }
+        nodes[i] = mTransforms.add(parent, models[i]->mTransform.mTransformMatrix);
+        mNodes.push_back(models[i]);
+        mVersions.push_back(models[i]->mTransformVersion);
+        return nodes[i];
+    };
+    for (size_t i = 0; i < models.size(); ++i) {
+        add(add, i);
+    }
+}
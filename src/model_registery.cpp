@@ -1,8 +1,7 @@
 #include "model_registery.h"
 
 #include <algorithm>
-#include <chrono>
-#include <future>
+#include <memory>
 
 #include "application.h"
 #include "camera.h"
@@ -25,12 +24,39 @@ void PawnBehaviour::handleKey(BaseModel* model, KeyEvent event, float dt) {}
 glm::vec3 InputHandler::getForward() { return glm::vec3{0.0}; }
 BaseModel* InputHandler::getWeapon() { return nullptr; }
 
+ModelRegistry::ModelRegistry() : mLoaderPool(LoaderPool::defaultThreadCount()) {}
+
 ModelRegistry& ModelRegistry::instance() {
     static ModelRegistry inst;
     return inst;
 }
 
-void ModelRegistry::registerModel(const std::string& name, FactoryFunc func) { factories[name] = func; }
+void ModelRegistry::registerModel(const std::string& name, FactoryFunc func, int priority) {
+    factories[name] = func;
+    mPriorities[name] = priority;
+}
+
+bool ModelRegistry::cancelLoad(const std::string& name) {
+    if (factories.erase(name) > 0) {
+        mPriorities.erase(name);
+        return true;
+    }
+    auto it = mLoading.find(name);
+    if (it == mLoading.end() || !mLoaderPool.cancel(it->second)) {
+        return false;
+    }
+    mLoading.erase(it);
+    return true;
+}
+
+bool ModelRegistry::unloadModel(Model* model) {
+    bool loaded = std::erase(mUserLoadedModel, model) > 0;
+    loaded |= std::erase(mEditorLoadedModel, model) > 0;
+    if (loaded) {
+        model->unloadFromGPU();
+    }
+    return loaded;
+}
 
 void ModelRegistry::registerInputHandler(const std::string& name, InputHandler* inputHandler) {
     inputHandlerMap[name] = inputHandler;
@@ -64,51 +90,70 @@ std::optional<Model*> ModelRegistry::query(std::string modelName, std::function<
 }
 
 void ModelRegistry::tick(Application* app) {
-    if (factories.size() > 0) {
-        auto it = factories.begin();
-        futures.push_back(std::async(std::launch::async, it->second, app));
-        factories.erase(it);
+    for (auto& [name, factory] : factories) {
+        int priority = mPriorities.contains(name) ? mPriorities[name] : LoadPriority_Background;
+        auto result = std::make_shared<LoadModelResult>(LoadModelResult{nullptr, Visibility_Other});
+        mLoading[name] = mLoaderPool.submit(
+            priority, [app, factory, result] { *result = factory(app); },
+            [this, name, result](LoaderPool::Status status) {
+                // cancelLoad already forgot about the model
+                if (status == LoaderPool::Status::Cancelled) {
+                    return;
+                }
+                // a factory that threw leaves the model null
+                std::lock_guard<std::mutex> lock(mLoadedMutex);
+                mLoaded.emplace_back(name, *result);
+            });
     }
+    factories.clear();
+    mPriorities.clear();
 
-    for (auto it = futures.begin(); it != futures.end();) {
-        if (it->wait_for(std::chrono::nanoseconds(0)) == std::future_status::ready) {
-            LoadModelResult model = it->get();
-            std::cout << "Model loaded with visibility " << model.visibility << " " << std::endl;
-            if (model.visibility == Visibility_User) {
-                mUserLoadedModel.push_back(model.model);
-            } else if (model.visibility == Visibility_Editor) {
-                mEditorLoadedModel.push_back(model.model);
-            } else if (model.visibility == Visibility_Other) {
-                // Do not add this model to any container
-            }
-            if (model.visibility != Visibility_Editor) {
-                app->mWorld->onNewModel(model.model);
-            }
-            std::cout << "Searching for Behaviour for: " << model.model->mName << '\n';
-            if (inputHandlerMap.contains(model.model->mName)) {
-                std::cout << "Behaviour for this  exists " << model.model->mName << '\n';
-                model.model->mInputHandler = inputHandlerMap[model.model->mName];
-                model.model->mInputHandler->app = app;
-                // model.model->mInputHandler->onModelLoad(model.model);
-            }
-            if (pawnBehaviourMap.contains(model.model->mName)) {
-                std::cout << "Behaviour for this  exists " << model.model->mName << '\n';
-                model.model->mBehaviour = pawnBehaviourMap[model.model->mName];
-                model.model->mBehaviour->app = app;
-                model.model->mBehaviour->onLoad(model.model);
-                model.model->mBehaviour->model = model.model;
-            }
-
-            if (mQueryWaitersList.contains(model.model->mName)) {
-                for (auto& waiters : mQueryWaitersList[model.model->mName]) {
-                    std::cout << "-------------" << model.model->mName << "model got loaded!\n";
-                    waiters.onSuccess(model.model, waiters.cbArgs);
-                }
-            }
+    std::vector<std::pair<std::string, LoadModelResult>> loaded;
+    {
+        std::lock_guard<std::mutex> lock(mLoadedMutex);
+        loaded.swap(mLoaded);
+    }
+    for (auto& [name, model] : loaded) {
+        mLoading.erase(name);
+        if (model.model == nullptr) {
+            std::cout << "Failed to load model " << name << std::endl;
+            continue;
+        }
+        onModelLoaded(app, model);
+    }
+}
+
+void ModelRegistry::onModelLoaded(Application* app, const LoadModelResult& model) {
+    std::cout << "Model loaded with visibility " << model.visibility << " " << std::endl;
+    if (model.visibility == Visibility_User) {
+        mUserLoadedModel.push_back(model.model);
+    } else if (model.visibility == Visibility_Editor) {
+        mEditorLoadedModel.push_back(model.model);
+    } else if (model.visibility == Visibility_Other) {
+        // Do not add this model to any container
+    }
+    if (model.visibility != Visibility_Editor) {
+        app->mWorld->onNewModel(model.model);
+    }
+    std::cout << "Searching for Behaviour for: " << model.model->mName << '\n';
+    if (inputHandlerMap.contains(model.model->mName)) {
+        std::cout << "Behaviour for this  exists " << model.model->mName << '\n';
+        model.model->mInputHandler = inputHandlerMap[model.model->mName];
+        model.model->mInputHandler->app = app;
+        // model.model->mInputHandler->onModelLoad(model.model);
+    }
+    if (pawnBehaviourMap.contains(model.model->mName)) {
+        std::cout << "Behaviour for this  exists " << model.model->mName << '\n';
+        model.model->mBehaviour = pawnBehaviourMap[model.model->mName];
+        model.model->mBehaviour->app = app;
+        model.model->mBehaviour->onLoad(model.model);
+        model.model->mBehaviour->model = model.model;
+    }
 
-            it = futures.erase(it);
-        } else {
-            it++;
+    if (mQueryWaitersList.contains(model.model->mName)) {
+        for (auto& waiters : mQueryWaitersList[model.model->mName]) {
+            std::cout << "-------------" << model.model->mName << "model got loaded!\n";
+            waiters.onSuccess(model.model, waiters.cbArgs);
         }
     }
 }
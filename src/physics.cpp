@@ -160,6 +160,25 @@ static JobSystemThreadPool* job_system;
 static PhysicsSystem physicsSystem;
 static BodyID boxBodyID;
 
+// render side pose of a body, indexed by BodyID::GetIndex()
+struct BodyPose {
+        BodyID id;
+        glm::vec3 position;
+        glm::quat rotation;
+};
+static FixedTimestep fixed_timestep{60.0f, 4};
+static std::vector<BodyPose> previous_poses;
+static std::vector<BodyPose> current_poses;
+static BodyIDVector body_ids;
+
+// the body was placed by hand, interpolating would pull it back towards the old poses
+static void forgetPose(BodyID id) {
+    size_t index = id.GetIndex();
+    if (index < current_poses.size()) {
+        current_poses[index].id = BodyID{};
+    }
+}
+
 JPH::Vec3 toJolt(const glm::vec3 vec) { return {vec.x, vec.z, vec.y}; }
 
 JPH::Quat toJolt(const glm::quat& rot) {
@@ -227,6 +246,7 @@ HitResult ShootRay2(glm::vec3 origin, glm::vec3 direction, float maxDistance) {
 }
 
 PhysicsSystem* getPhysicsSystem() { return &physicsSystem; }
+JobSystem* getJobSystem() { return job_system; }
 JPH::CapsuleShape* createCapsuleShape(float halfHeight, float radius) { return new CapsuleShape(halfHeight, radius); }
 
 CharacterVirtual* createCharacter(Ref<Shape> shape, const glm::vec3& initialPosition, uint64 userData) {
@@ -313,6 +333,7 @@ glm::vec3 syncPhysicsFromRender(Transform& render, PhysicsComponent* physic) {
     BodyInterface& bi = physicsSystem.GetBodyInterface();
     bi.SetPositionAndRotation(physic->bodyId, RVec3(com_pos.x, com_pos.z, com_pos.y), toJolt(render.mOrientation),
                               EActivation::Activate);
+    forgetPose(physic->bodyId);
     return com_pos;
 }
 
@@ -322,6 +343,7 @@ glm::vec3 syncPhysicsFromRender(const glm::vec3& position, const glm::quat& orie
     BodyInterface& bi = physicsSystem.GetBodyInterface();
     bi.SetPositionAndRotation(physic->bodyId, RVec3(com_pos.x, com_pos.z, com_pos.y), toJolt(orientation),
                               EActivation::Activate);
+    forgetPose(physic->bodyId);
     return com_pos;
 }
 
@@ -397,10 +419,7 @@ void prepareJolt() {
 
     getPhysicsSystem()->SetContactListener(new MyContactListener());
 }
-std::pair<glm::vec3, glm::quat> getPositionAndRotationyId(BodyID id) {
-    // TRS getTRSById(BodyID id) {
-    BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
-    RMat44 boxTransform = bodyInterface.GetCenterOfMassTransform(id);
+static std::pair<glm::vec3, glm::quat> toRenderPose(const RMat44& boxTransform) {
     RVec3 position = boxTransform.GetTranslation();
     Quat rotation = boxTransform.GetQuaternion();
     auto y = rotation.GetY();
@@ -416,20 +435,72 @@ std::pair<glm::vec3, glm::quat> getPositionAndRotationyId(BodyID id) {
     return {toGLM(position), glm_rot};
 }
 
+std::pair<glm::vec3, glm::quat> getPositionAndRotationyId(BodyID id) {
+    // TRS getTRSById(BodyID id) {
+    BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+    return toRenderPose(bodyInterface.GetCenterOfMassTransform(id));
+}
+
+std::pair<glm::vec3, glm::quat> getInterpolatedPositionAndRotation(BodyID id) {
+    size_t index = id.GetIndex();
+    if (index < current_poses.size() && index < previous_poses.size() && current_poses[index].id == id &&
+        previous_poses[index].id == id) {
+        const auto& previous = previous_poses[index];
+        const auto& current = current_poses[index];
+        float alpha = fixed_timestep.getAlpha();
+        return {glm::mix(previous.position, current.position, alpha),
+                glm::slerp(previous.rotation, current.rotation, alpha)};
+    }
+    return getPositionAndRotationyId(id);
+}
+
+static void capturePoses(std::vector<BodyPose>& poses) {
+    physicsSystem.GetBodies(body_ids);
+    const BodyInterface& body_interface = physicsSystem.GetBodyInterfaceNoLock();
+    for (const auto& id : body_ids) {
+        size_t index = id.GetIndex();
+        if (index >= poses.size()) {
+            poses.resize(index + 1);
+        }
+        auto [position, rotation] = toRenderPose(body_interface.GetCenterOfMassTransform(id));
+        poses[index] = {id, position, rotation};
+    }
+}
+
 void setRotation(BodyID id, const glm::quat& rot) {
     auto& interface = physics::getBodyInterface();
     auto qu = glm::normalize(rot);
     qu.z *= -1;
     qu = glm::normalize(qu);
     interface.SetRotation(id, {qu.x, qu.z, qu.y, qu.w}, EActivation::Activate);
+    forgetPose(id);
 }
 
 void setPosition(BodyID id, const glm::vec3& pos) {
     auto& interface = physics::getBodyInterface();
     interface.SetPosition(id, toJolt(pos), EActivation::Activate);
+    forgetPose(id);
+}
+
+void JoltLoop(float dt) {
+    int steps = fixed_timestep.advance(dt);
+    for (int step = 0; step < steps; ++step) {
+        // only the state around the last step is needed for interpolation
+        if (step == steps - 1) {
+            capturePoses(previous_poses);
+        }
+        physicsSystem.Update(fixed_timestep.getStep(), 1, temp_allocator, job_system);
+    }
+    if (steps > 0) {
+        capturePoses(current_poses);
+    }
+}
+
+void setFixedTimestep(float stepsPerSecond, int maxSubSteps) {
+    fixed_timestep.setRate(stepsPerSecond).setMaxSubSteps(maxSubSteps);
 }
 
-void JoltLoop(float dt) { physicsSystem.Update(dt, 1, temp_allocator, job_system); }
+FixedTimestep& getFixedTimestep() { return fixed_timestep; }
 
 BoxCollider::BoxCollider(Application* app, const std::string& name, const glm::vec3& center,
                          const glm::vec3& halfExtent, MotionType motionType, bool isSensor, void* userData)
@@ -450,7 +521,7 @@ BoxCollider::BoxCollider(Application* app, const std::string& name, const glm::v
 }
 
 glm::mat4 BoxCollider::getTransformation() const {
-    auto [pos, rot] = getPositionAndRotationyId(mPhysicComponent->bodyId);
+    auto [pos, rot] = getInterpolatedPositionAndRotation(mPhysicComponent->bodyId);
 
     return glm::translate(glm::mat4{1.0}, pos) * glm::toMat4(rot) *
            glm::scale(glm::mat4{1.0}, mHalfExtent * glm::vec3{2.0});
@@ -2,8 +2,8 @@
 
 #include <webgpu/webgpu.h>
 
+#include "pipeline_cache.h"
 #include "rendererResource.h"
-#include "shader.h"
 #include "wgpu_utils.h"
 
 WGPURenderPassDescriptor createRenderPassDescriptor(WGPUTextureView colorAttachment, WGPUTextureView depthTextureView) {
@@ -48,11 +48,31 @@ Pipeline& Pipeline::createPipeline(const RendererResource& resource) {
     pipeline_layout_descriptor.bindGroupLayoutCount = mBindGroupLayouts.size();
     pipeline_layout_descriptor.bindGroupLayouts = mBindGroupLayouts.data();
 
-    mPipelineLayout = wgpuDeviceCreatePipelineLayout(resource.device, &pipeline_layout_descriptor);
+    mPipelineLayout = resource.pipelines->getPipelineLayout(pipeline_layout_descriptor);
 
     mDescriptor.layout = mPipelineLayout;
     mDescriptor.label = createStringView(mPipelineName);
-    mPipeline = wgpuDeviceCreateRenderPipeline(resource.device, &mDescriptor);
+    mPipeline = resource.pipelines->getRenderPipeline(mDescriptor);
+
+    if (mPackedVariants) {
+        mlPackedBufferLayouts[0] = mPackedVertexLayout.configurePackedVertex();
+        mlPackedBufferLayouts[1] = mPackedSkinLayout.configurePackedSkin();
+
+        WGPURenderPipelineDescriptor descriptor = mDescriptor;
+        descriptor.vertex.buffers = mlPackedBufferLayouts.data();
+        descriptor.vertex.bufferCount = 2;
+        descriptor.vertex.entryPoint = createStringViewC("vs_main_packed");
+        mPackedPipeline = resource.pipelines->getRenderPipeline(descriptor);
+
+        descriptor.vertex.bufferCount = 1;
+        descriptor.vertex.entryPoint = createStringViewC("vs_main_packed_static");
+        mPackedStaticPipeline = resource.pipelines->getRenderPipeline(descriptor);
+    }
+    return *this;
+}
+
+Pipeline& Pipeline::enablePackedVertexVariants(bool enable) {
+    mPackedVariants = enable;
     return *this;
 }
 
@@ -76,7 +96,7 @@ Pipeline& Pipeline::defaultConfiguration(const RendererResource& resource, WGPUT
 
     std::cout << "Defalt confiiguraton for " << shaderPath << std::endl;
 
-    mShaderModule = loadShader(shaderPath, resource.device);
+    mShaderModule = resource.pipelines->getShaderModule(shaderPath);
     // 1 - vertex state
     mlVertexBufferLayout = getDefaultVertexBufferLayout();
     mDescriptor.nextInChain = nullptr;
@@ -147,13 +167,24 @@ Pipeline& Pipeline::defaultConfiguration(const RendererResource& resource, WGPUT
 
 WGPURenderPipeline Pipeline::getPipeline() { return mPipeline; }
 
+WGPURenderPipeline Pipeline::getPipeline(VertexLayout layout) {
+    switch (layout) {
+        case VertexLayout::Packed:
+            return mPackedPipeline != nullptr ? mPackedPipeline : mPipeline;
+        case VertexLayout::PackedStatic:
+            return mPackedStaticPipeline != nullptr ? mPackedStaticPipeline : mPipeline;
+        default:
+            return mPipeline;
+    }
+}
+
 WGPUPipelineLayout Pipeline::getPipelineLayout() { return mPipelineLayout; }
 
 WGPURenderPipelineDescriptor Pipeline::getDescriptor() { return mDescriptor; }
 WGPURenderPipelineDescriptor* Pipeline::getDescriptorPtr() { return &mDescriptor; }
 
 Pipeline& Pipeline::setShader(const std::filesystem::path& path, const RendererResource& resource) {
-    mShaderModule = loadShader(path, resource.device);
+    mShaderModule = resource.pipelines->getShaderModule(path);
     mDescriptor.vertex.module = mShaderModule;
     mFragmentState.module = mShaderModule;
     return *this;
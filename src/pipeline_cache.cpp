@@ -0,0 +1,212 @@
+#include "pipeline_cache.h"
+
+#include <cstring>
+
+#include "profiling.h"
+
+namespace {
+
+void addString(CacheKey& key, WGPUStringView value) {
+    if (value.data == nullptr) {
+        key.addString({});
+    } else {
+        key.addString({value.data, value.length == WGPU_STRLEN ? std::strlen(value.data) : value.length});
+    }
+}
+
+void addConstants(CacheKey& key, size_t count, const WGPUConstantEntry* constants) {
+    key.add(count);
+    for (size_t i = 0; i < count; i++) {
+        addString(key, constants[i].key);
+        key.add(constants[i].value);
+    }
+}
+
+void addStencilFace(CacheKey& key, const WGPUStencilFaceState& face) {
+    key.add(face.compare).add(face.failOp).add(face.depthFailOp).add(face.passOp);
+}
+
+void addBlendComponent(CacheKey& key, const WGPUBlendComponent& component) {
+    key.add(component.operation).add(component.srcFactor).add(component.dstFactor);
+}
+
+// false if the descriptor uses extensions the key does not cover
+bool makeKey(CacheKey& key, const WGPURenderPipelineDescriptor& descriptor) {
+    const auto* depth = descriptor.depthStencil;
+    const auto* fragment = descriptor.fragment;
+    if (descriptor.nextInChain != nullptr || descriptor.vertex.nextInChain != nullptr ||
+        descriptor.primitive.nextInChain != nullptr || descriptor.multisample.nextInChain != nullptr ||
+        (depth != nullptr && depth->nextInChain != nullptr) ||
+        (fragment != nullptr && fragment->nextInChain != nullptr)) {
+        return false;
+    }
+
+    const auto& vertex = descriptor.vertex;
+    key.add(descriptor.layout).add(vertex.module);
+    addString(key, vertex.entryPoint);
+    addConstants(key, vertex.constantCount, vertex.constants);
+    key.add(vertex.bufferCount);
+    for (size_t i = 0; i < vertex.bufferCount; i++) {
+        const auto& buffer = vertex.buffers[i];
+        key.add(buffer.stepMode).add(buffer.arrayStride).add(buffer.attributeCount);
+        for (size_t a = 0; a < buffer.attributeCount; a++) {
+            const auto& attribute = buffer.attributes[a];
+            key.add(attribute.format).add(attribute.offset).add(attribute.shaderLocation);
+        }
+    }
+
+    const auto& primitive = descriptor.primitive;
+    key.add(primitive.topology).add(primitive.stripIndexFormat).add(primitive.frontFace).add(primitive.cullMode);
+    key.add(primitive.unclippedDepth);
+
+    key.add(depth != nullptr);
+    if (depth != nullptr) {
+        key.add(depth->format).add(depth->depthWriteEnabled).add(depth->depthCompare);
+        addStencilFace(key, depth->stencilFront);
+        addStencilFace(key, depth->stencilBack);
+        key.add(depth->stencilReadMask).add(depth->stencilWriteMask).add(depth->depthBias);
+        key.add(depth->depthBiasSlopeScale).add(depth->depthBiasClamp);
+    }
+
+    const auto& multisample = descriptor.multisample;
+    key.add(multisample.count).add(multisample.mask).add(multisample.alphaToCoverageEnabled);
+
+    key.add(fragment != nullptr);
+    if (fragment != nullptr) {
+        key.add(fragment->module);
+        addString(key, fragment->entryPoint);
+        addConstants(key, fragment->constantCount, fragment->constants);
+        key.add(fragment->targetCount);
+        for (size_t i = 0; i < fragment->targetCount; i++) {
+            const auto& target = fragment->targets[i];
+            if (target.nextInChain != nullptr) {
+                return false;
+            }
+            key.add(target.format).add(target.writeMask).add(target.blend != nullptr);
+            if (target.blend != nullptr) {
+                addBlendComponent(key, target.blend->color);
+                addBlendComponent(key, target.blend->alpha);
+            }
+        }
+    }
+    return true;
+}
+
+template <typename Handle, typename Create>
+Handle lookup(std::unordered_map<std::string, Handle>& handles, PipelineCache::Stats& stats, const CacheKey& key,
+              Create create) {
+    auto it = handles.find(key.getBytes());
+    if (it != handles.end()) {
+        stats.hits++;
+        return it->second;
+    }
+    stats.misses++;
+    Handle handle = create();
+    handles.emplace(key.getBytes(), handle);
+    return handle;
+}
+
+}  // namespace
+
+PipelineCache::PipelineCache(RendererResource* resource) : mResources(resource) {}
+
+void PipelineCache::setDiskDirectory(const std::filesystem::path& directory) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSources.setDiskDirectory(directory);
+}
+
+WGPUShaderModule PipelineCache::getShaderModule(const std::filesystem::path& path) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    const auto& source = mSources.load(path);
+    return getShaderModuleLocked(source.code, path.filename().string().c_str());
+}
+
+WGPUShaderModule PipelineCache::getShaderModule(const std::string& code, const char* label) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return getShaderModuleLocked(code, label);
+}
+
+WGPUShaderModule PipelineCache::getShaderModuleLocked(const std::string& code, const char* label) {
+    CacheKey key;
+    key.addString(code);
+    return lookup(mModules, mModuleStats, key, [&] {
+        ZoneScopedN("Create shader module");
+        WGPUShaderSourceWGSL source = {};
+        source.chain.sType = WGPUSType_ShaderSourceWGSL;
+        source.code = {code.c_str(), code.size()};
+        WGPUShaderModuleDescriptor descriptor = {};
+        descriptor.nextInChain = &source.chain;
+        descriptor.label = {label, WGPU_STRLEN};
+        return wgpuDeviceCreateShaderModule(mResources->device, &descriptor);
+    });
+}
+
+WGPUPipelineLayout PipelineCache::getPipelineLayout(const WGPUPipelineLayoutDescriptor& descriptor) {
+    if (descriptor.nextInChain != nullptr) {
+        return wgpuDeviceCreatePipelineLayout(mResources->device, &descriptor);
+    }
+    CacheKey key;
+    key.add(descriptor.bindGroupLayoutCount);
+    for (size_t i = 0; i < descriptor.bindGroupLayoutCount; i++) {
+        key.add(descriptor.bindGroupLayouts[i]);
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    return lookup(mLayouts, mLayoutStats, key,
+                  [&] { return wgpuDeviceCreatePipelineLayout(mResources->device, &descriptor); });
+}
+
+WGPURenderPipeline PipelineCache::getRenderPipeline(const WGPURenderPipelineDescriptor& descriptor) {
+    CacheKey key;
+    if (!makeKey(key, descriptor)) {
+        return wgpuDeviceCreateRenderPipeline(mResources->device, &descriptor);
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    return lookup(mRenderPipelines, mPipelineStats, key, [&] {
+        ZoneScopedN("Create render pipeline");
+        return wgpuDeviceCreateRenderPipeline(mResources->device, &descriptor);
+    });
+}
+
+WGPUComputePipeline PipelineCache::getComputePipeline(const WGPUComputePipelineDescriptor& descriptor) {
+    const auto& compute = descriptor.compute;
+    if (descriptor.nextInChain != nullptr || compute.nextInChain != nullptr) {
+        return wgpuDeviceCreateComputePipeline(mResources->device, &descriptor);
+    }
+    CacheKey key;
+    key.add(descriptor.layout).add(compute.module);
+    addString(key, compute.entryPoint);
+    addConstants(key, compute.constantCount, compute.constants);
+    std::lock_guard<std::mutex> lock(mMutex);
+    return lookup(mComputePipelines, mPipelineStats, key, [&] {
+        ZoneScopedN("Create compute pipeline");
+        return wgpuDeviceCreateComputePipeline(mResources->device, &descriptor);
+    });
+}
+
+void PipelineCache::clear() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& [key, pipeline] : mRenderPipelines) {
+        wgpuRenderPipelineRelease(pipeline);
+    }
+    for (auto& [key, pipeline] : mComputePipelines) {
+        wgpuComputePipelineRelease(pipeline);
+    }
+    for (auto& [key, layout] : mLayouts) {
+        wgpuPipelineLayoutRelease(layout);
+    }
+    for (auto& [key, module] : mModules) {
+        wgpuShaderModuleRelease(module);
+    }
+    mRenderPipelines.clear();
+    mComputePipelines.clear();
+    mLayouts.clear();
+    mModules.clear();
+}
+
+const ShaderSourceCache::Stats& PipelineCache::getSourceStats() const { return mSources.getStats(); }
+
+const PipelineCache::Stats& PipelineCache::getModuleStats() const { return mModuleStats; }
+
+const PipelineCache::Stats& PipelineCache::getLayoutStats() const { return mLayoutStats; }
+
+const PipelineCache::Stats& PipelineCache::getPipelineStats() const { return mPipelineStats; }
@@ -1,5 +1,6 @@
 #include "point_light.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <format>
@@ -84,7 +85,7 @@ size_t LightManager::createSpotLight(glm::vec4 pos, glm::vec4 direction, glm::ve
 }
 
 void LightManager::updateCount() {
-    mLightCount = mLights.size();
+    mLightCount = std::min(mLights.size(), MAX_LIGHTS);
     mLightCountBuffer.queueWrite(0, &mLightCount, sizeof(uint32_t));
 }
 
@@ -92,7 +93,7 @@ Light* LightManager::get(size_t index) { return mLights.size() > 0 ? &mLights[in
 
 void LightManager::uploadToGpu(Application* app, WGPUBuffer buffer) {
     updateCount();
-    wgpuQueueWriteBuffer(app->getRendererResource().queue, buffer, 0, mLights.data(), sizeof(Light) * mLights.size());
+    wgpuQueueWriteBuffer(app->getRendererResource().queue, buffer, 0, mLights.data(), sizeof(Light) * mLightCount);
 }
 
 void LightManager::update(int index, bool updateDebugLines) {
@@ -104,7 +105,9 @@ void LightManager::update(int index, bool updateDebugLines) {
         glm::quat rot = rotationBetweenVectors(glm::vec3{0.0, 0.0, 1.0}, light->mDirection);
         t = t * glm::toMat4(rot);
     }
-    mApp->mLightBuffer.queueWrite(sizeof(Light) * mSelectedLightInGui, light, sizeof(Light));
+    if (mSelectedLightInGui < mLightCount) {
+        mApp->mLightBuffer.queueWrite(sizeof(Light) * mSelectedLightInGui, light, sizeof(Light));
+    }
 
     if (updateDebugLines) {
         if (boxId < 1024) {
@@ -179,7 +182,9 @@ void LightManager::renderGUI() {
             } else {
                 boxId = mApp->mLineEngine->addLines(generateCone());
             }
-            mApp->mLightBuffer.queueWrite(sizeof(Light) * mSelectedLightInGui, light, sizeof(Light));
+            if (mSelectedLightInGui < mLightCount) {
+                mApp->mLightBuffer.queueWrite(sizeof(Light) * mSelectedLightInGui, light, sizeof(Light));
+            }
         }
         // -------------------------- Back to first Column -----------------------------------
     }
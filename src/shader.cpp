@@ -1,59 +1,22 @@
 #include "shader.h"
 
-#include <format>
-#include <fstream>
-#include <iostream>
-#include <map>
 #include <string>
+#include <vector>
 
-static std::map<std::string, std::string> sShaderStorage;
+#include "shader_source_cache.h"
 
-std::string readFile(const fs::path& path) {
-    std::ifstream file{path};
-    if (!file.is_open()) {
-        std::cout << "Failed to open shader at " << path << std::endl;
-        return {};
-    }
-
-    file.seekg(0, std::ios::end);
-    size_t file_size = file.tellg();
-
-    std::string shader_code(file_size, ' ');
-
-    file.seekg(0);
-    file.read(shader_code.data(), file_size);
-    return {shader_code};
-}
-
-void preprocessShader(std::string& shaderCode, std::filesystem::path basePath) {
-    size_t find_index = shaderCode.find("#include");
-    while (find_index != std::string::npos) {
-        auto start_idx = shaderCode.find('"', find_index + 1);
-        auto end_idx = shaderCode.find('"', start_idx + 1);
-        std::string shader_name = shaderCode.substr(start_idx + 1, end_idx - start_idx - 1);
-
-        std::cout << std::format("loading {} in preprocessing from {}\n", shader_name,
-                                 (basePath / shader_name).string());
-        // std::string file_content = readFile(basePath.string() + "/" + shader_name);
-        std::string file_content = readFile(basePath / shader_name);
-
-        shaderCode.replace(find_index, end_idx - find_index + 1, file_content);
-        find_index = shaderCode.find("#include", find_index + 1);
-    }
-}
+std::string readFile(const fs::path& path) { return ShaderSourceCache::readFile(path); }
 
+// uncached, PipelineCache::getShaderModule shares the module between identical sources
 WGPUShaderModule loadShader(const fs::path& path, WGPUDevice device) {
-    // auto base_path = path.string().substr(0, path.string().find_last_of("/"));
-    auto base_path = std::filesystem::path(path).parent_path();
-    std::string shader_code = readFile(path);
-    preprocessShader(shader_code, base_path);
+    std::vector<fs::path> includes;
+    std::string shader_code = ShaderSourceCache::preprocess(readFile(path), path.parent_path(), includes);
     WGPUShaderSourceWGSL module_descriptor = {};
     module_descriptor.chain.next = nullptr;
     module_descriptor.chain.sType = WGPUSType_ShaderSourceWGSL;
     module_descriptor.code = {shader_code.c_str(), shader_code.size()};
 
     WGPUShaderModuleDescriptor shader_descriptor = {};
-    shader_descriptor.nextInChain = nullptr;
     shader_descriptor.nextInChain = &module_descriptor.chain;
     return wgpuDeviceCreateShaderModule(device, &shader_descriptor);
 }
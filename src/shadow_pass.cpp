@@ -1,8 +1,11 @@
 #include "shadow_pass.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <format>
+#include <limits>
 #include <string>
 
 #include "binding_group.h"
@@ -12,6 +15,7 @@
 #include <webgpu/webgpu.h>
 
 #include "application.h"
+#include "geometry_arena.h"
 #include "glm/ext.hpp"
 #include "glm/fwd.hpp"
 #include "glm/geometric.hpp"
@@ -24,11 +28,14 @@
 #include "renderpass.h"
 
 float sunlength = 5.0;
+constexpr const uint32_t SHADOW_MAP_SIZE = 2048;
+// depth24plus can not be copied, the static caster cache is copied into the shadow map every frame
+constexpr const WGPUTextureFormat SHADOW_DEPTH_FORMAT = WGPUTextureFormat_Depth32Float;
 
 ShadowPass::ShadowPass(Application* app, const std::string& name) : RenderPass(name) { mApp = app; }
 
 ShadowFrustum::ShadowFrustum(Application* app, WGPUTextureView renderTarget, WGPUTextureView depthTexture,
-                             const std::string& name)
+                             const std::string& name, LoadOp depthLoadOp)
     : mShadowDepthTexture(depthTexture), mRenderTarget(renderTarget), mApp(app), cascadeName(name) {
     mColorAttachment =
         ColorAttachment{mRenderTarget, nullptr, WGPUColor{0.02, 0.80, 0.92, 1.0}, StoreOp::Discard, LoadOp::Load};
@@ -39,7 +46,7 @@ ShadowFrustum::ShadowFrustum(Application* app, WGPUTextureView renderTarget, WGP
     mRenderPassDesc.colorAttachmentCount = 1;
     mRenderPassDesc.colorAttachments = mColorAttachment.get();
 
-    mDepthStencilAttachment = DepthStencilAttachment{mShadowDepthTexture, StoreOp::Store, LoadOp::Clear, false,
+    mDepthStencilAttachment = DepthStencilAttachment{mShadowDepthTexture, StoreOp::Store, depthLoadOp, false,
                                                      StoreOp::Discard,    LoadOp::Clear,  true};
 
     mRenderPassDesc.depthStencilAttachment = mDepthStencilAttachment.get();
@@ -49,7 +56,7 @@ ShadowFrustum::ShadowFrustum(Application* app, WGPUTextureView renderTarget, WGP
 void ShadowPass::createRenderPass(WGPUTextureFormat textureFormat) { (void)textureFormat; }
 
 void ShadowPass::createRenderPass(WGPUTextureFormat textureFormat, size_t cascadeNumber) {
-    constexpr uint32_t screen = 2048;
+    constexpr uint32_t screen = SHADOW_MAP_SIZE;
     auto& rc = mApp->getRendererResource();
     mNumOfCascades = cascadeNumber;
     mRenderTarget = new Texture{rc.device, screen, screen, TextureDimension::TEX_2D,
@@ -60,16 +67,33 @@ void ShadowPass::createRenderPass(WGPUTextureFormat textureFormat, size_t cascad
                                       screen,
                                       screen,
                                       TextureDimension::TEX_2D,
-                                      WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_TextureBinding,
-                                      WGPUTextureFormat_Depth24Plus,
+                                      WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_TextureBinding |
+                                          WGPUTextureUsage_CopyDst,
+                                      SHADOW_DEPTH_FORMAT,
                                       5};
 
+    mStaticDepthTexture = new Texture{rc.device,
+                                      screen,
+                                      screen,
+                                      TextureDimension::TEX_2D,
+                                      WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_CopySrc,
+                                      SHADOW_DEPTH_FORMAT,
+                                      5,
+                                      "static shadow cache"};
+
     mShadowDepthTexture->createViewArray(0, 5);
     for (size_t c = 0; c < mNumOfCascades; c++) {
         mSubFrustums.push_back(new ShadowFrustum{mApp, mRenderTarget->getTextureView(),
                                                  mShadowDepthTexture->createViewDepthOnly2(c, 1),
                                                  "cascade" + std::to_string(c)});
+        mStaticFrustums.push_back(new ShadowFrustum{mApp, mRenderTarget->getTextureView(),
+                                                    mStaticDepthTexture->createViewDepthOnly2(c, 1),
+                                                    "static cascade" + std::to_string(c)});
+        mDynamicFrustums.push_back(new ShadowFrustum{mApp, mRenderTarget->getTextureView(),
+                                                     mShadowDepthTexture->createViewDepthOnly2(c, 1),
+                                                     "dynamic cascade" + std::to_string(c), LoadOp::Load});
     }
+    mCascadeCaches.resize(mNumOfCascades);
     // for projection
     auto bind_group_layout =
         mBindingGroup
@@ -169,7 +193,7 @@ void ShadowPass::createRenderPass(WGPUTextureFormat textureFormat, size_t cascad
             .setMappedAtCraetion(false)
             .create(&rc);
 
-        wgpuQueueWriteBuffer(rc.queue, buf.getBuffer(), 0, &f, sizeof(uint32_t));
+        buf.queueWrite(0, &f, sizeof(uint32_t));
         mFrustuIndexBuffer.push_back(buf);
 
         WGPUBindGroupEntry mBindGroupEntry = {};
@@ -216,12 +240,12 @@ void ShadowPass::createRenderPass(WGPUTextureFormat textureFormat, size_t cascad
         .setVertexBufferLayout(d)
         .setVertexState()
         .setPrimitiveState()
-        .setDepthStencilState(true, 0xFF, 0xFF)
+        .setDepthStencilState(true, 0xFF, 0xFF, SHADOW_DEPTH_FORMAT)
         .setBlendState()
         .setColorTargetState(textureFormat)
         .setFragmentState();
 
-    mRenderPipeline->setMultiSampleState().createPipeline(rc);
+    mRenderPipeline->setMultiSampleState().enablePackedVertexVariants().createPipeline(rc);
 }
 
 glm::mat4 createProjectionFromFrustumCorner(const std::vector<glm::vec4>& corners, const glm::mat4& lightView,
@@ -266,6 +290,20 @@ glm::mat4 createProjectionFromFrustumCorner(const std::vector<glm::vec4>& corner
     return glm::ortho(minX, maxX, minY, maxY, minZ, maxZ);
 }
 
+// ortho box around the bounding sphere of a split, its size does not change when the camera turns. The depth range
+// keeps the old convention: view space z of the box, padded per cascade
+glm::mat4 createProjectionFromBoundingSphere(float radius, float pushBack, float* mm, float dis) {
+    float minZ = -radius * pushBack - radius;
+    float maxZ = -radius * pushBack + radius;
+
+    maxZ += 20.0f * dis;
+    minZ -= 20.0f * dis;
+
+    *mm = minZ;
+
+    return glm::ortho(-radius, radius, -radius, radius, minZ, maxZ);
+}
+
 std::vector<glm::vec4> calculateSplit(const FrustumCorners& corners, float begin, float end) {
     auto near0 = corners.nearBottomLeft + (glm::normalize(corners.farBottomLeft - corners.nearBottomLeft) * begin);
     auto near1 = corners.nearTopLeft + (glm::normalize(corners.farTopLeft - corners.nearTopLeft) * begin);
@@ -289,15 +327,28 @@ Scene ShadowPass::calculateFrustumScene(const std::vector<glm::vec4>& frustum, f
     center /= frustum.size();
 
     glm::vec3 lightDirection = glm::normalize(-this->sunDir);
-    auto dist = glm::length(frustum[0] - frustum[7]);
     float radius = 0.0f;
     for (const auto& v : frustum) radius = std::max(radius, glm::length(glm::vec3(v) - center));
 
-    glm::vec3 lightPosition = center - (lightDirection * radius * mPushBackFactor);  // Push light back
-    // center - lightDirection * (mPushBackFactor);  // Push light back
+    if (!mCacheStaticCasters) {
+        glm::vec3 lightPosition = center - (lightDirection * radius * mPushBackFactor);  // Push light back
+        auto view = glm::lookAt(lightPosition, center, glm::vec3{0.0f, 0.0f, 1.0f});
+        glm::mat4 projection = createProjectionFromFrustumCorner(frustum, view, &MinZ, "frustum", cascadeIdx);
+        return Scene{projection, glm::mat4{1.0}, view, farZ};
+    }
 
-    auto view = glm::lookAt(lightPosition, center, glm::vec3{0.0f, 0.0f, 1.0f});
-    glm::mat4 projection = createProjectionFromFrustumCorner(frustum, view, &MinZ, "frustum", cascadeIdx);
+    // rounded up so float noise does not change the texel size
+    radius = std::ceil(radius * 16.0f) / 16.0f;
+
+    // the center is snapped to whole shadow map texels in light space, a cascade only moves in texel steps and its
+    // matrices stay the same while the camera stands still, which keeps the static caster cache valid
+    auto rotation = glm::lookAt(glm::vec3{0.0f}, lightDirection, glm::vec3{0.0f, 0.0f, 1.0f});
+    float texel = 2.0f * radius / static_cast<float>(SHADOW_MAP_SIZE);
+    glm::vec3 light_center = glm::floor(glm::vec3(rotation * glm::vec4(center, 1.0f)) / texel) * texel;
+    glm::vec3 light_position = light_center + glm::vec3{0.0f, 0.0f, radius * mPushBackFactor};  // Push light back
+
+    auto view = glm::translate(glm::mat4{1.0f}, -light_position) * rotation;
+    glm::mat4 projection = createProjectionFromBoundingSphere(radius, mPushBackFactor, &MinZ, cascadeIdx);
     return Scene{projection, glm::mat4{1.0}, view, farZ};
 }
 
@@ -322,76 +373,187 @@ WGPURenderPassDescriptor* ShadowFrustum::getRenderPassDescriptor() { return &mRe
 
 void ShadowPass::renderAllCascades(WGPUCommandEncoder encoder) {
     auto& models = ModelRegistry::instance().getLoadedModel(ModelVisibility::Visibility_User);
+    size_t cascades = std::min(mNumOfCascades, mScenes.size());
     {
         ZoneScopedN("Calculating scene data");
 
-        for (auto& s : mScenes) {
+        mSceneUniforms = mScenes;
+        mSceneUniforms.resize(mNumOfCascades);
+        mCascadeFrustums.resize(mNumOfCascades);
+        for (size_t c = 0; c < cascades; ++c) {
+            auto& s = mSceneUniforms[c];
             s.projection = s.projection * s.view;
+            mCascadeFrustums[c] = Frustum::fromMatrix(s.projection);
         }
     }
 
     {
         mBindingData[1].buffer = mApp->mInstanceManager->getInstancingBuffer().getBuffer();
         mBindingData[3].sampler = mApp->getDefaultSampler();
-        mSceneUniformBuffer.queueWrite(0, mScenes.data(), sizeof(Scene) * mNumOfCascades);
+        mSceneUniformBuffer.queueWrite(0, mSceneUniforms.data(), sizeof(Scene) * mNumOfCascades);
         // wgpuQueueWriteBuffer(mApp->getRendererResource().queue, mSceneUniformBuffer.getBuffer(), );
     }
 
-    for (size_t c = 0; c < mNumOfCascades; ++c) {
+    bool static_casters_changed = updateCasters(models);
+    // the caches only hold what culling let through
+    if (mCachedWithCulling != mCullPerCascade) {
+        static_casters_changed = true;
+        mCachedWithCulling = mCullPerCascade;
+    }
+    mStats = {};
+
+    for (size_t c = 0; c < cascades; ++c) {
         ZoneScopedN("Draw Cascade loops");
-        WGPURenderPassEncoder shadow_pass_encoder;
-        // TracyGpuZone("ShadowPass");
-        {
-            ZoneScopedN("Begining render pass");
-            shadow_pass_encoder = wgpuCommandEncoderBeginRenderPass(encoder, getRenderPassDescriptor(c));
-            wgpuRenderPassEncoderSetPipeline(shadow_pass_encoder, getPipeline()->getPipeline());
+        if (!mCacheStaticCasters) {
+            mCascadeCaches[c].valid = false;
+            drawCascade(encoder, getRenderPassDescriptor(c), mDynamicCasters, c);
+            continue;
+        }
+
+        auto& cache = mCascadeCaches[c];
+        if (!cache.valid || static_casters_changed || cache.viewProjection != mSceneUniforms[c].projection) {
+            ZoneScopedN("Static shadow cache");
+            drawCascade(encoder, mStaticFrustums[c]->getRenderPassDescriptor(), mStaticCasters, c);
+            cache.viewProjection = mSceneUniforms[c].projection;
+            cache.valid = true;
+            mStats.cacheRebuilds++;
+        }
+
+        WGPUTexelCopyTextureInfo source = {};
+        source.texture = mStaticDepthTexture->getTexture();
+        source.origin = {0, 0, static_cast<uint32_t>(c)};
+        source.aspect = WGPUTextureAspect_All;
+
+        WGPUTexelCopyTextureInfo destination = {};
+        destination.texture = mShadowDepthTexture->getTexture();
+        destination.origin = {0, 0, static_cast<uint32_t>(c)};
+        destination.aspect = WGPUTextureAspect_All;
+
+        WGPUExtent3D size = {SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 1};
+        wgpuCommandEncoderCopyTextureToTexture(encoder, &source, &destination, &size);
+
+        drawCascade(encoder, mDynamicFrustums[c]->getRenderPassDescriptor(), mDynamicCasters, c);
+    }
+}
+
+void ShadowPass::drawCascade(WGPUCommandEncoder encoder, WGPURenderPassDescriptor* descriptor,
+                             const std::vector<Model*>& casters, size_t which) {
+    WGPURenderPassEncoder shadow_pass_encoder;
+    // TracyGpuZone("ShadowPass");
+    {
+        ZoneScopedN("Begining render pass");
+        shadow_pass_encoder = wgpuCommandEncoderBeginRenderPass(encoder, descriptor);
+        wgpuRenderPassEncoderSetPipeline(shadow_pass_encoder, getPipeline()->getPipeline());
+    }
+    {
+        ZoneScopedN("Shadow render call inside loop");
+        renderCasters(casters, shadow_pass_encoder, which);
+    }
+    {
+        ZoneScopedN("Ending render pass");
+        wgpuRenderPassEncoderEnd(shadow_pass_encoder);
+        wgpuRenderPassEncoderRelease(shadow_pass_encoder);
+    }
+}
+
+bool ShadowPass::updateCasters(ModelRegistry::ModelContainer& models) {
+    ZoneScopedN("Shadow casters");
+    mStaticCasters.clear();
+    mDynamicCasters.clear();
+    mCasterBounds.clear();
+
+    for (auto* model : models) {
+        // everything that changes what the model puts into the shadow map: its transform, which meshes are drawn and
+        // its bounds
+        glm::mat4 transform = model->getGlobalTransform();
+        uint64_t signature = StaticCasters::mix(StaticCasters::EMPTY_SIGNATURE, &transform, sizeof(transform));
+        size_t visible_meshes = 0;
+        float wind = 0.0f;
+        if (model->getVisible()) {
+            for (auto& [mat_id, mesh] : model->mFlattenMeshes) {
+                if (mesh.getVisible()) {
+                    visible_meshes++;
+                    wind = std::max(wind, std::abs(mesh.mWindParams.strength));
+                    signature = StaticCasters::mix(signature, &mat_id, sizeof(mat_id));
+                }
+            }
         }
-        {
-            ZoneScopedN("Shadow render call inside loop");
-            render(models, shadow_pass_encoder, c);
+
+        auto& bounds = mCasterBounds[model];
+        bounds.bounded = model->instance == nullptr;
+        if (bounds.bounded) {
+            auto [min, max] = model->getWorldSpaceAABB();
+            // the wind in the shadow shader sways vertices along x by up to 1.38 * strength
+            glm::vec3 sway{wind * 1.4f, 0.0f, 0.0f};
+            bounds.min = min - sway;
+            bounds.max = max + sway;
+            signature = StaticCasters::mix(signature, &bounds.min, sizeof(bounds.min));
+            signature = StaticCasters::mix(signature, &bounds.max, sizeof(bounds.max));
         }
-        {
-            ZoneScopedN("Ending render pass");
-            wgpuRenderPassEncoderEnd(shadow_pass_encoder);
-            wgpuRenderPassEncoderRelease(shadow_pass_encoder);
+
+        // skinned, swaying and instanced models move without their transform changing
+        bool can_be_static = mCacheStaticCasters && model->instance == nullptr &&
+                             model->mTransform.mObjectInfo.isAnimated == 0 && wind == 0.0f && visible_meshes > 0;
+        bool is_static = mCasterStates.update(model, signature, can_be_static);
+        if (visible_meshes > 0) {
+            (is_static ? mStaticCasters : mDynamicCasters).push_back(model);
         }
     }
+    // unloaded static casters leave the cache too
+    return mCasterStates.endFrame();
+}
+
+bool ShadowPass::reachesCascade(Model* model, size_t which) const {
+    auto bounds = mCasterBounds.find(model);
+    if (bounds == mCasterBounds.end() || !bounds->second.bounded || which >= mCascadeFrustums.size()) {
+        return true;
+    }
+    return mCascadeFrustums[which].AABBTest(bounds->second.min, bounds->second.max);
 }
 
+const ShadowPass::Stats& ShadowPass::getStats() const { return mStats; }
+
 void ShadowPass::render(ModelRegistry::ModelContainer& models, WGPURenderPassEncoder encoder, size_t which) {
+    mCascadeCasters.assign(models.begin(), models.end());
+    renderCasters(mCascadeCasters, encoder, which);
+}
+
+void ShadowPass::renderCasters(const std::vector<Model*>& casters, WGPURenderPassEncoder encoder, size_t which) {
     ZoneScopedN("render body");
     mBindingData[0].buffer = mSceneUniformBuffer.getBuffer();
     mBindingData[2].buffer = mFrustuIndexBuffer[which].getBuffer();
-    for (auto& model : models) {
+    VertexLayout bound_layout = VertexLayout::Full;
+    for (auto* model : casters) {
         if (!model->getVisible()) {
             continue;
         }
+        if (mCullPerCascade && !reachesCascade(model, which)) {
+            mStats.culledCasters++;
+            continue;
+        }
+        mStats.drawnCasters++;
         for (auto& [mat_id, mesh] : model->mFlattenMeshes) {
             ZoneScopedN("inner loop loop");
             if (!mesh.getVisible()) {
                 continue;
             }
-            wgpuRenderPassEncoderSetVertexBuffer(encoder, 0, mesh.mVertexBuffer.getBuffer(), 0,
-                                                 wgpuBufferGetSize(mesh.mVertexBuffer.getBuffer()));
-            wgpuRenderPassEncoderSetIndexBuffer(encoder, mesh.mIndexBuffer.getBuffer(), WGPUIndexFormat_Uint32, 0,
-                                                wgpuBufferGetSize(mesh.mIndexBuffer.getBuffer()));
+            if (mesh.mVertexLayout != bound_layout) {
+                bound_layout = mesh.mVertexLayout;
+                wgpuRenderPassEncoderSetPipeline(encoder, getPipeline()->getPipeline(bound_layout));
+            }
+            mesh.bindGeometry(encoder, mApp->mGeometryArena);
             wgpuRenderPassEncoderSetBindGroup(encoder, 0, mBindingGroup.getBindGroup(), 0, nullptr);
-            wgpuRenderPassEncoderSetBindGroup(encoder, 1,
-                                              mesh.mTextureBindGroup == nullptr
-                                                  ? mApp->mDefaultTextureBindingGroup.getBindGroup()
-                                                  : mesh.mTextureBindGroup,
-                                              0, nullptr);
+            wgpuRenderPassEncoderSetBindGroup(encoder, 1, model->getTextureBindGroup(mApp, mesh), 0, nullptr);
 
             wgpuRenderPassEncoderSetBindGroup(encoder, 2, mApp->mDefaultVisibleBuffer.getBindGroup(), 0, nullptr);
             wgpuRenderPassEncoderSetBindGroup(encoder, 3, model->getObjectInfoBindGroup(), 0, nullptr);
             wgpuRenderPassEncoderSetBindGroup(encoder, 4, mSceneIndicesBindGroup[which], 0, nullptr);
-            wgpuRenderPassEncoderSetBindGroup(encoder, 5, mesh.mMaterialBindGroup, 0, nullptr);
+            mApp->mMaterials.getBinding(mesh).set(encoder, 5);
 
             if (model->instance == nullptr) {
-                wgpuRenderPassEncoderDrawIndexed(encoder, mesh.mIndexData.size(), 1, 0, 0, 0);
+                mesh.drawIndexed(encoder);
             } else {
-                wgpuRenderPassEncoderDrawIndexed(encoder, mesh.mIndexData.size(), model->instance->getInstanceCount(),
-                                                 0, 0, 0);
+                mesh.drawIndexed(encoder, model->instance->getInstanceCount());
             }
         }
     }
@@ -423,73 +585,153 @@ DepthPrePass::DepthPrePass(Application* app, const std::string& name, WGPUTextur
     mRenderPassDesc->colorAttachmentCount = 1;
     mRenderPassDesc->colorAttachments = mColorAttachment.get();
 
-    mDepthStencilAttachment = DepthStencilAttachment{depthTexture,     StoreOp::Store, LoadOp::Clear, false,
-                                                     StoreOp::Discard, LoadOp::Clear,  false};
+    mDepthStencilAttachment = DepthStencilAttachment{depthTexture,   StoreOp::Store, LoadOp::Clear, false,
+                                                     StoreOp::Store, LoadOp::Clear,  false};
 
     mRenderPassDesc->depthStencilAttachment = mDepthStencilAttachment.get();
     mRenderPassDesc->timestampWrites = nullptr;
 }
 
+Pipeline* DepthPrePass::createPipeline(const char* shader, const char* name, bool alphaTest) {
+    auto* layouts = mApp->getBindGroupLayouts();
+    auto* pipeline = new Pipeline{
+        mApp, {layouts[0], layouts[1], layouts[2], layouts[3], layouts[4], layouts[5], layouts[6]}, name};
+
+    // the full interleaved vertices, but only the attributes placing the vertex are fetched
+    pipeline->mVertexBufferLayout.addAttribute(0, 0, WGPUVertexFormat_Float32x3);
+    if (alphaTest) {
+        pipeline->mVertexBufferLayout.addAttribute(offsetof(VertexAttributes, uv), 5, WGPUVertexFormat_Float32x2);
+    }
+    WGPUVertexBufferLayout layout =
+        pipeline->mVertexBufferLayout.addAttribute(offsetof(VertexAttributes, boneIds), 6, WGPUVertexFormat_Sint32x4)
+            .addAttribute(offsetof(VertexAttributes, weights), 7, WGPUVertexFormat_Float32x4)
+            .configure(sizeof(VertexAttributes), VertexStepMode::VERTEX);
+
+    // no depth bias and the culling of the main pipeline, the PBR pass tests for the very same depth
+    setDefaultActiveStencil2(pipeline->getDepthStencilState());
+    pipeline->setShader(mApp->getBinaryPathAbsolute() / ".." / RESOURCE_DIR / "shaders" / shader,
+                        mApp->getRendererResource())
+        .setVertexBufferLayout(layout)
+        .setVertexState()
+        .setPrimitiveState(WGPUFrontFace_CCW, WGPUCullMode_None)
+        .setDepthStencilState(pipeline->getDepthStencilState());
+
+    if (alphaTest) {
+        mAlphaTestFragmentState = {};
+        mAlphaTestFragmentState.module = pipeline->mShaderModule;
+        mAlphaTestFragmentState.entryPoint = {"fs_main", WGPU_STRLEN};
+        mAlphaTestFragmentState.targetCount = 0;
+        mAlphaTestFragmentState.targets = nullptr;
+        pipeline->setFragmentState(&mAlphaTestFragmentState);
+    } else {
+        pipeline->setFragmentState(nullptr);
+    }
+    pipeline->enablePackedVertexVariants().createPipeline(mApp->getRendererResource());
+    return pipeline;
+}
+
 void DepthPrePass::createRenderPass(WGPUTextureFormat textureFormat) {
     (void)textureFormat;
+    mRenderPipeline = nullptr;
+}
 
-    auto* layouts = mApp->getBindGroupLayouts();
-    mRenderPipeline = new Pipeline{
-        mApp,
-        {layouts[0], layouts[1], layouts[2], layouts[3], layouts[4], layouts[5], layouts[6] /*, mLayerThree*/},
-        "Depth Pre-Pass"};
+std::pair<glm::vec3, glm::vec3> DepthPrePass::getDrawnBounds(Model* model) {
+    if (model->instance == nullptr) {
+        return model->getWorldSpaceAABB();
+    }
+    glm::vec3 world_min{std::numeric_limits<float>::max()};
+    glm::vec3 world_max{std::numeric_limits<float>::lowest()};
+    for (const auto& data : model->instance->mInstanceBuffer) {
+        world_min = glm::min(world_min, glm::vec3{data.minAABB});
+        world_max = glm::max(world_max, glm::vec3{data.maxAABB});
+    }
+    return {world_min, world_max};
+}
 
-    WGPUColorTargetState colorTargetState;
+void DepthPrePass::render(const std::vector<Model*>& opaques, const glm::vec3& cameraPosition,
+                          WGPURenderPassEncoder encoder) {
+    ZoneScopedN("Depth PrePass");
+    mDrawnModels.clear();
+    mStats = {};
+    if (!mEnabled) {
+        return;
+    }
+    if (mRenderPipeline == nullptr) {
+        mRenderPipeline = createPipeline("depth_prepass.wgsl", "Depth Pre-Pass", false);
+        mAlphaTestPipeline = createPipeline("depth_prepass_alpha.wgsl", "Depth Pre-Pass alpha tested", true);
+    }
 
-    WGPUVertexBufferLayout d = mRenderPipeline->mVertexBufferLayout
-                                   .addAttribute(0, 0, WGPUVertexFormat_Float32x3)  // for position
-                                   .addAttribute(3 * sizeof(float), 1, WGPUVertexFormat_Float32x3)
-                                   .addAttribute(6 * sizeof(float), 2, WGPUVertexFormat_Float32x3)
-                                   .addAttribute(9 * sizeof(float), 3, WGPUVertexFormat_Float32x3)
-                                   .addAttribute(12 * sizeof(float), 4, WGPUVertexFormat_Float32x3)
-                                   .addAttribute(offsetof(VertexAttributes, uv), 5, WGPUVertexFormat_Float32x2)
-                                   .addAttribute(offsetof(VertexAttributes, boneIds), 6, WGPUVertexFormat_Sint32x4)
-                                   .addAttribute(offsetof(VertexAttributes, weights), 7, WGPUVertexFormat_Float32x4)
-                                   .configure(sizeof(VertexAttributes), VertexStepMode::VERTEX);
-    mRenderPipeline
-        // ->defaultConfiguration(mApp, textureFormat, WGPUTextureFormat_Depth24Plus,
-        //                        )
-        ->setShader(mApp->getBinaryPathAbsolute() / ".." / RESOURCE_DIR "/shaders/depth_prepass.wgsl",
-                    mApp->getRendererResource())
-        .setVertexBufferLayout(d)
-        .setVertexState()
-        .setPrimitiveState(WGPUFrontFace_CCW, WGPUCullMode_Front)
-        .setDepthStencilState(true, 0xFF, 0xFF, WGPUTextureFormat_Depth24PlusStencil8)
-        .setBlendState();
+    const glm::vec4& plane = mApp->mDefaultPlane;
+    mOccluders.clear();
+    for (auto* model : opaques) {
+        if (!model->getVisible() || model->getPipeline(mApp) != mApp->getPipeline()) {
+            continue;
+        }
+        auto [world_min, world_max] = getDrawnBounds(model);
+        if (world_min.x > world_max.x) {
+            continue;
+        }
+        // the PBR pass discards what is in front of the clip plane, depth written there would hide what is behind
+        glm::vec3 farthest = glm::mix(world_min, world_max, glm::step(glm::vec3{0.0f}, glm::vec3{plane}));
+        if (glm::dot(glm::vec3{plane}, farthest) + plane.w > 0.0f) {
+            mStats.skippedModels++;
+            continue;
+        }
+        glm::vec3 center = (world_min + world_max) * 0.5f;
+        float radius = glm::length(world_max - world_min) * 0.5f;
+        float distance = glm::distance(center, cameraPosition);
+        mOccluders.push_back({model, radius / std::max(distance, radius), distance});
+    }
 
-    static WGPUFragmentState mFragmentState = {};
-    mFragmentState.nextInChain = nullptr;
-    mFragmentState.module = mRenderPipeline->mShaderModule;
-    mFragmentState.entryPoint = {"fs_main", WGPU_STRLEN};
-    mFragmentState.constants = nullptr;
-    mFragmentState.constantCount = 0;
-    mFragmentState.targetCount = 0;
-    mFragmentState.targets = nullptr;
+    if (mMaxOccluders != 0 && mOccluders.size() > mMaxOccluders) {
+        std::nth_element(mOccluders.begin(), mOccluders.begin() + mMaxOccluders, mOccluders.end(),
+                         [](const Occluder& a, const Occluder& b) { return a.coverage > b.coverage; });
+        mStats.skippedModels += mOccluders.size() - mMaxOccluders;
+        mOccluders.resize(mMaxOccluders);
+    }
+    std::sort(mOccluders.begin(), mOccluders.end(),
+              [](const Occluder& a, const Occluder& b) { return a.distance < b.distance; });
+
+    Pipeline* bound_pipeline = nullptr;
+    VertexLayout bound_layout = VertexLayout::Full;
+    for (const auto& occluder : mOccluders) {
+        Model* model = occluder.model;
+        mDrawnModels.insert(model);
+        mStats.drawnModels++;
+        for (auto& [mat_id, mesh] : model->mFlattenMeshes) {
+            if (!mesh.getVisible()) {
+                continue;
+            }
+            bool foliage = mesh.mMaterial.hasFlag(MaterialProps::IsFoliage);
+            Pipeline* pipeline = foliage ? mAlphaTestPipeline : mRenderPipeline;
+            if (pipeline != bound_pipeline || mesh.mVertexLayout != bound_layout) {
+                bound_pipeline = pipeline;
+                bound_layout = mesh.mVertexLayout;
+                wgpuRenderPassEncoderSetPipeline(encoder, pipeline->getPipeline(bound_layout));
+            }
+            mStats.foliageMeshes += foliage ? 1 : 0;
+
+            mesh.bindGeometry(encoder, mApp->mGeometryArena);
+            wgpuRenderPassEncoderSetBindGroup(encoder, 1, model->getObjectInfoBindGroup(), 0, nullptr);
+            wgpuRenderPassEncoderSetBindGroup(encoder, 2, model->getTextureBindGroup(mApp, mesh), 0, nullptr);
+            mApp->mMaterials.getBinding(mesh).set(encoder, 6);
+            if (model->instance != nullptr) {
+                model->drawInstances(mApp, encoder, mat_id, mesh);
+            } else {
+                mesh.drawIndexed(encoder);
+            }
+        }
+    }
+}
 
-    mRenderPipeline->setColorTargetState(mApp->getTextureFormat()).setFragmentState(&mFragmentState);
+bool DepthPrePass::hasDepth(Model* model) const { return mDrawnModels.contains(model); }
 
-    mRenderPipeline->setMultiSampleState().createPipeline(mApp->getRendererResource());
-}
+const DepthPrePass::Stats& DepthPrePass::getStats() const { return mStats; }
 
 WGPURenderPassDescriptor& DepthPrePass::getRenderDesc(WGPUTextureView texture) {
     mDesc = {};
     mDesc.nextInChain = nullptr;
 
-    static WGPURenderPassColorAttachment color_attachment = {};
-    color_attachment.view = nullptr;
-    color_attachment.resolveTarget = nullptr;
-    color_attachment.loadOp = WGPULoadOp_Undefined;
-    color_attachment.storeOp = WGPUStoreOp_Discard;
-    color_attachment.clearValue = WGPUColor{0.52, 0.80, 0.92, 1.0};
-#ifndef WEBGPU_BACKEND_WGPU
-    color_attachment.depthSlice = WGPU_DEPTH_SLICE_UNDEFINED;
-#endif  // NOT WEBGPU_BACKEND_WGPU
-
     mDesc.colorAttachmentCount = 0;
     mDesc.colorAttachments = nullptr;
 
@@ -501,7 +743,8 @@ WGPURenderPassDescriptor& DepthPrePass::getRenderDesc(WGPUTextureView texture) {
     depth_stencil_attachment.depthReadOnly = false;
     depth_stencil_attachment.stencilClearValue = 0;
     depth_stencil_attachment.stencilLoadOp = WGPULoadOp_Clear;
-    depth_stencil_attachment.stencilStoreOp = WGPUStoreOp_Discard;
+    // the PBR pass loads the stencil and only writes where it draws
+    depth_stencil_attachment.stencilStoreOp = WGPUStoreOp_Store;
     depth_stencil_attachment.stencilReadOnly = false;
     mDesc.depthStencilAttachment = &depth_stencil_attachment;
     mDesc.timestampWrites = nullptr;
@@ -0,0 +1,402 @@
+#include "skeleton.h"
+
+#include <algorithm>
+#include <cmath>
+
+glm::mat4 AiToGlm(const aiMatrix4x4& aiMat) {
+    return glm::mat4(aiMat.a1, aiMat.b1, aiMat.c1, aiMat.d1, aiMat.a2, aiMat.b2, aiMat.c2, aiMat.d2, aiMat.a3, aiMat.b3,
+                     aiMat.c3, aiMat.d3, aiMat.a4, aiMat.b4, aiMat.c4, aiMat.d4);
+}
+
+static size_t findPositionKey(double time, const Bone* bone) {
+    const auto& t = bone->channel.translations;
+    for (size_t i = 0; i < t.size(); i++) {
+        if (time < t[i].time) {
+            return i;
+        }
+    }
+    return t.size() - 1;
+}
+
+static size_t findScaleKey(double time, const Bone* bone) {
+    const auto& s = bone->channel.scales;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (time < s[i].time) {
+            return i;
+        }
+    }
+    return s.size() - 1;
+}
+
+static size_t findRotationKey(double time, const Bone* bone) {
+    const auto& r = bone->channel.quats;
+    for (size_t i = 0; i < r.size(); ++i) {
+        if (time < r[i].time) {
+            return i;
+        }
+    }
+    return r.size() - 1;
+}
+
+static void decompose(const aiMatrix4x4& m, glm::vec3& t, glm::quat& r, glm::vec3& s) {
+    aiVector3D aiS, aiT;
+    aiQuaternion aiR;
+    m.Decompose(aiS, aiR, aiT);
+    t = glm::vec3(aiT.x, aiT.y, aiT.z);
+    r = glm::quat(aiR.w, aiR.x, aiR.y, aiR.z);
+    s = glm::vec3(aiS.x, aiS.y, aiS.z);
+}
+
+static glm::vec3 calculateInterpolatedPosition(double time, const Bone* bone, const aiNode* node) {
+    glm::vec3 t;
+    glm::quat r;
+    glm::vec3 s{};
+    decompose(node->mTransformation, t, r, s);
+
+    if (!bone) {
+        return t;
+    }
+
+    if (bone->channel.translations.size() == 0) {
+        return t;
+    }
+
+    if (bone->channel.translations.size() == 1) {
+        return bone->channel.translations[0].value;
+    }
+
+    size_t pose_idx = findPositionKey(time, bone);
+    if (pose_idx == bone->channel.translations.size() - 1) {
+        auto v = bone->channel.translations[pose_idx].value;
+
+        return v;
+    }
+
+    double deltatime = bone->channel.translations[pose_idx + 1].time - bone->channel.translations[pose_idx].time;
+    double factor = (time - bone->channel.translations[pose_idx].time) / deltatime;
+    const glm::vec3& start = bone->channel.translations[pose_idx].value;
+    const glm::vec3& end = bone->channel.translations[pose_idx + 1].value;
+
+    return glm::mix(start, end, factor);
+}
+
+static glm::vec3 calculateInterpolatedScale(double time, const Bone* bone, const aiNode* node) {
+    glm::vec3 t;
+    glm::quat r;
+    glm::vec3 s{};
+    decompose(node->mTransformation, t, r, s);
+
+    if (!bone) {
+        return s;
+    }
+
+    auto& scales = bone->channel.scales;
+    if (scales.size() == 0) {
+        return glm::vec3(1.0f);  // default scale
+    }
+
+    if (scales.size() == 1) {
+        return scales[0].value;
+    }
+
+    size_t pose_idx = findScaleKey(time, bone);
+    if (pose_idx == scales.size() - 1) {
+        return scales[pose_idx].value;
+    }
+
+    double deltatime = scales[pose_idx + 1].time - scales[pose_idx].time;
+    double factor = (time - scales[pose_idx].time) / deltatime;
+    const glm::vec3& start = scales[pose_idx].value;
+    const glm::vec3& end = scales[pose_idx + 1].value;
+    return glm::mix(start, end, factor);
+}
+
+static glm::quat CalcInterpolatedRotation(double time, const Bone* bone, const aiNode* node) {
+    glm::vec3 t;
+    glm::quat r{};
+    glm::vec3 s;
+    decompose(node->mTransformation, t, r, s);
+
+    if (!bone) {
+        return r;
+    }
+
+    auto& quats = bone->channel.quats;
+    if (quats.size() == 0) {
+        return r;
+    }
+
+    if (quats.size() == 1) {
+        return quats[0].value;
+    }
+
+    unsigned int idx = findRotationKey(time, bone);
+    if (idx == quats.size() - 1) {
+        auto v = quats[idx].value;
+        // std::cout << "here " << glm::to_string(v) << std::endl;
+        return v;
+    }
+
+    double deltaTime = quats[idx + 1].time - quats[idx].time;
+    double factor = (time - quats[idx].time) / deltaTime;
+    auto start = quats[idx].value;
+    auto end = quats[idx + 1].value;
+    glm::quat out = glm::slerp(start, end, (float)factor);
+
+    return out;
+}
+
+// keys the cursor may walk forward before findKey gives up and binary searches
+constexpr const uint32_t MAX_CURSOR_STEPS = 4;
+
+template <typename T>
+static void appendKeys(KeyTrack<T>& track, size_t joint, const std::vector<Keyframe<T>>& keys) {
+    track.ranges[joint] = {static_cast<uint32_t>(track.times.size()), static_cast<uint32_t>(keys.size())};
+    for (const auto& key : keys) {
+        track.times.push_back(key.time);
+        track.values.push_back(key.value);
+    }
+}
+
+// same key selection as findPositionKey, the first key after `time` or the last one. Playback moves forward by a key
+// or two per frame so the search starts from the previous result, seeks and loop wraps fall back to a binary search
+uint32_t findKey(const float* times, uint32_t count, double time, uint32_t& cursor) {
+    uint32_t last = count - 1;
+    uint32_t key = std::min(cursor, last);
+    if (key == 0 || times[key - 1] <= time) {
+        for (uint32_t step = 0; step < MAX_CURSOR_STEPS && key < last && times[key] <= time; ++step) {
+            ++key;
+        }
+        if (key == last || time < times[key]) {
+            cursor = key;
+            return key;
+        }
+    }
+
+    key = std::upper_bound(times, times + last, time, [](double t, float k) { return t < k; }) - times;
+    cursor = key;
+    return key;
+}
+
+static glm::vec3 sampleVec3(const KeyTrack<glm::vec3>& track, size_t joint, double time, const glm::vec3& fallback) {
+    const auto& range = track.ranges[joint];
+    if (range.count == 0) {
+        return fallback;
+    }
+    const float* times = track.times.data() + range.begin;
+    const glm::vec3* values = track.values.data() + range.begin;
+    if (range.count == 1) {
+        return values[0];
+    }
+
+    size_t idx = findKey(times, range.count, time, track.cursors[joint]);
+    if (idx == range.count - 1) {
+        return values[idx];
+    }
+    double deltatime = times[idx + 1] - times[idx];
+    double factor = (time - times[idx]) / deltatime;
+    return glm::mix(values[idx], values[idx + 1], factor);
+}
+
+static glm::quat sampleQuat(const KeyTrack<glm::quat>& track, size_t joint, double time, const glm::quat& fallback) {
+    const auto& range = track.ranges[joint];
+    if (range.count == 0) {
+        return fallback;
+    }
+    const float* times = track.times.data() + range.begin;
+    const glm::quat* values = track.values.data() + range.begin;
+    if (range.count == 1) {
+        return values[0];
+    }
+
+    size_t idx = findKey(times, range.count, time, track.cursors[joint]);
+    if (idx == range.count - 1) {
+        return values[idx];
+    }
+    double deltatime = times[idx + 1] - times[idx];
+    double factor = (time - times[idx]) / deltatime;
+    return glm::slerp(values[idx], values[idx + 1], (float)factor);
+}
+
+void sampleSkeleton(const Skeleton& skeleton, const Action& action, double time, std::vector<glm::mat4>& locals,
+                    std::vector<glm::mat4>& globals) {
+    const auto& compiled = action.compiled;
+    for (size_t joint = 0; joint < skeleton.size(); ++joint) {
+        const Action* source = compiled.sources[joint];
+        double joint_time = time;
+        if (source != &action && joint_time >= source->mAnimationDuration * 1000.0f) {
+            joint_time = std::fmod(joint_time, source->mAnimationDuration * 1000.0f);
+        }
+
+        glm::vec3 pos = skeleton.bindTranslations[joint];
+        glm::quat rotation = skeleton.bindRotations[joint];
+        glm::vec3 scale = skeleton.bindScales[joint];
+        const auto& tracks = source->compiled;
+        if (tracks.animated[joint]) {
+            pos = sampleVec3(tracks.translations, joint, joint_time, pos);
+            rotation = sampleQuat(tracks.rotations, joint, joint_time, rotation);
+            scale = sampleVec3(tracks.scales, joint, joint_time, glm::vec3(1.0f));
+        }
+
+        locals[joint] =
+            glm::translate(glm::mat4(1.0f), pos) * glm::mat4(rotation) * glm::scale(glm::mat4(1.0f), scale);
+        int32_t parent = skeleton.parents[joint];
+        globals[joint] = (parent < 0 ? skeleton.rootInverse : globals[parent]) * locals[joint];
+    }
+}
+
+static void addJoint(Skeleton& skeleton, const aiNode* node, int32_t parent) {
+    int32_t index = static_cast<int32_t>(skeleton.names.size());
+    glm::vec3 t;
+    glm::quat r;
+    glm::vec3 s;
+    decompose(node->mTransformation, t, r, s);
+
+    skeleton.names.emplace_back(node->mName.C_Str());
+    skeleton.parents.push_back(parent);
+    skeleton.bindTranslations.push_back(t);
+    skeleton.bindRotations.push_back(r);
+    skeleton.bindScales.push_back(s);
+    skeleton.jointIndices[skeleton.names.back()] = index;
+
+    for (unsigned int i = 0; i < node->mNumChildren; ++i) {
+        addJoint(skeleton, node->mChildren[i], index);
+    }
+}
+
+void Skeleton::build(const aiNode* root) {
+    *this = {};
+    if (root == nullptr) {
+        return;
+    }
+    rootInverse = glm::inverse(AiToGlm(root->mTransformation));
+    addJoint(*this, root, -1);
+}
+
+int32_t Skeleton::getJointIndex(const std::string& name) const {
+    auto it = jointIndices.find(name);
+    return it == jointIndices.end() ? -1 : it->second;
+}
+
+size_t Skeleton::size() const { return names.size(); }
+
+static glm::mat4 sampleReferenceLocal(const aiNode* node, const Action& active, double time) {
+    const Action* action = &active;
+    double newtime = time;
+
+    auto mixed = action->MixedActions.find(node->mName.C_Str());
+    if (mixed != action->MixedActions.end() && mixed->second != nullptr) {
+        action = mixed->second;
+        if (newtime >= action->mAnimationDuration * 1000.0f) {
+            newtime = std::fmod(newtime, action->mAnimationDuration * 1000.0f);
+        }
+    }
+
+    const Bone* bone = nullptr;
+    auto it = action->Bonemap.find(node->mName.C_Str());
+    if (it != action->Bonemap.end()) {
+        bone = it->second;
+    }
+
+    glm::vec3 pos = calculateInterpolatedPosition(newtime, bone, node);
+    glm::quat rotation = CalcInterpolatedRotation(newtime, bone, node);
+    glm::vec3 scale = calculateInterpolatedScale(newtime, bone, node);
+
+    glm::mat4 translation_mat = glm::translate(glm::mat4(1.0f), pos);
+    glm::mat4 rotation_mat = glm::mat4(rotation);
+    glm::mat4 scale_mat = glm::scale(glm::mat4(1.0f), scale);
+
+    return translation_mat * rotation_mat * scale_mat;
+}
+
+static void sampleReferenceNode(const aiNode* node, const glm::mat4& parentGlobal, const Action& action, double time,
+                                std::unordered_map<std::string, glm::mat4>& locals,
+                                std::unordered_map<std::string, glm::mat4>& globals) {
+    glm::mat4 local = sampleReferenceLocal(node, action, time);
+    glm::mat4 global = parentGlobal * local;
+
+    locals[node->mName.C_Str()] = local;
+    globals[node->mName.C_Str()] = global;
+
+    for (unsigned int i = 0; i < node->mNumChildren; ++i) {
+        sampleReferenceNode(node->mChildren[i], global, action, time, locals, globals);
+    }
+}
+
+void sampleReference(const aiNode* root, const Action& action, double time,
+                     std::unordered_map<std::string, glm::mat4>& locals,
+                     std::unordered_map<std::string, glm::mat4>& globals) {
+    if (root != nullptr) {
+        sampleReferenceNode(root, glm::inverse(AiToGlm(root->mTransformation)), action, time, locals, globals);
+    }
+}
+
+float compareWithReference(const Skeleton& skeleton, const Action& action, const aiNode* root, double time) {
+    std::unordered_map<std::string, glm::mat4> reference_globals;
+    std::unordered_map<std::string, glm::mat4> reference_locals;
+    sampleReference(root, action, time, reference_locals, reference_globals);
+    std::vector<glm::mat4> locals(skeleton.size());
+    std::vector<glm::mat4> globals(skeleton.size());
+    sampleSkeleton(skeleton, action, time, locals, globals);
+
+    float max_error = 0.0f;
+    for (size_t joint = 0; joint < skeleton.size(); ++joint) {
+        const auto& name = skeleton.names[joint];
+        // the maps only keep the last of duplicated names
+        if (skeleton.getJointIndex(name) != static_cast<int32_t>(joint) || !reference_globals.contains(name)) {
+            continue;
+        }
+        for (int c = 0; c < 4; ++c) {
+            for (int r = 0; r < 4; ++r) {
+                max_error = std::max(max_error, std::abs(reference_globals[name][c][r] - globals[joint][c][r]));
+                max_error = std::max(max_error, std::abs(reference_locals[name][c][r] - locals[joint][c][r]));
+            }
+        }
+    }
+    return max_error;
+}
+
+void compileAction(const Skeleton& skeleton, Action& action) {
+    auto& compiled = action.compiled;
+    if (compiled.skeleton == &skeleton) {
+        return;
+    }
+    compiled = {};
+    compiled.skeleton = &skeleton;
+
+    size_t joint_count = skeleton.size();
+    compiled.translations.ranges.resize(joint_count);
+    compiled.rotations.ranges.resize(joint_count);
+    compiled.scales.ranges.resize(joint_count);
+    compiled.translations.cursors.resize(joint_count, 0);
+    compiled.rotations.cursors.resize(joint_count, 0);
+    compiled.scales.cursors.resize(joint_count, 0);
+    compiled.animated.resize(joint_count, 0);
+    compiled.sources.resize(joint_count, &action);
+
+    for (size_t joint = 0; joint < joint_count; ++joint) {
+        const auto& name = skeleton.names[joint];
+        auto mixed = action.MixedActions.find(name);
+        if (mixed != action.MixedActions.end() && mixed->second != nullptr) {
+            compileAction(skeleton, *mixed->second);
+            compiled.sources[joint] = mixed->second;
+        }
+
+        auto it = action.Bonemap.find(name);
+        if (it == action.Bonemap.end()) {
+            continue;
+        }
+        const Bone* bone = it->second;
+        compiled.animated[joint] = 1;
+        appendKeys(compiled.translations, joint, bone->channel.translations);
+        appendKeys(compiled.rotations, joint, bone->channel.quats);
+        appendKeys(compiled.scales, joint, bone->channel.scales);
+    }
+
+    for (const auto& [bone_name, bone] : action.Bonemap) {
+        int32_t joint = skeleton.getJointIndex(bone_name);
+        if (joint >= 0) {
+            compiled.skin.push_back({joint, bone->id, bone->offsetMatrix});
+        }
+    }
+}
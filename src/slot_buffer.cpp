@@ -0,0 +1,95 @@
+#include "slot_buffer.h"
+
+#include <cstring>
+#include <format>
+
+#include "profiling.h"
+
+bool SlotBuffer::Slot::isValid() const { return page != UINT32_MAX; }
+
+SlotBuffer& SlotBuffer::setLabel(const std::string& label) {
+    mLabel = label;
+    return *this;
+}
+
+void SlotBuffer::create(RendererResource* resource, uint64_t elementSize, uint32_t slotsPerPage) {
+    mResources = resource;
+    mElementSize = elementSize;
+    mStride = (elementSize + UNIFORM_OFFSET_ALIGNMENT - 1) / UNIFORM_OFFSET_ALIGNMENT * UNIFORM_OFFSET_ALIGNMENT;
+    mSlotsPerPage = slotsPerPage;
+}
+
+SlotBuffer::Slot SlotBuffer::allocate() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (uint32_t page_index = 0; page_index < mPages.size(); ++page_index) {
+        auto& page = *mPages[page_index];
+        if (!page.freeSlots.empty()) {
+            uint32_t index = page.freeSlots.back();
+            page.freeSlots.pop_back();
+            return {page_index, index};
+        }
+        if (page.used < mSlotsPerPage) {
+            return {page_index, page.used++};
+        }
+    }
+
+    auto page = std::make_unique<Page>();
+    page->buffer.setLabel(std::format("{} page {}", mLabel, mPages.size()))
+        .setUsage(WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform)
+        .setSize(mStride * mSlotsPerPage)
+        .setMappedAtCraetion(false)
+        .create(mResources);
+    page->data.resize(mStride * mSlotsPerPage, 0);
+    page->used = 1;
+    mPages.push_back(std::move(page));
+    return {static_cast<uint32_t>(mPages.size() - 1), 0};
+}
+
+void SlotBuffer::free(Slot& slot) {
+    if (!slot.isValid()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPages[slot.page]->freeSlots.push_back(slot.index);
+    slot = {};
+}
+
+void SlotBuffer::write(const Slot& slot, const void* data, size_t size, uint64_t offset) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& page = *mPages[slot.page];
+    std::memcpy(page.data.data() + slot.index * mStride + offset, data, size);
+    page.dirty.mark(slot.index);
+    mPendingWrites++;
+}
+
+void SlotBuffer::flush() {
+    ZoneScopedN("Slot buffer flush");
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats = {};
+    mStats.slotWrites = mPendingWrites;
+    mPendingWrites = 0;
+    for (auto& page : mPages) {
+        if (page->dirty.empty()) {
+            continue;
+        }
+        page->dirty.takeRanges(mRanges);
+        for (const auto& range : mRanges) {
+            uint64_t offset = range.begin * mStride;
+            uint64_t size = (range.end - range.begin) * mStride;
+            page->buffer.queueWrite(offset, page->data.data() + offset, size);
+            mStats.queueWrites++;
+            mStats.bytes += size;
+        }
+    }
+}
+
+WGPUBuffer SlotBuffer::getBuffer(const Slot& slot) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPages[slot.page]->buffer.getBuffer();
+}
+
+uint64_t SlotBuffer::getOffset(const Slot& slot) const { return slot.index * mStride; }
+
+uint64_t SlotBuffer::getElementSize() const { return mElementSize; }
+
+const SlotBuffer::Stats& SlotBuffer::getStats() const { return mStats; }
@@ -192,34 +192,30 @@ Model& TerrainModel::load(std::string name, Application* app, const std::filesys
     return *this;
 }
 
-void TerrainModel::update(Application* app, float dt, float physicSimulating) {
+void TerrainModel::updateState(Application* app, float dt, float physicSimulating) {
+    (void)app;
+    (void)dt;
+    (void)physicSimulating;
+}
+
+void TerrainModel::writeBuffers(Application* app) {
     if (mTransform.mDirty) {
 #ifdef WIREFRAME_ENABLED
         wireFrame.updateTransformation(mTransform.mTransformMatrix);
 #endif
-        Drawable::getUniformBuffer().queueWrite(0, &mTransform.mObjectInfo, sizeof(ObjectInfo));
-        // wgpuQueueWriteBuffer(app->getRendererResource().queue, Drawable::getUniformBuffer().getBuffer(), 0,
-        //                      &mTransform.mObjectInfo, sizeof(ObjectInfo));
+        Drawable::writeObjectInfo(&mTransform.mObjectInfo, sizeof(ObjectInfo));
         for (auto& [id, mesh] : mFlattenMeshes) {
-            mesh.mMaterialBuffer.queueWrite(0, &mesh.mMaterial, sizeof(ShaderMaterial));
-            // wgpuQueueWriteBuffer(app->getRendererResource().queue, mesh.mMaterialBuffer.getBuffer(), 0,
-            // &mesh.mMaterial,
-            //                      sizeof(ShaderMaterial));
+            app->mMaterials.writeMaterial(mesh.mMaterialIndex, mesh.mMaterial);
         }
         mTransform.mDirty = false;
     }
 }
 
-void TerrainModel::getCustomBindGroup(Application* app, WGPURenderPassEncoder encoder, Mesh& mesh) {
-    wgpuRenderPassEncoderSetBindGroup(encoder, 0, app->getBindingGroup().getBindGroup(), 0, nullptr);
-
-    wgpuRenderPassEncoderSetBindGroup(encoder, 1, getObjectInfoBindGroup(), 0, nullptr);
-    wgpuRenderPassEncoderSetBindGroup(
-        encoder, 2,
-        mesh.mTextureBindGroup == nullptr ? app->mDefaultTextureBindingGroup.getBindGroup() : mesh.mTextureBindGroup, 0,
-        nullptr);
-
-    wgpuRenderPassEncoderSetBindGroup(encoder, 6, custom_bindgroup.getBindGroup(), 0, nullptr);
+const MaterialTable::Binding& TerrainModel::getMaterialBinding(Application* app, Mesh& mesh) {
+    (void)app;
+    (void)mesh;
+    mMaterialBinding.group = custom_bindgroup.getBindGroup();
+    return mMaterialBinding;
 }
 
 struct TTerrain : public IModel {
@@ -367,11 +363,11 @@ Model& Cube::load(std::string name, Application* app, const std::filesystem::pat
     return *this;
 }
 
-void Cube::update(Application* app, float dt, float physicSimulating) {
+void Cube::writeBuffers(Application* app) {
 #ifdef WIREFRAME_ENABLED
     wireFrame.updateTransformation(mTransform.mTransformMatrix);
 #endif
-    Model::update(app, dt, physicSimulating);
+    Model::writeBuffers(app);
     // if (mTransform.mDirty) {
     //     Drawable::getUniformBuffer().queueWrite(0, &mTransform.mObjectInfo, sizeof(ObjectInfo));
     //     for (auto& [id, mesh] : mFlattenMeshes) {
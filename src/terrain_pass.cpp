@@ -7,6 +7,7 @@
 #include <filesystem>
 
 #include "application.h"
+#include "geometry_arena.h"
 #include "profiling.h"
 #include "rendererResource.h"
 #include "renderpass.h"
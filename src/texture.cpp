@@ -2,7 +2,9 @@
 
 #include <webgpu/webgpu.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <format>
 #include <functional>
@@ -11,10 +13,13 @@
 
 #include "application.h"
 #include "glm/exponential.hpp"
+#include "ktx2.h"
+#include "mip_chain.h"
 #include "model.h"
+#include "pipeline_cache.h"
 #include "profiling.h"
 #include "rendererResource.h"
-#include "shader.h"
+#include "texture_residency.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -29,10 +34,42 @@ void loaderCallback(TextureLoader* loader, TextureLoader::LoadRequest* request)
     // request->baseTexture->uploadToGPU(request->queue);
     // request->promise.set_value(request->baseTexture);
 }
+
+
+WGPUTextureFormat toTextureFormat(bc::Format format) {
+    switch (format) {
+        case bc::Format::BC1:
+            return WGPUTextureFormat_BC1RGBAUnorm;
+        case bc::Format::BC3:
+            return WGPUTextureFormat_BC3RGBAUnorm;
+        case bc::Format::BC4:
+            return WGPUTextureFormat_BC4RUnorm;
+        case bc::Format::BC5:
+            return WGPUTextureFormat_BC5RGUnorm;
+        case bc::Format::BC7:
+            return WGPUTextureFormat_BC7RGBAUnorm;
+    }
+    return WGPUTextureFormat_RGBA8Unorm;
+}
+
+// textures whose level 0 was uploaded and that wait for their mips
+struct PendingMipmaps {
+        Texture* texture;
+        uint32_t mipLevelCount;
+        uint32_t layerCount;
+};
+
+struct {
+        WGPUComputePipeline computePipeline;
+        BindingGroup bindGroup;  // layout shared by every level
+        std::vector<PendingMipmaps> pending;
+} mipmap_compute;
+
 }  // namespace
 
 std::shared_ptr<Texture> Texture::asyncLoadTexture(Registery<std::string, Texture>* registery, RendererResource& rc,
-                                                   std::string path, const std::string& name) {
+                                                   std::string path, const std::string& name, bool streamed,
+                                                   bool srgb) {
     if (no_texture) {
         auto default_normal = registery->get("default normal");
         if (default_normal) {
@@ -44,8 +81,10 @@ std::shared_ptr<Texture> Texture::asyncLoadTexture(Registery<std::string, Textur
         return cached;
     }
 
-    auto texture = std::make_shared<Texture>(rc.device, path);  // reads file here
+    auto texture = std::make_shared<Texture>(rc.device, path, WGPUTextureFormat_RGBA8Unorm, 1, 0,
+                                             streamed);  // reads file here
     texture->setName(name);
+    texture->mIsSrgb = srgb;
 
     // queue async load
     auto future = registery->mLoader.loadAsync(path, rc.queue, texture, loaderCallback);
@@ -206,6 +245,17 @@ Texture::Texture(WGPUDevice wgpuDevice, uint32_t width, uint32_t height, Texture
 }
 
 void Texture::writeBaseTexture(const std::filesystem::path& path, uint32_t extent) {
+    if (mIsStreamed && !mCompressedPath.empty()) {
+        if (loadCompressedMips()) {
+            return;
+        }
+        if (mBlockFormat.has_value()) {
+            std::cout << "failed to read " << mCompressedPath << ", the texture stays empty" << std::endl;
+            return;
+        }
+        // the texture is RGBA8, the source image still works
+    }
+
     int width, height, channels;
     width = height = channels = 0;
     unsigned char* pixel_data = stbi_load(path.string().c_str(), &width, &height, &channels, 0);
@@ -237,10 +287,50 @@ void Texture::writeBaseTexture(const std::filesystem::path& path, uint32_t exten
     }
 
     stbi_image_free(pixel_data);
+
+    // the chain is built here, on the loader threads, and uploaded as it is
+    if (mIsStreamed) {
+        mMipData = buildMipChainRGBA8(std::move(mBufferData[0]), width, height, mMipFilter, mIsSrgb);
+        mBufferData[0].clear();
+    } else if (mDescriptor.mipLevelCount > 1 && mBufferData.size() == 1 &&
+               mDescriptor.format == WGPUTextureFormat_RGBA8Unorm) {
+        mMipData = buildMipChainRGBA8(std::move(mBufferData[0]), width, height, mMipFilter, mIsSrgb,
+                                      mDescriptor.mipLevelCount);
+        mBufferData[0].clear();
+    }
+}
+
+bool Texture::loadCompressedMips() {
+    ktx2::Image image;
+    if (!ktx2::read(mCompressedPath, image) || image.levelCount != mFullMipCount) {
+        return false;
+    }
+    auto format = ktx2::toBlockFormat(image.vkFormat);
+    if (mBlockFormat.has_value() || !format.has_value()) {
+        mMipData = std::move(image.levels);
+    } else {
+        mMipData.resize(image.levelCount);
+        for (uint32_t level = 0; level < image.levelCount; ++level) {
+            uint32_t width = std::max(1u, image.width >> level);
+            uint32_t height = std::max(1u, image.height >> level);
+            if (!bc::decode(*format, image.levels[level].data(), width, height, mMipData[level])) {
+                std::cout << "Unsupported blocks in level " << level << " of " << mCompressedPath << std::endl;
+            }
+        }
+    }
+
+    if (format.has_value()) {
+        mHasAlphaChannel = format == bc::Format::BC3;
+    } else {
+        for (size_t i = 3; i < mMipData[0].size() && !mHasAlphaChannel; i += 4) {
+            mHasAlphaChannel = mMipData[0][i] < 255;
+        }
+    }
+    return true;
 }
 
 Texture::Texture(WGPUDevice wgpuDevice, const std::filesystem::path& path, WGPUTextureFormat textureFormat,
-                 uint32_t extent, size_t mipLevels) {
+                 uint32_t extent, size_t mipLevels, bool streamed) {
     mBufferData.reserve(extent);
     mBufferData.resize(extent);
 
@@ -272,6 +362,37 @@ Texture::Texture(WGPUDevice wgpuDevice, const std::filesystem::path& path, WGPUT
     mDescriptor.viewFormatCount = 0;
     mDescriptor.viewFormats = nullptr;
 
+    // only the mip tail is allocated, the streamer grows the texture later. Mips are built on the CPU
+    mIsStreamed = streamed && extent == 1;
+    if (mIsStreamed) {
+        mFullMipCount = TextureResidency::mipCount(width, height);
+        mFirstResidentMip = TextureResidency::tailMip(width, height);
+        mDescriptor.size = {std::max(1u, (uint32_t)width >> mFirstResidentMip),
+                            std::max(1u, (uint32_t)height >> mFirstResidentMip), 1};
+        mDescriptor.mipLevelCount = mFullMipCount - mFirstResidentMip;
+        mDescriptor.usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst | WGPUTextureUsage_CopySrc;
+
+        // a baked KTX2 replaces decoding and filtering the source. Its blocks are uploaded as they are when every
+        // level the streamer may allocate the texture from is a whole number of blocks
+        mCompressedPath = ktx2::findCompressedTexture(path);
+        ktx2::Image header;
+        if (!mCompressedPath.empty()) {
+            if (!ktx2::read(mCompressedPath, header, true) || header.width != (uint32_t)width ||
+                header.height != (uint32_t)height || header.levelCount != mFullMipCount) {
+                std::cout << "Ignoring " << mCompressedPath << ", it does not match " << path << std::endl;
+                mCompressedPath.clear();
+            } else {
+                auto block_format = ktx2::toBlockFormat(header.vkFormat);
+                uint32_t alignment = bc::BLOCK_SIZE << mFirstResidentMip;
+                if (block_format.has_value() && mBlockCompressionSupported && width % alignment == 0 &&
+                    height % alignment == 0) {
+                    mBlockFormat = block_format;
+                    mDescriptor.format = toTextureFormat(*block_format);
+                }
+            }
+        }
+    }
+
     mTexture = wgpuDeviceCreateTexture(wgpuDevice, &mDescriptor);
     mIsTextureAlive = true;
 }
@@ -353,7 +474,32 @@ Texture::Texture(WGPUDevice wgpuDevice, std::vector<std::filesystem::path> paths
     }
 }
 
+// levels that left the GPU, copied to `buffer` rows padded to 256 bytes
+struct Texture::MipReadback {
+        struct Level {
+                uint32_t level;
+                uint64_t offset;
+                uint32_t bytesPerRow;
+                uint32_t rowBytes;
+                uint32_t rows;
+        };
+        Texture* texture;  // null once the texture is gone, the callback only frees the buffer then
+        WGPUBuffer buffer = nullptr;
+        uint64_t size = 0;
+        std::vector<Level> levels;
+        bool mapping = false;
+};
+
 Texture::~Texture() {
+    std::erase_if(mipmap_compute.pending, [this](const PendingMipmaps& pending) { return pending.texture == this; });
+    for (auto* readback : mReadbacks) {
+        if (readback->mapping) {
+            readback->texture = nullptr;
+        } else {
+            wgpuBufferRelease(readback->buffer);
+            delete readback;
+        }
+    }
     // if (mTexture != nullptr) {
     //     wgpuTextureDestroy(mTexture);
     // }
@@ -379,31 +525,17 @@ std::vector<uint8_t>& Texture::getBuffer(size_t level) { return mBufferData[leve
 
 bool Texture::isTransparent() { return mHasAlphaChannel; }
 
-struct {
-        WGPUComputePipeline computePipeline;
-} mipmap_compute;
-
 Application* app;
 
 void initializeMipmapCompute(Application* app) {
     ::app = app;
     auto& rc = app->getRendererResource();
 
-    auto source =
-        readFile((app->getBinaryPathAbsolute() / ".." / "resources" / "shaders" / "mipmap.wgsl").string().c_str());
-    // WGPUShaderModule shader_module =
-    WGPUShaderSourceWGSL shader_wgsl_desc = {};
-    shader_wgsl_desc.chain.next = nullptr;
-    shader_wgsl_desc.chain.sType = WGPUSType_ShaderSourceWGSL;
-    shader_wgsl_desc.code = {source.c_str(), strlen(source.c_str())};
-    WGPUShaderModuleDescriptor shader_module_desc = {};
-    shader_module_desc.nextInChain = &shader_wgsl_desc.chain;
-    shader_module_desc.label = {"mipmap shader", WGPU_STRLEN};
-    WGPUShaderModule shader_module = wgpuDeviceCreateShaderModule(rc.device, &shader_module_desc);
-
-    BindingGroup bind_group;
+    WGPUShaderModule shader_module =
+        rc.pipelines->getShaderModule(app->getBinaryPathAbsolute() / ".." / "resources" / "shaders" / "mipmap.wgsl");
+
     WGPUBindGroupLayout bind_group_layout =
-        bind_group
+        mipmap_compute.bindGroup
             .addTexture(0, BindGroupEntryVisibility::COMPUTE, TextureSampleType::FLAOT, TextureViewDimension::VIEW_2D)
             .addStorageTexture(1, BindGroupEntryVisibility::COMPUTE, StorageTextureAccessMode::WRITE_ONLY,
                                TextureViewDimension::VIEW_2D)
@@ -414,135 +546,93 @@ void initializeMipmapCompute(Application* app) {
     pipeline_layout_desc.label = {"mipmap compute", WGPU_STRLEN};
     pipeline_layout_desc.bindGroupLayoutCount = 1;
     pipeline_layout_desc.bindGroupLayouts = bind_group_layouts;
-    WGPUPipelineLayout pipeline_layout = wgpuDeviceCreatePipelineLayout(rc.device, &pipeline_layout_desc);
+    WGPUPipelineLayout pipeline_layout = rc.pipelines->getPipelineLayout(pipeline_layout_desc);
 
     WGPUComputePipelineDescriptor compute_pipeline_desc = {};
     compute_pipeline_desc.label = {"Simple Compute Pipeline2", WGPU_STRLEN};
     compute_pipeline_desc.layout = pipeline_layout;
     compute_pipeline_desc.compute.module = shader_module;
     compute_pipeline_desc.compute.entryPoint = {"computeMip", WGPU_STRLEN};  // Matches `fn main` in WGSL
-    mipmap_compute.computePipeline = wgpuDeviceCreateComputePipeline(rc.device, &compute_pipeline_desc);
+    mipmap_compute.computePipeline = rc.pipelines->getComputePipeline(compute_pipeline_desc);
 }
 
-void generateMipmapCompute(Texture* texture, size_t mipLevel, uint32_t layerCount) {
-    auto& rc = app->getRendererResource();
-    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(rc.device, nullptr);
-
-    auto [width, height] = texture->getTextureSize();
-    for (uint32_t layer = 0; layer < layerCount; ++layer) {
-        for (uint8_t lvl = 1; lvl < mipLevel; ++lvl) {
-            // std::cout << "mip level " << ((size_t)lvl) << " for " << texture->getName() << " : " <<
-            // texture->getPath()
-            //           << std::endl;
-            uint8_t src_mip = lvl - 1;
-            uint8_t dst_mip = lvl;
-
-            // WGPUTextureViewDescriptor src_desc = {};
-            // src_desc.label = {"src mip", WGPU_STRLEN};
-            auto src_view = texture->createView(layer, 1, src_mip, 1);
-            auto dst_view = texture->createView(layer, 1, dst_mip, 1);
-
-            std::vector<WGPUBindGroupEntry> entries(2);
-
-            entries[0].nextInChain = nullptr;
-            entries[0].binding = 0;
-            entries[0].textureView = src_view;
-
-            entries[1].nextInChain = nullptr;
-            entries[1].binding = 1;
-            entries[1].textureView = dst_view;
-
-            BindingGroup bind_group;
-
-            bind_group
-                .addTexture(0, BindGroupEntryVisibility::COMPUTE, TextureSampleType::FLAOT,
-                            TextureViewDimension::VIEW_2D)
-                .addStorageTexture(1, BindGroupEntryVisibility::COMPUTE, StorageTextureAccessMode::WRITE_ONLY,
-                                   TextureViewDimension::VIEW_2D)
-                .createLayout(rc, "mip");
-            bind_group.create(app->getRendererResource(), entries);
-
-            uint32_t dstWidth = std::max(1u, (uint32_t)width >> lvl);
-            uint32_t dstHeight = std::max(1u, (uint32_t)height >> lvl);
-
-            uint32_t workgroup_size_x = (dstWidth + 7) / 8;  // ceil division for workgroup size 8
-            uint32_t workgroup_size_y = (dstHeight + 7) / 8;
-
-            WGPUComputePassDescriptor compute_pass_desc = {};
-            // std::string compute_name = "mip map";
-            compute_pass_desc.label = {"mip map", WGPU_STRLEN};
-            compute_pass_desc.nextInChain = nullptr;
-
-            WGPUComputePassEncoder compute_pass_encoder =
-                wgpuCommandEncoderBeginComputePass(encoder, &compute_pass_desc);
-
-            // Set the pipeline and bind group for the compute pass
-            wgpuComputePassEncoderSetPipeline(compute_pass_encoder, mipmap_compute.computePipeline);
-            wgpuComputePassEncoderSetBindGroup(compute_pass_encoder, 0, bind_group.getBindGroup(), 0,
-                                               nullptr);  // Group 0, no dynamic offsets
-
-            wgpuComputePassEncoderDispatchWorkgroups(compute_pass_encoder, workgroup_size_x, workgroup_size_y, 1);
-            wgpuComputePassEncoderEnd(compute_pass_encoder);
-            wgpuComputePassEncoderRelease(compute_pass_encoder);
-
-            wgpuBindGroupRelease(bind_group.getBindGroup());
-            wgpuTextureViewRelease(src_view);
-            wgpuTextureViewRelease(dst_view);
-        }
+void generatePendingMipmaps(WGPUCommandEncoder encoder) {
+    if (mipmap_compute.pending.empty()) {
+        return;
     }
+    ZoneScopedN("Mipmap compute");
+    auto& rc = app->getRendererResource();
 
-    WGPUCommandBuffer commandBuffer = wgpuCommandEncoderFinish(encoder, nullptr);
-    wgpuQueueSubmit(app->getRendererResource().queue, 1, &commandBuffer);
-
-    // Release resources
-    wgpuCommandBufferRelease(commandBuffer);
-    wgpuCommandEncoderRelease(encoder);
-}
-
-void generateMipMaps(WGPUTexelCopyBufferLayout& source, WGPUTexelCopyTextureInfo& destination,
-                     WGPUTextureDescriptor& descriptor, std::vector<std::vector<uint8_t>>& buffer, uint32_t layer,
-                     WGPUQueue queue) {
-    // generate and upload other levels
-    WGPUExtent3D mip_level_size = descriptor.size;
-    std::vector<uint8_t> previous_level_pixels = buffer[layer];
-    WGPUExtent3D prev_mip_level_size = descriptor.size;
-    prev_mip_level_size.depthOrArrayLayers = 1;
-    for (uint32_t level = 1; level < descriptor.mipLevelCount; ++level) {
-        prev_mip_level_size = mip_level_size;
-        prev_mip_level_size.depthOrArrayLayers = 1;
-        mip_level_size.height /= 2;
-        mip_level_size.width /= 2;
-        mip_level_size.depthOrArrayLayers = 1;
-        std::vector<uint8_t> pixels(4 * mip_level_size.width * mip_level_size.height);
-
-        for (uint32_t i = 0; i < mip_level_size.width; ++i) {
-            for (uint32_t j = 0; j < mip_level_size.height; ++j) {
-                uint8_t* p = &pixels[4 * (j * mip_level_size.width + i)];
-
-                // Get the corresponding 4 pixels from the previous level
-                uint8_t* p00 = &previous_level_pixels[4 * ((2 * j + 0) * prev_mip_level_size.width + (2 * i + 0))];
-                uint8_t* p01 = &previous_level_pixels[4 * ((2 * j + 0) * prev_mip_level_size.width + (2 * i + 1))];
-                uint8_t* p10 = &previous_level_pixels[4 * ((2 * j + 1) * prev_mip_level_size.width + (2 * i + 0))];
-                uint8_t* p11 = &previous_level_pixels[4 * ((2 * j + 1) * prev_mip_level_size.width + (2 * i + 1))];
-                // Average
-                for (int c = 0; c < 4; ++c) {
-                    p[c] = (p00[c] + p01[c] + p10[c] + p11[c] + 2) >> 2;
-                }
+    // a compute pass synchronizes every dispatch, a level is written before the next one reads it
+    WGPUComputePassDescriptor compute_pass_desc = {};
+    compute_pass_desc.label = {"mip map", WGPU_STRLEN};
+    WGPUComputePassEncoder compute_pass_encoder = wgpuCommandEncoderBeginComputePass(encoder, &compute_pass_desc);
+    wgpuComputePassEncoderSetPipeline(compute_pass_encoder, mipmap_compute.computePipeline);
+
+    std::vector<WGPUBindGroup> bind_groups;
+    std::vector<WGPUTextureView> views;
+    for (const auto& pending : mipmap_compute.pending) {
+        auto [width, height] = pending.texture->getTextureSize();
+        for (uint32_t layer = 0; layer < pending.layerCount; ++layer) {
+            for (uint32_t level = 1; level < pending.mipLevelCount; ++level) {
+                auto src_view = pending.texture->createView(layer, 1, level - 1, 1);
+                auto dst_view = pending.texture->createView(layer, 1, level, 1);
+
+                std::vector<WGPUBindGroupEntry> entries(2);
+                entries[0].nextInChain = nullptr;
+                entries[0].binding = 0;
+                entries[0].textureView = src_view;
+                entries[1].nextInChain = nullptr;
+                entries[1].binding = 1;
+                entries[1].textureView = dst_view;
+                WGPUBindGroup bind_group = mipmap_compute.bindGroup.createNew(rc, entries);
+
+                uint32_t dst_width = std::max(1u, (uint32_t)width >> level);
+                uint32_t dst_height = std::max(1u, (uint32_t)height >> level);
+                wgpuComputePassEncoderSetBindGroup(compute_pass_encoder, 0, bind_group, 0, nullptr);
+                wgpuComputePassEncoderDispatchWorkgroups(compute_pass_encoder, (dst_width + 7) / 8,
+                                                         (dst_height + 7) / 8, 1);
+
+                bind_groups.push_back(bind_group);
+                views.push_back(src_view);
+                views.push_back(dst_view);
             }
         }
+    }
+    wgpuComputePassEncoderEnd(compute_pass_encoder);
+    wgpuComputePassEncoderRelease(compute_pass_encoder);
 
-        destination.mipLevel = level;
-        source.bytesPerRow = 4 * mip_level_size.width;
-        source.rowsPerImage = mip_level_size.height;
-        wgpuQueueWriteTexture(queue, &destination, pixels.data(), pixels.size(), &source, &mip_level_size);
-        previous_level_pixels = std::move(pixels);
+    // the encoder keeps what it references alive until it is done with it
+    for (auto bind_group : bind_groups) {
+        wgpuBindGroupRelease(bind_group);
+    }
+    for (auto view : views) {
+        wgpuTextureViewRelease(view);
     }
+    mipmap_compute.pending.clear();
 }
 
 bool Texture::isValid() const { return mIsTextureAlive; }
 
 void Texture::uploadToGPU(WGPUQueue deviceQueue) {
     if (!mIsTextureAlive) return;
+    if (mIsStreamed) {
+        if (mMipData.empty()) return;
+        // the resident levels only live on the GPU from now on
+        for (uint32_t level = mFirstResidentMip; level < mFullMipCount; ++level) {
+            writeMip(deviceQueue, level);
+            std::vector<uint8_t>().swap(mMipData[level]);
+        }
+        mIsStreamReady = true;
+        return;
+    }
+    if (!mMipData.empty()) {
+        for (uint32_t level = 0; level < mMipData.size(); ++level) {
+            writeMip(deviceQueue, level);
+        }
+        return;
+    }
+    bool uploaded = false;
     for (uint32_t layer = 0; layer < mDescriptor.size.depthOrArrayLayers; ++layer) {
         WGPUTexelCopyTextureInfo destination;
         destination.texture = mTexture;
@@ -560,13 +650,199 @@ void Texture::uploadToGPU(WGPUQueue deviceQueue) {
         if (mBufferData[layer].size() != 0) {
             wgpuQueueWriteTexture(deviceQueue, &destination, mBufferData[layer].data(), mBufferData[layer].size(),
                                   &source, &tmp_size);
+            uploaded = true;
+        }
+    }
+    // level 0 came without a CPU chain, the GPU filters the rest with the next frame
+    if (uploaded && mDescriptor.mipLevelCount > 1) {
+        if (mDescriptor.format != WGPUTextureFormat_RGBA8Unorm) {
+            std::cout << "No mipmaps for " << mPath << ", only RGBA8 textures are filtered on the GPU" << std::endl;
+            return;
+        }
+        mipmap_compute.pending.push_back({this, mDescriptor.mipLevelCount, mDescriptor.size.depthOrArrayLayers});
+    }
+}
+
+size_t Texture::getUploadSize() const {
+    size_t size = 0;
+    if (mIsStreamed || !mMipData.empty()) {
+        for (uint32_t level = mFirstResidentMip; level < mMipData.size(); ++level) {
+            size += mMipData[level].size();
+        }
+        return size;
+    }
+    for (const auto& layer : mBufferData) {
+        size += layer.size();
+    }
+    return size;
+}
+
+bool Texture::isStreamed() const { return mIsStreamed; }
+
+bool Texture::isStreamReady() const { return mIsStreamReady; }
+
+bool Texture::canStreamIn() const { return mReadbacks.empty() && !mLostMips; }
+
+uint32_t Texture::getViewVersion() const { return mViewVersion; }
+
+uint32_t Texture::getFullMipCount() const { return mFullMipCount; }
+
+uint32_t Texture::getFirstResidentMip() const { return mFirstResidentMip; }
+
+uint32_t Texture::getBlockBytes() const { return mBlockFormat.has_value() ? bc::blockBytes(*mBlockFormat) : 4; }
+
+uint32_t Texture::getBlockSize() const { return mBlockFormat.has_value() ? bc::BLOCK_SIZE : 1; }
+
+WGPUExtent3D Texture::levelExtent(uint32_t level) const {
+    uint32_t block_size = getBlockSize();
+    uint32_t width = std::max(1u, (uint32_t)mWidth >> level);
+    uint32_t height = std::max(1u, (uint32_t)mHeight >> level);
+    return {(width + block_size - 1) / block_size * block_size, (height + block_size - 1) / block_size * block_size,
+            1};
+}
+
+void Texture::writeMip(WGPUQueue queue, uint32_t level) {
+    WGPUTexelCopyTextureInfo destination = {};
+    destination.texture = mTexture;
+    destination.mipLevel = level - mFirstResidentMip;
+    destination.origin = {0, 0, 0};
+    destination.aspect = WGPUTextureAspect_All;
+
+    WGPUExtent3D size = levelExtent(level);
+    WGPUTexelCopyBufferLayout source = {};
+    source.offset = 0;
+    source.bytesPerRow = size.width / getBlockSize() * getBlockBytes();
+    source.rowsPerImage = size.height / getBlockSize();
+    wgpuQueueWriteTexture(queue, &destination, mMipData[level].data(), mMipData[level].size(), &source, &size);
+}
 
-            // generateMipMaps(source, destination, mDescriptor, mBufferData, layer, deviceQueue);
-            generateMipmapCompute(this, mDescriptor.mipLevelCount, mDescriptor.size.depthOrArrayLayers);
+void Texture::setResidentMip(WGPUDevice device, WGPUQueue queue, WGPUCommandEncoder encoder, uint32_t firstMip) {
+    firstMip = std::min(firstMip, mFullMipCount - 1);
+    if (!mIsStreamed || !mIsStreamReady || firstMip == mFirstResidentMip) {
+        return;
+    }
+
+    WGPUTextureDescriptor descriptor = mDescriptor;
+    descriptor.label = {"streamed texture", WGPU_STRLEN};
+    descriptor.size = {std::max(1u, (uint32_t)mWidth >> firstMip), std::max(1u, (uint32_t)mHeight >> firstMip), 1};
+    descriptor.mipLevelCount = mFullMipCount - firstMip;
+    WGPUTexture texture = wgpuDeviceCreateTexture(device, &descriptor);
+
+    // levels both textures have move over on the GPU
+    for (uint32_t level = std::max(firstMip, mFirstResidentMip); level < mFullMipCount; ++level) {
+        WGPUTexelCopyTextureInfo source = {};
+        source.texture = mTexture;
+        source.mipLevel = level - mFirstResidentMip;
+        source.aspect = WGPUTextureAspect_All;
+
+        WGPUTexelCopyTextureInfo destination = {};
+        destination.texture = texture;
+        destination.mipLevel = level - firstMip;
+        destination.aspect = WGPUTextureAspect_All;
+
+        WGPUExtent3D size = levelExtent(level);
+        wgpuCommandEncoderCopyTextureToTexture(encoder, &source, &destination, &size);
+    }
+
+    // evicted levels go back to the CPU chain, so they can stream in again
+    if (firstMip > mFirstResidentMip) {
+        auto* readback = new MipReadback{this};
+        for (uint32_t level = mFirstResidentMip; level < firstMip; ++level) {
+            WGPUExtent3D size = levelExtent(level);
+            uint32_t row_bytes = size.width / getBlockSize() * getBlockBytes();
+            uint32_t rows = size.height / getBlockSize();
+            uint32_t bytes_per_row = (row_bytes + 255) & ~255u;
+            readback->levels.push_back({level, readback->size, bytes_per_row, row_bytes, rows});
+            readback->size += static_cast<uint64_t>(bytes_per_row) * rows;
+        }
+        WGPUBufferDescriptor buffer_desc = {};
+        buffer_desc.label = {"evicted mips read back", WGPU_STRLEN};
+        buffer_desc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead;
+        buffer_desc.size = readback->size;
+        readback->buffer = wgpuDeviceCreateBuffer(device, &buffer_desc);
+
+        for (const auto& level : readback->levels) {
+            WGPUTexelCopyTextureInfo source = {};
+            source.texture = mTexture;
+            source.mipLevel = level.level - mFirstResidentMip;
+            source.aspect = WGPUTextureAspect_All;
+
+            WGPUTexelCopyBufferInfo destination = {};
+            destination.buffer = readback->buffer;
+            destination.layout.offset = level.offset;
+            destination.layout.bytesPerRow = level.bytesPerRow;
+            destination.layout.rowsPerImage = level.rows;
+
+            WGPUExtent3D size = levelExtent(level.level);
+            wgpuCommandEncoderCopyTextureToBuffer(encoder, &source, &destination, &size);
+        }
+        mReadbacks.push_back(readback);
+    }
+
+    // released, not destroyed: the copies above and the bind groups still in flight keep the old one alive
+    uint32_t old_first_mip = mFirstResidentMip;
+    if (mTextureView != nullptr) {
+        wgpuTextureViewRelease(mTextureView);
+        mTextureView = nullptr;
+    }
+    wgpuTextureRelease(mTexture);
+    mTexture = texture;
+    mDescriptor = descriptor;
+    mFirstResidentMip = firstMip;
+
+    for (uint32_t level = firstMip; level < old_first_mip; ++level) {
+        writeMip(queue, level);
+        std::vector<uint8_t>().swap(mMipData[level]);
+    }
+    createView();
+    mViewVersion++;
+}
+
+void Texture::mapEvictedMips() {
+    for (auto* readback : mReadbacks) {
+        if (readback->mapping) {
+            continue;
         }
+        readback->mapping = true;
+        // delivered by the device poll of the main thread, like every other use of mMipData
+        WGPUBufferMapCallbackInfo callback_info = {};
+        callback_info.mode = WGPUCallbackMode_AllowProcessEvents;
+        callback_info.callback = onMipsReadBack;
+        callback_info.userdata1 = readback;
+        wgpuBufferMapAsync(readback->buffer, WGPUMapMode_Read, 0, readback->size, callback_info);
     }
 }
 
+void Texture::onMipsReadBack(WGPUMapAsyncStatus status, WGPUStringView message, void* userdata1, void* userdata2) {
+    (void)userdata2;
+    auto* readback = static_cast<MipReadback*>(userdata1);
+    Texture* texture = readback->texture;
+    if (texture != nullptr && status == WGPUMapAsyncStatus_Success) {
+        const auto* data =
+            static_cast<const uint8_t*>(wgpuBufferGetConstMappedRange(readback->buffer, 0, readback->size));
+        for (const auto& level : readback->levels) {
+            auto& mip = texture->mMipData[level.level];
+            mip.resize(static_cast<size_t>(level.rowBytes) * level.rows);
+            for (uint32_t row = 0; row < level.rows; ++row) {
+                std::memcpy(mip.data() + static_cast<size_t>(row) * level.rowBytes,
+                            data + level.offset + static_cast<uint64_t>(row) * level.bytesPerRow, level.rowBytes);
+            }
+        }
+    } else if (texture != nullptr) {
+        std::cout << std::format("Failed to read back the evicted mips of {}: {}\n", texture->mPath.string(),
+                                 std::string{message.data, message.length == WGPU_STRLEN ? 0 : message.length});
+        texture->mLostMips = true;
+    }
+    if (texture != nullptr) {
+        std::erase(texture->mReadbacks, readback);
+    }
+    if (status == WGPUMapAsyncStatus_Success) {
+        wgpuBufferUnmap(readback->buffer);
+    }
+    wgpuBufferRelease(readback->buffer);
+    delete readback;
+}
+
 void Texture::Destroy() {
     // If the Texture is removed from VRAM before, then ignore
     if (mTexture != nullptr && mIsTextureAlive == true) {
@@ -650,16 +926,30 @@ std::future<std::shared_ptr<Texture>> TextureLoader::loadAsync(const std::string
 
 void TextureLoader::addToUploadQueue(TextureLoader::LoadRequest&& request) { uploadQueue.push(std::move(request)); }
 
-void TextureLoader::fetchQueue() {
-    if (uploadQueue.empty()) return;
-    auto req = std::move(uploadQueue.front());
-    uploadQueue.pop();
+void TextureLoader::fetchQueue(size_t budgetBytes) {
+    ZoneScopedN("Texture uploads");
+    size_t uploaded = 0;
+    while (true) {
+        if (!mDeferredUpload.has_value()) {
+            mDeferredUpload = uploadQueue.pop();
+            if (!mDeferredUpload.has_value()) {
+                return;
+            }
+        }
+        size_t size = mDeferredUpload->baseTexture->getUploadSize();
+        if (uploaded > 0 && uploaded + size > budgetBytes) {
+            return;  // stays deferred for the next frame
+        }
+        auto req = std::move(*mDeferredUpload);
+        mDeferredUpload.reset();
 
-    req.baseTexture->uploadToGPU(req.queue);
-    req.promise.set_value(req.baseTexture);
+        req.baseTexture->uploadToGPU(req.queue);
+        req.promise.set_value(req.baseTexture);
+        uploaded += size;
 
-    if (mWaitersList.count(req.baseTexture->getName()) > 0) {
-        mWaitersList[req.baseTexture->getName()] = std::move(req.baseTexture);
+        if (mWaitersList.count(req.baseTexture->getName()) > 0) {
+            mWaitersList[req.baseTexture->getName()] = std::move(req.baseTexture);
+        }
     }
 }
 
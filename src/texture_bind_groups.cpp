@@ -0,0 +1,60 @@
+#include "texture_bind_groups.h"
+
+WGPUBindGroup TextureBindGroups::acquire(WGPUDevice device, WGPUBindGroupLayout layout,
+                                         const std::vector<WGPUBindGroupEntry>& entries) {
+    Views views = {};
+    for (size_t i = 0; i < views.size() && i < entries.size(); ++i) {
+        views[i] = entries[i].textureView;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& entry = mGroups[views];
+    if (entry.group == nullptr) {
+        WGPUBindGroupDescriptor descriptor = {};
+        descriptor.label = WGPUStringView{"mesh texture bind group", WGPU_STRLEN};
+        descriptor.layout = layout;
+        descriptor.entryCount = entries.size();
+        descriptor.entries = entries.data();
+        entry.group = wgpuDeviceCreateBindGroup(device, &descriptor);
+        for (auto view : views) {
+            wgpuTextureViewAddRef(view);
+        }
+        mViews[entry.group] = views;
+    }
+    entry.references++;
+    mReferences++;
+    return entry.group;
+}
+
+void TextureBindGroups::release(WGPUBindGroup& group) {
+    if (group == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto views = mViews.find(group);
+    group = nullptr;
+    if (views == mViews.end()) {
+        return;
+    }
+    auto entry = mGroups.find(views->second);
+    mReferences--;
+    if (--entry->second.references > 0) {
+        return;
+    }
+    wgpuBindGroupRelease(entry->second.group);
+    for (auto view : views->second) {
+        wgpuTextureViewRelease(view);
+    }
+    mGroups.erase(entry);
+    mViews.erase(views);
+}
+
+size_t TextureBindGroups::getCount() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mGroups.size();
+}
+
+size_t TextureBindGroups::getReferenceCount() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mReferences;
+}
@@ -0,0 +1,98 @@
+#include "texture_streamer.h"
+
+#include <webgpu/webgpu.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "application.h"
+#include "camera.h"
+#include "frustum_culling.h"
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+#include "glm/trigonometric.hpp"
+#include "model.h"
+#include "model_registery.h"
+#include "profiling.h"
+#include "texture.h"
+
+TextureStreamer::TextureStreamer(size_t budgetBytes) : mResidency(budgetBytes) {}
+
+TextureResidency& TextureStreamer::getResidency() { return mResidency; }
+
+void TextureStreamer::update(Application* app) {
+    ZoneScopedN("Texture streaming");
+    mFrame++;
+
+    // textures freed since the last update give their budget back
+    for (auto it = mHandles.begin(); it != mHandles.end();) {
+        if (it->first.expired()) {
+            mResidency.remove(it->second);
+            mTextures.erase(it->second);
+            it = mHandles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    auto& camera = app->getCamera();
+    auto [width, height] = app->getWindowSize();
+    Frustum frustum = Frustum::fromMatrix(camera.getProjection() * camera.getView());
+    // pixels covered by one world unit at distance 1
+    float pixels_per_unit = static_cast<float>(height) / (2.0f * std::tan(glm::radians(camera.mFov) * 0.5f));
+    const glm::vec3& camera_pos = camera.getPos();
+
+    for (auto* model : ModelRegistry::instance().getLoadedModel(Visibility_User)) {
+        auto [min, max] = model->getWorldSpaceAABB();
+        // instances spread past the box of the model itself
+        bool in_view = model->instance != nullptr || frustum.AABBTest(min, max);
+        float distance = std::max(glm::length(camera_pos - glm::clamp(camera_pos, min, max)), camera.mZnear);
+        float screen_pixels = glm::length(max - min) * pixels_per_unit / distance;
+
+        for (auto& [id, mesh] : model->mFlattenMeshes) {
+            for (const auto* texture : {&mesh.mTexture, &mesh.mSpecularTexture, &mesh.mNormalMapTexture}) {
+                if (*texture == nullptr || !(*texture)->isStreamed() || !(*texture)->isStreamReady()) {
+                    continue;
+                }
+                auto [tex_width, tex_height] = (*texture)->getTextureSize();
+                auto tracked = mHandles.find(*texture);
+                if (tracked == mHandles.end()) {
+                    auto handle =
+                        mResidency.add(tex_width, tex_height, (*texture)->getBlockBytes(), (*texture)->getBlockSize());
+                    tracked = mHandles.emplace(*texture, handle).first;
+                    mTextures[handle] = *texture;
+                }
+                // levels evicted a moment ago are still on their way back to the CPU
+                if (in_view && (*texture)->canStreamIn()) {
+                    uint32_t mip = TextureResidency::desiredMip(std::max(tex_width, tex_height), screen_pixels);
+                    mResidency.request(tracked->second, mip, screen_pixels, mFrame);
+                }
+            }
+        }
+    }
+
+    auto changes = mResidency.update(mFrame, UPLOAD_BYTES_PER_FRAME);
+    if (changes.empty()) {
+        return;
+    }
+
+    auto& rc = app->getRendererResource();
+    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(rc.device, nullptr);
+    std::vector<std::shared_ptr<Texture>> changed;
+    for (const auto& change : changes) {
+        auto texture = mTextures[change.handle].lock();
+        if (texture != nullptr) {
+            texture->setResidentMip(rc.device, rc.queue, encoder, change.newFirstMip);
+            changed.push_back(std::move(texture));
+        }
+    }
+    WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(encoder, nullptr);
+    wgpuQueueSubmit(rc.queue, 1, &command_buffer);
+    wgpuCommandBufferRelease(command_buffer);
+    wgpuCommandEncoderRelease(encoder);
+
+    for (auto& texture : changed) {
+        texture->mapEvictedMips();
+    }
+}
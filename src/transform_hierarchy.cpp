@@ -0,0 +1,52 @@
+#include "transform_hierarchy.h"
+
+#include <algorithm>
+
+int32_t TransformHierarchy::add(int32_t parent, const glm::mat4& local) {
+    int32_t index = static_cast<int32_t>(mParents.size());
+    mParents.push_back(parent);
+    mLocals.push_back(local);
+    mWorlds.push_back(local);
+    mDirty.push_back(1);
+    mFirstDirty = std::min(mFirstDirty, static_cast<size_t>(index));
+    return index;
+}
+
+void TransformHierarchy::clear() { *this = {}; }
+
+void TransformHierarchy::setLocal(int32_t node, const glm::mat4& local) {
+    mLocals[node] = local;
+    mDirty[node] = 1;
+    mFirstDirty = std::min(mFirstDirty, static_cast<size_t>(node));
+}
+
+const glm::mat4& TransformHierarchy::getLocal(int32_t node) const { return mLocals[node]; }
+
+const glm::mat4& TransformHierarchy::getWorld(int32_t node) const { return mWorlds[node]; }
+
+int32_t TransformHierarchy::getParent(int32_t node) const { return mParents[node]; }
+
+size_t TransformHierarchy::size() const { return mParents.size(); }
+
+bool TransformHierarchy::isDirty() const { return mFirstDirty < mParents.size(); }
+
+size_t TransformHierarchy::update() {
+    if (!isDirty()) {
+        return 0;
+    }
+    // a parent is visited before its children, so its flag is final when they look at it
+    size_t updated = 0;
+    for (size_t i = mFirstDirty; i < mParents.size(); ++i) {
+        int32_t parent = mParents[i];
+        if (parent >= 0 && mDirty[parent]) {
+            mDirty[i] = 1;
+        }
+        if (mDirty[i]) {
+            mWorlds[i] = parent < 0 ? mLocals[i] : mWorlds[parent] * mLocals[i];
+            updated++;
+        }
+    }
+    std::fill(mDirty.begin() + static_cast<std::ptrdiff_t>(mFirstDirty), mDirty.end(), 0);
+    mFirstDirty = std::numeric_limits<size_t>::max();
+    return updated;
+}
@@ -6,6 +6,7 @@
 
 #include "application.h"
 #include "binding_group.h"
+#include "geometry_arena.h"
 #include "glm/fwd.hpp"
 #include "instance.h"
 #include "model.h"
@@ -179,18 +180,14 @@ std::pair<WGPUBuffer, WGPUBuffer> TransparencyPass::getSSBOBuffers() {
 
 void TransparencyPass::render(std::vector<BaseModel*> models, WGPURenderPassEncoder encoder,
                               WGPUTextureView opaqueDepthTextureView) {
-    auto& render_resource = mApp->getRendererResource();
-
     // Write reset data to heads buffer
     uint32_t num = 0;
-    wgpuQueueWriteBuffer(render_resource.queue, mHeadsBuffer.getBuffer(), 0, &num,
-                         sizeof(uint32_t));  // Reset numFragments
-    wgpuQueueWriteBuffer(render_resource.queue, mHeadsBuffer.getBuffer(), sizeof(uint32_t), headsData.data(),
-                         headsData.size() * sizeof(uint32_t));  // Reset heads.data
+    mHeadsBuffer.queueWrite(0, &num, sizeof(uint32_t));  // Reset numFragments
+    mHeadsBuffer.queueWrite(sizeof(uint32_t), headsData.data(),
+                            headsData.size() * sizeof(uint32_t));  // Reset heads.data
 
     // Write reset data to linked list buffer
-    wgpuQueueWriteBuffer(render_resource.queue, mLinkedlistBuffer.getBuffer(), 0, linkedListData.data(),
-                         linkedListData.size() * sizeof(LinkedListElement));
+    mLinkedlistBuffer.queueWrite(0, linkedListData.data(), linkedListData.size() * sizeof(LinkedListElement));
 
     for (auto* model : models) {
         for (auto& mesh_obj : model->mFlattenMeshes) {
@@ -217,16 +214,14 @@ void TransparencyPass::render(std::vector<BaseModel*> models, WGPURenderPassEnco
                 mBindingData[5].textureView = mApp->mDefaultDiffuse->getTextureView();
             }
 
-            wgpuQueueWriteBuffer(mApp->getRendererResource().queue, object_info_buffer.getBuffer(), 0,
-                                 &model->mTransform.getLocalTransform(), sizeof(glm::mat4));
+            object_info_buffer.queueWrite(0, &model->mTransform.getLocalTransform(), sizeof(glm::mat4));
             auto bindgroup = mBindingGroup.createNew(mApp->getRendererResource(), mBindingData);
-            wgpuRenderPassEncoderSetVertexBuffer(encoder, 0, mesh.mVertexBuffer.getBuffer(), 0,
-                                                 wgpuBufferGetSize(mesh.mVertexBuffer.getBuffer()));
+            mesh.bindGeometry(encoder, mApp->mGeometryArena);
 
             wgpuRenderPassEncoderSetBindGroup(encoder, 0, bindgroup, 0, nullptr);
 
             size_t instances = 1;
-            wgpuRenderPassEncoderDraw(encoder, mesh.mVertexData.size(), instances, 0, 0);
+            wgpuRenderPassEncoderDraw(encoder, mesh.mVertexData.size(), instances, mesh.getBaseVertex(), 0);
 
             wgpuBufferRelease(object_info_buffer.getBuffer());
             wgpuBindGroupRelease(bindgroup);
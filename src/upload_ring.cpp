@@ -0,0 +1,167 @@
+#include "upload_ring.h"
+
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <string>
+
+#include "profiling.h"
+
+UploadRing::UploadRing(RendererResource* resource) : mResources(resource), mRing(BLOCK_SIZE, MAX_BLOCKS) {}
+
+void UploadRing::write(WGPUBuffer destination, uint64_t offset, const void* data, size_t size) {
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+    mCounting.writes++;
+    mCounting.bytes += size;
+
+    StagingRing::Allocation allocation{};
+    if (offset % COPY_ALIGNMENT == 0 && size % COPY_ALIGNMENT == 0) {
+        allocation = mRing.allocate(size, COPY_ALIGNMENT);
+    }
+    if (allocation.block == StagingRing::NO_BLOCK) {
+        // written by flush(), a loader thread must not submit
+        size_t deferred = mDeferred.size();
+        mDeferred.resize(deferred + size);
+        std::memcpy(mDeferred.data() + deferred, data, size);
+        wgpuBufferAddRef(destination);
+        mCopies.push_back({destination, offset, StagingRing::NO_BLOCK, deferred, size});
+        mCounting.directWrites++;
+        return;
+    }
+
+    if (allocation.block == mBlocks.size()) {
+        std::string label = std::format("upload ring block {}", mBlocks.size());
+        WGPUBufferDescriptor descriptor = {};
+        descriptor.label = {label.c_str(), label.size()};
+        descriptor.usage = WGPUBufferUsage_MapWrite | WGPUBufferUsage_CopySrc;
+        descriptor.size = BLOCK_SIZE;
+        descriptor.mappedAtCreation = true;
+        Block block;
+        block.buffer = wgpuDeviceCreateBuffer(mResources->device, &descriptor);
+        block.mapped = static_cast<uint8_t*>(wgpuBufferGetMappedRange(block.buffer, 0, BLOCK_SIZE));
+        mBlocks.push_back(block);
+    }
+    std::memcpy(mBlocks[allocation.block].mapped + allocation.offset, data, size);
+
+    // consecutive writes to one buffer usually continue each other
+    if (!mCopies.empty()) {
+        auto& last = mCopies.back();
+        if (last.source == nullptr && last.destination == destination && last.block == allocation.block &&
+            last.destinationOffset + last.size == offset && last.blockOffset + last.size == allocation.offset) {
+            last.size += size;
+            return;
+        }
+    }
+    // the buffer may be released before the copy is recorded
+    wgpuBufferAddRef(destination);
+    mCopies.push_back({destination, offset, allocation.block, allocation.offset, size});
+}
+
+void UploadRing::copy(WGPUBuffer source, uint64_t sourceOffset, WGPUBuffer destination, uint64_t destinationOffset,
+                      uint64_t size) {
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+    wgpuBufferAddRef(source);
+    wgpuBufferAddRef(destination);
+    mCopies.push_back({destination, destinationOffset, StagingRing::NO_BLOCK, sourceOffset, size, source});
+}
+
+void UploadRing::flush() {
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+    flushLocked();
+}
+
+void UploadRing::flushLocked() {
+    if (mCopies.empty()) {
+        return;
+    }
+    ZoneScopedN("Upload ring flush");
+
+    mRing.submit(mFrame, mSubmitted);
+    for (uint32_t block : mSubmitted) {
+        wgpuBufferUnmap(mBlocks[block].buffer);
+        mBlocks[block].mapped = nullptr;
+    }
+
+    WGPUCommandEncoder encoder = nullptr;
+    auto submit = [&]() {
+        if (encoder == nullptr) {
+            return;
+        }
+        WGPUCommandBuffer command = wgpuCommandEncoderFinish(encoder, nullptr);
+        wgpuQueueSubmit(mResources->queue, 1, &command);
+        wgpuCommandBufferRelease(command);
+        wgpuCommandEncoderRelease(encoder);
+        encoder = nullptr;
+        mCounting.submits++;
+    };
+    for (const auto& copy : mCopies) {
+        if (copy.block == StagingRing::NO_BLOCK && copy.source == nullptr) {
+            // the copies queued before the write have to be submitted before it
+            submit();
+            wgpuQueueWriteBuffer(mResources->queue, copy.destination, copy.destinationOffset,
+                                 mDeferred.data() + copy.blockOffset, copy.size);
+            wgpuBufferRelease(copy.destination);
+            continue;
+        }
+        if (encoder == nullptr) {
+            WGPUCommandEncoderDescriptor encoder_descriptor = {};
+            encoder_descriptor.label = {"upload ring copies", WGPU_STRLEN};
+            encoder = wgpuDeviceCreateCommandEncoder(mResources->device, &encoder_descriptor);
+        }
+        WGPUBuffer source = copy.source != nullptr ? copy.source : mBlocks[copy.block].buffer;
+        wgpuCommandEncoderCopyBufferToBuffer(encoder, source, copy.blockOffset, copy.destination,
+                                             copy.destinationOffset, copy.size);
+        wgpuBufferRelease(copy.destination);
+        if (copy.source != nullptr) {
+            wgpuBufferRelease(copy.source);
+        }
+        mCounting.copies++;
+    }
+    submit();
+    mCopies.clear();
+    mDeferred.clear();
+
+    for (uint32_t block : mSubmitted) {
+        WGPUBufferMapCallbackInfo callback_info = {};
+        callback_info.mode = WGPUCallbackMode_AllowSpontaneous;
+        callback_info.callback = onBlockMapped;
+        callback_info.userdata1 = this;
+        callback_info.userdata2 = reinterpret_cast<void*>(static_cast<uintptr_t>(block));
+        wgpuBufferMapAsync(mBlocks[block].buffer, WGPUMapMode_Write, 0, BLOCK_SIZE, callback_info);
+    }
+}
+
+void UploadRing::onBlockMapped(WGPUMapAsyncStatus status, WGPUStringView message, void* userdata1,
+                               void* userdata2) {
+    auto* ring = static_cast<UploadRing*>(userdata1);
+    uint32_t block = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(userdata2));
+    if (status != WGPUMapAsyncStatus_Success) {
+        std::cout << std::format("Failed to map upload ring block {}: {}\n", block,
+                                 std::string{message.data, message.length == WGPU_STRLEN ? 0 : message.length});
+        return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(ring->mMutex);
+    ring->mBlocks[block].mapped =
+        static_cast<uint8_t*>(wgpuBufferGetMappedRange(ring->mBlocks[block].buffer, 0, BLOCK_SIZE));
+    ring->mRing.release(block);
+}
+
+void UploadRing::endFrame() {
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+    flushLocked();
+    mStats = mCounting;
+    mCounting = {};
+    mFrame++;
+}
+
+const UploadRing::Stats& UploadRing::getStats() const { return mStats; }
+
+uint32_t UploadRing::getBlockCount() {
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+    return mRing.getBlockCount();
+}
+
+uint32_t UploadRing::getInFlightCount() {
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+    return mRing.getInFlightCount();
+}
@@ -644,6 +644,23 @@ WGPUVertexBufferLayout VertexBufferLayout::configure(uint64_t arrayStride, Verte
     return mLayout;
 }
 
+WGPUVertexBufferLayout VertexBufferLayout::configurePackedVertex() {
+    mAttribs.clear();
+    return addAttribute(offsetof(PackedVertex, position), 0, WGPUVertexFormat_Float32x3)
+        .addAttribute(offsetof(PackedVertex, normal), 1, WGPUVertexFormat_Snorm16x2)
+        .addAttribute(offsetof(PackedVertex, color), 2, WGPUVertexFormat_Unorm8x4)
+        .addAttribute(offsetof(PackedVertex, tangent), 3, WGPUVertexFormat_Snorm16x2)
+        .addAttribute(offsetof(PackedVertex, uv), 5, WGPUVertexFormat_Float16x2)
+        .configure(sizeof(PackedVertex), VertexStepMode::VERTEX);
+}
+
+WGPUVertexBufferLayout VertexBufferLayout::configurePackedSkin() {
+    mAttribs.clear();
+    return addAttribute(offsetof(PackedSkin, boneIds), 6, WGPUVertexFormat_Uint8x4)
+        .addAttribute(offsetof(PackedSkin, weights), 7, WGPUVertexFormat_Unorm8x4)
+        .configure(sizeof(PackedSkin), VertexStepMode::VERTEX);
+}
+
 WGPUVertexBufferLayout VertexBufferLayout::getLayout() { return mLayout; }
 
 bool intersection(const glm::vec3& ray_origin, const glm::vec3& ray_dir, const glm::vec3& box_min,
@@ -809,6 +826,19 @@ BaseModel* testIntersection2(Camera& camera, size_t width, size_t height, std::p
     return nullptr;
 }
 
+std::pair<glm::vec3, glm::vec3> transformAABB(const glm::mat4& transform, const glm::vec3& min, const glm::vec3& max) {
+    // Arvo's method, each matrix column moves the box bounds independently
+    glm::vec3 world_min = glm::vec3(transform[3]);
+    glm::vec3 world_max = world_min;
+    for (int column = 0; column < 3; ++column) {
+        glm::vec3 a = glm::vec3(transform[column]) * min[column];
+        glm::vec3 b = glm::vec3(transform[column]) * max[column];
+        world_min += glm::min(a, b);
+        world_max += glm::max(a, b);
+    }
+    return {world_min, world_max};
+}
+
 std::vector<glm::vec4> generateAABBLines(const glm::vec3& min, const glm::vec3& max) {
     std::vector<glm::vec4> result;
 
@@ -4,6 +4,7 @@
 #include <webgpu/webgpu.h>
 
 #include "application.h"
+#include "geometry_arena.h"
 #include "model.h"
 #include "model_registery.h"
 #include "profiling.h"
@@ -73,7 +74,7 @@ WaterReflectionPass::WaterReflectionPass(Application* app, const std::string& na
         .create(&mApp->getRendererResource());
 
     static uint32_t cidx = 1;
-    wgpuQueueWriteBuffer(resource.queue, mDefaultCameraIndex.getBuffer(), 0, &cidx, sizeof(uint32_t));
+    mDefaultCameraIndex.queueWrite(0, &cidx, sizeof(uint32_t));
 
     mDefaultCameraIndexBindgroup.addBuffer(0, BindGroupEntryVisibility::VERTEX_FRAGMENT, BufferBindingType::UNIFORM,
                                            sizeof(uint32_t));
@@ -101,8 +102,7 @@ WaterReflectionPass::WaterReflectionPass(Application* app, const std::string& na
         .create(&mApp->getRendererResource());
 
     // glm::vec4 default_clip_plane{0.0, 0.0, 1.0, 100};
-    wgpuQueueWriteBuffer(resource.queue, mDefaultClipPlaneBuf.getBuffer(), 0, glm::value_ptr(mDefaultPlane),
-                         sizeof(glm::vec4));
+    mDefaultClipPlaneBuf.queueWrite(0, glm::value_ptr(mDefaultPlane), sizeof(glm::vec4));
 
     mDefaultClipPlaneBGData[0].nextInChain = nullptr;
     mDefaultClipPlaneBGData[0].binding = 0;
@@ -131,6 +131,7 @@ void WaterReflectionPass::createRenderPass(WGPUTextureFormat textureFormat) {
     mRenderPipeline->getDepthStencilState().depthCompare = WGPUCompareFunction_Less;
     mRenderPipeline->setPrimitiveState(WGPUFrontFace_CW, WGPUCullMode_Back);
 
+    mRenderPipeline->enablePackedVertexVariants();
     mRenderPipeline->createPipeline(resource);
 
     setColorAttachment({mRenderTargetView, nullptr, WGPUColor{0.52, 0.80, 0.92, 1.0}, StoreOp::Store, LoadOp::Load});
@@ -143,15 +144,15 @@ void WaterReflectionPass::execute(WGPUCommandEncoder encoder) {
     // water pass
 
     WGPURenderPassEncoder pass_encoder = wgpuCommandEncoderBeginRenderPass(encoder, getRenderPassDescriptor());
-
     wgpuRenderPassEncoderSetPipeline(pass_encoder, getPipeline()->getPipeline());
     wgpuRenderPassEncoderSetBindGroup(pass_encoder, 3, mDefaultCameraIndexBindgroup.getBindGroup(), 0, nullptr);
     wgpuRenderPassEncoderSetBindGroup(pass_encoder, 4, mDefaultClipPlaneBG.getBindGroup(), 0, nullptr);
-    wgpuRenderPassEncoderSetBindGroup(pass_encoder, 5, mApp->mDefaultVisibleBuffer.getBindGroup(), 0, nullptr);
+    // the instances were culled against the main camera, not the reflected one, so all of them are drawn
+    wgpuRenderPassEncoderSetBindGroup(pass_encoder, 5, mApp->mAllInstancesBindGroup, 0, nullptr);
 
     {
         for (const auto& model : ModelRegistry::instance().getLoadedModel(ModelVisibility::Visibility_User)) {
-            model->draw(mApp, pass_encoder);
+            model->draw(mApp, pass_encoder, getPipeline(), false);
         }
     }
 
@@ -201,8 +202,7 @@ WaterRefractionPass::WaterRefractionPass(Application* app, const std::string& na
         .create(&mApp->getRendererResource());
 
     // glm::vec4 default_clip_plane{0.0, 0.0, 1.0, 100};
-    wgpuQueueWriteBuffer(mApp->getRendererResource().queue, mDefaultClipPlaneBuf.getBuffer(), 0,
-                         glm::value_ptr(mDefaultPlane), sizeof(glm::vec4));
+    mDefaultClipPlaneBuf.queueWrite(0, glm::value_ptr(mDefaultPlane), sizeof(glm::vec4));
 
     mDefaultClipPlaneBGData[0].nextInChain = nullptr;
     mDefaultClipPlaneBGData[0].binding = 0;
@@ -215,7 +215,6 @@ WaterRefractionPass::WaterRefractionPass(Application* app, const std::string& na
 
 void WaterRefractionPass::execute(WGPUCommandEncoder encoder) {
     WGPURenderPassEncoder pass_encoder = wgpuCommandEncoderBeginRenderPass(encoder, getRenderPassDescriptor());
-
     wgpuRenderPassEncoderSetPipeline(pass_encoder, getPipeline()->getPipeline());
     wgpuRenderPassEncoderSetBindGroup(pass_encoder, 3, mApp->mDefaultCameraIndexBindgroup.getBindGroup(), 0, nullptr);
 
@@ -224,7 +223,7 @@ void WaterRefractionPass::execute(WGPUCommandEncoder encoder) {
 
     {
         for (const auto& model : ModelRegistry::instance().getLoadedModel(ModelVisibility::Visibility_User)) {
-            model->draw(mApp, pass_encoder);
+            model->draw(mApp, pass_encoder, getPipeline());
         }
     }
     wgpuRenderPassEncoderEnd(pass_encoder);
@@ -245,6 +244,7 @@ void WaterRefractionPass::createRenderPass(WGPUTextureFormat textureFormat) {
     mRenderPipeline->getDepthStencilState().depthCompare = WGPUCompareFunction_Less;
     mRenderPipeline->setPrimitiveState(WGPUFrontFace_CW, WGPUCullMode_Back);
 
+    mRenderPipeline->enablePackedVertexVariants();
     mRenderPipeline->createPipeline(mApp->getRendererResource());
 
     setColorAttachment({mRenderTargetView, nullptr, WGPUColor{0.52, 0.80, 0.92, 1.0}, StoreOp::Store, LoadOp::Clear});
@@ -360,13 +360,11 @@ void WaterPass::drawWater() {
         camera.mPitch *= -1.0;
         camera.updateCamera();
         muniform.setCamera(camera);
-        wgpuQueueWriteBuffer(mApp->getRendererResource().queue, mApp->getUniformBuffer().getBuffer(),
-                             sizeof(CameraInfo), &muniform, sizeof(CameraInfo));
+        mApp->getUniformBuffer().queueWrite(sizeof(CameraInfo), &muniform, sizeof(CameraInfo));
         glm::mat4 viewNoTranslation = glm::mat4(glm::mat3(muniform.viewMatrix));
         glm::mat4 mvp = muniform.projectMatrix * viewNoTranslation;
         auto reflected_camera = mvp;
-        wgpuQueueWriteBuffer(mApp->getRendererResource().queue, mApp->mSkybox->mReflectedCameraMatrix.getBuffer(), 0,
-                             &reflected_camera, sizeof(glm::mat4));
+        mApp->mSkybox->mReflectedCameraMatrix.queueWrite(0, &reflected_camera, sizeof(glm::mat4));
     }
     // }
 
@@ -471,7 +469,6 @@ void WaterPass::waterBlend() {
 
     WGPURenderPassEncoder water_render_pass_encoder =
         wgpuCommandEncoderBeginRenderPass(mApp->getRendererResource().commandEncoder, getRenderPassDescriptor());
-
     if (mWaterModel != nullptr) {
         // mWaterModel->update(mApp, 0.0);
         wgpuRenderPassEncoderSetPipeline(water_render_pass_encoder, getPipeline()->getPipeline());
@@ -62,9 +62,12 @@ void func(const WGPUDevice *device, WGPUDeviceLostReason reason, WGPUStringView
 
 // request webgpu device
 WGPUDevice requestDeviceSync(WGPUAdapter adapter, WGPULimits limits) {
-    (void)adapter;
     WGPUDeviceDescriptor descriptor = {};
     std::vector<WGPUFeatureName> features = {WGPUFeatureName_TimestampQuery};
+    // optional, textures baked to BC blocks are decoded on the CPU without it
+    if (wgpuAdapterHasFeature(adapter, WGPUFeatureName_TextureCompressionBC)) {
+        features.push_back(WGPUFeatureName_TextureCompressionBC);
+    }
     descriptor.nextInChain = nullptr;
     descriptor.label = {"My Device", sizeof("My Device")};  // anything works here, that's your
     descriptor.requiredFeatures = features.data();
@@ -332,6 +332,7 @@ struct BaseModelLoader : public IModel {
             mModel = new Model{param.cs};
             mModel->setVisible(param.isVisible);
             mModel->mPath = param.path;
+            mModel->setVertexPacking(param.packedVertices);
 
             glm::vec3 euler_radians = glm::radians(param.rotate);
             glm::quat qu = glm::normalize(glm::quat(euler_radians));
@@ -344,16 +345,13 @@ struct BaseModelLoader : public IModel {
 
             mModel->mTransform.mObjectInfo.isAnimated = param.animated;
             if (param.animated) {
-                mModel->mSkiningTransformationBuffer.setLabel("default skining data transform for human")
-                    .setSize(100 * sizeof(glm::mat4))
-                    .setUsage(WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst)
-                    .create(&app->getRendererResource());
+                mModel->mBoneSlot = app->mBoneSlots.allocate();
 
                 std::vector<glm::mat4> bones;
                 for (int i = 0; i < 100; i++) {
                     bones.emplace_back(glm::mat4{1.0});
                 }
-                mModel->mSkiningTransformationBuffer.queueWrite(0, bones.data(), sizeof(glm::mat4) * bones.size());
+                app->mBoneSlots.write(mModel->mBoneSlot, bones.data(), sizeof(glm::mat4) * bones.size());
             }
             // if mesh in node animated
             mModel->mGlobalMeshTransformationBuffer.setLabel("global mesh transformations buffer")
@@ -450,7 +448,7 @@ void generatePhysic(Application* app, BaseModel* model, const ObjectLoaderParam&
 
     if (param.physicsParams.method == PhysicGenMethod::MESH) {
         auto* loaded_model = model;
-        loaded_model->getGlobalTransform();
+        loaded_model->mTransform.getLocalTransform();
         if (loaded_model->getName() == "container") {
             std::cout << "container model\n";
         }
@@ -839,7 +837,8 @@ void parseMaterial(Application* app, const json& materials) {
                 dif_map.replace(0, 5, "");
                 dif_map = (world_file_dir / dif_map).string();
             }
-            dif_tex = Texture::asyncLoadTexture(app->mTextureRegistery, app->getRendererResource(), dif_map);
+            dif_tex = Texture::asyncLoadTexture(app->mTextureRegistery, app->getRendererResource(), dif_map, "",
+                                                true, true);
         }
         if (!nor_map_json.is_null()) {
             std::string nor_map = mat_obj["normal_map"].get<std::string>();
@@ -847,7 +846,8 @@ void parseMaterial(Application* app, const json& materials) {
                 nor_map.replace(0, 5, "");
                 nor_map = (world_file_dir / nor_map).string();
             }
-            nor_tex = Texture::asyncLoadTexture(app->mTextureRegistery, app->getRendererResource(), nor_map);
+            nor_tex = Texture::asyncLoadTexture(app->mTextureRegistery, app->getRendererResource(), nor_map, "",
+                                                true);
         }
         if (!spec_map_json.is_null()) {
             std::string spec_map = mat_obj["specular_map"].get<std::string>();
@@ -855,7 +855,8 @@ void parseMaterial(Application* app, const json& materials) {
                 spec_map.replace(0, 5, "");
                 spec_map = (world_file_dir / spec_map).string();
             }
-            spec_tex = Texture::asyncLoadTexture(app->mTextureRegistery, app->getRendererResource(), spec_map);
+            spec_tex = Texture::asyncLoadTexture(app->mTextureRegistery, app->getRendererResource(), spec_map, "",
+                                                 true);
         }
 
         app->mMaterialRegistery->addToRegistery(name, std::make_shared<Material>(name, dif_tex, nor_tex, nullptr));
@@ -969,16 +970,22 @@ std::optional<PhysicsParams> parsePhysics(const json& params) {
 }
 
 void World::loadModel(const ObjectLoaderParam& param) {
-    ModelRegistry::instance().registerModel(param.name, [param](Application* app) -> LoadModelResult {
-        BaseModelLoader model = BaseModelLoader{app, param};
-        model.onLoad(app, nullptr);
-
-        if (param.isPhysicEnabled) {
-            generatePhysic(app, model.getModel(), param);
-        }
+    int priority = param.isDefaultActor ? LoadPriority_Actor
+                   : param.isVisible    ? LoadPriority_Visible
+                                        : LoadPriority_Background;
+    ModelRegistry::instance().registerModel(
+        param.name,
+        [param](Application* app) -> LoadModelResult {
+            BaseModelLoader model = BaseModelLoader{app, param};
+            model.onLoad(app, nullptr);
+
+            if (param.isPhysicEnabled) {
+                generatePhysic(app, model.getModel(), param);
+            }
 
-        return {model.getModel(), Visibility_User};
-    });
+            return {model.getModel(), Visibility_User};
+        },
+        priority);
 }
 
 void World::loadWorld() {
@@ -1053,6 +1060,7 @@ void World::loadWorld() {
         param.instanceTransformations = instance_info;
 
         param.isDefaultActor = actorName == name;
+        param.packedVertices = object.contains("packed_vertices") && object["packed_vertices"].get<bool>();
         if (physics_props.has_value()) {
             param.isPhysicEnabled = true;
             param.physicsParams = *physics_props;
@@ -0,0 +1,118 @@
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "block_compression.h"
+#include "check.h"
+
+using bc::Format;
+
+static const char* formatName(Format format) {
+    switch (format) {
+        case Format::BC1:
+            return "BC1";
+        case Format::BC3:
+            return "BC3";
+        case Format::BC4:
+            return "BC4";
+        case Format::BC5:
+            return "BC5";
+        case Format::BC7:
+            return "BC7";
+    }
+    return "?";
+}
+
+// largest difference over the channels a format keeps
+static int maxError(Format format, const std::vector<uint8_t>& expected, const std::vector<uint8_t>& actual) {
+    int error = 0;
+    for (size_t i = 0; i < expected.size(); i += 4) {
+        for (uint32_t c = 0; c < bc::channelCount(format); c++) {
+            error = std::max(error, std::abs(int(expected[i + c]) - int(actual[i + c])));
+        }
+    }
+    return error;
+}
+
+// a solid colour survives the round trip up to the endpoint precision of the format: 565 for the BC1 colour,
+// 8 bit for the BC4 channels, 7 bit plus a shared p-bit for BC7
+static void constantBlocks(Format format, int tolerance) {
+    constexpr const uint32_t SIZE = 8;
+    std::mt19937 rng{13};
+    std::uniform_int_distribution<int> channel{0, 255};
+    int worst = 0;
+    bool supported = true;
+    for (uint32_t sample = 0; sample < 256; sample++) {
+        std::array<uint8_t, 4> color;
+        for (auto& c : color) {
+            c = static_cast<uint8_t>(channel(rng));
+        }
+        // the extremes are the easy ones to get wrong in the palette selection
+        if (sample < 2) {
+            color.fill(sample == 0 ? 0 : 255);
+        }
+        std::vector<uint8_t> image(4 * SIZE * SIZE);
+        for (size_t i = 0; i < image.size(); i++) {
+            image[i] = color[i % 4];
+        }
+        std::vector<uint8_t> blocks = bc::encode(format, image.data(), SIZE, SIZE);
+        std::vector<uint8_t> decoded;
+        supported &= bc::decode(format, blocks.data(), SIZE, SIZE, decoded);
+        worst = std::max(worst, maxError(format, image, decoded));
+    }
+    CHECK(supported);
+    CHECK(worst <= tolerance);
+    if (worst > tolerance) {
+        std::cout << formatName(format) << " constant block error " << worst << '\n';
+    }
+}
+
+// smooth ramps in every channel, partial blocks at the right and bottom edge
+static void gradient(Format format, double minimumPsnr) {
+    constexpr const uint32_t WIDTH = 66;
+    constexpr const uint32_t HEIGHT = 63;
+    std::vector<uint8_t> image(4 * WIDTH * HEIGHT);
+    for (uint32_t y = 0; y < HEIGHT; y++) {
+        for (uint32_t x = 0; x < WIDTH; x++) {
+            uint8_t* texel = &image[4 * (y * WIDTH + x)];
+            texel[0] = static_cast<uint8_t>(x * 255 / (WIDTH - 1));
+            texel[1] = static_cast<uint8_t>(y * 255 / (HEIGHT - 1));
+            texel[2] = static_cast<uint8_t>((x + y) * 255 / (WIDTH + HEIGHT - 2));
+            texel[3] = static_cast<uint8_t>(255 - (x + 2 * y) * 255 / (WIDTH + 2 * HEIGHT - 3));
+        }
+    }
+    std::vector<uint8_t> blocks = bc::encode(format, image.data(), WIDTH, HEIGHT);
+    CHECK(blocks.size() == bc::imageBytes(format, WIDTH, HEIGHT));
+    std::vector<uint8_t> decoded;
+    CHECK(bc::decode(format, blocks.data(), WIDTH, HEIGHT, decoded));
+    CHECK(decoded.size() == image.size());
+
+    double quality = bc::psnr(image.data(), decoded.data(), WIDTH, HEIGHT, bc::channelCount(format));
+    CHECK(quality >= minimumPsnr);
+    if (quality < minimumPsnr) {
+        std::cout << formatName(format) << " gradient psnr " << quality << " dB\n";
+    }
+}
+
+int main() {
+    CHECK(bc::imageBytes(Format::BC1, 5, 4) == 16);
+    CHECK(bc::imageBytes(Format::BC7, 4, 9) == 48);
+
+    constantBlocks(Format::BC1, 4);
+    constantBlocks(Format::BC3, 4);
+    constantBlocks(Format::BC4, 0);
+    constantBlocks(Format::BC5, 0);
+    constantBlocks(Format::BC7, 1);
+
+    gradient(Format::BC1, 36.0);
+    gradient(Format::BC3, 36.0);
+    gradient(Format::BC4, 48.0);
+    gradient(Format::BC5, 48.0);
+    gradient(Format::BC7, 38.0);
+
+    return testResult();
+}
@@ -0,0 +1,34 @@
+#ifndef WORLD_EXPLORER_TESTS_CHECK_H
+#define WORLD_EXPLORER_TESTS_CHECK_H
+
+#include <format>
+#include <iostream>
+
+/*
+ * Minimal checks for the test executables, a failed check prints its location and the test returns non zero from
+ * main through testResult().
+ */
+inline int& failedChecks() {
+    static int failed = 0;
+    return failed;
+}
+
+inline bool checkCondition(bool condition, const char* expression, const char* file, int line) {
+    if (!condition) {
+        std::cout << std::format("{}:{}: check failed: {}\n", file, line, expression);
+        failedChecks()++;
+    }
+    return condition;
+}
+
+#define CHECK(condition) checkCondition(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+inline int testResult() {
+    if (failedChecks() != 0) {
+        std::cout << std::format("{} checks failed\n", failedChecks());
+        return 1;
+    }
+    return 0;
+}
+
+#endif  //! WORLD_EXPLORER_TESTS_CHECK_H
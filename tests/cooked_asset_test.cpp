@@ -0,0 +1,148 @@
+#include <assimp/Importer.hpp>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "check.h"
+#include "cooked_asset.h"
+
+namespace fs = std::filesystem;
+
+static fs::path writeFile(const fs::path& dir, const char* name, std::string_view contents) {
+    auto path = dir / name;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    return path;
+}
+
+static cooked::Vertex vertexAt(const cooked::Mesh& mesh, uint32_t index) {
+    cooked::Vertex vertex;
+    std::memcpy(&vertex, mesh.vertices + sizeof(cooked::Vertex) * index, sizeof(cooked::Vertex));
+    return vertex;
+}
+
+static bool nearly(float a, float b) { return std::abs(a - b) < 1e-5f; }
+
+// a textured quad, cooked and loaded back has to match what assimp imports, with the vertices already rotated Z up
+static void objQuad(const fs::path& dir) {
+    writeFile(dir, "quad.mtl", "newmtl quad\nKd 0.25 0.5 0.75\nmap_Kd quad.png\n");
+    auto source = writeFile(dir, "quad.obj",
+                            "mtllib quad.mtl\n"
+                            "v 0 0 0\nv 1 0 0\nv 1 2 3\nv 0 2 3\n"
+                            "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+                            "usemtl quad\n"
+                            "f 1/1 2/2 3/3 4/4\n");
+    auto target = dir / "quad.wexc";
+
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(source.string().c_str(), cooked::IMPORT_FLAGS);
+    if (!CHECK(scene != nullptr && scene->mRootNode != nullptr)) return;
+    CHECK(cooked::writeScene(scene, target));
+
+    auto asset = cooked::loadAsset(target);
+    if (!CHECK(asset != nullptr)) return;
+    CHECK(cooked::compareScenes(scene, *asset, target));
+    if (!CHECK(asset->meshes.size() == 1 && scene->mNumMeshes == 1)) return;
+
+    const aiMesh* mesh = scene->mMeshes[0];
+    const cooked::Mesh& cooked_mesh = asset->meshes[0];
+    CHECK(cooked_mesh.vertexCount == mesh->mNumVertices);
+    CHECK(cooked_mesh.indexCount == 6);  // triangulated
+    for (uint32_t i = 0; i < cooked_mesh.vertexCount; ++i) {
+        auto vertex = vertexAt(cooked_mesh, i);
+        const aiVector3D& p = mesh->mVertices[i];
+        CHECK(nearly(vertex.position[0], p.x) && nearly(vertex.position[1], -p.z) && nearly(vertex.position[2], p.y));
+        CHECK(nearly(vertex.color[0], 0.25f) && nearly(vertex.color[1], 0.5f) && nearly(vertex.color[2], 0.75f));
+        const aiVector3D& uv = mesh->mTextureCoords[0][i];
+        CHECK(nearly(vertex.uv[0], uv.x) && nearly(vertex.uv[1], uv.y));
+        CHECK(vertex.weights[0] == 1.0f && vertex.boneIds[0] == 0);
+    }
+
+    // plain texture paths are kept as they are
+    aiString path;
+    CHECK(asset->scene->mMaterials[mesh->mMaterialIndex]->GetTexture(aiTextureType_DIFFUSE, 0, &path) == AI_SUCCESS);
+    CHECK(std::string{path.C_Str()} == "quad.png");
+}
+
+// a 1x1 PNG, and the positions and indices of one triangle
+static constexpr const char* PNG_URI =
+    "data:image/png;base64,iVBORw0KGgoAAAANSUhEUgAAAAEAAAABCAYAAAAfFcSJAAAADUlEQVR42mP8z8BQDwAEhQGA"
+    "hKmMIQAAAABJRU5ErkJggg==";
+static constexpr const char* BUFFER_URI =
+    "data:application/octet-stream;base64,AAAAAAAAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAgD8AAAAAAAABAAIAAAA=";
+
+// the glTF triangle carries its texture as a data URI, cooking writes it out and points the material at the file
+static void gltfEmbeddedTexture(const fs::path& dir) {
+    auto gltf = std::format(R"({{
+  "asset": {{"version": "2.0"}},
+  "scene": 0,
+  "scenes": [{{"nodes": [0]}}],
+  "nodes": [{{"mesh": 0}}],
+  "meshes": [{{"primitives": [{{"attributes": {{"POSITION": 0}}, "indices": 1, "material": 0}}]}}],
+  "materials": [{{"pbrMetallicRoughness": {{"baseColorTexture": {{"index": 0}}}}}}],
+  "textures": [{{"source": 0}}],
+  "images": [{{"uri": "{}"}}],
+  "buffers": [{{"byteLength": 44, "uri": "{}"}}],
+  "bufferViews": [
+    {{"buffer": 0, "byteOffset": 0, "byteLength": 36}},
+    {{"buffer": 0, "byteOffset": 36, "byteLength": 6}}
+  ],
+  "accessors": [
+    {{"bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3", "min": [0, 0, 0], "max": [1, 1, 0]}},
+    {{"bufferView": 1, "componentType": 5123, "count": 3, "type": "SCALAR"}}
+  ]
+}})",
+                            PNG_URI, BUFFER_URI);
+    auto source = writeFile(dir, "triangle.gltf", gltf);
+    auto target = dir / "triangle.wexc";
+
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(source.string().c_str(), cooked::IMPORT_FLAGS);
+    if (!CHECK(scene != nullptr && scene->mRootNode != nullptr)) return;
+    if (!CHECK(scene->mNumTextures == 1)) return;
+    CHECK(cooked::writeScene(scene, target));
+
+    auto asset = cooked::loadAsset(target);
+    if (!CHECK(asset != nullptr)) return;
+    CHECK(cooked::compareScenes(scene, *asset, target));
+
+    auto texture_path = cooked::getEmbeddedTexturePath(target, scene->mTextures[0], 0);
+    std::error_code ec;
+    CHECK(fs::file_size(texture_path, ec) == scene->mTextures[0]->mWidth && !ec);
+
+    // every reference to the embedded texture now names the written file
+    const aiMaterial* material = asset->scene->mMaterials[asset->scene->mMeshes[0]->mMaterialIndex];
+    uint32_t references = 0;
+    for (uint32_t type = aiTextureType_NONE + 1; type <= AI_TEXTURE_TYPE_MAX; ++type) {
+        for (uint32_t i = 0; i < material->GetTextureCount(static_cast<aiTextureType>(type)); ++i) {
+            aiString path;
+            material->GetTexture(static_cast<aiTextureType>(type), i, &path);
+            CHECK(path.data[0] != '*');
+            references += std::string{path.C_Str()} == texture_path.filename().string();
+        }
+    }
+    CHECK(references > 0);
+}
+
+// files that are not a cooked asset of this version are rejected
+static void rejected(const fs::path& dir) {
+    CHECK(cooked::loadAsset(dir / "missing.wexc") == nullptr);
+    CHECK(cooked::loadAsset(writeFile(dir, "garbage.wexc", "WEXC but not really a cooked asset")) == nullptr);
+}
+
+int main() {
+    auto dir = fs::temp_directory_path() / "world_explorer_cooked_asset_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    objQuad(dir);
+    gltfEmbeddedTexture(dir);
+    rejected(dir);
+
+    fs::remove_all(dir);
+    return testResult();
+}
@@ -0,0 +1,78 @@
+#include "check.h"
+#include "fixed_timestep.h"
+
+// the same wall time gives the same number of steps whatever the frame rate, and alpha stays in [0, 1)
+static void frameRates() {
+    const double seconds = 50.0;  // a whole number of frames at 30, 59.94 and 144 fps
+    int counts[3] = {};
+    const double rates[3] = {30.0, 59.94, 144.0};
+    for (int i = 0; i < 3; ++i) {
+        FixedTimestep timestep{60.0f, 4};
+        // half a step ahead, so the frame sums never land right on a step boundary
+        CHECK(timestep.advance(timestep.getStep() * 0.5) == 0);
+
+        int frames = static_cast<int>(seconds * rates[i] + 0.5);
+        bool alpha_in_range = true;
+        bool within_sub_steps = true;
+        for (int frame = 0; frame < frames; ++frame) {
+            int steps = timestep.advance(1.0 / rates[i]);
+            within_sub_steps &= steps >= 0 && steps <= timestep.getMaxSubSteps();
+            alpha_in_range &= timestep.getAlpha() >= 0.0f && timestep.getAlpha() < 1.0f;
+            counts[i] += steps;
+        }
+        CHECK(alpha_in_range);
+        CHECK(within_sub_steps);
+        CHECK(counts[i] == 3000);
+    }
+    CHECK(counts[0] == counts[1] && counts[1] == counts[2]);
+}
+
+// a frame longer than maxSubSteps steps runs maxSubSteps and drops the rest instead of catching up later
+static void droppedTime() {
+    FixedTimestep timestep{60.0f, 4};
+    const double step = timestep.getStep();
+
+    CHECK(timestep.advance(1.0) == 4);
+    CHECK(timestep.getAlpha() == 0.0f);
+    CHECK(timestep.advance(step * 0.5) == 0);  // nothing owed from the long frame
+
+    // what is left after maxSubSteps steps is kept when it is less than a step
+    timestep.reset();
+    CHECK(timestep.advance(step * 4.5) == 4);
+    CHECK(timestep.getAlpha() > 0.49f && timestep.getAlpha() < 0.51f);
+
+    // and dropped as a whole when it is more
+    timestep.reset();
+    CHECK(timestep.advance(step * 6.5) == 4);
+    CHECK(timestep.getAlpha() == 0.0f);
+
+    // at most one step per frame never drops anything
+    timestep.setMaxSubSteps(1);
+    timestep.reset();
+    int steps = 0;
+    for (int frame = 0; frame < 101; ++frame) {
+        steps += timestep.advance(step * 0.75);
+    }
+    CHECK(steps == 75);  // 75.75 steps of time
+}
+
+// rate and sub step limits are clamped, negative deltas do nothing
+static void settings() {
+    FixedTimestep timestep{0.0f, 0};
+    CHECK(timestep.getRate() == 1.0f);
+    CHECK(timestep.getMaxSubSteps() == 1);
+
+    timestep.setRate(120.0f).setMaxSubSteps(8);
+    CHECK(timestep.getStep() == 1.0f / 120.0f);
+    CHECK(timestep.getMaxSubSteps() == 8);
+
+    CHECK(timestep.advance(-1.0) == 0);
+    CHECK(timestep.getAlpha() == 0.0f);
+}
+
+int main() {
+    frameRates();
+    droppedTime();
+    settings();
+    return testResult();
+}
@@ -0,0 +1,119 @@
+#include <cstdint>
+
+#include "check.h"
+#include "frame_pacer.h"
+
+// submits until the pacer says to wait, returns how many frames went through
+static uint32_t submitUntilWait(FramePacer& pacer, uint64_t firstSubmission) {
+    uint32_t count = 0;
+    while (!pacer.mustWait() && count <= FramePacer::MAX_FRAMES_IN_FLIGHT) {
+        pacer.submitted(firstSubmission + count);
+        count++;
+    }
+    return count;
+}
+
+// the CPU runs exactly max latency frames ahead, finishing the oldest lets one more through
+static void latencies() {
+    for (uint32_t latency = 1; latency <= FramePacer::MAX_FRAMES_IN_FLIGHT; ++latency) {
+        FramePacer pacer{latency};
+        CHECK(!pacer.mustWait());
+        CHECK(pacer.getInFlightCount() == 0);
+
+        CHECK(submitUntilWait(pacer, 0) == latency);
+        CHECK(pacer.getInFlightCount() == latency);
+        CHECK(pacer.getFrame() == latency);
+
+        pacer.completed(pacer.getOldestFrame());
+        CHECK(!pacer.mustWait());
+        CHECK(pacer.submitted(latency) == latency);
+        CHECK(pacer.mustWait());
+    }
+}
+
+// frames finish in order, so a late report of an older frame changes nothing and one for a frame not submitted
+// yet only finishes what was submitted
+static void completions() {
+    FramePacer pacer{4};
+    for (uint64_t frame = 0; frame < 4; ++frame) {
+        CHECK(pacer.submitted(frame) == frame);
+    }
+
+    // frame 2 finishing means 0 and 1 did too
+    pacer.completed(2);
+    CHECK(pacer.getOldestFrame() == 3);
+    CHECK(pacer.getInFlightCount() == 1);
+
+    // the reports for 0 and 1 arrive late
+    pacer.completed(0);
+    pacer.completed(1);
+    CHECK(pacer.getOldestFrame() == 3);
+    CHECK(pacer.getInFlightCount() == 1);
+
+    // nothing beyond the last submitted frame
+    pacer.completed(10);
+    CHECK(pacer.getOldestFrame() == 4);
+    CHECK(pacer.getInFlightCount() == 0);
+    CHECK(pacer.submitted(4) == 4);
+    CHECK(pacer.getInFlightCount() == 1);
+
+    // with nothing in flight a report does nothing either
+    FramePacer idle;
+    idle.completed(0);
+    CHECK(idle.getOldestFrame() == 0 && idle.getInFlightCount() == 0);
+}
+
+// the latency is clamped to [1, MAX_FRAMES_IN_FLIGHT], lowering it below the frames in flight makes the CPU wait
+static void latencyClamping() {
+    FramePacer pacer{0};
+    CHECK(pacer.getMaxLatency() == 1);
+    pacer.setMaxLatency(FramePacer::MAX_FRAMES_IN_FLIGHT + 5);
+    CHECK(pacer.getMaxLatency() == FramePacer::MAX_FRAMES_IN_FLIGHT);
+    pacer.setMaxLatency(3);
+    CHECK(pacer.getMaxLatency() == 3);
+
+    pacer.submitted(0);
+    pacer.submitted(1);
+    CHECK(!pacer.mustWait());
+    pacer.setMaxLatency(0);
+    CHECK(pacer.getMaxLatency() == 1);
+    CHECK(pacer.mustWait());
+
+    // it takes both frames finishing to go on
+    pacer.completed(0);
+    CHECK(pacer.mustWait());
+    pacer.completed(1);
+    CHECK(!pacer.mustWait());
+}
+
+// the submission of the oldest frame in flight, after the frame indices wrapped around the ring several times
+static void oldestSubmissionWraparound() {
+    FramePacer pacer{FramePacer::MAX_FRAMES_IN_FLIGHT};
+    const uint64_t frames = FramePacer::MAX_FRAMES_IN_FLIGHT * 3 + 1;
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+        if (pacer.mustWait()) {
+            CHECK(pacer.getOldestSubmission() == 100 + pacer.getOldestFrame());
+            pacer.completed(pacer.getOldestFrame());
+        }
+        pacer.submitted(100 + frame);
+    }
+    CHECK(pacer.getFrame() == frames);
+    CHECK(pacer.getInFlightCount() == FramePacer::MAX_FRAMES_IN_FLIGHT);
+    CHECK(pacer.getOldestFrame() == frames - FramePacer::MAX_FRAMES_IN_FLIGHT);
+
+    // every frame still in flight, oldest first, shares no slot with a finished one
+    for (uint64_t frame = pacer.getOldestFrame(); frame < frames; ++frame) {
+        CHECK(pacer.getOldestFrame() == frame);
+        CHECK(pacer.getOldestSubmission() == 100 + frame);
+        pacer.completed(frame);
+    }
+    CHECK(pacer.getInFlightCount() == 0);
+}
+
+int main() {
+    latencies();
+    completions();
+    latencyClamping();
+    oldestSubmissionWraparound();
+    return testResult();
+}
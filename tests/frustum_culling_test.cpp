@@ -0,0 +1,144 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "frustum.h"
+#include "glm/glm.hpp"
+
+// a box is outside a plane when all of its eight corners are, and culled when it is outside any plane
+static bool bruteForceVisible(const Frustum& frustum, const glm::vec3& min, const glm::vec3& max) {
+    for (const auto& plane : frustum.faces) {
+        bool outside = true;
+        for (uint32_t corner = 0; corner < 8; corner++) {
+            glm::vec3 point = {corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z};
+            outside &= glm::dot(plane.normal, point) + plane.distance < 0.0f;
+        }
+        if (outside) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static FrustumPlanesUniform randomPlanes(std::mt19937& rng) {
+    std::uniform_real_distribution<float> axis{-1.0f, 1.0f};
+    std::uniform_real_distribution<float> distance{0.0f, 20.0f};
+    FrustumPlanesUniform planes = {};
+    for (auto& plane : planes.planes) {
+        glm::vec3 normal = glm::normalize(glm::vec3{axis(rng), axis(rng), axis(rng)});
+        plane.N_D = glm::vec4{normal, distance(rng)};
+    }
+    return planes;
+}
+
+static std::vector<InstanceBounds> randomBoxes(uint32_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<float> position{-30.0f, 30.0f};
+    std::uniform_real_distribution<float> size{0.1f, 15.0f};
+    std::vector<InstanceBounds> boxes;
+    for (uint32_t i = 0; i < count; i++) {
+        glm::vec3 min = {position(rng), position(rng), position(rng)};
+        glm::vec3 max = min + glm::vec3{size(rng), size(rng), size(rng)};
+        boxes.push_back({glm::vec4{min, 1.0f}, glm::vec4{max, 1.0f}});
+    }
+    return boxes;
+}
+
+// the p-vertex test and the compacted reference agree with testing every corner
+static void matchesBruteForce() {
+    std::mt19937 rng{8};
+    bool tests = true;
+    bool flags = true;
+    bool compacted = true;
+    size_t culled = 0;
+    std::vector<uint8_t> visible;
+    std::vector<uint32_t> indices;
+    for (uint32_t round = 0; round < 200; round++) {
+        FrustumPlanesUniform planes = randomPlanes(rng);
+        Frustum frustum = Frustum::fromPlanes(planes);
+        std::vector<InstanceBounds> boxes = randomBoxes(64, rng);
+        cullInstances(planes, boxes, visible, indices);
+
+        std::vector<uint32_t> expected;
+        for (size_t i = 0; i < boxes.size(); i++) {
+            glm::vec3 min{boxes[i].minAABB};
+            glm::vec3 max{boxes[i].maxAABB};
+            bool brute_force = bruteForceVisible(frustum, min, max);
+            tests &= frustum.AABBTest(min, max) == brute_force;
+            if (i == 0) {
+                flags &= visible[i] == 1;
+                continue;
+            }
+            flags &= visible[i] == brute_force;
+            if (brute_force) {
+                expected.push_back(static_cast<uint32_t>(i));
+            } else {
+                culled++;
+            }
+        }
+        compacted &= indices == expected;
+    }
+    CHECK(tests);
+    CHECK(flags);
+    CHECK(compacted);
+    CHECK(culled > 0);
+}
+
+// boxes straddling a plane are kept whichever way its normal points, the old test only looked at `min`
+static void straddlingBoxes() {
+    for (uint32_t axis = 0; axis < 3; axis++) {
+        for (float sign : {1.0f, -1.0f}) {
+            FrustumPlanesUniform planes = {};
+            for (auto& plane : planes.planes) {
+                plane.N_D = glm::vec4{0.0f, 0.0f, 0.0f, 1.0f};  // everything is inside
+            }
+            glm::vec3 normal{0.0f};
+            normal[axis] = sign;
+            planes.planes[axis].N_D = glm::vec4{normal, 0.0f};
+            Frustum frustum = Frustum::fromPlanes(planes);
+
+            // one corner is outside the plane and the other inside
+            glm::vec3 min{-1.0f};
+            glm::vec3 max{1.0f};
+            CHECK(frustum.AABBTest(min, max));
+            // the box is completely on the inside or the outside
+            glm::vec3 inside = normal * 2.0f;
+            glm::vec3 outside = normal * -2.0f;
+            CHECK(frustum.AABBTest(inside - glm::vec3{0.5f}, inside + glm::vec3{0.5f}));
+            CHECK(!frustum.AABBTest(outside - glm::vec3{0.5f}, outside + glm::vec3{0.5f}));
+        }
+    }
+}
+
+// an identity view projection is the -1..1 clip cube
+static void clipCube() {
+    Frustum frustum = Frustum::fromMatrix(glm::mat4{1.0f});
+    CHECK(frustum.AABBTest(glm::vec3{-0.5f}, glm::vec3{0.5f}));
+    CHECK(frustum.AABBTest(glm::vec3{0.5f}, glm::vec3{3.0f}));
+    CHECK(!frustum.AABBTest(glm::vec3{1.5f}, glm::vec3{3.0f}));
+    CHECK(!frustum.AABBTest(glm::vec3{-0.5f, -0.5f, -3.0f}, glm::vec3{0.5f, 0.5f, -1.5f}));
+
+    // the uniform the compute shader reads gives back the same frustum
+    Frustum uploaded = Frustum::fromPlanes(createFrustumPlanes(frustum));
+    for (size_t i = 0; i < 6; i++) {
+        CHECK(uploaded.faces[i].normal == frustum.faces[i].normal);
+        CHECK(uploaded.faces[i].distance == frustum.faces[i].distance);
+    }
+
+    // instance 0 is the model itself and drawn anyway
+    std::vector<InstanceBounds> boxes = {{glm::vec4{5.0f, 5.0f, 5.0f, 1.0f}, glm::vec4{6.0f, 6.0f, 6.0f, 1.0f}},
+                                         {glm::vec4{5.0f, 5.0f, 5.0f, 1.0f}, glm::vec4{6.0f, 6.0f, 6.0f, 1.0f}},
+                                         {glm::vec4{0.0f, 0.0f, 0.0f, 1.0f}, glm::vec4{0.1f, 0.1f, 0.1f, 1.0f}}};
+    std::vector<uint8_t> visible;
+    std::vector<uint32_t> indices;
+    cullInstances(createFrustumPlanes(frustum), boxes, visible, indices);
+    CHECK(visible == std::vector<uint8_t>({1, 0, 1}));
+    CHECK(indices == std::vector<uint32_t>({2}));
+}
+
+int main() {
+    matchesBruteForce();
+    straddlingBoxes();
+    clipCube();
+    return testResult();
+}
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "hi_z.h"
+
+// odd on both sides, so the last texels of the rows and columns take the ones left over
+constexpr const uint32_t WIDTH = 13;
+constexpr const uint32_t HEIGHT = 7;
+
+static float bruteForceFarthest(const std::vector<float>& depth, uint32_t firstX, uint32_t firstY, uint32_t lastX,
+                                uint32_t lastY) {
+    float farthest = 0.0f;
+    for (uint32_t y = firstY; y <= lastY; y++) {
+        for (uint32_t x = firstX; x <= lastX; x++) {
+            farthest = std::max(farthest, depth[y * WIDTH + x]);
+        }
+    }
+    return farthest;
+}
+
+// every texel keeps the farthest depth of the level 0 texels under it
+static void pyramid(const std::vector<float>& depth, const HiZPyramid& hi_z) {
+    CHECK(hi_z.getLevelCount() == 4);
+    CHECK(HiZPyramid::levelCount(1, 1) == 1 && HiZPyramid::levelCount(1024, 768) == 11);
+    bool exact = true;
+    for (uint32_t level = 0; level < hi_z.getLevelCount(); level++) {
+        uint32_t width = hi_z.getWidth(level);
+        uint32_t height = hi_z.getHeight(level);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                uint32_t last_x = x == width - 1 ? WIDTH - 1 : ((x + 1) << level) - 1;
+                uint32_t last_y = y == height - 1 ? HEIGHT - 1 : ((y + 1) << level) - 1;
+                float expected = bruteForceFarthest(depth, x << level, y << level, last_x, last_y);
+                exact &= hi_z.getDepth(level, x, y) == expected;
+            }
+        }
+    }
+    CHECK(exact);
+    CHECK(hi_z.getWidth(3) == 1 && hi_z.getHeight(3) == 1);
+}
+
+// the coarse lookup never reports a nearer depth than the texels it covers actually have
+static void farthestDepth(const std::vector<float>& depth, const HiZPyramid& hi_z) {
+    float everything = bruteForceFarthest(depth, 0, 0, WIDTH - 1, HEIGHT - 1);
+    bool conservative = true;
+    bool exact_texels = true;
+    for (uint32_t first_y = 0; first_y < HEIGHT; first_y++) {
+        for (uint32_t last_y = first_y; last_y < HEIGHT; last_y++) {
+            for (uint32_t first_x = 0; first_x < WIDTH; first_x++) {
+                for (uint32_t last_x = first_x; last_x < WIDTH; last_x++) {
+                    float expected = bruteForceFarthest(depth, first_x, first_y, last_x, last_y);
+                    float farthest = hi_z.getFarthestDepth(first_x, first_y, last_x, last_y);
+                    conservative &= farthest >= expected && farthest <= everything;
+                    if (first_x == last_x && first_y == last_y) {
+                        exact_texels &= farthest == expected;
+                    }
+                }
+            }
+        }
+    }
+    CHECK(conservative);
+    CHECK(exact_texels);
+}
+
+// with the identity as view projection, x and y are NDC and z is the depth
+static void occlusion() {
+    // a wall at depth 0.5 over the left half, the far plane elsewhere
+    std::vector<float> depth(WIDTH * HEIGHT, 1.0f);
+    for (uint32_t y = 0; y < HEIGHT; y++) {
+        for (uint32_t x = 0; x < WIDTH / 2; x++) {
+            depth[y * WIDTH + x] = 0.5f;
+        }
+    }
+    HiZPyramid hi_z;
+    CHECK(!hi_z.isOccluded(nullptr, nullptr, nullptr));  // nothing built, nothing is hidden
+    hi_z.build(depth.data(), WIDTH, HEIGHT);
+
+    const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    auto occluded = [&](float minX, float minY, float minZ, float maxX, float maxY, float maxZ) {
+        const float box_min[3] = {minX, minY, minZ};
+        const float box_max[3] = {maxX, maxY, maxZ};
+        return hi_z.isOccluded(identity, box_min, box_max);
+    };
+    CHECK(occluded(-0.9f, -0.3f, 0.6f, -0.5f, 0.3f, 0.7f));    // behind the wall
+    CHECK(!occluded(-0.9f, -0.3f, 0.3f, -0.5f, 0.3f, 0.4f));   // in front of it
+    CHECK(!occluded(-0.9f, -0.3f, 0.45f, -0.5f, 0.3f, 0.7f));  // reaching through it
+    CHECK(!occluded(-0.9f, -0.3f, 0.6f, 0.4f, 0.3f, 0.7f));    // behind it but sticking out
+    CHECK(!occluded(0.2f, -0.3f, 0.6f, 0.9f, 0.3f, 0.7f));     // beside it
+    CHECK(!occluded(-3.0f, -3.0f, 0.6f, 3.0f, 3.0f, 0.7f));    // covering the screen
+    // right at the wall's edge the coarser level already sees past it, the test stays conservative
+    CHECK(!occluded(-0.9f, -0.5f, 0.6f, -0.3f, 0.5f, 0.7f));
+
+    // w = -z, a box reaching behind the camera is kept
+    const float behind[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0};
+    const float box_min[3] = {-0.5f, -0.5f, -0.7f};
+    const float box_max[3] = {-0.1f, 0.5f, 0.2f};
+    CHECK(!hi_z.isOccluded(behind, box_min, box_max));
+}
+
+// a box found occluded is behind every texel its screen rectangle touches
+static void neverHidesVisibleBoxes(const std::vector<float>& depth, const HiZPyramid& hi_z) {
+    const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    std::mt19937 rng{23};
+    std::uniform_real_distribution<float> ndc{-1.2f, 1.2f};
+    std::uniform_real_distribution<float> z{0.0f, 1.0f};
+    auto to_texel = [](float uv, uint32_t size) {
+        return std::min(static_cast<uint32_t>(std::clamp(uv, 0.0f, 1.0f) * size), size - 1);
+    };
+    uint32_t occluded = 0;
+    uint32_t wrong = 0;
+    for (uint32_t i = 0; i < 20'000; i++) {
+        float x0 = ndc(rng), x1 = ndc(rng), y0 = ndc(rng), y1 = ndc(rng), z0 = z(rng), z1 = z(rng);
+        const float box_min[3] = {std::min(x0, x1), std::min(y0, y1), std::min(z0, z1)};
+        const float box_max[3] = {std::max(x0, x1), std::max(y0, y1), std::max(z0, z1)};
+        if (!hi_z.isOccluded(identity, box_min, box_max)) {
+            continue;
+        }
+        occluded++;
+        // uv has y pointing down
+        uint32_t first_x = to_texel(box_min[0] * 0.5f + 0.5f, WIDTH);
+        uint32_t last_x = to_texel(box_max[0] * 0.5f + 0.5f, WIDTH);
+        uint32_t first_y = to_texel(0.5f - box_max[1] * 0.5f, HEIGHT);
+        uint32_t last_y = to_texel(0.5f - box_min[1] * 0.5f, HEIGHT);
+        wrong += box_min[2] <= bruteForceFarthest(depth, first_x, first_y, last_x, last_y);
+    }
+    CHECK(occluded > 0);
+    CHECK(wrong == 0);
+    if (wrong != 0) {
+        std::cout << wrong << " of " << occluded << " occluded boxes are visible\n";
+    }
+}
+
+int main() {
+    std::mt19937 rng{7};
+    std::uniform_real_distribution<float> random_depth{0.2f, 0.9f};
+    std::vector<float> depth(WIDTH * HEIGHT);
+    for (auto& d : depth) {
+        d = random_depth(rng);
+    }
+    HiZPyramid hi_z;
+    hi_z.build(depth.data(), WIDTH, HEIGHT);
+
+    pyramid(depth, hi_z);
+    farthestDepth(depth, hi_z);
+    occlusion();
+    neverHidesVisibleBoxes(depth, hi_z);
+    return testResult();
+}
@@ -0,0 +1,76 @@
+#include <cstdint>
+#include <utility>
+
+#include "check.h"
+#include "indirect_draw_args.h"
+
+using Range = std::pair<uint32_t, uint32_t>;
+
+// setMesh grows the table and widens the dirty range, an unchanged entry is not dirty again
+static void dirtyRanges() {
+    IndirectDrawArgs args;
+    CHECK(args.takeDirtyRange() == Range(0, 0));
+
+    CHECK(args.setMesh(2, 36, 0, 0));
+    CHECK(args.size() == 3);
+    CHECK(args.takeDirtyRange() == Range(2, 3));
+    CHECK(args.takeDirtyRange() == Range(0, 0));  // taken
+
+    // slots that were skipped are zero
+    CHECK(args.getArgs()[0].indexCount == 0 && args.getArgs()[1].indexCount == 0);
+
+    CHECK(!args.setMesh(2, 36, 0, 0));
+    CHECK(args.takeDirtyRange() == Range(0, 0));
+
+    // every field of the index range counts
+    CHECK(args.setMesh(2, 36, 12, 0));
+    CHECK(args.setMesh(2, 36, 12, -4));
+    CHECK(args.setMesh(2, 48, 12, -4));
+    CHECK(args.takeDirtyRange() == Range(2, 3));
+
+    // changes to distant slots are covered by one range
+    CHECK(args.setMesh(0, 6, 0, 0));
+    CHECK(!args.setMesh(2, 48, 12, -4));
+    CHECK(args.setMesh(5, 3, 100, 7));
+    CHECK(args.size() == 6);
+    CHECK(args.takeDirtyRange() == Range(0, 6));
+
+    const auto& entry = args.getArgs()[5];
+    CHECK(entry.indexCount == 3 && entry.firstIndex == 100 && entry.baseVertex == 7);
+    CHECK(entry.instanceCount == 0 && entry.firstInstance == 0);
+}
+
+// the instance count goes into every entry without touching the index ranges or the dirty range
+static void instanceCounts() {
+    IndirectDrawArgs args;
+    args.setMesh(0, 6, 0, 0);
+    args.setMesh(1, 12, 6, 4);
+    args.setMesh(2, 3, 18, 8);
+    args.takeDirtyRange();
+
+    args.setInstanceCount(5);
+    for (const auto& entry : args.getArgs()) {
+        CHECK(entry.instanceCount == 5);
+    }
+    CHECK(args.getArgs()[1].indexCount == 12 && args.getArgs()[1].firstIndex == 6 && args.getArgs()[1].baseVertex == 4);
+    CHECK(args.takeDirtyRange() == Range(0, 0));
+
+    // a mesh update keeps the count
+    CHECK(args.setMesh(1, 12, 30, 4));
+    CHECK(args.getArgs()[1].instanceCount == 5);
+}
+
+// byte offsets of the slots in the uploaded buffer, DrawIndexedIndirect reads 20 byte entries
+static void offsets() {
+    static_assert(sizeof(DrawIndexedIndirectArgs) == 20);
+    CHECK(IndirectDrawArgs::getOffset(0) == 0);
+    CHECK(IndirectDrawArgs::getOffset(1) == 20);
+    CHECK(IndirectDrawArgs::getOffset(7) == 140);
+}
+
+int main() {
+    dirtyRanges();
+    instanceCounts();
+    offsets();
+    return testResult();
+}
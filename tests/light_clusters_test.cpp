@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "light_clusters.h"
+
+using Sphere = LightClusters::Sphere;
+
+constexpr const float X_SCALE = 1.0f / 1.7777f;  // 90 degrees vertical field of view at 16:9
+constexpr const float Y_SCALE = 1.0f;
+constexpr const float Z_NEAR = 0.1f;
+constexpr const float Z_FAR = 200.0f;
+
+static std::vector<uint32_t> lightsOf(const LightClusters& clusters, uint32_t cluster) {
+    const auto& grid = clusters.getGrid();
+    const auto& indices = clusters.getIndices();
+    return {indices.begin() + grid[2 * cluster], indices.begin() + grid[2 * cluster] + grid[2 * cluster + 1]};
+}
+
+static std::vector<Sphere> randomLights(uint32_t count, uint32_t seed) {
+    std::mt19937 rng{seed};
+    std::uniform_real_distribution<float> lateral{-60.0f, 60.0f};
+    std::uniform_real_distribution<float> depth{-Z_FAR * 1.1f, 5.0f};
+    std::uniform_real_distribution<float> radius{0.05f, 12.0f};
+    std::vector<Sphere> lights(count);
+    for (auto& light : lights) {
+        light = {lateral(rng), lateral(rng) * 0.5f, depth(rng), radius(rng)};
+    }
+    lights[0].radius = 0.0f;  // never binned
+    return lights;
+}
+
+// every cluster lists exactly the lights the exhaustive sphere/box test finds, in ascending order
+static void matchesBruteForce() {
+    LightClusters clusters;
+    clusters.setProjection(X_SCALE, Y_SCALE, Z_NEAR, Z_FAR);
+    auto lights = randomLights(300, 5);
+    clusters.build(lights);
+    CHECK(clusters.getOverflowCount() == 0);
+
+    uint32_t mismatches = 0;
+    size_t binned = 0;
+    for (uint32_t slice = 0; slice < LightClusters::SLICES; slice++) {
+        for (uint32_t y = 0; y < LightClusters::TILES_Y; y++) {
+            for (uint32_t x = 0; x < LightClusters::TILES_X; x++) {
+                auto bounds = clusters.getClusterBounds(x, y, slice);
+                std::vector<uint32_t> expected;
+                for (uint32_t light = 0; light < lights.size(); light++) {
+                    if (lights[light].radius > 0.0f && LightClusters::intersects(bounds, lights[light])) {
+                        expected.push_back(light);
+                    }
+                }
+                uint32_t cluster = LightClusters::clusterIndex(x, y, slice);
+                mismatches += lightsOf(clusters, cluster) != expected;
+                binned += expected.size();
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+    CHECK(clusters.getIndices().size() == binned);
+    CHECK(binned > 0);
+    if (mismatches != 0) {
+        std::cout << mismatches << " clusters differ from the brute force assignment\n";
+    }
+}
+
+// a view space point lit by a light finds that light in the cluster the shader looks up for it
+static void pointsFindTheirLights() {
+    LightClusters clusters;
+    clusters.setProjection(X_SCALE, Y_SCALE, Z_NEAR, Z_FAR);
+    auto lights = randomLights(200, 11);
+    clusters.build(lights);
+    auto uniform = clusters.getUniform(1920.0f, 1080.0f);
+
+    std::mt19937 rng{17};
+    std::uniform_real_distribution<float> ndc{-0.999f, 0.999f};
+    std::uniform_real_distribution<float> log_depth{std::log(Z_NEAR * 0.5f), std::log(Z_FAR * 0.999f)};
+    uint32_t missing = 0;
+    uint32_t lit = 0;
+    for (uint32_t i = 0; i < 20'000; i++) {
+        float depth = std::exp(log_depth(rng));
+        float nx = ndc(rng);
+        float ny = ndc(rng);
+        float px = nx * depth / X_SCALE;
+        float py = ny * depth / Y_SCALE;
+        float pz = -depth;
+
+        auto x = static_cast<uint32_t>((nx + 1.0f) * 0.5f * LightClusters::TILES_X);
+        auto y = static_cast<uint32_t>((ny + 1.0f) * 0.5f * LightClusters::TILES_Y);
+        float slice_f = std::floor(std::log(depth / uniform.zNear) * uniform.sliceScale);
+        auto slice = static_cast<uint32_t>(std::clamp(slice_f, 0.0f, float(LightClusters::SLICES - 1)));
+        auto listed = lightsOf(clusters, LightClusters::clusterIndex(x, y, slice));
+
+        for (uint32_t light = 0; light < lights.size(); light++) {
+            const auto& s = lights[light];
+            float d2 = (px - s.x) * (px - s.x) + (py - s.y) * (py - s.y) + (pz - s.z) * (pz - s.z);
+            // a margin so texels right on a slice boundary do not depend on float rounding
+            if (s.radius > 0.0f && d2 < s.radius * s.radius * 0.999f) {
+                lit++;
+                missing += std::find(listed.begin(), listed.end(), light) == listed.end();
+            }
+        }
+    }
+    CHECK(lit > 0);
+    CHECK(missing == 0);
+    if (missing != 0) {
+        std::cout << missing << " of " << lit << " lit points miss their light\n";
+    }
+}
+
+// full clusters keep their first lights and count the rest
+static void overflow() {
+    LightClusters clusters;
+    clusters.setProjection(X_SCALE, Y_SCALE, Z_NEAR, Z_FAR);
+    std::vector<Sphere> lights(LightClusters::MAX_LIGHTS_PER_CLUSTER + 10, Sphere{0.0f, 0.0f, -50.0f, 0.01f});
+    clusters.build(lights);
+    CHECK(clusters.getOverflowCount() > 0);
+    CHECK(clusters.getOverflowCount() % 10 == 0);
+    const auto& grid = clusters.getGrid();
+    bool capped = true;
+    bool first_lights = true;
+    for (uint32_t cluster = 0; cluster < LightClusters::CLUSTER_COUNT; cluster++) {
+        capped &= grid[2 * cluster + 1] <= LightClusters::MAX_LIGHTS_PER_CLUSTER;
+        auto listed = lightsOf(clusters, cluster);
+        for (uint32_t i = 0; i < listed.size(); i++) {
+            first_lights &= listed[i] == i;
+        }
+    }
+    CHECK(capped);
+    CHECK(first_lights);
+}
+
+static void attenuation() {
+    float range = LightClusters::attenuationRange(1.0f, 0.09f, 0.032f, 1.0f);
+    float at_range = 1.0f / (1.0f + 0.09f * range + 0.032f * range * range);
+    CHECK(std::abs(at_range - LightClusters::ATTENUATION_CUTOFF) < 1e-5f);
+    CHECK(LightClusters::attenuationRange(1.0f, 0.0f, 0.0f, 1.0f) == INFINITY);
+    CHECK(LightClusters::attenuationRange(1.0f, 0.1f, 0.0f, 0.0f) == 0.0f);
+    // already under the cutoff at the light itself
+    CHECK(LightClusters::attenuationRange(1000.0f, 0.1f, 0.1f, 1.0f) == 0.0f);
+}
+
+int main() {
+    matchesBruteForce();
+    pointsFindTheirLights();
+    overflow();
+    attenuation();
+    return testResult();
+}
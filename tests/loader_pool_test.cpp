@@ -0,0 +1,69 @@
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "check.h"
+#include "loader_pool.h"
+
+// one worker held by a first job, so everything submitted after it is queued when the worker frees up
+static void priorities() {
+    LoaderPool pool{1};
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    pool.submit(0, [opened] { opened.wait(); });
+
+    std::mutex order_mutex;
+    std::vector<int> order;
+    auto record = [&](int id) {
+        return [&order_mutex, &order, id] {
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back(id);
+        };
+    };
+    pool.submit(0, record(1));
+    pool.submit(2, record(2));
+    auto cancelled = pool.submit(1, record(3));
+    pool.submit(2, record(4));
+    pool.submit(1, record(5));
+
+    LoaderPool::Status cancel_status = LoaderPool::Status::Finished;
+    auto ticket = pool.submit(0, record(6), [&](LoaderPool::Status status) { cancel_status = status; });
+    CHECK(pool.cancel(cancelled));
+    CHECK(pool.cancel(ticket));
+    CHECK(!pool.cancel(ticket));
+    CHECK(cancel_status == LoaderPool::Status::Cancelled);
+
+    gate.set_value();
+    pool.waitIdle();
+    CHECK((order == std::vector<int>{2, 4, 5, 1}));
+    CHECK(pool.getPendingCount() == 0 && pool.getRunningCount() == 0);
+}
+
+// a throwing job is reported through its completion and the worker keeps serving the queue
+static void failures() {
+    LoaderPool pool{2};
+    std::atomic<int> failed{0};
+    std::atomic<int> finished{0};
+    auto count = [&](LoaderPool::Status status) {
+        (status == LoaderPool::Status::Failed ? failed : finished)++;
+    };
+    for (int i = 0; i < 20; i++) {
+        if (i % 2 == 0) {
+            pool.submit(0, [] { throw std::runtime_error("broken asset"); }, count);
+        } else {
+            pool.submit(0, [] { throw 7; }, count);
+        }
+        pool.submit(0, [] {}, count);
+    }
+    pool.waitIdle();
+    CHECK(failed == 20);
+    CHECK(finished == 20);
+}
+
+int main() {
+    priorities();
+    failures();
+    return testResult();
+}
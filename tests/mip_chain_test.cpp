@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "mip_chain.h"
+
+static std::vector<uint8_t> noise(uint32_t width, uint32_t height, uint32_t seed) {
+    std::mt19937 rng{seed};
+    std::uniform_int_distribution<int> byte{0, 255};
+    std::vector<uint8_t> image(4 * (size_t)width * height);
+    for (auto& value : image) {
+        value = static_cast<uint8_t>(byte(rng));
+    }
+    return image;
+}
+
+// hand computed levels, odd edges repeat their last texel
+static void golden() {
+    // 3x2, one channel shown, the others are offset by 1, 2, 3
+    const uint8_t red[] = {10, 20, 30, 40, 51, 255};
+    std::vector<uint8_t> image;
+    for (uint8_t value : red) {
+        for (uint8_t c = 0; c < 4; c++) {
+            image.push_back(static_cast<uint8_t>(value + c));
+        }
+    }
+    // (10 + 20 + 40 + 51 + 2) >> 2 = 30, the third column is dropped
+    std::vector<uint8_t> expected = {30, 31, 32, 33};
+    CHECK(downsampleRGBA8(image.data(), 3, 2) == expected);
+    CHECK(downsampleRGBA8(image.data(), 3, 2, MipFilter::Box, false) == expected);
+
+    // a single row only halves its width, rounding half up: (1 + 2 + 1 + 2 + 2) >> 2 = 2
+    std::vector<uint8_t> row = {1, 1, 1, 1, 2, 2, 2, 2, 254, 254, 254, 254, 255, 255, 255, 255};
+    std::vector<uint8_t> row_expected = {2, 2, 2, 2, 255, 255, 255, 255};
+    CHECK(downsampleRGBA8(row.data(), 4, 1) == row_expected);
+    CHECK(downsampleRGBA8(row.data(), 4, 1, MipFilter::Box, false) == row_expected);
+}
+
+// the filtered box path matches downsampleRGBA8 byte for byte on every level, through the SIMD rows, their scalar
+// tails and the 1 texel wide and high levels
+static void boxMatchesScalar() {
+    const uint32_t sizes[][2] = {{1, 1}, {2, 2}, {3, 5}, {7, 1}, {1, 9}, {8, 8}, {13, 6}, {64, 33}, {129, 70}};
+    uint32_t seed = 0;
+    for (auto [width, height] : sizes) {
+        std::vector<uint8_t> base = noise(width, height, seed++);
+        auto levels = buildMipChainRGBA8(base, width, height);
+        std::vector<uint8_t> scalar = base;
+        uint32_t w = width;
+        uint32_t h = height;
+        bool exact = levels[0] == base;
+        for (size_t level = 1; level < levels.size(); level++) {
+            scalar = downsampleRGBA8(scalar.data(), w, h);
+            w = std::max(1u, w / 2);
+            h = std::max(1u, h / 2);
+            exact &= levels[level] == scalar;
+        }
+        CHECK(exact);
+        CHECK(w == 1 && h == 1);
+        if (!exact) {
+            std::cout << "box chain of " << width << "x" << height << " differs from downsampleRGBA8\n";
+        }
+    }
+
+    auto partial = buildMipChainRGBA8(noise(16, 16, 9), 16, 16, MipFilter::Box, false, 3);
+    CHECK(partial.size() == 3 && partial[2].size() == 4 * 4 * 4);
+}
+
+// a solid image stays solid through every filter, in linear and sRGB
+static void constant() {
+    constexpr const uint32_t WIDTH = 37;
+    constexpr const uint32_t HEIGHT = 20;
+    std::vector<uint8_t> base(4 * WIDTH * HEIGHT);
+    const uint8_t color[] = {200, 13, 128, 77};
+    for (size_t i = 0; i < base.size(); i++) {
+        base[i] = color[i % 4];
+    }
+    for (MipFilter filter : {MipFilter::Box, MipFilter::Kaiser}) {
+        for (bool srgb : {false, true}) {
+            bool solid = true;
+            for (const auto& level : buildMipChainRGBA8(base, WIDTH, HEIGHT, filter, srgb)) {
+                for (size_t i = 0; i < level.size(); i++) {
+                    solid &= level[i] == color[i % 4];
+                }
+            }
+            CHECK(solid);
+        }
+    }
+}
+
+int main() {
+    golden();
+    boxMatchesScalar();
+    constant();
+    return testResult();
+}
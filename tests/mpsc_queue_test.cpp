@@ -0,0 +1,83 @@
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "mpsc_queue.h"
+
+// producers push while the consumer drains, every item arrives exactly once and in order per producer
+static void stress() {
+    constexpr const uint32_t PRODUCERS = 8;
+    constexpr const uint32_t ITEMS_PER_PRODUCER = 50'000;
+
+    struct Item {
+            uint32_t producer;
+            uint32_t sequence;
+            std::unique_ptr<uint64_t> payload;  // checks the value is moved, not copied or dropped
+    };
+    MpscQueue<Item> queue;
+    std::atomic<uint32_t> ready{0};
+
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&queue, &ready, p] {
+            ready++;
+            while (ready.load() != PRODUCERS) {
+            }
+            for (uint32_t i = 0; i < ITEMS_PER_PRODUCER; i++) {
+                queue.push(Item{p, i, std::make_unique<uint64_t>(uint64_t{p} << 32 | i)});
+            }
+        });
+    }
+
+    std::vector<uint32_t> next_sequence(PRODUCERS, 0);
+    uint32_t received = 0;
+    bool in_order = true;
+    bool payloads_match = true;
+    while (received < PRODUCERS * ITEMS_PER_PRODUCER) {
+        auto item = queue.pop();
+        if (!item.has_value()) {
+            std::this_thread::yield();
+            continue;
+        }
+        in_order &= item->producer < PRODUCERS && item->sequence == next_sequence[item->producer];
+        uint64_t expected = uint64_t{item->producer} << 32 | item->sequence;
+        payloads_match &= item->payload != nullptr && *item->payload == expected;
+        if (item->producer < PRODUCERS) {
+            next_sequence[item->producer] = item->sequence + 1;
+        }
+        received++;
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    CHECK(in_order);
+    CHECK(payloads_match);
+    CHECK(received == PRODUCERS * ITEMS_PER_PRODUCER);
+    CHECK(queue.empty());
+    CHECK(!queue.pop().has_value());
+}
+
+// items left in the queue are destroyed with it
+static void destruction() {
+    auto counter = std::make_shared<int>(0);
+    {
+        MpscQueue<std::shared_ptr<int>> queue;
+        for (uint32_t i = 0; i < 100; i++) {
+            queue.push(counter);
+        }
+        CHECK(counter.use_count() == 101);
+        CHECK(queue.pop().has_value());
+        CHECK(counter.use_count() == 100);
+    }
+    CHECK(counter.use_count() == 1);
+}
+
+int main() {
+    stress();
+    destruction();
+    return testResult();
+}
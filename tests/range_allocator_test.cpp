@@ -0,0 +1,152 @@
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "check.h"
+#include "range_allocator.h"
+
+// ranges come from the lowest offset that fits, a hole too small for the request is skipped
+static void firstFit() {
+    RangeAllocator allocator{100};
+    CHECK(allocator.allocate(10) == 0u);
+    CHECK(allocator.allocate(20) == 10u);
+    CHECK(allocator.allocate(30) == 30u);
+    CHECK(allocator.getFreeSize() == 40);
+
+    allocator.free(0, 10);
+    CHECK(allocator.allocate(15) == 60u);  // the hole at 0 is too small
+    CHECK(allocator.allocate(5) == 0u);    // the first hole that fits, not the best one
+    CHECK(allocator.allocate(5) == 5u);
+
+    CHECK(!allocator.allocate(26).has_value());
+    CHECK(!allocator.allocate(0).has_value());
+    CHECK(allocator.allocate(25) == 75u);
+    CHECK(allocator.getFreeSize() == 0);
+    CHECK(allocator.getFreeRangeCount() == 0);
+}
+
+// a freed range merges with the free ranges right before and after it
+static void coalescing() {
+    RangeAllocator allocator{40};
+    for (uint64_t offset = 0; offset < 40; offset += 10) {
+        CHECK(allocator.allocate(10) == offset);
+    }
+
+    allocator.free(0, 10);
+    allocator.free(20, 10);
+    CHECK(allocator.getFreeRangeCount() == 2);
+    CHECK(allocator.getLargestFreeRange() == 10);
+
+    // both neighbours are free, the three become one
+    allocator.free(10, 10);
+    CHECK(allocator.getFreeRangeCount() == 1);
+    CHECK(allocator.getLargestFreeRange() == 30);
+
+    // only the preceding one
+    allocator.free(30, 10);
+    CHECK(allocator.getFreeRangeCount() == 1);
+    CHECK(allocator.getLargestFreeRange() == 40);
+    CHECK(allocator.allocate(40) == 0u);
+
+    // only the following one
+    allocator.free(20, 20);
+    allocator.free(10, 10);
+    CHECK(allocator.getFreeRangeCount() == 1);
+    CHECK(allocator.getLargestFreeRange() == 30);
+    CHECK(allocator.getFreeSize() == 30);
+}
+
+// grow appends the new space to the free list, merged with a free range at the old end
+static void growing() {
+    RangeAllocator allocator{0};
+    CHECK(!allocator.allocate(1).has_value());
+    allocator.grow(16);
+    CHECK(allocator.allocate(16) == 0u);
+
+    allocator.grow(32);
+    CHECK(allocator.getCapacity() == 32);
+    CHECK(allocator.getFreeSize() == 16);
+    CHECK(allocator.allocate(8) == 16u);
+
+    // the free tail [24, 32) and the grown space become one range
+    allocator.grow(64);
+    CHECK(allocator.getFreeRangeCount() == 1);
+    CHECK(allocator.getLargestFreeRange() == 40);
+    CHECK(allocator.allocate(40) == 24u);
+
+    // shrinking is ignored
+    allocator.grow(10);
+    CHECK(allocator.getCapacity() == 64);
+}
+
+// compact packs the live ranges to the front in offset order and reports the copies
+static void compacting() {
+    RangeAllocator allocator{100};
+    std::vector<RangeAllocator::Range> ranges;
+    for (uint64_t size : {10, 20, 10, 30}) {
+        ranges.push_back({*allocator.allocate(size), size});
+    }
+    // [0,10) [10,30) [30,40) [40,70), drop the first and third
+    allocator.free(ranges[0].offset, ranges[0].size);
+    allocator.free(ranges[2].offset, ranges[2].size);
+    CHECK(allocator.getFreeRangeCount() == 3);
+
+    std::vector<RangeAllocator::Range*> live = {&ranges[3], &ranges[1]};  // any order
+    auto moves = allocator.compact(live);
+    CHECK(moves.size() == 2);
+    CHECK(moves[0].from == 10 && moves[0].to == 0 && moves[0].size == 20);
+    CHECK(moves[1].from == 40 && moves[1].to == 20 && moves[1].size == 30);
+    CHECK(ranges[1].offset == 0);
+    CHECK(ranges[3].offset == 20);
+
+    CHECK(allocator.getFreeRangeCount() == 1);
+    CHECK(allocator.getFreeSize() == 50);
+    CHECK(allocator.allocate(50) == 50u);
+
+    // ranges already in place are not copied
+    RangeAllocator packed{30};
+    RangeAllocator::Range first{*packed.allocate(10), 10};
+    RangeAllocator::Range second{*packed.allocate(20), 20};
+    std::vector<RangeAllocator::Range*> all = {&first, &second};
+    CHECK(packed.compact(all).empty());
+    CHECK(packed.getFreeRangeCount() == 0 && packed.getFreeSize() == 0);
+}
+
+// the share of the free space outside the largest free range
+static void fragmentation() {
+    RangeAllocator allocator{100};
+    CHECK(allocator.getFragmentation() == 0.0f);
+
+    for (int i = 0; i < 10; ++i) {
+        allocator.allocate(10);
+    }
+    CHECK(allocator.getFragmentation() == 0.0f);  // no free space at all
+
+    // four holes of 10
+    for (uint64_t offset : {0, 20, 40, 60}) {
+        allocator.free(offset, 10);
+    }
+    CHECK(std::abs(allocator.getFragmentation() - 0.75f) < 1e-6f);
+
+    // holes of 30, 10 and 10
+    allocator.free(10, 10);
+    CHECK(allocator.getFreeRangeCount() == 3);
+    CHECK(std::abs(allocator.getFragmentation() - 0.4f) < 1e-6f);
+
+    // one of 50 and one of 10
+    allocator.free(30, 10);
+    CHECK(allocator.getFreeRangeCount() == 2);
+    CHECK(std::abs(allocator.getFragmentation() - 1.0f / 6.0f) < 1e-6f);
+
+    allocator.free(50, 10);
+    CHECK(allocator.getFragmentation() == 0.0f);
+}
+
+int main() {
+    firstFit();
+    coalescing();
+    growing();
+    compacting();
+    fragmentation();
+    return testResult();
+}
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "render_queue.h"
+
+// opaque keys order by pass, pipeline, material and then front to back
+static void opaqueKeys() {
+    uint64_t far = RenderQueue::makeOpaqueKey(0, 1, 5, 0.9f);
+    CHECK(RenderQueue::makeOpaqueKey(0, 1, 5, 0.1f) < far);
+    CHECK(far < RenderQueue::makeOpaqueKey(0, 1, 6, 0.0f));
+    CHECK(far < RenderQueue::makeOpaqueKey(0, 2, 0, 0.1f));
+    uint32_t max_pipeline = (1u << RenderQueue::PIPELINE_BITS) - 1;
+    uint32_t max_material = (1u << RenderQueue::MATERIAL_BITS) - 1;
+    CHECK(RenderQueue::makeOpaqueKey(1, 0, 0, 0.0f) > RenderQueue::makeOpaqueKey(0, max_pipeline, max_material, 1.0f));
+
+    // ids wrap at their width, depths are clamped
+    CHECK(RenderQueue::makeOpaqueKey(0, max_pipeline + 4, 0, 0.0f) == RenderQueue::makeOpaqueKey(0, 3, 0, 0.0f));
+    CHECK(RenderQueue::makeOpaqueKey(0, 0, max_material + 2, 0.0f) == RenderQueue::makeOpaqueKey(0, 0, 1, 0.0f));
+    CHECK(RenderQueue::makeOpaqueKey(0, 0, 0, -1.0f) == RenderQueue::makeOpaqueKey(0, 0, 0, 0.0f));
+    CHECK(RenderQueue::makeOpaqueKey(0, 0, 0, 3.0f) == RenderQueue::makeOpaqueKey(0, 0, 0, 1.0f));
+}
+
+// transparent keys put the depth back to front right after the pass
+static void transparentKeys() {
+    uint64_t far = RenderQueue::makeTransparentKey(1, 0.9f, 7, 7);
+    uint64_t near = RenderQueue::makeTransparentKey(1, 0.1f, 0, 0);
+    CHECK(far < near);
+    CHECK(RenderQueue::makeTransparentKey(1, 0.5f, 0, 1) < RenderQueue::makeTransparentKey(1, 0.5f, 1, 0));
+    CHECK(RenderQueue::makeTransparentKey(1, 2.0f, 0, 0) == RenderQueue::makeTransparentKey(1, 1.0f, 0, 0));
+    CHECK(RenderQueue::makeOpaqueKey(0, 9, 9, 1.0f) < RenderQueue::makeTransparentKey(1, 1.0f, 0, 0));
+}
+
+// the radix sort matches a stable sort, also for keys that leave whole bytes unused
+static void sorting() {
+    RenderQueue queue;
+    std::mt19937_64 rng{42};
+    bool sizes = true;
+    bool same = true;
+    for (uint32_t round = 0; round < 20; round++) {
+        queue.clear();
+        std::vector<RenderQueue::Item> expected;
+        size_t count = rng() % 2000;
+        for (uint32_t i = 0; i < count; i++) {
+            uint64_t key = round % 2 == 1 ? rng() : (rng() % 16) << 40;
+            queue.push(key, i);
+            expected.push_back({key, i});
+        }
+        queue.sort();
+        std::stable_sort(expected.begin(), expected.end(), [](const auto& a, const auto& b) { return a.key < b.key; });
+
+        const auto& items = queue.getItems();
+        sizes &= items.size() == expected.size();
+        for (size_t i = 0; sizes && i < items.size(); i++) {
+            same &= items[i].key == expected[i].key && items[i].draw == expected[i].draw;
+        }
+    }
+    CHECK(sizes);
+    CHECK(same);
+
+    queue.clear();
+    queue.sort();
+    CHECK(queue.getItems().empty());
+}
+
+static void stateCache() {
+    StateCache state;
+    int pipeline = 0;
+    int other_pipeline = 0;
+    int group = 0;
+    CHECK(state.setPipeline(&pipeline));
+    CHECK(!state.setPipeline(&pipeline));
+    CHECK(state.setPipeline(&other_pipeline));
+
+    CHECK(state.setBindGroup(0, &group));
+    CHECK(!state.setBindGroup(0, &group));
+    CHECK(state.setBindGroup(1, &group));
+    // nothing bound is never taken for bound
+    CHECK(state.setBindGroup(2, nullptr));
+    CHECK(state.setBindGroup(2, nullptr));
+    // a dynamic offset counts as part of the binding
+    CHECK(state.setBindGroup(6, &group, 256));
+    CHECK(!state.setBindGroup(6, &group, 256));
+    CHECK(state.setBindGroup(6, &group, 512));
+
+    state.reset();
+    CHECK(state.setBindGroup(6, &group, 512));
+    state.reset();
+    CHECK(state.setPipeline(&other_pipeline));
+    CHECK(state.getElidedCount() == 3);
+    CHECK(state.getIssuedCount() == 10);
+    state.resetCounters();
+    CHECK(state.getElidedCount() == 0 && state.getIssuedCount() == 0);
+
+    // geometry shared through the arena is bound once
+    int arena = 0;
+    CHECK(state.setVertexBuffer(0, &arena));
+    CHECK(!state.setVertexBuffer(0, &arena));
+    CHECK(state.setVertexBuffer(1, &arena));
+    CHECK(state.setIndexBuffer(&arena));
+    CHECK(!state.setIndexBuffer(&arena));
+    CHECK(state.getElidedCount() == 2);
+}
+
+int main() {
+    opaqueKeys();
+    transparentKeys();
+    sorting();
+    stateCache();
+    return testResult();
+}
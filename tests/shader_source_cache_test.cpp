@@ -0,0 +1,100 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "cache_key.h"
+#include "check.h"
+#include "shader_source_cache.h"
+
+namespace fs = std::filesystem;
+
+static void writeFile(const fs::path& path, const std::string& text) {
+    std::ofstream file{path, std::ios::binary};
+    file << text;
+}
+
+// rewrites `path` with a modification time later than its last one, however coarse the file system clock is
+static void editFile(const fs::path& path, const std::string& text) {
+    auto modified = fs::last_write_time(path);
+    writeFile(path, text);
+    fs::last_write_time(path, modified + std::chrono::seconds(2));
+}
+
+static fs::path makeSources(const fs::path& root) {
+    fs::remove_all(root);
+    fs::path sources = root / "src";
+    fs::create_directories(sources);
+    writeFile(sources / "common.wgsl", "// common\n#include \"inner.wgsl\"\nfn c() {}\n");
+    writeFile(sources / "inner.wgsl", "fn inner() {}\n");
+    writeFile(sources / "main.wgsl", "#include \"common.wgsl\"\nfn main() {}\n");
+    writeFile(sources / "self.wgsl", "#include \"self.wgsl\"\nfn self() {}\n");
+    return sources;
+}
+
+// strings are length prefixed, so moving bytes between them changes the key
+static void cacheKey() {
+    CacheKey a;
+    CacheKey b;
+    a.addString("ab").addString("c");
+    b.addString("a").addString("bc");
+    CHECK(a.getBytes() != b.getBytes());
+    // FNV-1a
+    CHECK(CacheKey::hash("") == 0xcbf29ce484222325ull);
+    CHECK(CacheKey::hash("a") == 0xaf63dc4c8601ec8cull);
+}
+
+// nested includes are expanded, a modified include invalidates the source that includes it
+static void includes(const fs::path& sources) {
+    ShaderSourceCache cache;
+    const auto& source = cache.load(sources / "main.wgsl");
+    std::string expected = "// common\nfn inner() {}\n\nfn c() {}\n\nfn main() {}\n";
+    CHECK(source.code == expected);
+    CHECK(source.hash == CacheKey::hash(expected));
+    cache.load(sources / "main.wgsl");
+    CHECK(cache.getStats().hits == 1 && cache.getStats().misses == 1);
+
+    editFile(sources / "inner.wgsl", "fn inner2() {}\n");
+    const auto& edited = cache.load(sources / "main.wgsl");
+    CHECK(edited.code.find("inner2") != std::string::npos);
+    CHECK(cache.getStats().misses == 2);
+
+    // a file including itself is expanded once
+    const auto& self = cache.load(sources / "self.wgsl");
+    CHECK(self.code.find("fn self()") != std::string::npos);
+}
+
+// preprocessed sources survive a restart until one of their files changes
+static void disk(const fs::path& sources, const fs::path& directory) {
+    std::string code;
+    {
+        ShaderSourceCache cache;
+        cache.setDiskDirectory(directory);
+        code = cache.load(sources / "main.wgsl").code;
+        CHECK(cache.getStats().diskHits == 0);
+    }
+    {
+        ShaderSourceCache cache;
+        cache.setDiskDirectory(directory);
+        const auto& source = cache.load(sources / "main.wgsl");
+        CHECK(cache.getStats().diskHits == 1);
+        CHECK(source.code == code);
+        CHECK(source.hash == CacheKey::hash(code));
+    }
+    editFile(sources / "inner.wgsl", "fn inner3() {}\n");
+    {
+        ShaderSourceCache cache;
+        cache.setDiskDirectory(directory);
+        CHECK(cache.load(sources / "main.wgsl").code.find("inner3") != std::string::npos);
+        CHECK(cache.getStats().diskHits == 0);
+    }
+}
+
+int main() {
+    fs::path root = fs::temp_directory_path() / "world_explorer_shader_source_cache_test";
+    cacheKey();
+    includes(makeSources(root));
+    disk(makeSources(root), root / "cache");
+    fs::remove_all(root);
+    return testResult();
+}
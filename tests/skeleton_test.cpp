@@ -0,0 +1,130 @@
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "skeleton.h"
+
+// sampleSkeleton against the string keyed reference on a small scene with bind poses, partial channels and a mixed
+// action, played forward like the engine does and sought at random times
+
+static aiNode* addNode(aiNode* parent, const char* name, const aiMatrix4x4& transform) {
+    auto* node = new aiNode(name);
+    node->mTransformation = transform;
+    if (parent != nullptr) {
+        parent->addChildren(1, &node);
+    }
+    return node;
+}
+
+static aiMatrix4x4 makeTransform(aiVector3D translation, float angle, aiVector3D scale = {1.0f, 1.0f, 1.0f}) {
+    return aiMatrix4x4(scale, aiQuaternion(aiVector3D(0.0f, 1.0f, 0.0f), angle), translation);
+}
+
+static std::unique_ptr<Bone> makeBone(int id, uint32_t keyCount, float duration, float phase) {
+    auto bone = std::make_unique<Bone>();
+    bone->id = id;
+    bone->offsetMatrix = glm::mat4{1.0f};
+    for (uint32_t i = 0; i < keyCount; i++) {
+        float time = keyCount > 1 ? duration * static_cast<float>(i) / static_cast<float>(keyCount - 1) : 0.0f;
+        float angle = phase + static_cast<float>(i) * 0.7f;
+        bone->channel.translations.push_back({time, glm::vec3{std::sin(angle), 0.5f * i, std::cos(angle)}});
+        bone->channel.quats.push_back({time, glm::angleAxis(angle, glm::normalize(glm::vec3{1.0f, 2.0f, 0.5f}))});
+        if (i % 2 == 0) {
+            bone->channel.scales.push_back({time, glm::vec3{1.0f + 0.1f * i}});
+        }
+    }
+    return bone;
+}
+
+int main() {
+    std::unique_ptr<aiNode> root{addNode(nullptr, "root", makeTransform({0.0f, 1.0f, 0.0f}, 0.3f, {2.0f, 2.0f, 2.0f}))};
+    aiNode* hips = addNode(root.get(), "hips", makeTransform({0.0f, 0.9f, 0.0f}, 0.0f));
+    aiNode* spine = addNode(hips, "spine", makeTransform({0.0f, 0.3f, 0.0f}, 0.1f));
+    addNode(spine, "head", makeTransform({0.0f, 0.4f, 0.1f}, -0.2f));
+    aiNode* arm = addNode(spine, "arm", makeTransform({0.3f, 0.2f, 0.0f}, 1.2f, {1.0f, 0.5f, 1.0f}));
+    addNode(arm, "hand", makeTransform({0.4f, 0.0f, 0.0f}, 0.0f));
+    addNode(hips, "leg", makeTransform({0.1f, -0.5f, 0.0f}, 0.0f));
+
+    Skeleton skeleton;
+    skeleton.build(root.get());
+    CHECK(skeleton.size() == 7);
+    CHECK(skeleton.parents[0] == -1);
+    for (size_t joint = 1; joint < skeleton.size(); joint++) {
+        CHECK(skeleton.parents[joint] >= 0 && static_cast<size_t>(skeleton.parents[joint]) < joint);
+    }
+
+    // head and leg keep their bind pose, hand has a single key, the bone outside of the scene is not skinned
+    std::vector<std::unique_ptr<Bone>> bones;
+    Action walk;
+    walk.mAnimationDuration = 1.0;
+    for (const char* name : {"hips", "spine", "arm", "ghost"}) {
+        bones.push_back(makeBone(static_cast<int>(bones.size()), 9, 1000.0f, static_cast<float>(bones.size())));
+        walk.Bonemap[name] = bones.back().get();
+    }
+    bones.push_back(makeBone(static_cast<int>(bones.size()), 1, 1000.0f, 2.0f));
+    walk.Bonemap["hand"] = bones.back().get();
+
+    Action aim;
+    aim.mAnimationDuration = 0.6;
+    for (const char* name : {"spine", "arm"}) {
+        bones.push_back(makeBone(static_cast<int>(bones.size()), 5, 600.0f, -static_cast<float>(bones.size())));
+        aim.Bonemap[name] = bones.back().get();
+    }
+
+    // the upper body plays `aim`, like Animation::createMaskedAction does
+    Action masked;
+    masked.Bonemap = walk.Bonemap;
+    masked.mAnimationDuration = walk.mAnimationDuration;
+    for (const char* name : {"spine", "arm", "hand"}) {
+        masked.MixedActions[name] = &aim;
+    }
+
+    compileAction(skeleton, walk);
+    compileAction(skeleton, masked);
+    CHECK(walk.compiled.skin.size() == 4);
+    CHECK(masked.compiled.sources[skeleton.getJointIndex("arm")] == &aim);
+    CHECK(aim.compiled.skeleton == &skeleton);
+
+    constexpr const float TOLERANCE = 1e-5f;
+    float max_error = 0.0f;
+    for (const Action* action : {&walk, &masked}) {
+        // forward playback walks the key cursors, past the end the last keys hold
+        for (double time = 0.0; time < 1500.0; time += 16.6) {
+            max_error = std::max(max_error, compareWithReference(skeleton, *action, root.get(), time));
+        }
+        // seeks backwards and across the mixed action's loop
+        std::mt19937 rng{3};
+        std::uniform_real_distribution<double> seek{-10.0, 2500.0};
+        for (uint32_t i = 0; i < 500; i++) {
+            max_error = std::max(max_error, compareWithReference(skeleton, *action, root.get(), seek(rng)));
+        }
+        // exactly on the keys
+        for (double time = 0.0; time <= 1000.0; time += 125.0) {
+            max_error = std::max(max_error, compareWithReference(skeleton, *action, root.get(), time));
+        }
+    }
+    CHECK(max_error < TOLERANCE);
+    if (max_error >= TOLERANCE) {
+        std::cout << "max error " << max_error << '\n';
+    }
+
+    // joints without keys sample their bind pose, relative to the scene root
+    std::vector<glm::mat4> locals(skeleton.size());
+    std::vector<glm::mat4> globals(skeleton.size());
+    sampleSkeleton(skeleton, walk, 250.0, locals, globals);
+    int32_t head = skeleton.getJointIndex("head");
+    glm::mat4 bind = AiToGlm(makeTransform({0.0f, 0.4f, 0.1f}, -0.2f));
+    float bind_error = 0.0f;
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            bind_error = std::max(bind_error, std::abs(locals[head][c][r] - bind[c][r]));
+        }
+    }
+    CHECK(bind_error < TOLERANCE);
+    glm::mat4 root_global = globals[0];
+    CHECK(std::abs(root_global[3][1]) < TOLERANCE && std::abs(root_global[0][0] - 1.0f) < TOLERANCE);
+
+    return testResult();
+}
@@ -0,0 +1,107 @@
+#include <cstdint>
+#include <vector>
+
+#include "check.h"
+#include "staging_ring.h"
+
+// allocations bump inside the current block, a full block is swapped for a new one
+static void bumping() {
+    StagingRing ring{64, 3};
+    auto first = ring.allocate(10, 4);
+    CHECK(first.block == 0 && first.offset == 0);
+    auto aligned = ring.allocate(8, 4);
+    CHECK(aligned.block == 0 && aligned.offset == 12);
+    auto wide = ring.allocate(8, 16);
+    CHECK(wide.block == 0 && wide.offset == 32);
+    auto exact = ring.allocate(24, 4);
+    CHECK(exact.block == 0 && exact.offset == 40);  // ends right at the block end
+    auto next = ring.allocate(1, 4);
+    CHECK(next.block == 1 && next.offset == 0);
+    CHECK(ring.getBlockCount() == 2);
+    CHECK(ring.getInFlightCount() == 0);
+}
+
+// writes that can not be staged get NO_BLOCK, UploadRing writes them directly then
+static void fallback() {
+    StagingRing ring{64, 2};
+    CHECK(ring.allocate(65, 4).block == StagingRing::NO_BLOCK);
+    CHECK(ring.allocate(64, 4).block == 0);
+    CHECK(ring.allocate(64, 4).block == 1);
+    // both blocks are being written, there is no third one
+    CHECK(ring.allocate(4, 4).block == StagingRing::NO_BLOCK);
+    CHECK(ring.getBlockCount() == 2);
+
+    std::vector<uint32_t> submitted;
+    ring.submit(1, submitted);
+    CHECK(submitted.size() == 2);
+    CHECK(ring.allocate(4, 4).block == StagingRing::NO_BLOCK);  // every block is in flight
+    ring.release(1);
+    CHECK(ring.allocate(4, 4).block == 1);
+}
+
+// submitted blocks are fenced with their frame and only come back once released
+static void fence() {
+    StagingRing ring{64, 3};
+    std::vector<uint32_t> submitted;
+    CHECK(ring.getOldestInFlightFrame() == StagingRing::NO_FRAME);
+    ring.allocate(40, 4);
+    ring.allocate(40, 4);
+    ring.submit(7, submitted);
+    CHECK(submitted == std::vector<uint32_t>({0, 1}));
+    CHECK(ring.getInFlightCount() == 2);
+    CHECK(ring.getOldestInFlightFrame() == 7);
+
+    // a submit starts a new block, the written one is in flight
+    CHECK(ring.allocate(4, 4).block == 2);
+    ring.submit(8, submitted);
+    CHECK(submitted == std::vector<uint32_t>({2}));
+
+    ring.release(0);
+    CHECK(ring.getOldestInFlightFrame() == 7);
+    ring.release(1);
+    CHECK(ring.getOldestInFlightFrame() == 8);
+    ring.release(1);  // released twice, like a late map callback
+    CHECK(ring.getInFlightCount() == 1);
+
+    // nothing written, nothing submitted
+    ring.submit(9, submitted);
+    CHECK(submitted.empty());
+    CHECK(ring.getInFlightCount() == 1);
+}
+
+// over many frames the blocks cycle, the ring never grows past what the frames in flight need
+static void wrapAround() {
+    StagingRing ring{256, 4};
+    std::vector<uint32_t> submitted;
+    std::vector<std::vector<uint32_t>> in_flight;
+    bool staged = true;
+    bool fenced = true;
+    for (uint64_t frame = 0; frame < 1000; frame++) {
+        // the GPU is two frames behind
+        if (in_flight.size() == 2) {
+            for (uint32_t block : in_flight.front()) {
+                ring.release(block);
+            }
+            in_flight.erase(in_flight.begin());
+            fenced &= ring.getOldestInFlightFrame() == frame - 1;
+        }
+        for (uint32_t write = 0; write < 3; write++) {
+            auto allocation = ring.allocate(100, 4);
+            staged &= allocation.block != StagingRing::NO_BLOCK;
+        }
+        ring.submit(frame, submitted);
+        in_flight.push_back(submitted);
+    }
+    CHECK(staged);
+    CHECK(fenced);
+    CHECK(ring.getBlockCount() == 4);
+    CHECK(ring.getInFlightCount() == 4);
+}
+
+int main() {
+    bumping();
+    fallback();
+    fence();
+    wrapAround();
+    return testResult();
+}
@@ -0,0 +1,122 @@
+#include <cstdint>
+
+#include "check.h"
+#include "static_casters.h"
+
+static uint64_t signatureOf(float x, float y, float z, uint32_t visibleMeshes) {
+    const float transform[3] = {x, y, z};
+    uint64_t signature = StaticCasters::mix(StaticCasters::EMPTY_SIGNATURE, transform, sizeof(transform));
+    return StaticCasters::mix(signature, &visibleMeshes, sizeof(visibleMeshes));
+}
+
+// runs `frames` frames with the given casters still, returns whether any of them reported a change
+template <typename Update>
+static bool still(uint32_t frames, Update&& update, StaticCasters& casters) {
+    bool changed = false;
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        update();
+        changed |= casters.endFrame();
+    }
+    return changed;
+}
+
+// casters settle after STATIC_FRAMES, the cache is redrawn once for them and then stays valid
+static void settling() {
+    StaticCasters casters;
+    int house = 0;
+    int tree = 0;
+    int car = 0;
+    auto update = [&] {
+        casters.update(&house, signatureOf(0, 0, 0, 3), true);
+        casters.update(&tree, signatureOf(5, 0, 0, 1), true);
+        casters.update(&car, signatureOf(9, 0, 0, 2), false);
+    };
+    CHECK(still(1, update, casters));  // the first frame always draws the cache
+    CHECK(!still(StaticCasters::STATIC_FRAMES - 1, update, casters));
+    CHECK(casters.getStaticCount() == 0);
+
+    update();
+    CHECK(casters.isStatic(&house) && casters.isStatic(&tree));
+    CHECK(!casters.isStatic(&car));
+    CHECK(casters.endFrame());
+    CHECK(casters.getStaticCount() == 2);
+    CHECK(!still(100, update, casters));
+}
+
+// a static caster that moves leaves the cache on that very frame and only comes back after settling again
+static void staticCasterMoves() {
+    StaticCasters casters;
+    int house = 0;
+    int crate = 0;
+    float crate_x = 2.0f;
+    auto update = [&] {
+        casters.update(&house, signatureOf(0, 0, 0, 3), true);
+        casters.update(&crate, signatureOf(crate_x, 0, 0, 1), true);
+    };
+    still(StaticCasters::STATIC_FRAMES + 1, update, casters);
+    CHECK(casters.getStaticCount() == 2);
+
+    crate_x = 3.0f;
+    CHECK(!casters.update(&crate, signatureOf(crate_x, 0, 0, 1), true));
+    casters.update(&house, signatureOf(0, 0, 0, 3), true);
+    CHECK(casters.endFrame());
+    CHECK(casters.getStaticCount() == 1);
+
+    // moving every frame keeps it dynamic without touching the cache
+    bool changed = false;
+    for (uint32_t frame = 0; frame < 100; frame++) {
+        crate_x += 0.1f;
+        update();
+        changed |= casters.endFrame();
+    }
+    CHECK(!changed);
+    CHECK(!casters.isStatic(&crate));
+
+    CHECK(still(StaticCasters::STATIC_FRAMES + 1, update, casters));
+    CHECK(casters.isStatic(&crate));
+}
+
+// swapping which meshes are visible changes the signature even when their count stays the same
+static void visibilityChanges() {
+    StaticCasters casters;
+    int statue = 0;
+    uint64_t signature = StaticCasters::mix(StaticCasters::EMPTY_SIGNATURE, "mesh 1", 6);
+    auto update = [&] { casters.update(&statue, signature, true); };
+    still(StaticCasters::STATIC_FRAMES + 1, update, casters);
+    CHECK(casters.isStatic(&statue));
+
+    signature = StaticCasters::mix(StaticCasters::EMPTY_SIGNATURE, "mesh 2", 6);
+    update();
+    CHECK(casters.endFrame());
+    CHECK(!casters.isStatic(&statue));
+}
+
+// an unloaded static caster is dropped from the cache, an unloaded dynamic one does not touch it
+static void removal() {
+    StaticCasters casters;
+    int house = 0;
+    int npc = 0;
+    still(StaticCasters::STATIC_FRAMES + 1, [&] {
+        casters.update(&house, signatureOf(0, 0, 0, 3), true);
+        casters.update(&npc, signatureOf(1, 0, 0, 1), false);
+    }, casters);
+
+    casters.update(&house, signatureOf(0, 0, 0, 3), true);
+    CHECK(!casters.endFrame());
+
+    CHECK(casters.endFrame());
+    CHECK(casters.getStaticCount() == 0);
+    CHECK(!casters.isStatic(&house));
+
+    casters.invalidate();
+    CHECK(casters.endFrame());
+    CHECK(!casters.endFrame());
+}
+
+int main() {
+    settling();
+    staticCasterMoves();
+    visibilityChanges();
+    removal();
+    return testResult();
+}
@@ -0,0 +1,150 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "check.h"
+#include "texture_residency.h"
+
+// a 256x256 RGBA8 texture: levels 0 and 1 stream, its tail is level 2 (64x64) and below
+static constexpr size_t LEVEL0 = 256 * 256 * 4;
+static constexpr size_t LEVEL1 = 128 * 128 * 4;
+static constexpr size_t TAIL = (64 * 64 + 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2 + 1) * 4;
+static constexpr size_t UNLIMITED = 1ull << 40;
+
+static TextureResidency::Handle addTexture(TextureResidency& residency) { return residency.add(256, 256, 4); }
+
+// only the mip tail is resident after add, even over the budget
+static void tailOnly() {
+    TextureResidency residency{0};
+    auto handle = addTexture(residency);
+    CHECK(residency.getTailMip(handle) == 2);
+    CHECK(residency.getFirstMip(handle) == 2);
+    CHECK(residency.getResidentBytes() == TAIL);
+    CHECK(residency.getTextureCount() == 1);
+
+    // nothing requested, nothing streams, and the tail is never evicted
+    CHECK(residency.update(1, UNLIMITED).empty());
+    CHECK(residency.getFirstMip(handle) == 2);
+
+    // block compressed: 4x4 blocks, the tail of a 1024x1024 BC1 texture is level 4
+    auto bc = residency.add(1024, 1024, 8, 4);
+    CHECK(residency.getTailMip(bc) == 4);
+    CHECK(TextureResidency::levelBytes(1024, 1024, 8, 4, 9) == 8);  // 2x2 still takes one block
+}
+
+// a frame streams at most the upload cap, but always at least one level
+static void uploadCap() {
+    TextureResidency residency{UNLIMITED};
+    auto handle = addTexture(residency);
+
+    residency.request(handle, 0, 1.0f, 1);
+    auto changes = residency.update(1, 1);  // smaller than any level
+    CHECK(changes.size() == 1);
+    CHECK(changes[0].handle == handle && changes[0].oldFirstMip == 2 && changes[0].newFirstMip == 1);
+    CHECK(residency.getResidentBytes() == TAIL + LEVEL1);
+
+    residency.request(handle, 0, 1.0f, 2);
+    changes = residency.update(2, 1);
+    CHECK(changes.size() == 1 && changes[0].oldFirstMip == 1 && changes[0].newFirstMip == 0);
+
+    // with room for both levels they come in one update, reported as a single change
+    auto other = addTexture(residency);
+    residency.request(other, 0, 1.0f, 3);
+    changes = residency.update(3, LEVEL0 + LEVEL1);
+    CHECK(changes.size() == 1);
+    CHECK(changes[0].handle == other && changes[0].oldFirstMip == 2 && changes[0].newFirstMip == 0);
+
+    // a request for a level that is resident already uploads nothing
+    residency.request(other, 1, 1.0f, 4);
+    CHECK(residency.update(4, UNLIMITED).empty());
+}
+
+// higher priority streams first when the cap does not fit everyone
+static void priorityOrder() {
+    TextureResidency residency{UNLIMITED};
+    auto low = addTexture(residency);
+    auto high = addTexture(residency);
+    residency.request(low, 0, 1.0f, 1);
+    residency.request(high, 0, 2.0f, 1);
+
+    auto changes = residency.update(1, LEVEL1);
+    CHECK(changes.size() == 1);
+    CHECK(changes[0].handle == high);
+    CHECK(residency.getFirstMip(low) == 2);
+    CHECK(residency.getFirstMip(high) == 1);
+
+    // several requests in one frame: the finest level and the highest priority win
+    residency.request(low, 1, 3.0f, 2);
+    residency.request(low, 0, 0.5f, 2);
+    residency.request(high, 0, 2.0f, 2);
+    changes = residency.update(2, 1);
+    CHECK(changes.size() == 1 && changes[0].handle == low && changes[0].newFirstMip == 1);
+}
+
+// lowering the budget evicts the finest levels of the least recently used texture first
+static void lruEviction() {
+    TextureResidency residency{UNLIMITED};
+    auto old_texture = addTexture(residency);
+    auto new_texture = addTexture(residency);
+    residency.request(old_texture, 0, 1.0f, 1);
+    residency.update(1, UNLIMITED);
+    residency.request(new_texture, 0, 1.0f, 2);
+    residency.update(2, UNLIMITED);
+    CHECK(residency.getResidentBytes() == 2 * (TAIL + LEVEL1 + LEVEL0));
+
+    residency.setBudget(residency.getResidentBytes() - 1);
+    auto changes = residency.update(3, UNLIMITED);
+    CHECK(changes.size() == 1);
+    CHECK(changes[0].handle == old_texture && changes[0].oldFirstMip == 0 && changes[0].newFirstMip == 1);
+    CHECK(residency.getFirstMip(new_texture) == 0);
+
+    // down to the tails, the older texture gives up all its levels before the newer one
+    residency.setBudget(2 * TAIL + LEVEL1);
+    changes = residency.update(4, UNLIMITED);
+    CHECK(residency.getFirstMip(old_texture) == 2);
+    CHECK(residency.getFirstMip(new_texture) == 1);
+    CHECK(residency.getResidentBytes() <= residency.getBudget());
+
+    // tails stay even when the budget can not hold them
+    residency.setBudget(0);
+    residency.update(5, UNLIMITED);
+    CHECK(residency.getFirstMip(old_texture) == 2 && residency.getFirstMip(new_texture) == 2);
+    CHECK(residency.getResidentBytes() == 2 * TAIL);
+}
+
+// remove gives the texture's bytes back to the budget, its handle is reused by the next add
+static void removeAndReuse() {
+    TextureResidency residency{UNLIMITED};
+    auto first = addTexture(residency);
+    auto second = addTexture(residency);
+    residency.request(first, 0, 1.0f, 1);
+    residency.update(1, UNLIMITED);
+    CHECK(residency.getResidentBytes() == 2 * TAIL + LEVEL1 + LEVEL0);
+
+    residency.remove(first);
+    CHECK(residency.getResidentBytes() == TAIL);
+    CHECK(residency.getTextureCount() == 1);
+    residency.remove(first);  // twice is a no-op
+    CHECK(residency.getResidentBytes() == TAIL);
+
+    // a removed texture ignores requests and is never a candidate
+    residency.request(first, 0, 1.0f, 2);
+    CHECK(residency.update(2, UNLIMITED).empty());
+
+    auto reused = residency.add(128, 128, 4);
+    CHECK(reused == first);
+    CHECK(reused != second);
+    CHECK(residency.getTailMip(reused) == 1);
+    CHECK(residency.getFirstMip(reused) == 1);  // starts over from its tail, not the old texture's levels
+    CHECK(residency.getTextureCount() == 2);
+    CHECK(residency.getResidentBytes() == 2 * TAIL);  // a 128x128 tail is the 256x256 one without level 1
+}
+
+int main() {
+    tailOnly();
+    uploadCap();
+    priorityOrder();
+    lruEviction();
+    removeAndReuse();
+    return testResult();
+}
@@ -0,0 +1,138 @@
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "transform_hierarchy.h"
+
+struct Tree {
+        std::vector<int32_t> parents;
+        std::vector<glm::mat4> locals;
+};
+
+static glm::mat4 randomLocal(std::mt19937& rng) {
+    std::uniform_real_distribution<float> offset{-5.0f, 5.0f};
+    std::uniform_real_distribution<float> angle{-3.0f, 3.0f};
+    std::uniform_real_distribution<float> scale{0.5f, 1.5f};
+    glm::mat4 local = glm::translate(glm::mat4{1.0f}, glm::vec3{offset(rng), offset(rng), offset(rng)});
+    local = glm::rotate(local, angle(rng), glm::normalize(glm::vec3{offset(rng), offset(rng), 1.0f}));
+    return glm::scale(local, glm::vec3{scale(rng), scale(rng), scale(rng)});
+}
+
+// parents come before their children, a few roots and some deep chains
+static Tree randomTree(uint32_t size, std::mt19937& rng) {
+    Tree tree;
+    for (uint32_t i = 0; i < size; i++) {
+        std::uniform_int_distribution<int32_t> parent{-1, static_cast<int32_t>(i) - 1};
+        tree.parents.push_back(i % 17 == 0 ? -1 : (i % 3 == 0 ? static_cast<int32_t>(i) - 1 : parent(rng)));
+        tree.locals.push_back(randomLocal(rng));
+    }
+    return tree;
+}
+
+static TransformHierarchy build(const Tree& tree) {
+    TransformHierarchy hierarchy;
+    for (size_t i = 0; i < tree.parents.size(); i++) {
+        CHECK(hierarchy.add(tree.parents[i], tree.locals[i]) == static_cast<int32_t>(i));
+    }
+    return hierarchy;
+}
+
+// the recursive parent walk the hierarchy replaces
+static glm::mat4 recursiveWorld(const Tree& tree, int32_t node) {
+    int32_t parent = tree.parents[node];
+    return parent < 0 ? tree.locals[node] : recursiveWorld(tree, parent) * tree.locals[node];
+}
+
+static bool matchesRecursive(const Tree& tree, const TransformHierarchy& hierarchy) {
+    bool same = true;
+    for (size_t i = 0; i < tree.parents.size(); i++) {
+        same &= hierarchy.getWorld(static_cast<int32_t>(i)) == recursiveWorld(tree, static_cast<int32_t>(i));
+    }
+    return same;
+}
+
+static bool isUnder(const Tree& tree, int32_t node, const std::vector<uint8_t>& edited) {
+    for (; node >= 0; node = tree.parents[node]) {
+        if (edited[node]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void firstUpdate() {
+    std::mt19937 rng{3};
+    Tree tree = randomTree(200, rng);
+    TransformHierarchy hierarchy = build(tree);
+    CHECK(hierarchy.size() == 200);
+    CHECK(hierarchy.isDirty());
+    CHECK(hierarchy.update() == 200);
+    CHECK(matchesRecursive(tree, hierarchy));
+    CHECK(hierarchy.getParent(3) == 2);
+
+    // nothing changed, nothing is recomputed
+    CHECK(!hierarchy.isDirty());
+    CHECK(hierarchy.update() == 0);
+}
+
+// only the edited nodes and everything under them are recomputed, and still match the recursive walk
+static void edits() {
+    std::mt19937 rng{9};
+    Tree tree = randomTree(200, rng);
+    TransformHierarchy hierarchy = build(tree);
+    hierarchy.update();
+
+    std::uniform_int_distribution<int32_t> node{0, 199};
+    std::uniform_int_distribution<uint32_t> count{1, 6};
+    bool counts = true;
+    bool same = true;
+    for (uint32_t round = 0; round < 100; round++) {
+        std::vector<uint8_t> edited(tree.parents.size(), 0);
+        for (uint32_t i = count(rng); i > 0; i--) {
+            int32_t n = node(rng);
+            tree.locals[n] = randomLocal(rng);
+            hierarchy.setLocal(n, tree.locals[n]);
+            edited[n] = 1;
+        }
+        size_t expected = 0;
+        for (size_t i = 0; i < tree.parents.size(); i++) {
+            expected += isUnder(tree, static_cast<int32_t>(i), edited);
+        }
+        counts &= hierarchy.update() == expected;
+        same &= matchesRecursive(tree, hierarchy);
+    }
+    CHECK(counts);
+    CHECK(same);
+
+    // a leaf on its own
+    hierarchy.setLocal(199, hierarchy.getLocal(199));
+    CHECK(hierarchy.update() == 1);
+}
+
+// reparenting rebuilds the hierarchy, as ModelHierarchy does when a model gets a new parent or socket
+static void rebuild() {
+    std::mt19937 rng{21};
+    Tree tree = randomTree(50, rng);
+    TransformHierarchy hierarchy = build(tree);
+    hierarchy.update();
+
+    hierarchy.clear();
+    CHECK(hierarchy.size() == 0);
+    CHECK(hierarchy.update() == 0);
+
+    Tree reparented = randomTree(60, rng);
+    hierarchy = build(reparented);
+    CHECK(hierarchy.update() == 60);
+    CHECK(matchesRecursive(reparented, hierarchy));
+}
+
+int main() {
+    firstUpdate();
+    edits();
+    rebuild();
+    return testResult();
+}
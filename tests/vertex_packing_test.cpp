@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <random>
+
+#include "check.h"
+#include "vertex_packing.h"
+
+static void octahedralNormals() {
+    double max_angle = 0.0;
+    for (uint32_t i = 0; i <= 180; i++) {
+        for (uint32_t j = 0; j < 360; j++) {
+            float theta = static_cast<float>(i) * std::numbers::pi_v<float> / 180.0f;
+            float phi = static_cast<float>(j) * std::numbers::pi_v<float> / 180.0f;
+            float x = std::sin(theta) * std::cos(phi);
+            float y = std::sin(theta) * std::sin(phi);
+            float z = std::cos(theta);
+            auto n = packing::unpackOctahedral(packing::packOctahedral(x, y, z));
+            // acos of a float dot product is too coarse for the angles of interest
+            double cx = static_cast<double>(n[1]) * z - static_cast<double>(n[2]) * y;
+            double cy = static_cast<double>(n[2]) * x - static_cast<double>(n[0]) * z;
+            double cz = static_cast<double>(n[0]) * y - static_cast<double>(n[1]) * x;
+            double dot = static_cast<double>(n[0]) * x + static_cast<double>(n[1]) * y + static_cast<double>(n[2]) * z;
+            double angle = std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot);
+            max_angle = std::max(max_angle, angle * 180.0 / std::numbers::pi);
+        }
+    }
+    CHECK(max_angle < 0.01);
+
+    // not normalized input keeps its direction
+    auto n = packing::unpackOctahedral(packing::packOctahedral(0.0f, -3.0f, 0.0f));
+    CHECK(std::abs(n[1] + 1.0f) < 1e-6f);
+    n = packing::unpackOctahedral(packing::packOctahedral(0.0f, 0.0f, 0.0f));
+    CHECK(n[2] == 1.0f);
+}
+
+static void halfFloats() {
+    // every half but NaN survives a round trip bit exact
+    for (uint32_t bits = 0; bits < 0x10000; bits++) {
+        if ((bits & 0x7C00) == 0x7C00 && (bits & 0x3FF) != 0) {
+            continue;
+        }
+        uint32_t packed = bits | (bits << 16);
+        auto values = packing::unpackHalf2(packed);
+        if (!CHECK(packing::packHalf2(values[0], values[1]) == packed)) {
+            break;
+        }
+    }
+    auto values = packing::unpackHalf2(packing::packHalf2(65519.0f, 1e6f));
+    CHECK(values[0] == 65504.0f);
+    CHECK(std::isinf(values[1]));
+    values = packing::unpackHalf2(packing::packHalf2(1.0f + 1.0f / 2048.0f, 1.0f + 3.0f / 2048.0f));
+    CHECK(values[0] == 1.0f);  // ties to even
+    CHECK(values[1] == 1.0f + 2.0f / 1024.0f);
+
+    // UVs up to MAX_PACKED_UV stay within half a texel of a 1024px texture
+    float max_error = 0.0f;
+    for (float uv = -packing::MAX_PACKED_UV; uv <= packing::MAX_PACKED_UV; uv += 1.0f / 4093.0f) {
+        max_error = std::max(max_error, std::abs(packing::unpackHalf2(packing::packHalf2(uv, 0.0f))[0] - uv));
+    }
+    CHECK(max_error <= 0.5f / 1024.0f);
+}
+
+static void colorsAndSkin() {
+    float max_error = 0.0f;
+    for (uint32_t i = 0; i <= 1000; i++) {
+        float value = static_cast<float>(i) / 1000.0f;
+        auto color = packing::unpackUnorm4(packing::packUnorm4(value, 1.0f - value, 2.0f, -1.0f));
+        max_error = std::max({max_error, std::abs(color[0] - value), std::abs(color[1] - (1.0f - value))});
+        CHECK(color[2] == 1.0f);
+        CHECK(color[3] == 0.0f);
+    }
+    CHECK(max_error <= 0.5f / 255.0f + 1e-6f);
+
+    std::mt19937 rng{7};
+    std::uniform_real_distribution<float> weight{0.0f, 1.0f};
+    float max_weight_error = 0.0f;
+    for (uint32_t i = 0; i < 10000; i++) {
+        std::array<float, 4> weights = {weight(rng), weight(rng), weight(rng) * 0.1f, 0.0f};
+        float sum = weights[0] + weights[1] + weights[2] + weights[3];
+        uint32_t packed = packing::packWeights(weights);
+        uint32_t total = 0;
+        for (uint32_t j = 0; j < 4; j++) {
+            uint32_t quantized = (packed >> (8 * j)) & 0xFF;
+            total += quantized;
+            max_weight_error = std::max(max_weight_error, std::abs(quantized / 255.0f - weights[j] / sum));
+        }
+        CHECK(total == 255);
+    }
+    // the heaviest weight absorbs up to two roundings of half a step
+    CHECK(max_weight_error <= 2.0f / 255.0f);
+    CHECK(packing::packWeights({0.0f, 0.0f, 0.0f, 0.0f}) == 255);
+    CHECK(packing::packWeights({-1.0f, 2.0f, 0.0f, 0.0f}) == 255u << 8);
+
+    CHECK(packing::packBoneIds({1, 2, 3, 4}) == 0x04030201u);
+    CHECK(packing::packBoneIds({-5, 300, 255, 0}) == 0x00FFFF00u);
+}
+
+int main() {
+    octahedralNormals();
+    halfFloats();
+    colorsAndSkin();
+    return testResult();
+}